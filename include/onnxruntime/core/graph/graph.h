@@ -258,7 +258,10 @@ class Node {
   /** Gets a modifiable count of arguments for each of the Node's explicit inputs.
   @todo This should be removed in favor of a method that updates the input args and the count.
         Currently these operations are separate which is not a good setup. */
-  std::vector<int>& MutableInputArgsCount() { return definitions_.input_arg_count; }
+  std::vector<int>& MutableInputArgsCount() {
+    ResetInferenceState();
+    return definitions_.input_arg_count;
+  }
 
   /** Gets a modifiable collection of the Node's input definitions. */
   std::vector<NodeArg*>& MutableInputDefs() noexcept {
@@ -397,7 +400,10 @@ class Node {
   bool ClearAttribute(const std::string& attr_name);
 
   /** Gets the Node's mutable attributes. */
-  NodeAttributes& GetMutableAttributes() noexcept { return attributes_; }
+  NodeAttributes& GetMutableAttributes() noexcept {
+    ResetInferenceState();
+    return attributes_;
+  }
 
 #endif  // !defined(ORT_MINIMAL_BUILD) || defined(ORT_EXTENDED_MINIMAL_BUILD)
 
@@ -605,6 +611,13 @@ class Node {
   // validate and update the input arg count
   common::Status UpdateInputArgCount();
 
+  // Forget the state recorded by the last type and shape inferencing so the next Graph::Resolve infers the node again.
+  void ResetInferenceState() noexcept {
+#if !defined(ORT_MINIMAL_BUILD)
+    inference_state_.reset();
+#endif
+  }
+
   const Definitions& GetDefinitions() const noexcept { return definitions_; }
   const Relationships& GetRelationships() const noexcept { return relationships_; }
 
@@ -642,6 +655,20 @@ class Node {
   // Node::ToProto when running onnx::check_node in the first Graph::Resolve. At that point we know all the nodes are
   // unchanged from the original model.
   const ONNX_NAMESPACE::NodeProto* original_node_proto_ = nullptr;
+
+  // What type and shape inferencing of the node depended on when it last ran, besides the attributes.
+  // Graph::Resolve skips inferencing for the node while this is unchanged.
+  struct InferenceState {
+    const ONNX_NAMESPACE::OpSchema* op = nullptr;
+    InlinedVector<uint64_t> arg_versions;                          // NodeArg type versions of the inputs then outputs
+    InlinedVector<const ONNX_NAMESPACE::TensorProto*> input_data;  // constant initializer of each input, if any
+
+    bool operator==(const InferenceState& other) const {
+      return op == other.op && arg_versions == other.arg_versions && input_data == other.input_data;
+    }
+  };
+
+  std::optional<InferenceState> inference_state_;
 #endif
 
   // Execution priority, lower value for higher priority
@@ -727,6 +754,13 @@ class Graph {  // NOLINT(clang-analyzer-optin.performance.Padding): preserve exi
   */
   common::Status ReplaceInitializedTensor(ONNX_NAMESPACE::TensorProto new_initializer);
 
+  /** Replaces the initializer tensor with the given name with the data of the given OrtValue, which must be a
+  non-string tensor with the same type and shape as the existing initializer tensor.
+  The data is not copied. The TensorProto refers to it in memory, and session state finalization uses the OrtValue,
+  which the Graph keeps alive until the initializer is removed, so several graphs can share the data.
+  */
+  common::Status ReplaceInitializedTensor(const std::string& name, const OrtValue& value);
+
 #if !defined(DISABLE_EXTERNAL_INITIALIZERS)
   /** This function takes externally provided data for initializers with external data
    *    and replaces graph initializers with its content.
@@ -1350,6 +1384,14 @@ class Graph {  // NOLINT(clang-analyzer-optin.performance.Padding): preserve exi
     // Whether to set that no proto sync is required after resolving.
     // Useful for resolving right after loading from a GraphProto.
     bool no_proto_sync_required = false;
+    // Resolve only runs type and shape inferencing for nodes that changed since the last Resolve, or whose inputs
+    // changed type or shape. If set, the skipped nodes are inferred as well and Resolve fails if that would change
+    // any of their outputs. Enabled in debug builds to validate the change tracking.
+#ifdef NDEBUG
+    bool verify_skipped_inferencing = false;
+#else
+    bool verify_skipped_inferencing = true;
+#endif
   };
 
   /**
@@ -1604,6 +1646,14 @@ class Graph {  // NOLINT(clang-analyzer-optin.performance.Padding): preserve exi
   // Initialize overridable initializers container
   void ComputeOverridableInitializers();
 
+  // The data of an initializer was added, removed or replaced. Type and shape inferencing of its consumers may have
+  // used the data, so make the next Resolve infer them again.
+  void InitializerDataChanged(const std::string& name) {
+    if (NodeArg* node_arg = GetNodeArg(name); node_arg != nullptr) {
+      node_arg->type_version_ = NodeArg::NextTypeVersion();
+    }
+  }
+
 #if !defined(ORT_MINIMAL_BUILD)
   // Build and verify node connection (edges).
   // Verify NodeArg name/type/shape matching correctly.
@@ -1621,6 +1671,13 @@ class Graph {  // NOLINT(clang-analyzer-optin.performance.Padding): preserve exi
 
   common::Status InferAndVerifyTypeMatch(Node& node, const ONNX_NAMESPACE::OpSchema& op, const ResolveOptions& options);
 
+  // Collect what type and shape inferencing of the node depends on besides its attributes.
+  Node::InferenceState GetInferenceState(const Node& node) const;
+
+  // Run type and shape inferencing for a node that Resolve skipped, and fail if it changes any of the outputs.
+  common::Status VerifySkippedInferencing(Node& node, const ONNX_NAMESPACE::OpSchema& op,
+                                          const ResolveOptions& options);
+
   // perform type and shape inferencing on the subgraph and Resolve to validate
   static common::Status InferAndVerifySubgraphTypes(const Node& node, Graph& subgraph,
                                                     const std::vector<const ONNX_NAMESPACE::TypeProto*>& input_types,
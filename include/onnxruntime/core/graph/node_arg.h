@@ -130,5 +130,11 @@ class NodeArg {
 
   // Flag indicates whether <*this> node arg exists or not.
   bool exists_;
+
+  // Identifies the current type and shape. It is set to a new process-wide unique value whenever they may have
+  // changed, which lets Graph::Resolve tell whether the types a node was inferred from are still current.
+  uint64_t type_version_ = NextTypeVersion();
+
+  static uint64_t NextTypeVersion() noexcept;
 };
 }  // namespace onnxruntime
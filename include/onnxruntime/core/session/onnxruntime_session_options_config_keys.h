@@ -285,6 +285,78 @@ static const char* const kOrtSessionOptionsOptimizedModelExternalInitializersFil
 static const char* const kOrtSessionOptionsOptimizedModelExternalInitializersMinSizeInBytes =
     "session.optimized_model_external_initializers_min_size_in_bytes";
 
+// Directory of an on-disk cache of optimized models. If set, session creation loads the ORT format model that an
+// earlier session stored for the same model and configuration instead of optimizing the model, or stores it after
+// optimizing the model. The cache key is a hash of the model bytes, the session options and config entries, the
+// execution providers and their options, the CPU features and the ORT version.
+// The cache is only used for ONNX models loaded from a file or from a memory buffer. It is not used if
+// SessionOptions.optimized_model_filepath is set, if external initializers or initializers to share are provided, if
+// custom graph transformers are registered, or if an execution provider compiles nodes of the model.
+static const char* const kOrtSessionOptionsOptimizedModelCacheDir = "session.optimized_model_cache_dir";
+
+// Maximum total size in bytes of the optimized model cache. When storing an entry exceeds it, the least recently used
+// entries are removed. "0" means no limit. Default is "1073741824" (1 GiB).
+static const char* const kOrtSessionOptionsOptimizedModelCacheMaxSizeInBytes =
+    "session.optimized_model_cache_max_size_in_bytes";
+
+// Number of Runs with the same values of the symbolic dimensions of the model inputs after which a session specialized
+// for these values is created. It overrides the free dimensions with the values, so optimizers and memory planning see
+// fixed shapes. The Run that reaches the count creates it and runs on it, so that Run takes longer, and later Runs with
+// these values use it. It shares the initializers, pre-packed weights and thread pools of the session. The initializers
+// of the session are kept after they were pre-packed. "0" disables it. Default is "0".
+// Only supported for ONNX models that only use the CPU execution provider.
+static const char* const kOrtSessionOptionsShapeSpecializationMinRunCount =
+    "session.shape_specialization_min_run_count";
+
+// Maximum number of specialized sessions created by "session.shape_specialization_min_run_count". Default is "4".
+static const char* const kOrtSessionOptionsShapeSpecializationMaxSessions = "session.shape_specialization_max_sessions";
+
+// Enables TunableOp of the CPU execution provider. Its tuning results decide whether the graph optimizer applies some
+// fusions (MatMul + Add into Gemm, Gemm + activation into FusedGemm) to the shapes they see in the model. Tuning results
+// of the CPU EP saved in the model metadata enable it too. It is only enabled if the CPU EP is the only execution
+// provider of the session.
+// "0": disabled [DEFAULT]. "1": enabled.
+static const char* const kOrtSessionOptionsCpuTunableOpEnable = "session.cpu_tunable_op_enable";
+
+// Enables tuning for TunableOp of the CPU execution provider. Decisions missing from the tuning results are made by
+// profiling the fused and unfused kernels while the graph is optimized, and can be retrieved with the tuning results of
+// the session. Meant for offline tuning runs. Implies "session.cpu_tunable_op_enable".
+// "0": disabled [DEFAULT]. "1": enabled.
+static const char* const kOrtSessionOptionsCpuTunableOpTuningEnable = "session.cpu_tunable_op_tuning_enable";
+
+// Maximum time in milliseconds spent profiling each candidate subgraph when tuning. "0" means no limit besides the
+// maximum number of runs. Default is "0".
+static const char* const kOrtSessionOptionsCpuTunableOpMaxTuningDurationMs =
+    "session.cpu_tunable_op_max_tuning_duration_ms";
+
+// Only execute the nodes needed to compute the outputs requested in a Run, like RunOptions
+// only_execute_path_to_fetches does for a single run. The nodes outside of the backward cone of the requested
+// outputs are skipped and their outputs are not allocated.
+// "0": disabled [DEFAULT]. "1": enabled.
+static const char* const kOrtSessionOptionsPruneExecutionToFetches = "session.prune_execution_to_fetches";
+
+// Maximum number of distinct sets of requested outputs whose pruned execution plans are cached. The least recently
+// used plan is evicted when a new set is requested. "0" disables the cache. Default is "8".
+static const char* const kOrtSessionOptionsPrunedExecutionPlanCacheSize = "session.pruned_execution_plan_cache_size";
+
+// Directory of a persistent cache of the results of constant folding. A folded node is looked up by a hash of its
+// operator, attributes and the contents of its inputs, so sessions that load the same constant subgraphs, including
+// other models sharing them, skip computing them. Entries are never removed by ORT; the directory is managed by the
+// user. Folded outputs loaded from the cache may reference the data files in the directory, which must therefore
+// not be modified while a session using them exists. Default is "" (no cache).
+static const char* const kOrtSessionOptionsConstantFoldingCacheDir = "session.constant_folding_cache_dir";
+
+// Maximum number of bytes of folded outputs that constant folding keeps in memory. Outputs of at least 4 KB that
+// exceed the budget stay in the data files of the constant folding cache and are memory mapped like external
+// initializers instead. Requires kOrtSessionOptionsConstantFoldingCacheDir. Default is "0" (no limit).
+static const char* const kOrtSessionOptionsConstantFoldingMemoryBudgetInBytes =
+    "session.constant_folding_memory_budget_in_bytes";
+
+// Maximum number of independent nodes that constant folding computes in parallel on the intra-op thread pool of the
+// session. No nodes are computed in parallel if the pool has a single thread, e.g. with intra_op_num_threads = 1.
+// "0": as many as the pool has threads [DEFAULT]. "1": fold one node at a time.
+static const char* const kOrtSessionOptionsConstantFoldingNumThreads = "session.constant_folding_num_threads";
+
 // When loading model from memory buffer and the model has external initializers
 // Use this config to set the external data file folder path
 // All external data files should be in the same folder
@@ -66,6 +66,12 @@ Status DecoderMaskedMultiHeadAttention<T>::Compute(OpKernelContext* context) con
   const Tensor* cache_indir = context->Input<Tensor>(kCacheIndirectionInputIndex);
   const Tensor* bias = context->Input<Tensor>(kBiasIndex);
 
+  // Decoder cross-attention with key and value shared by the beams of each batch entry
+  if (past_key == nullptr && key != nullptr && key->Shape().NumDimensions() == 4 &&
+      query->Shape().NumDimensions() == 3 && key->Shape()[0] != query->Shape()[0]) {
+    return ApplySharedCrossAttention(context, query, key, value, mask_index, attention_bias, bias);
+  }
+
   DecoderMaskedMultiHeadAttentionParameters parameters;
 
   bool is_unidirectional = false;
@@ -223,5 +229,111 @@ Status DecoderMaskedMultiHeadAttention<T>::Compute(OpKernelContext* context) con
                                  beam_width_value, output_qk);
 }
 
+template <typename T>
+Status DecoderMaskedMultiHeadAttention<T>::ApplySharedCrossAttention(OpKernelContext* context,
+                                                                     const Tensor* query,
+                                                                     const Tensor* key,
+                                                                     const Tensor* value,
+                                                                     const Tensor* mask_index,
+                                                                     const Tensor* attention_bias,
+                                                                     const Tensor* bias) const {
+  const auto& query_dims = query->Shape().GetDims();
+  const auto& key_dims = key->Shape().GetDims();
+  const int64_t batch_beam_size = query_dims[0];
+  const int64_t batch_size = key_dims[0];
+  if (batch_size <= 0 || batch_beam_size % batch_size != 0) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'key' dimension 0 (", batch_size, ") shall divide 'query' dimension 0 (",
+                           batch_beam_size, ") when key and value are shared by the beams of each batch entry");
+  }
+  if (value == nullptr || value->Shape() != key->Shape()) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'key' and 'value' shall have same shape (batch_size, num_heads, "
+                           "kv_sequence_length, head_size)");
+  }
+  if (attention_bias != nullptr) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, NOT_IMPLEMENTED,
+                           "DecoderMaskedMultiHeadAttention does not support attention bias for cross-attention");
+  }
+
+  const int num_beams = static_cast<int>(batch_beam_size / batch_size);
+  const int kv_sequence_length = static_cast<int>(key_dims[2]);
+  const int head_size = static_cast<int>(key_dims[3]);
+  const int hidden_size = num_heads_ * head_size;
+  if (key_dims[1] != num_heads_ || query_dims[1] != 1 || query_dims[2] != hidden_size) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'query' is expected to have shape (batch_size * beam_width, 1, ", hidden_size,
+                           ") for key with shape ", key->Shape());
+  }
+  if (mask_index != nullptr && mask_index->Shape() != TensorShape({batch_beam_size, kv_sequence_length})) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, NOT_IMPLEMENTED,
+                           "DecoderMaskedMultiHeadAttention only supports no mask or 2D key padding mask of shape "
+                           "[batch, total_seq_length] for cross-attention with shared key and value");
+  }
+
+  Tensor* output = context->Output(0, query->Shape());
+  TensorShape present_shape({batch_beam_size, num_heads_, kv_sequence_length, head_size});
+  if (context->Output(kPresentOutputIndex, present_shape) != nullptr) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'key' and 'value' can only be shared by the beams for cross-attention");
+  }
+  Tensor* output_qk = nullptr;
+  if (output_qk_) {
+    output_qk = context->Output(kQKOutputIndex, {batch_beam_size, num_heads_, 1, kv_sequence_length});
+  }
+
+  AllocatorPtr allocator;
+  ORT_RETURN_IF_ERROR(context->GetTempSpaceAllocator(&allocator));
+
+  // The query rows of the beams of a batch entry are laid out as one query of sequence length num_beams, which
+  // attends to the shared key and value of that entry without a causal mask.
+  OrtValue Q;
+  ORT_RETURN_IF_ERROR(MaybeTransposeToBNSHAndAddBias<T>(
+      context, allocator, static_cast<int>(batch_size), num_heads_, num_beams, head_size, query, bias, 0, Q));
+
+  // The beams of a batch entry have the same key padding mask, so keep the row of the first beam.
+  Tensor batch_mask;
+  if (mask_index != nullptr) {
+    batch_mask = Tensor(DataTypeImpl::GetType<int32_t>(), TensorShape({batch_size, kv_sequence_length}), allocator);
+    const int32_t* mask_data = mask_index->Data<int32_t>();
+    int32_t* batch_mask_data = batch_mask.MutableData<int32_t>();
+    for (int64_t b = 0; b < batch_size; ++b) {
+      std::memcpy(batch_mask_data + b * kv_sequence_length, mask_data + b * num_beams * kv_sequence_length,
+                  sizeof(int32_t) * kv_sequence_length);
+    }
+  }
+
+  // Q*K' comes out as (batch_size, num_heads, num_beams, kv_sequence_length) and is reordered into output_qk.
+  Tensor batch_qk;
+  if (output_qk != nullptr) {
+    batch_qk = Tensor(DataTypeImpl::GetType<T>(),
+                      TensorShape({batch_size, num_heads_, num_beams, kv_sequence_length}), allocator);
+  }
+
+  ORT_RETURN_IF_ERROR(ApplyAttention(Q.GetMutable<Tensor>()->MutableData<T>(), key->Data<T>(), value->Data<T>(),
+                                     mask_index != nullptr ? &batch_mask : nullptr, nullptr /* past */,
+                                     nullptr /* past_key */, nullptr /* past_value */, output,
+                                     nullptr /* present_key */, nullptr /* present_value */,
+                                     output_qk != nullptr ? &batch_qk : nullptr,
+                                     static_cast<int>(batch_size), num_beams, kv_sequence_length,
+                                     head_size, head_size, hidden_size, nullptr /* attn_bias */, context));
+
+  if (output_qk != nullptr) {
+    const T* batch_qk_data = batch_qk.Data<T>();
+    T* output_qk_data = output_qk->MutableData<T>();
+    for (int64_t b = 0; b < batch_size; ++b) {
+      for (int n = 0; n < num_heads_; ++n) {
+        for (int beam = 0; beam < num_beams; ++beam) {
+          std::memcpy(output_qk_data + ((b * num_beams + beam) * num_heads_ + n) * kv_sequence_length,
+                      batch_qk_data + ((b * num_heads_ + n) * num_beams + beam) * kv_sequence_length,
+                      sizeof(T) * kv_sequence_length);
+        }
+      }
+    }
+  }
+
+  return Status::OK();
+}
+
 }  // namespace contrib
 }  // namespace onnxruntime
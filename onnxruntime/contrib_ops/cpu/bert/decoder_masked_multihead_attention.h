@@ -16,6 +16,12 @@ class DecoderMaskedMultiHeadAttention final : public OpKernel, public AttentionC
   Status Compute(OpKernelContext* context) const override;
 
  protected:
+  // Cross-attention where the beams of each batch entry share one copy of key and value, i.e. key and value have
+  // batch_size rows while query has batch_size * beam_width rows.
+  Status ApplySharedCrossAttention(OpKernelContext* context, const Tensor* query, const Tensor* key,
+                                   const Tensor* value, const Tensor* mask_index, const Tensor* attention_bias,
+                                   const Tensor* bias) const;
+
   int num_heads_;  // number of attention heads
   float mask_filter_value_;
   float scale_;
@@ -0,0 +1,463 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "contrib_ops/cpu/bert/paged_attention.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "contrib_ops/cpu/bert/attention_helper.h"
+#include "core/common/safeint.h"
+#include "core/platform/threadpool.h"
+
+using onnxruntime::concurrency::ThreadPool;
+
+namespace onnxruntime {
+namespace contrib {
+
+// These ops are internal-only, so register outside of onnx
+ONNX_OPERATOR_KERNEL_EX(
+    PagedAttention,
+    kMSDomain,
+    1,
+    kCpuExecutionProvider,
+    KernelDefBuilder()
+        .TypeConstraint("T", DataTypeImpl::GetTensorType<float>())
+        .TypeConstraint("C", BuildKernelDefConstraints<float, int8_t>())
+        .TypeConstraint("M", DataTypeImpl::GetTensorType<int32_t>())
+        .MayInplace(3, 1)
+        .MayInplace(4, 2)
+        .MayInplace(8, 3)
+        .MayInplace(9, 4),
+    PagedAttention);
+
+PagedAttention::PagedAttention(const OpKernelInfo& info)
+    : OpKernel(info), GQAAttentionBase(info, true) {
+  ORT_ENFORCE(num_heads_ % kv_num_heads_ == 0,
+              "num_heads (", num_heads_, ") must be a multiple of kv_num_heads (", kv_num_heads_, ")");
+}
+
+namespace {
+
+struct PagedAttentionParameters {
+  int batch_size;
+  int token_count;
+  int num_blocks;
+  int block_size;
+  int max_blocks_per_sequence;
+  int head_size;
+  int hidden_size;     // num_heads * head_size
+  int kv_hidden_size;  // kv_num_heads * head_size
+  bool is_packed_qkv;
+  bool is_quantized_cache;  // int8 caches with a scale per token and kv head
+};
+
+// Quantizes each kv head of one token symmetrically to int8 with its own scale.
+void QuantizeToken(const float* src, int kv_num_heads, int head_size, int8_t* dst, float* scales) {
+  for (int h = 0; h < kv_num_heads; ++h) {
+    const float* x = src + static_cast<ptrdiff_t>(h) * head_size;
+    int8_t* q = dst + static_cast<ptrdiff_t>(h) * head_size;
+
+    float max_abs = 0.0f;
+    for (int i = 0; i < head_size; ++i) {
+      max_abs = std::max(max_abs, std::fabs(x[i]));
+    }
+
+    const float inverse_scale = max_abs > 0.0f ? 127.0f / max_abs : 0.0f;
+    for (int i = 0; i < head_size; ++i) {
+      const float rounded = std::nearbyint(x[i] * inverse_scale);
+      q[i] = static_cast<int8_t>(std::min(127.0f, std::max(-127.0f, rounded)));
+    }
+    scales[h] = max_abs / 127.0f;
+  }
+}
+
+// Dequantizes n tokens of one kv head of an int8 cache block into a dense n x head_size matrix, so that the
+// int8 cache is read once per (sequence, head) and the GEMMs still run on float.
+void DequantizeBlockHead(const int8_t* cache, const float* scales, int n, int head_size, int kv_hidden_size,
+                         int kv_num_heads, float* dst) {
+  for (int j = 0; j < n; ++j) {
+    const int8_t* q = cache + static_cast<ptrdiff_t>(j) * kv_hidden_size;
+    const float scale = scales[static_cast<ptrdiff_t>(j) * kv_num_heads];
+    float* x = dst + static_cast<ptrdiff_t>(j) * head_size;
+    for (int i = 0; i < head_size; ++i) {
+      x[i] = static_cast<float>(q[i]) * scale;
+    }
+  }
+}
+
+Status CheckInputs(const Tensor* query, const Tensor* key, const Tensor* value,
+                   const Tensor* key_cache, const Tensor* value_cache,
+                   const Tensor* cumulative_sequence_length, const Tensor* past_seqlens, const Tensor* block_table,
+                   const Tensor* key_cache_scale, const Tensor* value_cache_scale,
+                   int num_heads, int kv_num_heads, PagedAttentionParameters& parameters) {
+  const auto& query_dims = query->Shape().GetDims();
+  if (query_dims.size() != 2) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'query' is expected to have 2 dimensions, got ", query_dims.size());
+  }
+
+  const auto& cache_dims = key_cache->Shape().GetDims();
+  if (cache_dims.size() != 3 || cache_dims[1] <= 0 || value_cache->Shape() != key_cache->Shape()) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Inputs 'key_cache' and 'value_cache' are expected to have the same shape "
+                           "(num_blocks, block_size, kv_num_heads * head_size)");
+  }
+
+  const int64_t kv_hidden_size = cache_dims[2];
+  if (kv_hidden_size % kv_num_heads != 0) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "The last dimension of 'key_cache' (", kv_hidden_size,
+                           ") is not a multiple of kv_num_heads (", kv_num_heads, ")");
+  }
+
+  const bool is_quantized_cache = key_cache->IsDataType<int8_t>();
+  if (is_quantized_cache) {
+    const TensorShape scale_shape({cache_dims[0], cache_dims[1], kv_num_heads});
+    if (key_cache_scale == nullptr || value_cache_scale == nullptr ||
+        key_cache_scale->Shape() != scale_shape || value_cache_scale->Shape() != scale_shape) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "Inputs 'key_cache_scale' and 'value_cache_scale' with shape ", scale_shape,
+                             " are required when the caches are int8");
+    }
+  } else if (key_cache_scale != nullptr || value_cache_scale != nullptr) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Inputs 'key_cache_scale' and 'value_cache_scale' are only used with int8 caches");
+  }
+
+  const int64_t head_size = kv_hidden_size / kv_num_heads;
+  const int64_t hidden_size = head_size * num_heads;
+  const int64_t token_count = query_dims[0];
+
+  const bool is_packed_qkv = key == nullptr;
+  if (is_packed_qkv) {
+    if (value != nullptr) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "Input 'value' is expected to be empty when 'key' is empty (packed QKV)");
+    }
+    if (query_dims[1] != hidden_size + 2 * kv_hidden_size) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "Packed 'query' is expected to have last dimension ", hidden_size + 2 * kv_hidden_size,
+                             ", got ", query_dims[1]);
+    }
+  } else {
+    if (value == nullptr) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "Input 'value' is required when 'key' is given");
+    }
+    if (query_dims[1] != hidden_size) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "Input 'query' is expected to have last dimension ", hidden_size,
+                             ", got ", query_dims[1]);
+    }
+    const TensorShape kv_shape({token_count, kv_hidden_size});
+    if (key->Shape() != kv_shape || value->Shape() != kv_shape) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "Inputs 'key' and 'value' are expected to have shape ", kv_shape);
+    }
+  }
+
+  const auto& past_dims = past_seqlens->Shape().GetDims();
+  if (past_dims.size() != 1) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "Input 'past_seqlens' is expected to be 1D");
+  }
+  const int64_t batch_size = past_dims[0];
+
+  if (cumulative_sequence_length->Shape() != TensorShape({batch_size + 1})) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'cumulative_sequence_length' is expected to have shape (", batch_size + 1, ")");
+  }
+
+  const auto& block_table_dims = block_table->Shape().GetDims();
+  if (block_table_dims.size() != 2 || block_table_dims[0] != batch_size) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'block_table' is expected to have shape (batch_size, max_blocks_per_sequence)");
+  }
+
+  parameters.batch_size = static_cast<int>(batch_size);
+  parameters.token_count = static_cast<int>(token_count);
+  parameters.num_blocks = static_cast<int>(cache_dims[0]);
+  parameters.block_size = static_cast<int>(cache_dims[1]);
+  parameters.max_blocks_per_sequence = static_cast<int>(block_table_dims[1]);
+  parameters.head_size = static_cast<int>(head_size);
+  parameters.hidden_size = static_cast<int>(hidden_size);
+  parameters.kv_hidden_size = static_cast<int>(kv_hidden_size);
+  parameters.is_packed_qkv = is_packed_qkv;
+  parameters.is_quantized_cache = is_quantized_cache;
+
+  // Every block a sequence touches must be a valid block of the pool.
+  const int32_t* cu_seqlens = cumulative_sequence_length->Data<int32_t>();
+  const int32_t* past = past_seqlens->Data<int32_t>();
+  const int32_t* blocks = block_table->Data<int32_t>();
+  if (cu_seqlens[0] != 0 || cu_seqlens[batch_size] != token_count) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'cumulative_sequence_length' must start at 0 and end at the token count ",
+                           token_count);
+  }
+
+  for (int b = 0; b < parameters.batch_size; ++b) {
+    const int new_length = cu_seqlens[b + 1] - cu_seqlens[b];
+    if (new_length < 0 || past[b] < 0) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "Invalid sequence lengths for sequence ", b);
+    }
+
+    const int64_t total_length = static_cast<int64_t>(past[b]) + new_length;
+    const int64_t used_blocks = (total_length + parameters.block_size - 1) / parameters.block_size;
+    if (used_blocks > parameters.max_blocks_per_sequence) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "Sequence ", b, " has ", total_length,
+                             " tokens, which does not fit in its block table");
+    }
+
+    const int32_t* sequence_blocks = blocks + static_cast<ptrdiff_t>(b) * parameters.max_blocks_per_sequence;
+    for (int64_t i = 0; i < used_blocks; ++i) {
+      if (sequence_blocks[i] < 0 || sequence_blocks[i] >= parameters.num_blocks) {
+        return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "Block id ", sequence_blocks[i],
+                               " in 'block_table' is out of range [0, ", parameters.num_blocks, ")");
+      }
+    }
+  }
+
+  return Status::OK();
+}
+
+}  // namespace
+
+Status PagedAttention::Compute(OpKernelContext* context) const {
+  const Tensor* query = context->Input<Tensor>(0);
+  const Tensor* key = context->Input<Tensor>(1);
+  const Tensor* value = context->Input<Tensor>(2);
+  const Tensor* key_cache = context->Input<Tensor>(3);
+  const Tensor* value_cache = context->Input<Tensor>(4);
+  const Tensor* cumulative_sequence_length = context->Input<Tensor>(5);
+  const Tensor* past_seqlens = context->Input<Tensor>(6);
+  const Tensor* block_table = context->Input<Tensor>(7);
+  const Tensor* key_cache_scale = context->Input<Tensor>(8);
+  const Tensor* value_cache_scale = context->Input<Tensor>(9);
+
+  PagedAttentionParameters parameters = {};
+  ORT_RETURN_IF_ERROR(CheckInputs(query, key, value, key_cache, value_cache, cumulative_sequence_length,
+                                  past_seqlens, block_table, key_cache_scale, value_cache_scale,
+                                  num_heads_, kv_num_heads_, parameters));
+
+  const int batch_size = parameters.batch_size;
+  const int block_size = parameters.block_size;
+  const int head_size = parameters.head_size;
+  const int hidden_size = parameters.hidden_size;
+  const int kv_hidden_size = parameters.kv_hidden_size;
+  const int max_blocks = parameters.max_blocks_per_sequence;
+
+  Tensor* output = context->Output(0, {static_cast<int64_t>(parameters.token_count), static_cast<int64_t>(hidden_size)});
+  Tensor* key_cache_out = context->Output(1, key_cache->Shape());
+  Tensor* value_cache_out = context->Output(2, value_cache->Shape());
+
+  Tensor* key_cache_scale_out = nullptr;
+  Tensor* value_cache_scale_out = nullptr;
+  if (parameters.is_quantized_cache) {
+    key_cache_scale_out = context->Output(3, key_cache_scale->Shape());
+    value_cache_scale_out = context->Output(4, value_cache_scale->Shape());
+    ORT_RETURN_IF_NOT(key_cache_scale_out != nullptr && value_cache_scale_out != nullptr,
+                      "Outputs 'key_cache_scale_out' and 'value_cache_scale_out' are required when the caches are int8");
+  }
+
+  // The cache is normally shared with the outputs so only the new tokens are written.
+  // Otherwise the whole pool has to be carried over first.
+  auto carry_over = [](const Tensor* input, Tensor* output) {
+    if (output != nullptr && output->MutableDataRaw() != input->DataRaw()) {
+      memcpy(output->MutableDataRaw(), input->DataRaw(), input->SizeInBytes());
+    }
+  };
+  carry_over(key_cache, key_cache_out);
+  carry_over(value_cache, value_cache_out);
+  if (parameters.is_quantized_cache) {
+    carry_over(key_cache_scale, key_cache_scale_out);
+    carry_over(value_cache_scale, value_cache_scale_out);
+  }
+
+  if (parameters.token_count == 0) {
+    return Status::OK();
+  }
+
+  const int32_t* cu_seqlens = cumulative_sequence_length->Data<int32_t>();
+  const int32_t* past = past_seqlens->Data<int32_t>();
+  const int32_t* blocks = block_table->Data<int32_t>();
+
+  const float* q_data = query->Data<float>();
+  const float* k_data;
+  const float* v_data;
+  int q_stride;
+  int kv_stride;
+  if (parameters.is_packed_qkv) {
+    q_stride = hidden_size + 2 * kv_hidden_size;
+    kv_stride = q_stride;
+    k_data = q_data + hidden_size;
+    v_data = k_data + kv_hidden_size;
+  } else {
+    q_stride = hidden_size;
+    kv_stride = kv_hidden_size;
+    k_data = key->Data<float>();
+    v_data = value->Data<float>();
+  }
+
+  const bool is_quantized_cache = parameters.is_quantized_cache;
+  float* k_cache = is_quantized_cache ? nullptr : key_cache_out->MutableData<float>();
+  float* v_cache = is_quantized_cache ? nullptr : value_cache_out->MutableData<float>();
+  int8_t* k_cache_quantized = is_quantized_cache ? key_cache_out->MutableData<int8_t>() : nullptr;
+  int8_t* v_cache_quantized = is_quantized_cache ? value_cache_out->MutableData<int8_t>() : nullptr;
+  float* k_scales = is_quantized_cache ? key_cache_scale_out->MutableData<float>() : nullptr;
+  float* v_scales = is_quantized_cache ? value_cache_scale_out->MutableData<float>() : nullptr;
+
+  auto* tp = context->GetOperatorThreadPool();
+  const size_t kv_bytes = sizeof(float) * kv_hidden_size;
+
+  // Scatter the new tokens of every sequence into the slots that follow its past tokens.
+  const double average_tokens = static_cast<double>(parameters.token_count) / batch_size;
+  ThreadPool::TryParallelFor(
+      tp, batch_size, TensorOpCost{average_tokens * 2 * kv_bytes, average_tokens * 2 * kv_bytes, 0},
+      [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+        for (std::ptrdiff_t b = begin; b != end; ++b) {
+          const int32_t* sequence_blocks = blocks + b * max_blocks;
+          for (int32_t token = cu_seqlens[b]; token < cu_seqlens[b + 1]; ++token) {
+            const int position = past[b] + token - cu_seqlens[b];
+            const ptrdiff_t slot = static_cast<ptrdiff_t>(sequence_blocks[position / block_size]) * block_size +
+                                   position % block_size;
+            const float* k_token = k_data + static_cast<ptrdiff_t>(token) * kv_stride;
+            const float* v_token = v_data + static_cast<ptrdiff_t>(token) * kv_stride;
+            if (is_quantized_cache) {
+              QuantizeToken(k_token, kv_num_heads_, head_size, k_cache_quantized + slot * kv_hidden_size,
+                            k_scales + slot * kv_num_heads_);
+              QuantizeToken(v_token, kv_num_heads_, head_size, v_cache_quantized + slot * kv_hidden_size,
+                            v_scales + slot * kv_num_heads_);
+            } else {
+              memcpy(k_cache + slot * kv_hidden_size, k_token, kv_bytes);
+              memcpy(v_cache + slot * kv_hidden_size, v_token, kv_bytes);
+            }
+          }
+        }
+      });
+
+  // Each (sequence, head) pair owns a new_length x total_length block of attention probabilities.
+  std::vector<size_t> probs_offsets(static_cast<size_t>(batch_size) + 1, 0);
+  for (int b = 0; b < batch_size; ++b) {
+    const size_t new_length = static_cast<size_t>(cu_seqlens[b + 1] - cu_seqlens[b]);
+    const size_t total_length = static_cast<size_t>(past[b]) + new_length;
+    probs_offsets[b + 1] = probs_offsets[b] + SafeInt<size_t>(new_length) * total_length * num_heads_;
+  }
+
+  AllocatorPtr allocator;
+  ORT_RETURN_IF_ERROR(context->GetTempSpaceAllocator(&allocator));
+  auto probs_buffer = IAllocator::MakeUniquePtr<float>(allocator, std::max<size_t>(probs_offsets[batch_size], 1));
+  float* attention_probs = probs_buffer.get();
+
+  const float alpha = scale_ == 0.0f ? 1.0f / std::sqrt(static_cast<float>(head_size)) : scale_;
+  const int kv_num_heads_factor = num_heads_ / kv_num_heads_;
+  float* output_data = output->MutableData<float>();
+
+  const std::ptrdiff_t loop_len = static_cast<std::ptrdiff_t>(batch_size) * num_heads_;
+  const double average_probs = static_cast<double>(probs_offsets[batch_size]) / static_cast<double>(loop_len);
+  TensorOpCost unit_cost;
+  unit_cost.compute_cycles = average_probs * 4.0 * head_size;
+  unit_cost.bytes_loaded = average_probs * sizeof(float) * 2.0;
+  unit_cost.bytes_stored = average_probs * sizeof(float) * 2.0;
+
+  ThreadPool::TryParallelFor(tp, loop_len, unit_cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+    // Rows of one head in a cache block, as a matrix with leading dimension ld. An int8 block is dequantized into
+    // dequantized_block, which stays in cache between the dequantization and the GEMM that reads it.
+    std::vector<float> dequantized_block(is_quantized_cache ? static_cast<size_t>(block_size) * head_size : 0);
+    auto get_block_head = [&](const float* cache, const int8_t* cache_quantized, const float* scales,
+                              int block_id, int kv_head_index, int n, int& ld) -> const float* {
+      const ptrdiff_t offset = static_cast<ptrdiff_t>(block_id) * block_size * kv_hidden_size +
+                               static_cast<ptrdiff_t>(kv_head_index) * head_size;
+      if (!is_quantized_cache) {
+        ld = kv_hidden_size;
+        return cache + offset;
+      }
+
+      DequantizeBlockHead(cache_quantized + offset,
+                          scales + static_cast<ptrdiff_t>(block_id) * block_size * kv_num_heads_ + kv_head_index,
+                          n, head_size, kv_hidden_size, kv_num_heads_, dequantized_block.data());
+      ld = head_size;
+      return dequantized_block.data();
+    };
+
+    for (std::ptrdiff_t i = begin; i != end; ++i) {
+      const int batch_index = static_cast<int>(i / num_heads_);
+      const int head_index = static_cast<int>(i % num_heads_);
+      const int kv_head_index = head_index / kv_num_heads_factor;
+
+      const int new_length = cu_seqlens[batch_index + 1] - cu_seqlens[batch_index];
+      if (new_length == 0) {
+        continue;
+      }
+
+      const int past_length = past[batch_index];
+      const int total_length = past_length + new_length;
+      const int num_sequence_blocks = (total_length + block_size - 1) / block_size;
+      const int32_t* sequence_blocks = blocks + static_cast<ptrdiff_t>(batch_index) * max_blocks;
+
+      float* probs = attention_probs + probs_offsets[batch_index] +
+                     static_cast<size_t>(head_index) * new_length * total_length;
+      const float* q = q_data + static_cast<ptrdiff_t>(cu_seqlens[batch_index]) * q_stride +
+                       static_cast<ptrdiff_t>(head_index) * head_size;
+
+      // Q*K' gathered block by block. Inside a block the rows of one head are kv_hidden_size apart.
+      // A: Q                S x H          lda = q_stride
+      // B: K' of a block    H x n          ldb = kv_hidden_size, or head_size when dequantized
+      // C: attention_probs  S x n          ldc = T
+      for (int block = 0; block < num_sequence_blocks; ++block) {
+        const int start = block * block_size;
+        const int n = std::min(block_size, total_length - start);
+        int ldk = 0;
+        const float* k = get_block_head(k_cache, k_cache_quantized, k_scales, sequence_blocks[block], kv_head_index,
+                                        n, ldk);
+        math::GemmEx<float, ThreadPool>(CblasNoTrans, CblasTrans, new_length, n, head_size, alpha, q, q_stride,
+                                        k, ldk, 0.0f, probs + start, total_length, nullptr);
+      }
+
+      float* probs_row = probs;
+      for (int seq = 0; seq < new_length; ++seq) {
+        const int seq_causal_length = past_length + seq + 1;
+
+        // local_window_size does not include the current query token, while window_size includes it.
+        const bool should_apply_local_window = local_window_size_ >= 0 &&
+                                               seq_causal_length > local_window_size_ + 1;
+        const int start_offset = should_apply_local_window ? seq_causal_length - local_window_size_ - 1 : 0;
+        const int window_size = should_apply_local_window ? local_window_size_ + 1 : seq_causal_length;
+
+        std::fill_n(probs_row, start_offset, 0.f);
+
+        if (softcap_ > 0.f) {
+          ComputeAttentionSoftcapInplace(probs_row + start_offset, window_size, softcap_);
+        }
+
+        if (use_smooth_softmax_) {
+          ComputeSmoothSoftmaxInplace(probs_row + start_offset, 1, window_size, nullptr);
+        } else {
+          ComputeAttentionSoftmaxInplace(probs_row + start_offset, 1, window_size, nullptr);
+        }
+
+        std::fill(probs_row + seq_causal_length, probs_row + total_length, 0.f);
+        probs_row += total_length;
+      }
+
+      // Probs*V accumulated block by block straight into the token-major output.
+      float* output_current = output_data + static_cast<ptrdiff_t>(cu_seqlens[batch_index]) * hidden_size +
+                              static_cast<ptrdiff_t>(head_index) * head_size;
+      for (int block = 0; block < num_sequence_blocks; ++block) {
+        const int start = block * block_size;
+        const int n = std::min(block_size, total_length - start);
+        int ldv = 0;
+        const float* v = get_block_head(v_cache, v_cache_quantized, v_scales, sequence_blocks[block], kv_head_index,
+                                        n, ldv);
+        math::GemmEx<float, ThreadPool>(CblasNoTrans, CblasNoTrans, new_length, head_size, n, 1.0f,
+                                        probs + start, total_length, v, ldv, block == 0 ? 0.0f : 1.0f,
+                                        output_current, hidden_size, nullptr);
+      }
+    }
+  });
+
+  return Status::OK();
+}
+
+}  // namespace contrib
+}  // namespace onnxruntime
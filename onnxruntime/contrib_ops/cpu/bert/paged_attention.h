@@ -0,0 +1,26 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "core/common/common.h"
+#include "core/framework/op_kernel.h"
+#include "gqa_attention_base.h"
+
+namespace onnxruntime {
+namespace contrib {
+
+/**
+ * @brief Group query attention over a paged KV cache.
+ * Key and value caches are pools of fixed-size blocks. Each sequence owns the blocks listed in its row of
+ * block_table, so sequences with different lengths are packed token-major without any padding.
+ * The caches can be int8 with a float scale per token and kv head, which are dequantized block by block.
+ */
+class PagedAttention final : public OpKernel, public GQAAttentionBase {
+ public:
+  PagedAttention(const OpKernelInfo& info);
+  Status Compute(OpKernelContext* context) const override;
+};
+
+}  // namespace contrib
+}  // namespace onnxruntime
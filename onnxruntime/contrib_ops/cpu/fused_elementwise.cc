@@ -0,0 +1,244 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "contrib_ops/cpu/fused_elementwise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+
+#include "core/common/narrow.h"
+#include "core/mlas/inc/mlas.h"
+#include "core/platform/threadpool.h"
+#include "core/providers/common.h"
+
+namespace onnxruntime {
+namespace contrib {
+
+ONNX_OPERATOR_KERNEL_EX(
+    FusedElementwise,
+    kMSDomain,
+    1,
+    kCpuExecutionProvider,
+    KernelDefBuilder()
+        .TypeConstraint("T", DataTypeImpl::GetTensorType<float>()),
+    FusedElementwise);
+
+namespace {
+
+using OpCode = FusedElementwise::OpCode;
+
+constexpr std::pair<const char*, OpCode> kOpCodes[] = {
+    {"Add", OpCode::Add},
+    {"Sub", OpCode::Sub},
+    {"Mul", OpCode::Mul},
+    {"Div", OpCode::Div},
+    {"Sigmoid", OpCode::Sigmoid},
+    {"Tanh", OpCode::Tanh},
+    {"Exp", OpCode::Exp},
+    {"Relu", OpCode::Relu},
+    {"Neg", OpCode::Neg},
+    {"Abs", OpCode::Abs},
+    {"Sqrt", OpCode::Sqrt},
+    {"Erf", OpCode::Erf},
+};
+
+// Number of output elements evaluated at once. Each instruction needs a buffer of this size, so the buffers of a
+// typical chain fit in the L1 or L2 cache.
+constexpr size_t kBlockSize = 1024;
+
+bool IsBinary(OpCode op) {
+  return op == OpCode::Add || op == OpCode::Sub || op == OpCode::Mul || op == OpCode::Div;
+}
+
+template <typename Op>
+void ApplyBinary(const float* a, const float* b, float* y, size_t n, Op op) {
+  for (size_t i = 0; i < n; ++i) {
+    y[i] = op(a[i], b[i]);
+  }
+}
+
+template <typename Op>
+void ApplyUnary(const float* x, float* y, size_t n, Op op) {
+  for (size_t i = 0; i < n; ++i) {
+    y[i] = op(x[i]);
+  }
+}
+
+// The transcendental functions use the same MLAS routines as the standalone CPU kernels, so the fused result
+// matches the unfused graph.
+void Apply(OpCode op, const float* a, const float* b, float* y, size_t n) {
+  switch (op) {
+    case OpCode::Add:
+      ApplyBinary(a, b, y, n, [](float l, float r) { return l + r; });
+      break;
+    case OpCode::Sub:
+      ApplyBinary(a, b, y, n, [](float l, float r) { return l - r; });
+      break;
+    case OpCode::Mul:
+      ApplyBinary(a, b, y, n, [](float l, float r) { return l * r; });
+      break;
+    case OpCode::Div:
+      ApplyBinary(a, b, y, n, [](float l, float r) { return l / r; });
+      break;
+    case OpCode::Sigmoid:
+      MlasComputeLogistic(a, y, n);
+      break;
+    case OpCode::Tanh:
+      MlasComputeTanh(a, y, n);
+      break;
+    case OpCode::Exp:
+      MlasComputeExp(a, y, n);
+      break;
+    case OpCode::Erf:
+      MlasComputeErf(a, y, n);
+      break;
+    case OpCode::Relu:
+      ApplyUnary(a, y, n, [](float x) { return std::max(x, 0.f); });
+      break;
+    case OpCode::Neg:
+      ApplyUnary(a, y, n, [](float x) { return -x; });
+      break;
+    case OpCode::Abs:
+      ApplyUnary(a, y, n, [](float x) { return std::abs(x); });
+      break;
+    case OpCode::Sqrt:
+      ApplyUnary(a, y, n, [](float x) { return std::sqrt(x); });
+      break;
+  }
+}
+
+}  // namespace
+
+FusedElementwise::FusedElementwise(const OpKernelInfo& info)
+    : OpKernel(info), num_inputs_(info.GetInputCount()) {
+  std::vector<std::string> op_types;
+  ORT_ENFORCE(info.GetAttrs<std::string>("op_types", op_types).IsOK() && !op_types.empty(),
+              "FusedElementwise requires at least one entry in 'op_types'.");
+  const std::vector<int64_t> operands = info.GetAttrsOrDefault<int64_t>("operands");
+  ORT_ENFORCE(operands.size() == 2 * op_types.size(),
+              "'operands' must have two entries per instruction. Got ", operands.size(), " for ",
+              op_types.size(), " instructions.");
+
+  instructions_.reserve(op_types.size());
+  for (size_t i = 0; i < op_types.size(); ++i) {
+    const auto* entry = std::find_if(std::begin(kOpCodes), std::end(kOpCodes),
+                                     [&](const auto& op_code) { return op_types[i] == op_code.first; });
+    ORT_ENFORCE(entry != std::end(kOpCodes), "Unsupported op type in FusedElementwise: ", op_types[i]);
+
+    // Operands may only refer to the inputs and to the results of earlier instructions.
+    const int64_t num_values = static_cast<int64_t>(num_inputs_ + i);
+    const int64_t lhs = operands[2 * i];
+    const int64_t rhs = operands[2 * i + 1];
+    const bool binary = IsBinary(entry->second);
+    ORT_ENFORCE(lhs >= 0 && lhs < num_values && (!binary || (rhs >= 0 && rhs < num_values)),
+                "Invalid operands for instruction ", i, " of FusedElementwise: ", lhs, ", ", rhs);
+
+    instructions_.push_back({entry->second, static_cast<size_t>(lhs), binary ? static_cast<size_t>(rhs) : 0});
+  }
+}
+
+Status FusedElementwise::Compute(OpKernelContext* context) const {
+  const int num_inputs = context->InputCount();
+  ORT_RETURN_IF_NOT(static_cast<size_t>(num_inputs) == num_inputs_, "Expected ", num_inputs_, " inputs. Got ",
+                    num_inputs);
+
+  TensorShape output_shape = context->Input<Tensor>(0)->Shape();
+  for (int i = 1; i < num_inputs; ++i) {
+    ORT_RETURN_IF_ERROR(ComputeBroadcastOutputShape(Node().Name(), output_shape,
+                                                    context->Input<Tensor>(i)->Shape(), output_shape));
+  }
+
+  // Each input is repeated along the leading dimensions of the output, so element j of the output reads element
+  // (j % period) of the input.
+  const auto output_dims = output_shape.GetDims();
+  std::vector<const float*> input_data(num_inputs_);
+  std::vector<size_t> periods(num_inputs_);
+  for (size_t i = 0; i < num_inputs_; ++i) {
+    const Tensor& input = *context->Input<Tensor>(static_cast<int>(i));
+    auto dims = input.Shape().GetDims();
+    while (!dims.empty() && dims.front() == 1) {
+      dims = dims.subspan(1);
+    }
+
+    if (!std::equal(dims.begin(), dims.end(), output_dims.end() - static_cast<std::ptrdiff_t>(dims.size()))) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "Input ", i, " of FusedElementwise with shape ",
+                             input.Shape(), " must match the trailing dimensions of the output shape ",
+                             output_shape);
+    }
+
+    input_data[i] = input.Data<float>();
+    periods[i] = narrow<size_t>(input.Shape().Size());
+  }
+
+  Tensor& output = *context->Output(0, output_shape);
+  const size_t total = narrow<size_t>(output_shape.Size());
+  if (total == 0) {
+    return Status::OK();
+  }
+
+  float* output_data = output.MutableData<float>();
+  const size_t num_instructions = instructions_.size();
+  const std::ptrdiff_t num_blocks = static_cast<std::ptrdiff_t>((total + kBlockSize - 1) / kBlockSize);
+
+  auto process_blocks = [&](std::ptrdiff_t first, std::ptrdiff_t last) {
+    // One buffer per input that is not read in place and one per instruction except the last, which writes to the
+    // output directly.
+    std::vector<float> scratch((num_inputs_ + num_instructions) * kBlockSize);
+    std::vector<const float*> values(num_inputs_ + num_instructions);
+
+    for (size_t i = 0; i < num_inputs_; ++i) {
+      if (periods[i] == 1) {
+        std::fill_n(scratch.data() + i * kBlockSize, kBlockSize, input_data[i][0]);
+      }
+    }
+
+    for (std::ptrdiff_t block = first; block < last; ++block) {
+      const size_t start = static_cast<size_t>(block) * kBlockSize;
+      const size_t count = std::min(kBlockSize, total - start);
+
+      for (size_t i = 0; i < num_inputs_; ++i) {
+        const size_t period = periods[i];
+        const size_t offset = start % period;
+        float* buffer = scratch.data() + i * kBlockSize;
+        if (period == 1) {
+          values[i] = buffer;
+        } else if (offset + count <= period) {
+          values[i] = input_data[i] + offset;
+        } else {
+          // The block wraps around the end of the input, so gather the repeated rows.
+          size_t copied = 0;
+          size_t position = offset;
+          while (copied < count) {
+            const size_t run = std::min(period - position, count - copied);
+            std::copy_n(input_data[i] + position, run, buffer + copied);
+            copied += run;
+            position = 0;
+          }
+          values[i] = buffer;
+        }
+      }
+
+      for (size_t i = 0; i < num_instructions; ++i) {
+        const Instruction& instruction = instructions_[i];
+        float* result = i + 1 == num_instructions ? output_data + start
+                                                  : scratch.data() + (num_inputs_ + i) * kBlockSize;
+        Apply(instruction.op, values[instruction.lhs], values[instruction.rhs], result, count);
+        values[num_inputs_ + i] = result;
+      }
+    }
+  };
+
+  const double block_bytes = static_cast<double>(kBlockSize * sizeof(float));
+  concurrency::ThreadPool::TryParallelFor(
+      context->GetOperatorThreadPool(), num_blocks,
+      TensorOpCost{block_bytes * static_cast<double>(num_inputs_), block_bytes,
+                   static_cast<double>(kBlockSize * num_instructions) * 4.0},
+      process_blocks);
+
+  return Status::OK();
+}
+
+}  // namespace contrib
+}  // namespace onnxruntime
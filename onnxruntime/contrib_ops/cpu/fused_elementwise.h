@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <vector>
+
+#include "core/common/common.h"
+#include "core/framework/op_kernel.h"
+
+namespace onnxruntime {
+namespace contrib {
+
+/**
+ * @brief Evaluates a chain of float elementwise operators, as produced by ElementwiseChainFusion.
+ * The output is computed in cache sized blocks. Every instruction of the chain is applied to a block before moving on
+ * to the next one, so intermediate results stay in cache instead of being written out as full tensors.
+ */
+class FusedElementwise final : public OpKernel {
+ public:
+  FusedElementwise(const OpKernelInfo& info);
+
+  Status Compute(OpKernelContext* context) const override;
+
+  enum class OpCode {
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Sigmoid,
+    Tanh,
+    Exp,
+    Relu,
+    Neg,
+    Abs,
+    Sqrt,
+    Erf,
+  };
+
+ private:
+  struct Instruction {
+    OpCode op;
+    size_t lhs;  // operand index: an input, or num_inputs_ + index of an earlier instruction
+    size_t rhs;  // unused for unary operators
+  };
+
+  size_t num_inputs_;
+  std::vector<Instruction> instructions_;
+};
+
+}  // namespace contrib
+}  // namespace onnxruntime
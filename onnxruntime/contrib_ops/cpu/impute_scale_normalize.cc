@@ -0,0 +1,170 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "contrib_ops/cpu/impute_scale_normalize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "core/common/narrow.h"
+#include "core/platform/threadpool.h"
+
+namespace onnxruntime {
+namespace contrib {
+
+ONNX_OPERATOR_KERNEL_EX(
+    ImputeScaleNormalize,
+    kMSDomain,
+    1,
+    kCpuExecutionProvider,
+    KernelDefBuilder()
+        .TypeConstraint("T", DataTypeImpl::GetTensorType<float>())
+        .MayInplace(0, 0),
+    ImputeScaleNormalize);
+
+ImputeScaleNormalize::ImputeScaleNormalize(const OpKernelInfo& info)
+    : OpKernel(info),
+      imputed_values_(info.GetAttrsOrDefault<float>("imputed_values")),
+      replaced_value_(info.GetAttrOrDefault<float>("replaced_value", 0.f)),
+      offset_(info.GetAttrsOrDefault<float>("offset")),
+      scale_(info.GetAttrsOrDefault<float>("scale")) {
+  ORT_ENFORCE(scale_.size() == offset_.size(),
+              "Scale size: (", scale_.size(), ") != offset size: (", offset_.size(), ")");
+
+  std::string norm;
+  if (info.GetAttr<std::string>("norm", &norm).IsOK()) {
+    norm_ = ml::MakeNormalize(norm);
+    has_norm_ = true;
+  }
+}
+
+namespace {
+
+// Normalizes one row in place. Matches the arithmetic of the ai.onnx.ml Normalizer kernel.
+void NormalizeRow(ml::NORMALIZE norm, float* y, size_t size) {
+  switch (norm) {
+    case ml::NORMALIZE::NMAX: {
+      float max = std::numeric_limits<float>::lowest();
+      for (size_t i = 0; i < size; ++i) {
+        max = std::max(max, y[i]);
+      }
+      if (max != 0.f) {
+        for (size_t i = 0; i < size; ++i) {
+          y[i] /= max;
+        }
+      }
+      break;
+    }
+    case ml::NORMALIZE::L1: {
+      float sum = 0.f;
+      for (size_t i = 0; i < size; ++i) {
+        sum += std::abs(y[i]);
+      }
+      if (sum != 0.f) {
+        for (size_t i = 0; i < size; ++i) {
+          y[i] /= sum;
+        }
+      }
+      break;
+    }
+    case ml::NORMALIZE::L2: {
+      float sum = 0.f;
+      for (size_t i = 0; i < size; ++i) {
+        sum += y[i] * y[i];
+      }
+      if (sum != 0.f) {
+        for (size_t i = 0; i < size; ++i) {
+          const float x = y[i];
+          const float value = std::sqrt((x * x) / sum);
+          y[i] = x < 0 ? -value : value;
+        }
+      }
+      break;
+    }
+  }
+}
+
+}  // namespace
+
+Status ImputeScaleNormalize::Compute(OpKernelContext* context) const {
+  const Tensor& X = *context->Input<Tensor>(0);
+  const TensorShape& x_shape = X.Shape();
+  const size_t rank = x_shape.NumDimensions();
+  if (rank == 0 || rank > 2) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input of ImputeScaleNormalize must have rank 1 or 2. Got ", rank);
+  }
+
+  const size_t num_rows = rank == 1 ? 1 : narrow<size_t>(x_shape[0]);
+  const size_t row_size = narrow<size_t>(rank == 1 ? x_shape[0] : x_shape[1]);
+
+  // Imputer uses per-feature values when the sizes line up and the first value otherwise.
+  const bool has_imputer = !imputed_values_.empty();
+  const size_t imputed_step = imputed_values_.size() == row_size ? 1 : 0;
+
+  const bool has_scaler = !scale_.empty();
+  size_t scale_step = 0;
+  if (has_scaler) {
+    if (scale_.size() == row_size) {
+      scale_step = 1;
+    } else if (scale_.size() != 1) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "Either both scale and offset can be of feature size (", row_size, ") or 1");
+    }
+  }
+
+  Tensor* Y = context->Output(0, x_shape);
+  if (x_shape.Size() == 0) {
+    return Status::OK();
+  }
+
+  const float* x_data = X.Data<float>();
+  float* y_data = Y->MutableData<float>();
+  const bool replaced_is_nan = std::isnan(replaced_value_);
+
+  auto process_rows = [&](std::ptrdiff_t first, std::ptrdiff_t last) {
+    for (std::ptrdiff_t row = first; row < last; ++row) {
+      const size_t offset_in_tensor = static_cast<size_t>(row) * row_size;
+      const float* x = x_data + offset_in_tensor;
+      float* y = y_data + offset_in_tensor;
+
+      if (has_imputer) {
+        const float* imputed = imputed_values_.data();
+        for (size_t i = 0; i < row_size; ++i) {
+          const bool replace = replaced_is_nan ? std::isnan(x[i]) : x[i] == replaced_value_;
+          y[i] = replace ? imputed[i * imputed_step] : x[i];
+        }
+        x = y;
+      }
+
+      if (has_scaler) {
+        const float* offset = offset_.data();
+        const float* scale = scale_.data();
+        for (size_t i = 0; i < row_size; ++i) {
+          y[i] = (x[i] - offset[i * scale_step]) * scale[i * scale_step];
+        }
+        x = y;
+      }
+
+      if (x != y) {
+        std::copy_n(x, row_size, y);
+      }
+
+      if (has_norm_) {
+        NormalizeRow(norm_, y, row_size);
+      }
+    }
+  };
+
+  const double row_bytes = static_cast<double>(row_size * sizeof(float));
+  concurrency::ThreadPool::TryParallelFor(
+      context->GetOperatorThreadPool(), static_cast<std::ptrdiff_t>(num_rows),
+      TensorOpCost{row_bytes, row_bytes, static_cast<double>(row_size) * 4.0},
+      process_rows);
+
+  return Status::OK();
+}
+
+}  // namespace contrib
+}  // namespace onnxruntime
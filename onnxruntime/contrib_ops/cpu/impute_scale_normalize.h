@@ -0,0 +1,35 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <vector>
+
+#include "core/common/common.h"
+#include "core/framework/op_kernel.h"
+#include "core/providers/cpu/ml/ml_common.h"
+
+namespace onnxruntime {
+namespace contrib {
+
+/**
+ * @brief Fused ai.onnx.ml Imputer -> Scaler -> Normalizer chain over a [N, C] or [C] float tensor.
+ * Each stage is optional. Every row is processed in a single pass, which produces the same values as the unfused ops.
+ */
+class ImputeScaleNormalize final : public OpKernel {
+ public:
+  ImputeScaleNormalize(const OpKernelInfo& info);
+
+  Status Compute(OpKernelContext* context) const override;
+
+ private:
+  std::vector<float> imputed_values_;
+  float replaced_value_{0.f};
+  std::vector<float> offset_;
+  std::vector<float> scale_;
+  bool has_norm_{false};
+  ml::NORMALIZE norm_{ml::NORMALIZE::NMAX};
+};
+
+}  // namespace contrib
+}  // namespace onnxruntime
@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include "nchwc_ops.h"
+#include <algorithm>
 #include "core/common/narrow.h"
 #include "core/common/safeint.h"
 #include "core/mlas/inc/mlas.h"
@@ -377,6 +378,127 @@ Status NchwcUpsample::Compute(OpKernelContext* context) const {
   return Status::OK();
 }
 
+std::vector<int64_t> NchwcPad::ComputeSourceIndices(int64_t input_length,
+                                                    int64_t output_length,
+                                                    int64_t pad_begin) const {
+  // Map each output index to the input index it copies from, or -1 if the
+  // output is filled with the constant value.
+  std::vector<int64_t> source_indices(narrow<size_t>(output_length));
+
+  for (int64_t o = 0; o < output_length; o++) {
+    int64_t i = o - pad_begin;
+    if (i < 0 || i >= input_length) {
+      if (mode_ == Mode::CONSTANT) {
+        i = -1;
+      } else if (mode_ == Mode::EDGE) {
+        i = std::clamp<int64_t>(i, 0, input_length - 1);
+      } else {
+        // Mode::REFLECT, where the pads are smaller than the input length.
+        i = (i < 0) ? -i : 2 * (input_length - 1) - i;
+      }
+    }
+    source_indices[narrow<size_t>(o)] = i;
+  }
+
+  return source_indices;
+}
+
+Status NchwcPad::Compute(OpKernelContext* context) const {
+  const auto* X = context->Input<Tensor>(0);
+  const auto X_shape = X->Shape().GetDims();
+  ORT_ENFORCE(X_shape.size() == 4);
+  ORT_ENFORCE((X_shape[1] % MlasNchwcGetBlockSize()) == 0);
+
+  const int64_t batch_count = X_shape[0];
+  const int64_t nchwc_channels = X_shape[1];
+
+  const int64_t input_h = X_shape[2];
+  const int64_t input_w = X_shape[3];
+
+  const int64_t output_h = input_h + pads_[0] + pads_[2];
+  const int64_t output_w = input_w + pads_[1] + pads_[3];
+
+  if (mode_ == Mode::REFLECT) {
+    // Zero pads of an empty dimension are allowed.
+    const int64_t max_pad_h = std::max<int64_t>(input_h, 1) - 1;
+    const int64_t max_pad_w = std::max<int64_t>(input_w, 1) - 1;
+    ORT_RETURN_IF(pads_[0] > max_pad_h || pads_[2] > max_pad_h || pads_[1] > max_pad_w || pads_[3] > max_pad_w,
+                  "Pads must be smaller than the spatial dimensions in reflect mode.");
+  } else if (mode_ == Mode::EDGE) {
+    ORT_RETURN_IF((input_h == 0 && output_h != 0) || (input_w == 0 && output_w != 0),
+                  "Cannot pad an empty spatial dimension in edge mode.");
+  }
+
+  auto* Y = context->Output(0, {batch_count, nchwc_channels, output_h, output_w});
+
+  // Bail out early if one of the dimensions is zero.
+  if (Y->Shape().Size() == 0) {
+    return Status::OK();
+  }
+
+  const auto source_h = ComputeSourceIndices(input_h, output_h, pads_[0]);
+  const auto source_w = ComputeSourceIndices(input_w, output_w, pads_[1]);
+
+  const auto* x_data = X->Data<float>();
+  auto* y_data = Y->MutableData<float>();
+
+  const int64_t nchwc_block_size = static_cast<int64_t>(MlasNchwcGetBlockSize());
+  const ptrdiff_t total_work = ((SafeInt<ptrdiff_t>(batch_count) * nchwc_channels) / nchwc_block_size) * output_h;
+  // Partition the work with the goal of generating the following number of
+  // elements, so that operations involving a smaller number of columns will
+  // process more rows per worker.
+  constexpr ptrdiff_t worker_goal = 16 * 1024;
+  ptrdiff_t work_per_worker = std::max<ptrdiff_t>(worker_goal / (SafeInt<ptrdiff_t>(output_w) * nchwc_block_size), 1);
+  ptrdiff_t worker_count = std::max<ptrdiff_t>(total_work / work_per_worker, 1);
+
+  auto pad_worker = [&](ptrdiff_t batch) {
+    auto work = concurrency::ThreadPool::PartitionWork(batch, worker_count, total_work);
+
+    for (int64_t work_index = work.start; work_index < static_cast<int64_t>(work.end); work_index++) {
+      const int64_t channel_index = work_index / output_h;
+      const int64_t row_index = work_index % output_h;
+
+      auto* y_row = y_data + (work_index * output_w * nchwc_block_size);
+      const int64_t input_row_index = source_h[narrow<size_t>(row_index)];
+      if (input_row_index < 0) {
+        std::fill_n(y_row, output_w * nchwc_block_size, value_);
+        continue;
+      }
+
+      const auto* x_row = x_data + (((channel_index * input_h) + input_row_index) * input_w * nchwc_block_size);
+
+      auto pad_column = [&](int64_t column_index) {
+        auto* y_block = y_row + (column_index * nchwc_block_size);
+        const int64_t input_column_index = source_w[narrow<size_t>(column_index)];
+        if (input_column_index < 0) {
+          std::fill_n(y_block, nchwc_block_size, value_);
+        } else {
+          std::copy_n(x_row + (input_column_index * nchwc_block_size), nchwc_block_size, y_block);
+        }
+      };
+
+      for (int64_t column_index = 0; column_index < pads_[1]; column_index++) {
+        pad_column(column_index);
+      }
+      std::copy_n(x_row, input_w * nchwc_block_size, y_row + (pads_[1] * nchwc_block_size));
+      for (int64_t column_index = pads_[1] + input_w; column_index < output_w; column_index++) {
+        pad_column(column_index);
+      }
+    }
+  };
+
+  concurrency::ThreadPool* thread_pool = context->GetOperatorThreadPool();
+
+  // Handle the work in a single batch if only a single thread is available.
+  if (concurrency::ThreadPool::DegreeOfParallelism(thread_pool) == 1) {
+    worker_count = 1;
+  }
+
+  concurrency::ThreadPool::TrySimpleParallelFor(thread_pool, worker_count, pad_worker);
+
+  return Status::OK();
+}
+
 #define ONNX_CPU_OPERATOR_TYPED_NCHWC_KERNEL(name, ver, type, builder, ...) \
   ONNX_OPERATOR_TYPED_KERNEL_EX(name, kMSNchwcDomain, ver, type, kCpuExecutionProvider, builder, __VA_ARGS__)
 
@@ -445,5 +567,13 @@ ONNX_CPU_OPERATOR_TYPED_NCHWC_KERNEL(
         .TypeConstraint("T", DataTypeImpl::GetTensorType<float>()),
     NchwcUpsample);
 
+ONNX_CPU_OPERATOR_TYPED_NCHWC_KERNEL(
+    Pad,
+    1,
+    float,
+    KernelDefBuilder()
+        .TypeConstraint("T", DataTypeImpl::GetTensorType<float>()),
+    NchwcPad);
+
 }  // namespace contrib
 }  // namespace onnxruntime
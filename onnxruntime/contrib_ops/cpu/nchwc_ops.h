@@ -131,5 +131,46 @@ class NchwcUpsample final : public OpKernel {
   bool nearest_mode_;
 };
 
+class NchwcPad final : public OpKernel {
+ private:
+  enum class Mode {
+    CONSTANT,
+    REFLECT,
+    EDGE,
+  };
+
+ public:
+  NchwcPad(const OpKernelInfo& info) : OpKernel(info) {
+    // The pads are ordered as [top, left, bottom, right].
+    ORT_ENFORCE(info.GetAttrs("pads", pads_).IsOK());
+    ORT_ENFORCE(pads_.size() == 4);
+    ORT_ENFORCE(pads_[0] >= 0 && pads_[1] >= 0 && pads_[2] >= 0 && pads_[3] >= 0, "negative pads are not supported");
+
+    const std::string mode = info.GetAttrOrDefault<std::string>("mode", "constant");
+    if (mode == "constant") {
+      mode_ = Mode::CONSTANT;
+    } else if (mode == "reflect") {
+      mode_ = Mode::REFLECT;
+    } else if (mode == "edge") {
+      mode_ = Mode::EDGE;
+    } else {
+      ORT_THROW("Unsupported mode '" + mode + "' for NCHWc Pad");
+    }
+
+    value_ = info.GetAttrOrDefault<float>("value", 0.0f);
+  }
+
+  Status Compute(OpKernelContext* context) const override;
+
+ private:
+  std::vector<int64_t> ComputeSourceIndices(int64_t input_length,
+                                            int64_t output_length,
+                                            int64_t pad_begin) const;
+
+  TensorShapeVector pads_;
+  Mode mode_;
+  float value_;
+};
+
 }  // namespace contrib
 }  // namespace onnxruntime
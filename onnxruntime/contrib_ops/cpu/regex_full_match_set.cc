@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "contrib_ops/cpu/regex_full_match_set.h"
+
+#include <algorithm>
+
+#include "core/platform/threadpool.h"
+
+namespace onnxruntime {
+namespace contrib {
+
+ONNX_OPERATOR_KERNEL_EX(
+    RegexFullMatchSet,
+    kMSDomain,
+    1,
+    kCpuExecutionProvider,
+    KernelDefBuilder()
+        .TypeConstraint("T1", DataTypeImpl::GetTensorType<std::string>())
+        .TypeConstraint("T2", DataTypeImpl::GetTensorType<bool>()),
+    RegexFullMatchSet);
+
+RegexFullMatchSet::RegexFullMatchSet(const OpKernelInfo& info)
+    : OpKernel(info), set_{RE2::Options(), RE2::ANCHOR_BOTH} {
+  const auto patterns = info.GetAttrs<std::string>("patterns");
+  ORT_ENFORCE(!patterns.empty(), "At least one pattern is required.");
+  ORT_ENFORCE(patterns.size() == info.GetOutputCount(),
+              "Number of patterns (", patterns.size(), ") must match the number of outputs (",
+              info.GetOutputCount(), ")");
+
+  res_.reserve(patterns.size());
+  filters_.reserve(patterns.size());
+  for (const auto& pattern : patterns) {
+    auto re = std::make_unique<RE2>(pattern);
+    ORT_ENFORCE(re->ok(), "Invalid regex pattern: ", pattern);
+    std::string error;
+    ORT_ENFORCE(set_.Add(pattern, &error) >= 0, "Invalid regex pattern: ", pattern, " ", error);
+    filters_.emplace_back(*re);
+    res_.push_back(std::move(re));
+  }
+  ORT_ENFORCE(set_.Compile(), "Failed to compile the regex set.");
+}
+
+Status RegexFullMatchSet::Compute(OpKernelContext* context) const {
+  const auto* input_tensor = context->Input<Tensor>(0);
+  const auto input_data = input_tensor->DataAsSpan<std::string>();
+  const size_t num_patterns = res_.size();
+
+  InlinedVector<bool*> outputs(num_patterns);
+  for (size_t p = 0; p < num_patterns; ++p) {
+    outputs[p] = context->Output(static_cast<int>(p), input_tensor->Shape())->MutableData<bool>();
+  }
+
+  concurrency::ThreadPool::TryParallelFor(
+      context->GetOperatorThreadPool(), static_cast<std::ptrdiff_t>(input_data.size()),
+      TensorOpCost{static_cast<double>(sizeof(std::string)), static_cast<double>(num_patterns),
+                   regex_full_match::kMatchCostCycles},
+      [&](std::ptrdiff_t first, std::ptrdiff_t last) {
+        std::vector<int> matches;
+        for (auto i = static_cast<size_t>(first), end = static_cast<size_t>(last); i < end; ++i) {
+          const std::string& s = input_data[i];
+          for (size_t p = 0; p < num_patterns; ++p) {
+            outputs[p][i] = false;
+          }
+
+          if (std::none_of(filters_.begin(), filters_.end(),
+                           [&s](const regex_full_match::MatchRangeFilter& filter) { return filter.MayMatch(s); })) {
+            continue;
+          }
+
+          RE2::Set::ErrorInfo error_info;
+          if (set_.Match(s, &matches, &error_info)) {
+            for (int p : matches) {
+              outputs[static_cast<size_t>(p)][i] = true;
+            }
+          } else if (error_info.kind != RE2::Set::kNoError) {
+            for (size_t p = 0; p < num_patterns; ++p) {
+              outputs[p][i] = RE2::FullMatch(s, *res_[p]);
+            }
+          }
+        }
+      });
+
+  return Status::OK();
+}
+
+}  // namespace contrib
+}  // namespace onnxruntime
@@ -0,0 +1,35 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "core/common/common.h"
+#include "core/framework/op_kernel.h"
+#include "core/providers/cpu/text/regex_full_match.h"
+#include "re2/set.h"
+
+namespace onnxruntime {
+namespace contrib {
+
+/**
+ * @brief Full matches a string tensor against several patterns with one RE2::Set scan per element.
+ * Created by RegexFullMatchSetFusion from RegexFullMatch nodes that share an input.
+ */
+class RegexFullMatchSet final : public OpKernel {
+ public:
+  explicit RegexFullMatchSet(const OpKernelInfo& info);
+
+  Status Compute(OpKernelContext* context) const override;
+
+ private:
+  RE2::Set set_;
+  // Individual patterns are kept for the range filters and as a fallback if the RE2::Set DFA runs out of memory.
+  std::vector<std::unique_ptr<RE2>> res_;
+  std::vector<regex_full_match::MatchRangeFilter> filters_;
+};
+
+}  // namespace contrib
+}  // namespace onnxruntime
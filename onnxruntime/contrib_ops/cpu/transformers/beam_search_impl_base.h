@@ -92,6 +92,11 @@ struct BeamSearchCpuState : IBeamSearchCpuState {
     sequences_space = AllocateBuffer<int32_t>(allocator, sequences_space_buffer_, sequences_bytes, stream, true /* fill */);
     sequences.Init(sequences_space, batch_beam_size_, parameters.sequence_length, parameters.max_length);
 
+    if (!is_cuda) {
+      // Logits processors run on CPU, where tokens are appended to the sequences.
+      sequences.InitIndex(parameters);
+    }
+
     if (is_cuda) {
       // buffers used by CUDA operator but not by CPU operator.
       topk_scores = AllocateBuffer<float>(allocator, topk_scores_buffer_, 2 * static_cast<size_t>(batch_beam_size_), stream);
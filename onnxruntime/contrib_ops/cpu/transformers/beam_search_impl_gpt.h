@@ -366,7 +366,7 @@ Status BeamSearchGpt<T>::Execute(const FeedsFetchesManager* init_run_feeds_fetch
       ORT_RETURN_IF_ERROR(UpdateFeeds(fetches, feeds, current_length,
                                       position_ids, increase_position,
                                       ReinterpretAsSpan<const int32_t>(beam_next_tokens),
-                                      gpt_subgraph_.has_decoder_masked_attention_
+                                      gpt_subgraph_.has_decoder_masked_attention_ && this->IsCuda()
                                           ? place_holder
                                           : ReinterpretAsSpan<const int32_t>(this->beam_scorer_->GetNextIndicesCPU()),
                                       gpt_subgraph_.has_decoder_masked_attention_
@@ -6,8 +6,9 @@
 #include <memory>
 #include "core/providers/cpu/math/top_k.h"
 #include "core/providers/cpu/math/softmax_shared.h"
-#include "core/providers/cpu/generator/random.h"
 #include "core/common/safeint.h"
+#include "core/mlas/inc/mlas.h"
+#include "core/platform/threadpool.h"
 #include <gsl/gsl>
 #include "contrib_ops/cpu/transformers/sequences.h"
 #include "contrib_ops/cpu/transformers/beam_search_scorer.h"
@@ -277,6 +278,118 @@ void InitGreedyState(transformers::IGreedySearchState<T>* greedy_state,
   gsl::copy(sequence_lengths, greedy_state->next_positions);
 }
 
+namespace {
+
+// Candidate token for top-k selection. Ties prefer the lower index, like the TopK operator.
+struct ScoredIndex {
+  float score;
+  int64_t index;
+};
+
+bool IsBetter(const ScoredIndex& a, const ScoredIndex& b) {
+  return a.score > b.score || (a.score == b.score && a.index < b.index);
+}
+
+// Adds a candidate to a heap holding the best k candidates, with the worst one at the front.
+// Candidates must come in increasing index order, so a tie with the front never replaces it.
+inline void PushTopK(std::vector<ScoredIndex>& heap, size_t k, float score, int64_t index) {
+  if (heap.size() < k) {
+    heap.push_back({score, index});
+    std::push_heap(heap.begin(), heap.end(), IsBetter);
+  } else if (score > heap.front().score) {
+    std::pop_heap(heap.begin(), heap.end(), IsBetter);
+    heap.back() = {score, index};
+    std::push_heap(heap.begin(), heap.end(), IsBetter);
+  }
+}
+
+// Fused version of the log-softmax, logits processors, beam scores and top-k steps of ProcessLogits.
+// Log-softmax reads the last token of logits directly, and the element-wise logits processors, beam scores, the copy
+// to the scores output and top-k selection of each row are done in one sweep. Each row keeps its best 2 * num_beams
+// tokens, which contain the best 2 * num_beams tokens of its batch.
+void FusedProcessLogits(const float* logits_data,
+                        int64_t input_length,
+                        int64_t logits_batch_size,
+                        transformers::IBeamSearchState<float>* beam_state,
+                        transformers::ISequences* sequences,
+                        onnxruntime::concurrency::ThreadPool* thread_pool,
+                        transformers::LogitsProcessorList* logits_processors,
+                        const transformers::IGenerationParameters* parameters,
+                        int step) {
+  const int batch_size = parameters->batch_size;
+  const int num_beams = parameters->num_beams;
+  const int batch_beam_size = batch_size * num_beams;
+  const size_t vocab_size = static_cast<size_t>(parameters->vocab_size);
+  const size_t top_k = static_cast<size_t>(2 * num_beams);
+  const double row_bytes = static_cast<double>(vocab_size * sizeof(float));
+
+  gsl::span<float>& next_token_scores = beam_state->next_token_scores;
+  concurrency::ThreadPool::TryParallelFor(
+      thread_pool, batch_beam_size, TensorOpCost{row_bytes, row_bytes, static_cast<double>(vocab_size) * 4},
+      [&](std::ptrdiff_t first, std::ptrdiff_t last) {
+        for (std::ptrdiff_t i = first; i < last; ++i) {
+          const int64_t logits_row = logits_batch_size == batch_beam_size ? i : i / num_beams;
+          const float* current_logits = logits_data + (logits_row * input_length + input_length - 1) * vocab_size;
+          MlasComputeSoftmax(current_logits, next_token_scores.data() + i * vocab_size, 1, vocab_size, true, false,
+                             nullptr);
+        }
+      });
+
+  // Repetition penalty, no repeat ngram and min length only change a few tokens per row.
+  logits_processors->ProcessSparse(sequences, next_token_scores);
+
+  float* scores_output = parameters->output_scores ? beam_state->remaining_scores.data() : nullptr;
+  std::vector<ScoredIndex> candidates(static_cast<size_t>(batch_beam_size) * top_k);
+  concurrency::ThreadPool::TryParallelFor(
+      thread_pool, batch_beam_size, TensorOpCost{row_bytes, row_bytes, static_cast<double>(vocab_size) * 2},
+      [&](std::ptrdiff_t first, std::ptrdiff_t last) {
+        std::vector<ScoredIndex> heap;
+        heap.reserve(top_k);
+        for (std::ptrdiff_t i = first; i < last; ++i) {
+          const transformers::ElementwiseLogitsProcessor processor =
+              logits_processors->GetElementwiseProcessor(static_cast<int>(i), step);
+          const float beam_score = beam_state->beam_scores[i];
+          float* scores = next_token_scores.data() + i * vocab_size;
+          float* output = scores_output != nullptr ? scores_output + i * vocab_size : nullptr;
+          // Tokens are numbered in the (num_beams * vocab_size) row of the batch, like the top-k input.
+          const int64_t index_offset = static_cast<int64_t>(i % num_beams) * static_cast<int64_t>(vocab_size);
+
+          heap.clear();
+          for (size_t j = 0; j < vocab_size; ++j) {
+            const float score = processor(j, scores[j]) + beam_score;
+            scores[j] = score;
+            if (output != nullptr) {
+              output[j] = score;
+            }
+            PushTopK(heap, top_k, score, index_offset + static_cast<int64_t>(j));
+          }
+
+          // Rows with fewer tokens than top_k fill the rest with candidates that are never selected.
+          std::sort(heap.begin(), heap.end(), IsBetter);
+          heap.resize(top_k, ScoredIndex{std::numeric_limits<float>::lowest(), std::numeric_limits<int64_t>::max()});
+          std::copy(heap.begin(), heap.end(), candidates.begin() + i * top_k);
+        }
+      });
+
+  if (parameters->output_scores) {
+    beam_state->remaining_scores = beam_state->remaining_scores.subspan(next_token_scores.size());
+  }
+
+  // Merge the candidates of the beams of each batch.
+  for (int i = 0; i < batch_size; i++) {
+    auto batch_candidates = candidates.begin() + static_cast<size_t>(i) * num_beams * top_k;
+    std::partial_sort(batch_candidates, batch_candidates + top_k, batch_candidates + num_beams * top_k, IsBetter);
+    for (size_t j = 0; j < top_k; j++) {
+      const size_t offset = static_cast<size_t>(i) * top_k + j;
+      beam_state->next_indices[offset] = gsl::narrow_cast<int32_t>(batch_candidates[j].index / vocab_size);
+      beam_state->next_tokens[offset] = gsl::narrow_cast<int32_t>(batch_candidates[j].index % vocab_size);
+      beam_state->next_scores[offset] = batch_candidates[j].score;
+    }
+  }
+}
+
+}  // namespace
+
 template <typename T>
 Status ProcessLogits(const OrtValue& logits,                                 // logits output of subgraph
                      transformers::IBeamSearchState<T>* beam_state,          // state
@@ -308,6 +421,34 @@ Status ProcessLogits(const OrtValue& logits,                                 //
   auto input_length = logits_shape[1];
   auto logits_batch_size = logits_shape[0];
 
+  // On CPU the logits processors are always a LogitsProcessorList.
+  auto* cpu_logits_processors = static_cast<transformers::LogitsProcessorList*>(logits_processors);
+  if (cpu_logits_processors->IsFusable()) {
+    FusedProcessLogits(logits_data, input_length, logits_batch_size, beam_state, sequences, thread_pool,
+                       cpu_logits_processors, parameters, step);
+
+    gsl::span<const float> next_scores(beam_state->next_scores.data(), SafeInt<size_t>(2) * batch_beam_size);
+    gsl::span<const int32_t> next_tokens(beam_state->next_tokens.data(), beam_state->next_tokens.size());
+    gsl::span<const int32_t> next_indices(beam_state->next_indices.data(), beam_state->next_indices.size());
+
+#ifdef DEBUG_GENERATION
+    dumper->Print("logits", logits);
+    dumper->Print("next_token_scores adding beam_scores", beam_state->next_token_scores.data(), batch_size, num_beams,
+                  vocab_size);
+    dumper->Print("next_scores before scorer", next_scores.data(), batch_size, 2 * num_beams);
+    dumper->Print("next_tokens before scorer", next_tokens.data(), batch_size, 2 * num_beams);
+    dumper->Print("next_indices before scorer", next_indices.data(), batch_size, 2 * num_beams);
+#endif
+
+    beam_scorer->Process(
+        *sequences,
+        next_scores,
+        next_tokens,
+        next_indices);
+
+    return Status::OK();
+  }
+
   // Get logits for the last token:
   //    next_token_logits = logits[:, -1, :], and the result shape is (batch_size * num_beams, vocab_size)
   // When input_length == 1, use logits directly in SoftmaxCPU below so it only need for input_length > 1.
@@ -466,13 +607,19 @@ Status GreedySearchProcessLogits(
   // Get logits for the last token:
   //    next_token_logits = logits[:, -1, :], and the result shape is (batch_size, vocab_size)
   // When input_length == 1, use logits directly in SoftmaxCPU below so it only need for input_length > 1.
+  // The token of a finished sequence is replaced by the pad token, so its scores are zeroed rather than copied. Its
+  // logits are not computed when finished sequences are evicted from the subgraph inputs.
   gsl::span<T>& next_token_scores = greedy_state->next_token_scores;
   const T* current_logits = logits_data + (input_length - 1) * vocab_size;
   for (int i = 0; i < batch_size; i++) {
     gsl::span<const T> source(current_logits, vocab_size);
     gsl::span<T> target = next_token_scores.subspan(SafeInt<gsl::index>(i) * vocab_size,
                                                     static_cast<gsl::index>(vocab_size));
-    gsl::copy(source, target);
+    if (greedy_state->eos_meet[i]) {
+      std::fill(target.begin(), target.end(), T{});
+    } else {
+      gsl::copy(source, target);
+    }
     current_logits += input_length * vocab_size;
   }
 
@@ -481,6 +628,46 @@ Status GreedySearchProcessLogits(
   dumper->Print("next_token_logits", next_token_scores.data(), batch_size, 1, vocab_size);
 #endif
 
+  // On CPU the logits processors are always a LogitsProcessorList. Greedy search applies the element-wise
+  // processors and picks the best token of each row in the same sweep.
+  auto* cpu_logits_processors = static_cast<transformers::LogitsProcessorList*>(logits_processors);
+  if (!do_sampling && cpu_logits_processors->IsFusable()) {
+    cpu_logits_processors->ProcessSparse(sequences, next_token_scores);
+
+    const size_t vocab = static_cast<size_t>(vocab_size);
+    const double row_bytes = static_cast<double>(vocab * sizeof(T));
+    concurrency::ThreadPool::TryParallelFor(
+        thread_pool, batch_size, TensorOpCost{row_bytes, row_bytes, static_cast<double>(vocab) * 2},
+        [&](std::ptrdiff_t first, std::ptrdiff_t last) {
+          for (std::ptrdiff_t i = first; i < last; ++i) {
+            if (greedy_state->eos_meet[i]) {
+              greedy_state->next_tokens[i] = parameters->pad_token_id;
+              continue;
+            }
+
+            const transformers::ElementwiseLogitsProcessor processor =
+                cpu_logits_processors->GetElementwiseProcessor(static_cast<int>(i), step);
+            T* scores = next_token_scores.data() + i * vocab;
+
+            // Ties prefer the lower token id, like the TopK operator.
+            size_t best_token = 0;
+            scores[0] = processor(0, scores[0]);
+            for (size_t j = 1; j < vocab; ++j) {
+              scores[j] = processor(j, scores[j]);
+              if (scores[j] > scores[best_token]) {
+                best_token = j;
+              }
+            }
+            greedy_state->next_tokens[i] = gsl::narrow_cast<int32_t>(best_token);
+          }
+        });
+
+#ifdef DEBUG_GENERATION
+    dumper->Print("next_token_scores after logits processor", next_token_scores.data(), batch_size, 1, vocab_size);
+#endif
+    return Status::OK();
+  }
+
   // Apply all score processors that updates scores
   logits_processors->Process(sequences, next_token_scores, step);
 
@@ -555,6 +742,62 @@ Status DeviceCopy(gsl::span<T> target, gsl::span<const T> source, Stream* /*stre
   return Status::OK();
 }
 
+namespace {
+
+// Whether every beam continues from its own past state, so presents can be fed back as pasts without a copy.
+bool IsIdentityBeamOrder(gsl::span<const int32_t> beam_indices) {
+  for (size_t i = 0; i < beam_indices.size(); i++) {
+    if (beam_indices[i] != static_cast<int32_t>(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+Status UpdateCacheIndirection(AllocatorPtr allocator,
+                              OrtValue& cache_indirection,
+                              gsl::span<const int32_t> beam_indices,
+                              int num_beams,
+                              int input_sequence_len,
+                              int current_length) {
+  const Tensor& old_cache_indirection = cache_indirection.Get<Tensor>();
+  const TensorShape& shape = old_cache_indirection.Shape();
+  const int batch_size = static_cast<int>(shape[0]);
+  const int max_sequence_length = static_cast<int>(shape[2]);
+  ORT_RETURN_IF_NOT(static_cast<int>(beam_indices.size()) == batch_size * num_beams,
+                    "Beam indices must be present on CPU while using DecoderMaskedMultiHeadAttention with BeamSearch");
+  ORT_RETURN_IF_NOT(current_length <= max_sequence_length, "current_length exceeds the cache indirection length");
+
+  OrtValue new_cache_indirection;
+  Tensor::InitOrtValue(DataTypeImpl::GetType<int32_t>(), shape, allocator, new_cache_indirection);
+  const int32_t* source = old_cache_indirection.Data<int32_t>();
+  int32_t* target = new_cache_indirection.GetMutable<Tensor>()->MutableData<int32_t>();
+
+  for (int batch = 0; batch < batch_size; batch++) {
+    for (int beam = 0; beam < num_beams; beam++) {
+      const int source_beam = beam_indices[SafeInt<size_t>(batch) * num_beams + beam] % num_beams;
+      const int32_t* source_row = source + (SafeInt<size_t>(batch) * num_beams + source_beam) * max_sequence_length;
+      int32_t* target_row = target + (SafeInt<size_t>(batch) * num_beams + beam) * max_sequence_length;
+      for (int t = 0; t < current_length; t++) {
+        if (t < input_sequence_len) {
+          // The prompt is shared by all beams, and its past state is the same in every beam.
+          target_row[t] = 0;
+        } else if (t == current_length - 1) {
+          // The token generated in this step is appended to the past state of this beam.
+          target_row[t] = beam;
+        } else {
+          target_row[t] = source_row[t];
+        }
+      }
+    }
+  }
+
+  cache_indirection = new_cache_indirection;
+  return Status::OK();
+}
+
 // Copy present state to past state for GPT model
 template <typename T>
 void PickGptPastState(const std::vector<OrtValue>& last_outputs,
@@ -619,8 +862,6 @@ Status UpdateGptFeeds(
   // next_inputs: input_ids, position_id, attention_mask, past_0, past_1
   ORT_UNUSED_PARAMETER(stream);
   ORT_UNUSED_PARAMETER(beam_indices_gpu);
-  ORT_UNUSED_PARAMETER(input_sequence_len);
-  ORT_UNUSED_PARAMETER(need_cache_indir);
 
   // The following updates inputs for subgraph
 
@@ -664,12 +905,19 @@ Status UpdateGptFeeds(
   next_inputs[2] = attention_mask;
 
   if (past_present_share_buffer) {
-    int32_t* past_seq_len_data = const_cast<int32_t*>(next_inputs.back().Get<Tensor>().Data<int32_t>());
-    *past_seq_len_data = past_sequence_len;
+    // Update past sequence length input
+    const ptrdiff_t past_sequence_length_idx = (static_cast<ptrdiff_t>(last_outputs.size()) - gpt_subgraph_first_present_output_idx) + gpt_subgraph_first_past_input_idx;
+    *(next_inputs[past_sequence_length_idx].GetMutable<Tensor>()->MutableData<int32_t>()) = past_sequence_len;
+
+    // The cache indirection feed comes 2 feeds after the `past_sequence_length` feed
+    if (need_cache_indir && num_beams > 1) {
+      ORT_RETURN_IF_ERROR(UpdateCacheIndirection(allocator, next_inputs[past_sequence_length_idx + 2], beam_indices_cpu,
+                                                 num_beams, input_sequence_len, current_length));
+    }
     return Status::OK();
   }
 
-  if (num_beams == 1) {  // Update past state
+  if (num_beams == 1 || IsIdentityBeamOrder(beam_indices_cpu)) {  // Update past state
     // feed present_* output to past_* inputs one by one
     const int k = gpt_subgraph_first_past_input_idx - gpt_subgraph_first_present_output_idx;
     for (size_t i = gpt_subgraph_first_present_output_idx; i < last_outputs.size(); ++i) {
@@ -813,9 +1061,6 @@ Status UpdateDecoderFeeds(
     const IConsoleDumper* dumper) {
   ORT_UNUSED_PARAMETER(stream);
   ORT_UNUSED_PARAMETER(beam_indices_gpu);
-  ORT_UNUSED_PARAMETER(input_sequence_len);
-  ORT_UNUSED_PARAMETER(past_present_share_buffer);
-  ORT_UNUSED_PARAMETER(need_cache_indir);
   // last_outputs: logits, present_key_self_0, present_value_self_0, ...
   // next_inputs: input_ids,
   //              encoder_attention_mask, encoder_hidden_states(optional),
@@ -856,8 +1101,22 @@ Status UpdateDecoderFeeds(
 
   // Update past state
   ORT_ENFORCE(last_outputs.size() >= static_cast<size_t>(1) + num_present_tensors);
+
+  if (past_present_share_buffer) {
+    // Update past sequence length input
+    const ptrdiff_t past_sequence_length_idx = 2 * num_present_tensors + t5_decoder_first_past_input_idx;
+    *(next_inputs[past_sequence_length_idx].GetMutable<Tensor>()->MutableData<int32_t>()) = current_length - 1;
+
+    // The cache indirection feed comes 2 feeds after the `past_sequence_length` feed
+    if (need_cache_indir && num_beams > 1) {
+      ORT_RETURN_IF_ERROR(UpdateCacheIndirection(allocator, next_inputs[past_sequence_length_idx + 2], beam_indices,
+                                                 num_beams, input_sequence_len, current_length));
+    }
+    return Status::OK();
+  }
+
   // TODO(tianleiwu): remove num_beams==1 once GreedySearch operator is available.
-  if (num_beams == 1) {
+  if (num_beams == 1 || IsIdentityBeamOrder(beam_indices)) {
     // feed present_* output to past_* inputs one by one
     for (ptrdiff_t i = 0; i < num_present_tensors; ++i) {
       next_inputs[t5_decoder_first_past_input_idx + i] =
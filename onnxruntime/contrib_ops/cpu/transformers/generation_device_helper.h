@@ -334,6 +334,17 @@ Status UpdateGptFeeds(
     int input_sequence_len,
     bool need_cache_indir);
 
+// Reorders beams through the cache indirection input of DecoderMaskedMultiHeadAttention instead of copying their
+// past state. cache_indirection has shape (batch_size, num_beams, max_sequence_length), where entry [b, i, t] is
+// the beam of batch b whose past state holds time step t of beam i. This is the CPU version of
+// UpdateDecoderMaskedMultiHeadAttentionCacheIndirection for CUDA. Entries from current_length on are not set.
+Status UpdateCacheIndirection(AllocatorPtr allocator,
+                              OrtValue& cache_indirection,
+                              gsl::span<const int32_t> beam_indices,
+                              int num_beams,
+                              int input_sequence_len,
+                              int current_length);
+
 // ---------------------------------------------------------------
 // Functions for encoder-decoder model like T5
 // ---------------------------------------------------------------
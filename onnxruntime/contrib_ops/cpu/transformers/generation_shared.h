@@ -5,6 +5,7 @@
 
 #include <utility>
 #include <random>
+#include <vector>
 #include <gsl/gsl>
 #include "core/framework/allocator.h"
 #include "core/framework/ort_value.h"
@@ -89,11 +90,14 @@ struct ISamplingState {
   BufferUniquePtr storage_buffer;
   size_t temp_storage_bytes;
   std::default_random_engine generator;
+  std::vector<std::default_random_engine> sequence_generators;  // one per sequence when seed_per_sequence is set
 
-  gsl::span<T> sorted_scores;
-  gsl::span<T> cumulative_probs;
+  gsl::span<T> probs;
+  gsl::span<int32_t> candidates;
 };
 
+class SequenceIndex;
+
 struct ISequences {
   virtual ~ISequences() {}
   virtual gsl::span<const int32_t> GetSequence(int beam_index) const = 0;
@@ -101,6 +105,10 @@ struct ISequences {
   virtual gsl::span<int32_t> GetNextDeviceSequences() = 0;                 // Get all next beam_index sequences in one continuous block (to pass to CUDA)
   virtual int GetSequenceLength() const = 0;
   virtual int GetMaxLength() const = 0;
+
+  // Index of the tokens of the sequences that is kept up to date as tokens are appended, or nullptr when it is not
+  // maintained.
+  virtual const SequenceIndex* GetIndex() const { return nullptr; }
 };
 
 struct ILogitsProcessorList {
@@ -178,7 +186,10 @@ struct IGenerationParameters {
   float filter_value;
   float temperature = 1.0f;
   float top_p = 0.0f;
+  int top_k = 0;
+  float min_p = 0.0f;
   int seed = 0;
+  bool seed_per_sequence = false;
   int min_tokens_to_keep = 1;
   bool custom_sampling = false;
 
@@ -11,6 +11,7 @@
 
 #include <assert.h>
 #include <functional>
+#include <limits>
 #include <string>
 #include <utility>
 #include "core/common/safeint.h"
@@ -98,6 +99,16 @@ void GreedySearch::Init(const OpKernelInfo& info) {
 
   // Make sure the decoder sub-graph attribute is present for all model types.
   ORT_ENFORCE(info.GetAttr<ONNX_NAMESPACE::GraphProto>("decoder", &proto).IsOK());
+
+  const int64_t prefix_cache_max_bytes = info.GetAttrOrDefault<int64_t>("prefix_cache_max_bytes", 0);
+  ORT_ENFORCE(prefix_cache_max_bytes >= 0, "prefix_cache_max_bytes must not be negative. Got ", prefix_cache_max_bytes);
+  if (prefix_cache_max_bytes > 0) {
+    const int64_t prefix_cache_block_size = info.GetAttrOrDefault<int64_t>("prefix_cache_block_size", 64);
+    ORT_ENFORCE(prefix_cache_block_size > 0 && prefix_cache_block_size <= std::numeric_limits<int>::max(),
+                "prefix_cache_block_size must be positive. Got ", prefix_cache_block_size);
+    prefix_cache_ = std::make_unique<PrefixKVCache>(static_cast<size_t>(prefix_cache_max_bytes),
+                                                    static_cast<int>(prefix_cache_block_size));
+  }
 }
 
 Status GreedySearch::SetupSubgraphExecutionInfo(const SessionState& session_state,
@@ -207,6 +218,7 @@ Status GreedySearch::Compute(OpKernelContext* ctx) const {
       ORT_RETURN_IF_ERROR(impl.InitializeCuda(reorder_past_state_func_, cuda_device_prop_, cuda_device_arch_));
 #endif
       ORT_RETURN_IF_ERROR(impl.Initialize());
+      impl.SetPrefixCache(prefix_cache_.get());
 
       return impl.Execute(init_run_decoder_feeds_fetches_manager_, *decoder_feeds_fetches_manager_);
     } else {
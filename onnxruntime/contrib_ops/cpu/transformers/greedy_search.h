@@ -8,6 +8,7 @@
 #include "core/framework/op_kernel.h"
 #include "core/providers/cpu/controlflow/utils.h"
 #include "contrib_ops/cpu/transformers/greedy_search_parameters.h"
+#include "contrib_ops/cpu/transformers/prefix_kv_cache.h"
 #include "contrib_ops/cpu/transformers/subgraph_gpt.h"
 #include "contrib_ops/cpu/transformers/subgraph_t5_encoder.h"
 #include "contrib_ops/cpu/transformers/subgraph_t5_decoder.h"
@@ -39,6 +40,9 @@ class GreedySearch : public IControlFlowKernel {
                                     const std::string& attribute_name,
                                     const SessionState& subgraph_session_state) override;
 
+  // Null when the prefix cache is disabled.
+  const PrefixKVCache* GetPrefixCache() const { return prefix_cache_.get(); }
+
  protected:
   void SetConsoleDumper(IConsoleDumper* dumper) { dumper_ = dumper; }
 
@@ -129,6 +133,9 @@ class GreedySearch : public IControlFlowKernel {
   GreedySearchParameters parameters_;
 
   bool has_init_decoder_ = false;
+
+  // Past state of prompt prefixes shared by all Compute calls. Null when prefix_cache_max_bytes is 0.
+  std::unique_ptr<PrefixKVCache> prefix_cache_;
 };
 
 }  // namespace transformers
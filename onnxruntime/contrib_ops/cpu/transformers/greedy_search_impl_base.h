@@ -20,6 +20,7 @@ struct SamplingState : public ISamplingState<T> {
             int vocab_size,
             int max_iter,
             int seed,
+            bool seed_per_sequence,
             bool is_cuda,
             Stream* stream) {
     int total_count = batch_size * vocab_size;
@@ -27,6 +28,14 @@ struct SamplingState : public ISamplingState<T> {
     this->h_softmaxed_score = AllocateBuffer<float>(cpu_allocator, h_softmaxed_score_buffer_, SafeInt<size_t>(total_count), stream);
 
     this->generator = std::default_random_engine{gsl::narrow_cast<uint32_t>(seed)};
+    if (seed_per_sequence) {
+      // Seeded from the sequence index, so the tokens sampled for a sequence do not depend on the rest of the batch.
+      this->sequence_generators.resize(static_cast<size_t>(batch_size));
+      for (int i = 0; i < batch_size; i++) {
+        std::seed_seq seed_sequence{gsl::narrow_cast<uint32_t>(seed), static_cast<uint32_t>(i)};
+        this->sequence_generators[i].seed(seed_sequence);
+      }
+    }
 
     if (is_cuda) {
       this->d_index_in = AllocateBuffer<int>(allocator, d_index_in_buffer_, SafeInt<size_t>(total_count), stream);
@@ -48,9 +57,8 @@ struct SamplingState : public ISamplingState<T> {
         this->h_sampled_all[i] = distribution(this->generator);
       }
     } else {
-      // TODO: Some buffer can be reused for CPU
-      this->sorted_scores = AllocateBuffer<T>(cpu_allocator, sorted_scores_buffer_, SafeInt<size_t>(total_count), stream);
-      this->cumulative_probs = AllocateBuffer<T>(cpu_allocator, cumulative_probs_buffer_, SafeInt<size_t>(total_count), stream);
+      this->probs = AllocateBuffer<T>(cpu_allocator, probs_buffer_, SafeInt<size_t>(total_count), stream);
+      this->candidates = AllocateBuffer<int32_t>(cpu_allocator, candidates_buffer_, SafeInt<size_t>(total_count), stream);
     }
   }
 
@@ -66,8 +74,8 @@ struct SamplingState : public ISamplingState<T> {
   IAllocatorUniquePtr<void> h_sampled_all_buffer_;
   IAllocatorUniquePtr<void> d_indices_buffer_;
   IAllocatorUniquePtr<void> d_presence_mask_buffer_;
-  IAllocatorUniquePtr<void> sorted_scores_buffer_;
-  IAllocatorUniquePtr<void> cumulative_probs_buffer_;
+  IAllocatorUniquePtr<void> probs_buffer_;
+  IAllocatorUniquePtr<void> candidates_buffer_;
 };
 
 template <typename T>
@@ -3,10 +3,14 @@
 
 #pragma once
 #include <algorithm>
+#include <numeric>
 #include <vector>
 
+#include "core/common/logging/logging.h"
+#include "core/common/narrow.h"
 #include "core/common/span_utils.h"
 #include "contrib_ops/cpu/transformers/greedy_search_impl_base.h"
+#include "contrib_ops/cpu/transformers/prefix_kv_cache.h"
 
 namespace onnxruntime {
 namespace contrib {
@@ -21,6 +25,34 @@ std::pair<Status, std::unique_ptr<GptSubgraph>> CreateGptSubgraphAndUpdateParame
     const std::string& attribute_name,
     const SessionState& subgraph_session_state,
     /*out*/ BeamSearchParameters& parameters);
+
+// Copies the given rows along the batch axis of a CPU tensor into a new tensor. The batch axis is 0 for
+// attention_mask and 1 for GPT past state of shape (2, batch_size, num_heads, past_seq_len, head_size).
+template <typename T>
+void SelectBatchRows(const OrtValue& input,
+                     size_t batch_axis,
+                     gsl::span<const int32_t> rows,
+                     AllocatorPtr allocator,
+                     OrtValue& output) {
+  const Tensor& input_tensor = input.Get<Tensor>();
+  const TensorShape& input_shape = input_tensor.Shape();
+  const size_t outer_size = onnxruntime::narrow<size_t>(input_shape.SizeToDimension(batch_axis));
+  const size_t row_size = onnxruntime::narrow<size_t>(input_shape.SizeFromDimension(batch_axis + 1));
+  const size_t input_rows = onnxruntime::narrow<size_t>(input_shape[batch_axis]);
+
+  TensorShape output_shape = input_shape;
+  output_shape[batch_axis] = static_cast<int64_t>(rows.size());
+  Tensor::InitOrtValue(input_tensor.DataType(), output_shape, std::move(allocator), output);
+
+  const T* source = input_tensor.Data<T>();
+  T* target = output.GetMutable<Tensor>()->MutableData<T>();
+  for (size_t outer = 0; outer < outer_size; ++outer) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+      std::copy_n(source + (outer * input_rows + static_cast<size_t>(rows[i])) * row_size, row_size,
+                  target + (outer * rows.size() + i) * row_size);
+    }
+  }
+}
 }  // namespace gpt_details
 
 // Greedy search implementation for GPT-2 model.
@@ -79,6 +111,9 @@ class GreedySearchGpt : public GreedySearchBase<T, ParametersT> {
   }
 #endif
 
+  // Share the past state of prompt prefixes with other Compute calls of the node. Only used on CPU.
+  void SetPrefixCache(PrefixKVCache* prefix_cache) { prefix_cache_ = prefix_cache; }
+
   // Execute beam search in iterations util stopping criteria is reached.
   // In each iteration, GPT subgraph is called, and next token for each sequence is generated.
   Status Execute(const FeedsFetchesManager* init_run_feeds_fetches_manager,
@@ -101,6 +136,27 @@ class GreedySearchGpt : public GreedySearchBase<T, ParametersT> {
       gsl::span<const int32_t> next_tokens,
       int past_sequence_length);
 
+  // Drop the rows of finished sequences from the subgraph feeds so that later subgraph calls only run the
+  // sequences that are still generating. active_slots maps each row of the feeds to its sequence index in
+  // greedy_state, and it is compacted in place together with next_positions.
+  Status EvictFinishedSequences(gsl::span<const bool> eos_meet,
+                                std::vector<int32_t>& active_slots,
+                                std::vector<OrtValue>& feeds,
+                                std::vector<OrtValue>& fetches,
+                                gsl::span<int32_t> next_positions,
+                                OrtValue& position_ids);
+
+  // Look up the longest cached prefix shared by all rows of input_ids. On a hit, input_ids and position_ids in feeds
+  // are cut down to the remaining tokens and the past state feeds are filled from the cache.
+  Status ApplyCachedPrefix(gsl::span<const int32_t> input_ids,
+                           std::vector<OrtValue>& feeds,
+                           int& prefix_length);
+
+  // Store the past state of the whole blocks of the first row after the first subgraph call.
+  void CachePrefix(gsl::span<const int32_t> input_ids,
+                   const std::vector<OrtValue>& fetches,
+                   int reused_prefix_length);
+
   const SessionState* init_run_decoder_session_state_ = nullptr;
   GptSubgraph* init_run_gpt_subgraph_ = nullptr;
   GptSubgraph& gpt_subgraph_;
@@ -114,6 +170,8 @@ class GreedySearchGpt : public GreedySearchBase<T, ParametersT> {
 #endif
   GenerationDeviceHelper::UpdateGptFeedsFunc<T> update_feeds_func_;
 
+  PrefixKVCache* prefix_cache_ = nullptr;
+
   const void* cuda_device_prop_ = nullptr;
   int cuda_device_arch_ = 0;
 };
@@ -187,6 +245,183 @@ Status GreedySearchGpt<T, ParametersT>::UpdateFeeds(
                             false);
 }
 
+template <typename T, typename ParametersT>
+Status GreedySearchGpt<T, ParametersT>::EvictFinishedSequences(gsl::span<const bool> eos_meet,
+                                                               std::vector<int32_t>& active_slots,
+                                                               std::vector<OrtValue>& feeds,
+                                                               std::vector<OrtValue>& fetches,
+                                                               gsl::span<int32_t> next_positions,
+                                                               OrtValue& position_ids) {
+  InlinedVector<int32_t> kept_rows;
+  kept_rows.reserve(active_slots.size());
+  for (size_t row = 0; row < active_slots.size(); ++row) {
+    if (!eos_meet[active_slots[row]]) {
+      kept_rows.push_back(static_cast<int32_t>(row));
+    }
+  }
+
+  if (kept_rows.size() == active_slots.size()) {
+    return Status::OK();
+  }
+
+  // Rows only move towards the front, so the per-row buffers can be compacted in place.
+  for (size_t i = 0; i < kept_rows.size(); ++i) {
+    active_slots[i] = active_slots[kept_rows[i]];
+    next_positions[i] = next_positions[kept_rows[i]];
+  }
+  active_slots.resize(kept_rows.size());
+
+  int64_t position_dims[] = {static_cast<int64_t>(kept_rows.size()), 1};
+  Tensor::InitOrtValue(DataTypeImpl::GetType<int32_t>(),
+                       TensorShape(&position_dims[0], 2),
+                       next_positions.data(),
+                       this->temp_space_allocator_->Info(),
+                       position_ids);
+
+  OrtValue attention_mask;
+  gpt_details::SelectBatchRows<int32_t>(feeds[2], 0, kept_rows, this->temp_space_allocator_, attention_mask);
+  feeds[2] = attention_mask;
+
+  for (size_t i = static_cast<size_t>(gpt_subgraph_.GetFirstPresentOutputIndex()); i < fetches.size(); ++i) {
+    OrtValue present;
+    gpt_details::SelectBatchRows<T>(fetches[i], 1, kept_rows, this->temp_space_allocator_, present);
+    fetches[i] = present;
+  }
+
+  return Status::OK();
+}
+
+template <typename T, typename ParametersT>
+Status GreedySearchGpt<T, ParametersT>::ApplyCachedPrefix(gsl::span<const int32_t> input_ids,
+                                                          std::vector<OrtValue>& feeds,
+                                                          int& prefix_length) {
+  const ParametersT* parameters = this->parameters_;
+  const size_t batch_size = static_cast<size_t>(parameters->BatchBeamSize());
+  const size_t sequence_length = static_cast<size_t>(parameters->sequence_length);
+  prefix_length = 0;
+
+  // All rows must start with the same tokens and no padding, so that they see the cached past state at the same
+  // positions. At least one token is left for the subgraph call to produce logits.
+  size_t shared_length = sequence_length - 1;
+  for (size_t i = 0; i < shared_length; ++i) {
+    if (input_ids[i] == parameters->pad_token_id) {
+      shared_length = i;
+      break;
+    }
+  }
+  for (size_t row = 1; row < batch_size && shared_length > 0; ++row) {
+    auto mismatch = std::mismatch(input_ids.begin(), input_ids.begin() + shared_length,
+                                  input_ids.begin() + row * sequence_length);
+    shared_length = static_cast<size_t>(mismatch.first - input_ids.begin());
+  }
+
+  std::vector<OrtValue> cached_presents;
+  prefix_length = prefix_cache_->Lookup(input_ids.first(sequence_length), static_cast<int>(shared_length),
+                                        cached_presents);
+
+  const PrefixKVCacheStats stats = prefix_cache_->GetStats();
+  LOGS(this->context_.Logger(), VERBOSE) << "Prefix cache reused " << prefix_length << " of " << sequence_length
+                                         << " prompt tokens. Hits: " << stats.hits << "/" << stats.lookups
+                                         << ", entries evicted: " << stats.evictions;
+  if (prefix_length == 0) {
+    return Status::OK();
+  }
+
+  ORT_RETURN_IF_NOT(cached_presents.size() == static_cast<size_t>(gpt_subgraph_.num_layers),
+                    "Prefix cache entry has ", cached_presents.size(), " layers. Expected ", gpt_subgraph_.num_layers);
+
+  // input_ids and position_ids keep the tokens after the prefix. attention_mask still covers the whole prompt.
+  const size_t prefix = static_cast<size_t>(prefix_length);
+  const size_t suffix_length = sequence_length - prefix;
+  for (int feed_idx = 0; feed_idx < 2; ++feed_idx) {
+    const Tensor& full = feeds[feed_idx].Get<Tensor>();
+    OrtValue suffix;
+    Tensor::InitOrtValue(full.DataType(),
+                         TensorShape{static_cast<int64_t>(batch_size), static_cast<int64_t>(suffix_length)},
+                         this->cpu_allocator_, suffix);
+    const int32_t* source = full.Data<int32_t>();
+    int32_t* target = suffix.GetMutable<Tensor>()->MutableData<int32_t>();
+    for (size_t row = 0; row < batch_size; ++row) {
+      std::copy_n(source + row * sequence_length + prefix, suffix_length, target + row * suffix_length);
+    }
+    feeds[feed_idx] = suffix;
+  }
+
+  // Broadcast the cached past state of shape (2, 1, num_heads, cached_length, head_size) to every row.
+  for (int layer = 0; layer < gpt_subgraph_.num_layers; ++layer) {
+    const Tensor& cached = cached_presents[layer].Get<Tensor>();
+    const auto& cached_dims = cached.Shape().GetDims();
+    const size_t num_heads = onnxruntime::narrow<size_t>(cached_dims[2]);
+    const size_t cached_length = onnxruntime::narrow<size_t>(cached_dims[3]);
+    const size_t head_size = onnxruntime::narrow<size_t>(cached_dims[4]);
+
+    OrtValue past;
+    Tensor::InitOrtValue(cached.DataType(),
+                         TensorShape{2, static_cast<int64_t>(batch_size), cached_dims[2], prefix_length, cached_dims[4]},
+                         this->cpu_allocator_, past);
+    const T* source = cached.Data<T>();
+    T* target = past.GetMutable<Tensor>()->MutableData<T>();
+    const size_t chunk = prefix * head_size;
+    for (size_t kv = 0; kv < 2; ++kv) {
+      for (size_t row = 0; row < batch_size; ++row) {
+        for (size_t head = 0; head < num_heads; ++head) {
+          std::copy_n(source + (kv * num_heads + head) * cached_length * head_size, chunk,
+                      target + ((kv * batch_size + row) * num_heads + head) * chunk);
+        }
+      }
+    }
+    feeds[static_cast<size_t>(gpt_subgraph_.GetFirstPastInputIndex()) + layer] = past;
+  }
+
+  return Status::OK();
+}
+
+template <typename T, typename ParametersT>
+void GreedySearchGpt<T, ParametersT>::CachePrefix(gsl::span<const int32_t> input_ids,
+                                                  const std::vector<OrtValue>& fetches,
+                                                  int reused_prefix_length) {
+  const ParametersT* parameters = this->parameters_;
+  const int block_size = prefix_cache_->BlockSize();
+
+  // Only the leading tokens of the first row before any padding are at the positions another request would use.
+  gsl::span<const int32_t> first_row = input_ids.first(static_cast<size_t>(parameters->sequence_length));
+  const auto unpadded_length = std::find(first_row.begin(), first_row.end(), parameters->pad_token_id) -
+                               first_row.begin();
+  const int cache_length = static_cast<int>(unpadded_length) / block_size * block_size;
+  if (cache_length <= reused_prefix_length) {
+    return;
+  }
+
+  std::vector<OrtValue> presents;
+  presents.reserve(static_cast<size_t>(gpt_subgraph_.num_layers));
+  for (int layer = 0; layer < gpt_subgraph_.num_layers; ++layer) {
+    // present has shape (2, batch_size, num_heads, sequence_length, head_size)
+    const size_t fetch_idx = static_cast<size_t>(gpt_subgraph_.GetFirstPresentOutputIndex()) + layer;
+    const Tensor& present = fetches[fetch_idx].Get<Tensor>();
+    const auto& present_dims = present.Shape().GetDims();
+    const size_t rows = onnxruntime::narrow<size_t>(present_dims[1]);
+    const size_t num_heads = onnxruntime::narrow<size_t>(present_dims[2]);
+    const size_t present_length = onnxruntime::narrow<size_t>(present_dims[3]);
+    const size_t head_size = onnxruntime::narrow<size_t>(present_dims[4]);
+
+    OrtValue cached;
+    Tensor::InitOrtValue(present.DataType(), TensorShape{2, 1, present_dims[2], cache_length, present_dims[4]},
+                         this->cpu_allocator_, cached);
+    const T* source = present.Data<T>();
+    T* target = cached.GetMutable<Tensor>()->MutableData<T>();
+    const size_t chunk = static_cast<size_t>(cache_length) * head_size;
+    for (size_t kv = 0; kv < 2; ++kv) {
+      for (size_t head = 0; head < num_heads; ++head) {
+        std::copy_n(source + (kv * rows * num_heads + head) * present_length * head_size, chunk,
+                    target + (kv * num_heads + head) * chunk);
+      }
+    }
+    presents.push_back(std::move(cached));
+  }
+
+  prefix_cache_->Insert(first_row.first(static_cast<size_t>(cache_length)), std::move(presents));
+}
+
 template <typename T, typename ParametersT>
 Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_run_feeds_fetches_manager,
                                                 const FeedsFetchesManager& feeds_fetches_manager) {
@@ -213,6 +448,9 @@ Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_
                     gpt_subgraph_.has_decoder_masked_attention_,
                     this->IsCuda(),
                     this->ort_stream_);
+  if (!this->IsCuda()) {
+    greedy_state.sequences.InitIndex(*parameters);
+  }
 
   SamplingState<T> sampling_state;
   if (std::is_same<ParametersT, SamplingParameters>::value) {
@@ -222,6 +460,7 @@ Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_
                         static_cast<int>(parameters->vocab_size),
                         static_cast<int>(parameters->max_length - parameters->sequence_length),
                         parameters->seed,
+                        parameters->seed_per_sequence,
                         this->IsCuda(),
                         this->ort_stream_);
   }
@@ -254,6 +493,19 @@ Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_
                            parameters->max_length,
                            parameters->sequence_length);
 
+  // Prompts that start with a cached prefix only run the rest of the prompt through the first subgraph call.
+  // The past state fed to the first call has to be built from the cache, so this is limited to CPU without an
+  // init_decoder subgraph, a fixed past buffer or a custom attention mask.
+  const bool use_prefix_cache = prefix_cache_ != nullptr &&
+                                !this->IsCuda() &&
+                                init_run_decoder_session_state_ == nullptr &&
+                                !gpt_subgraph_.past_present_share_buffer_ &&
+                                this->context_.GetInputOrtValue(6) == nullptr;
+  int reused_prefix_length = 0;
+  if (use_prefix_cache) {
+    ORT_RETURN_IF_ERROR(ApplyCachedPrefix(input_ids, feeds, reused_prefix_length));
+  }
+
 #ifdef DEBUG_GENERATION
   const IConsoleDumper* dumper = this->GetConsoleDumper();
 #endif
@@ -268,6 +520,16 @@ Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_
                        this->temp_space_allocator_->Info(),
                        position_ids);
 
+  // On CPU, finished sequences are evicted from the batch so that they stop costing a row in every subgraph call.
+  // Rows of the feeds map to sequences through active_slots, and logits of the remaining rows are scattered back
+  // to full_logits so that logits processing and the sequences keep their (batch_size, ...) layout.
+  // With past_present_share_buffer the past state lives in a fixed buffer and cannot be compacted.
+  const bool evict_finished_sequences = !this->IsCuda() && !gpt_subgraph_.past_present_share_buffer_;
+  std::vector<int32_t> active_slots(static_cast<size_t>(parameters->BatchBeamSize()));
+  std::iota(active_slots.begin(), active_slots.end(), 0);
+  std::vector<int32_t> active_next_tokens;
+  OrtValue full_logits;
+
   int current_length = parameters->sequence_length;
   int iteration_counter = 0;
   while (current_length < parameters->max_length) {
@@ -312,10 +574,37 @@ Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_
 
     ORT_RETURN_IF_ERROR(status);
 
-    const OrtValue& logits = fetches[0];
+    if (use_prefix_cache && iteration_counter == 1) {
+      CachePrefix(input_ids, fetches, reused_prefix_length);
+    }
+
+    const OrtValue* logits = &fetches[0];
+    if (active_slots.size() < static_cast<size_t>(parameters->BatchBeamSize())) {
+      // Sequences are only evicted after the first iteration, so logits has shape (active rows, 1, vocab_size).
+      const Tensor& active_logits = fetches[0].Get<Tensor>();
+      const size_t row_size = onnxruntime::narrow<size_t>(active_logits.Shape().SizeFromDimension(1));
+      if (!full_logits.IsAllocated()) {
+        TensorShape full_shape = active_logits.Shape();
+        full_shape[0] = parameters->BatchBeamSize();
+        Tensor::InitOrtValue(active_logits.DataType(), full_shape, this->temp_space_allocator_, full_logits);
+
+        // The rows of evicted sequences are never written. Keep them finite, as the logits processors and the
+        // sampling still see them.
+        Tensor* full_logits_tensor = full_logits.GetMutable<Tensor>();
+        memset(full_logits_tensor->MutableDataRaw(), 0, full_logits_tensor->SizeInBytes());
+      }
+
+      const T* source = active_logits.Data<T>();
+      T* target = full_logits.GetMutable<Tensor>()->MutableData<T>();
+      for (size_t row = 0; row < active_slots.size(); ++row) {
+        std::copy_n(source + row * row_size, row_size, target + static_cast<size_t>(active_slots[row]) * row_size);
+      }
+      logits = &full_logits;
+    }
+
     gsl::span<int32_t> next_tokens;
 
-    ORT_RETURN_IF_ERROR(this->GenerateNextToken(logits,
+    ORT_RETURN_IF_ERROR(this->GenerateNextToken(*logits,
                                                 next_tokens,
                                                 greedy_state,
                                                 sampling_state,
@@ -361,9 +650,22 @@ Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_
     if (current_length < parameters->max_length) {
       bool increase_position = (iteration_counter > 1);
 
+      gsl::span<const int32_t> feed_tokens = ReinterpretAsSpan<const int32_t>(next_tokens);
+      if (evict_finished_sequences) {
+        ORT_RETURN_IF_ERROR(EvictFinishedSequences(eos_meet, active_slots, feeds, fetches,
+                                                   greedy_state.next_positions, position_ids));
+        if (active_slots.size() < next_tokens.size()) {
+          active_next_tokens.resize(active_slots.size());
+          for (size_t row = 0; row < active_slots.size(); ++row) {
+            active_next_tokens[row] = next_tokens[active_slots[row]];
+          }
+          feed_tokens = active_next_tokens;
+        }
+      }
+
       ORT_RETURN_IF_ERROR(UpdateFeeds(fetches, feeds, current_length,
                                       position_ids, increase_position,
-                                      ReinterpretAsSpan<const int32_t>(next_tokens),
+                                      feed_tokens,
                                       current_length - 1));
     }
     if (gpt_subgraph_.past_present_share_buffer_) {
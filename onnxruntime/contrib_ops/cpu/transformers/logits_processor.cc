@@ -8,6 +8,7 @@
 #include "core/common/span_utils.h"
 #include "core/providers/cpu/math/softmax_shared.h"
 #include "contrib_ops/cpu/transformers/logits_processor.h"
+#include "contrib_ops/cpu/transformers/sequence_index.h"
 #include "contrib_ops/cpu/utils/dump_tensor.h"
 #include <vector>
 #include <numeric>
@@ -40,20 +41,29 @@ void RepetitionPenaltyLogitsProcessor<T>::Process(const ISequences* sequences,
   const int batch_beam_size = next_token_scores.batch_beam_size;
   for (int i = 0; i < batch_beam_size; i++) {
     gsl::span<T> beam_token_scores = next_token_scores.GetScores(i);
-    gsl::span<const int32_t> sequence = sequences->GetSequence(i);
+    auto apply_penalty = [&](int32_t word_id) {
+      T score = beam_token_scores[word_id];
+
+      // If score < 0, then repetition penalty > 1.0 has to multiplied to reduce the previous token probability,
+      // This assumes that scores are either positive (like ctrl) or negative (like GPT-2), but not a mixture.
+      beam_token_scores[word_id] = (score < 0 ? score * penalty_ : score / penalty_);
+    };
+
+    // Use the distinct tokens kept by the sequences when available, so the sequence is not scanned again.
+    if (const SequenceIndex* index = sequences->GetIndex(); index != nullptr && index->IndexesTokens()) {
+      index->ForEachToken(i, apply_penalty);
+      continue;
+    }
 
     // Find unique word IDs in sequence.
+    gsl::span<const int32_t> sequence = sequences->GetSequence(i);
     std::unordered_set<int32_t> unique_word_ids;
     for (const auto& word_id : sequence) {
       unique_word_ids.insert(word_id);
     }
 
     for (const int32_t word_id : unique_word_ids) {
-      T score = beam_token_scores[word_id];
-
-      // If score < 0, then repetition penalty > 1.0 has to multiplied to reduce the previous token probability,
-      // This assumes that scores are either positive (like ctrl) or negative (like GPT-2), but not a mixture.
-      beam_token_scores[word_id] = (score < 0 ? score * penalty_ : score / penalty_);
+      apply_penalty(word_id);
     }
   }
 }
@@ -71,19 +81,32 @@ void NoRepeatNGramLogitsProcessor<T>::Process(const ISequences* sequences,
 
   const gsl::index prefix_length = static_cast<gsl::index>(ngram_size_) - 1;
   int batch_beam_size = next_token_scores.batch_beam_size;
+  const SequenceIndex* index = sequences->GetIndex();
 
   for (int i = 0; i < batch_beam_size; i++) {
     gsl::span<T> beam_token_scores = next_token_scores.GetScores(i);
     gsl::span<const int32_t> sequence = sequences->GetSequence(i);
 
+    // Use the index kept by the sequences when available. Every token of the sequence is blocked for unigrams.
+    auto block = [&beam_token_scores](int32_t word_id) {
+      beam_token_scores[word_id] = std::numeric_limits<T>::lowest();
+    };
+    if (index != nullptr && ngram_size_ == 1 && index->IndexesTokens()) {
+      index->ForEachToken(i, block);
+      continue;
+    }
+
+    if (index != nullptr && index->NGramSize() == ngram_size_) {
+      index->ForEachBlockedToken(i, block);
+      continue;
+    }
+
     gsl::span<const int32_t> prefix = sequence.subspan(sequence.size() - prefix_length);
     ORT_ENFORCE(prefix.size() == narrow<size_t>(prefix_length));
 
     std::unordered_set<int32_t> blocked_word_ids;
     for (int j = 0; j <= static_cast<int>(sequence.size()) - ngram_size_; j++) {
       // Here we use naive algorithm for matching. The complexity is O(batch_beam_size * ngram_size * sequence_length)
-      // TODO(tianleiwu): build N-Gram index (hash table with prefix of length NGram - 1 as key,
-      //                  and list of last word of NGram as value) for fast matching.
       if (ngram_size_ == 1 || SpanEq(prefix, sequence.subspan(j, prefix_length))) {
         blocked_word_ids.insert(sequence[static_cast<gsl::index>(j) + prefix_length]);
       }
@@ -213,6 +236,40 @@ void LogitsProcessorList::Process(const ISequences* sequences,
   }
 }
 
+void LogitsProcessorList::ProcessSparse(const ISequences* sequences,
+                                        gsl::span<float>& next_token_scores) {
+  assert(IsFusable());
+
+  // The element-wise processors are left out. Moving them after the min length processor keeps the scores of
+  // Process, since both set the score of blocked tokens to the lowest value.
+  NextTokenScores<float> input_scores = {next_token_scores, batch_beam_size_, vocab_size_};
+  for (size_t i = 0; i < processor_list_.size(); i++) {
+    if (!IsElementwise(processor_list_[i])) {
+      processor_list_[i]->Process(sequences, input_scores);
+    }
+  }
+}
+
+ElementwiseLogitsProcessor LogitsProcessorList::GetElementwiseProcessor(int batch_beam_index, int step) const {
+  ElementwiseLogitsProcessor processor;
+  if (vocab_mask_processor_ != nullptr) {
+    processor.vocab_mask = vocab_mask_.data();
+  }
+
+  // Prefix vocab mask is applied to first iteration only.
+  if (prefix_vocab_mask_processor_ != nullptr && step <= 1) {
+    const int num_beams = batch_beam_size_ / batch_size_;
+    processor.prefix_vocab_mask = prefix_vocab_mask_.data() +
+                                  SafeInt<size_t>(batch_beam_index / num_beams) * vocab_size_;
+  }
+
+  if (temperature_processor_ != nullptr) {
+    processor.temperature = temperature_;
+  }
+
+  return processor;
+}
+
 }  // namespace transformers
 }  // namespace contrib
 }  // namespace onnxruntime
@@ -293,6 +293,22 @@ class TimestampLogitsProcessor : public ILogitsProcessor<T> {
   int max_initial_timestamp_index_;
 };
 
+// Vocabulary masks and temperature for one row of scores, applied token by token so that callers can combine them
+// with other per-token work like log-softmax, adding beam scores and top-k selection in a single sweep.
+struct ElementwiseLogitsProcessor {
+  const int32_t* vocab_mask = nullptr;         // (vocab_size), or nullptr when not used
+  const int32_t* prefix_vocab_mask = nullptr;  // (vocab_size) row of the batch, or nullptr when not used
+  float temperature = 1.0f;
+
+  float operator()(size_t token_id, float score) const {
+    if ((vocab_mask != nullptr && vocab_mask[token_id] == 0) ||
+        (prefix_vocab_mask != nullptr && prefix_vocab_mask[token_id] == 0)) {
+      score = std::numeric_limits<float>::lowest();
+    }
+    return temperature == 1.0f ? score : score / temperature;
+  }
+};
+
 class LogitsProcessorList : public ILogitsProcessorList {
  public:
   LogitsProcessorList() = default;
@@ -301,6 +317,15 @@ class LogitsProcessorList : public ILogitsProcessorList {
   void Init(const SamplingParameters& parameters);
   void Process(const ISequences* sequences, gsl::span<float>& next_token_scores, int step);
 
+  // Fused processing, which gives the same scores as Process: ProcessSparse runs the processors that change a few
+  // tokens per row, then the ElementwiseLogitsProcessor of each row is applied to every token.
+  // Only supported when IsFusable() returns true.
+  bool IsFusable() const {
+    return presence_penalty_processor_ == nullptr && timestamp_processor_ == nullptr;
+  }
+  void ProcessSparse(const ISequences* sequences, gsl::span<float>& next_token_scores);
+  ElementwiseLogitsProcessor GetElementwiseProcessor(int batch_beam_index, int step) const;
+
  private:
   template <typename GenerationParametersT>
   void LogitsProcessorInitImpl(const GenerationParametersT& parameters) {
@@ -364,11 +389,25 @@ class LogitsProcessorList : public ILogitsProcessorList {
     }
 
     batch_beam_size_ = parameters.BatchBeamSize();
+    batch_size_ = parameters.batch_size;
     vocab_size_ = parameters.vocab_size;
+    vocab_mask_ = parameters.vocab_mask;
+    prefix_vocab_mask_ = parameters.prefix_vocab_mask;
+    temperature_ = parameters.temperature > 0 ? parameters.temperature : 1.0f;
+  }
+
+  bool IsElementwise(const ILogitsProcessor<float>* processor) const {
+    return processor == vocab_mask_processor_.get() ||
+           processor == prefix_vocab_mask_processor_.get() ||
+           processor == temperature_processor_.get();
   }
 
   int batch_beam_size_;
+  int batch_size_;
   int vocab_size_;
+  gsl::span<const int32_t> vocab_mask_;
+  gsl::span<const int32_t> prefix_vocab_mask_;
+  float temperature_;
   InlinedVector<ILogitsProcessor<float>*> processor_list_;
 
   std::unique_ptr<RepetitionPenaltyLogitsProcessor<float>> repetition_penalty_processor_;
@@ -0,0 +1,137 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "contrib_ops/cpu/transformers/prefix_kv_cache.h"
+
+#include <algorithm>
+
+#include "core/framework/tensor.h"
+
+namespace onnxruntime {
+namespace contrib {
+namespace transformers {
+
+PrefixKVCache::PrefixKVCache(size_t max_bytes, int block_size)
+    : max_bytes_(max_bytes), block_size_(block_size) {
+  ORT_ENFORCE(block_size_ > 0, "prefix cache block size must be positive. Got ", block_size_);
+}
+
+std::vector<uint64_t> PrefixKVCache::BlockHashes(gsl::span<const int32_t> tokens) const {
+  // FNV-1a over the token ids, chained from block to block so that each hash covers the whole prefix.
+  constexpr uint64_t kOffsetBasis = 14695981039346656037ULL;
+  constexpr uint64_t kPrime = 1099511628211ULL;
+
+  const size_t block_size = static_cast<size_t>(block_size_);
+  const size_t num_blocks = tokens.size() / block_size;
+  std::vector<uint64_t> hashes(num_blocks);
+  uint64_t hash = kOffsetBasis;
+  for (size_t block = 0; block < num_blocks; ++block) {
+    for (size_t i = block * block_size; i < (block + 1) * block_size; ++i) {
+      const uint32_t token = static_cast<uint32_t>(tokens[i]);
+      for (int byte = 0; byte < 4; ++byte) {
+        hash ^= (token >> (8 * byte)) & 0xFF;
+        hash *= kPrime;
+      }
+    }
+    hashes[block] = hash;
+  }
+  return hashes;
+}
+
+PrefixKVCache::EntryList::iterator PrefixKVCache::Find(gsl::span<const int32_t> tokens, uint64_t hash) {
+  const size_t num_blocks = tokens.size() / static_cast<size_t>(block_size_);
+  auto range = index_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    const auto& [entry, entry_blocks] = it->second;
+    // Compare the tokens as well, since different prefixes can share a hash.
+    if (entry_blocks == num_blocks && std::equal(tokens.begin(), tokens.end(), entry->tokens.begin())) {
+      return entry;
+    }
+  }
+  return entries_.end();
+}
+
+int PrefixKVCache::Lookup(gsl::span<const int32_t> tokens, int max_length, std::vector<OrtValue>& presents) {
+  const size_t block_size = static_cast<size_t>(block_size_);
+  const size_t max_blocks = std::min(tokens.size(), static_cast<size_t>(std::max(max_length, 0))) / block_size;
+  const std::vector<uint64_t> hashes = BlockHashes(tokens.first(max_blocks * block_size));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.lookups;
+  for (size_t blocks = max_blocks; blocks > 0; --blocks) {
+    auto entry = Find(tokens.first(blocks * block_size), hashes[blocks - 1]);
+    if (entry != entries_.end()) {
+      entries_.splice(entries_.begin(), entries_, entry);
+      presents = entry->presents;
+
+      const int length = static_cast<int>(blocks * block_size);
+      ++stats_.hits;
+      stats_.reused_tokens += static_cast<uint64_t>(length);
+      return length;
+    }
+  }
+  return 0;
+}
+
+void PrefixKVCache::Insert(gsl::span<const int32_t> tokens, std::vector<OrtValue> presents) {
+  const size_t num_blocks = tokens.size() / static_cast<size_t>(block_size_);
+  if (num_blocks == 0) {
+    return;
+  }
+
+  tokens = tokens.first(num_blocks * static_cast<size_t>(block_size_));
+  std::vector<uint64_t> hashes = BlockHashes(tokens);
+
+  size_t bytes = 0;
+  for (const OrtValue& present : presents) {
+    bytes += present.Get<Tensor>().SizeInBytes();
+  }
+  if (bytes > max_bytes_) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // Another request may have stored the same prompt meanwhile.
+  auto existing = Find(tokens, hashes.back());
+  if (existing != entries_.end()) {
+    entries_.splice(entries_.begin(), entries_, existing);
+    return;
+  }
+
+  while (total_bytes_ + bytes > max_bytes_ && !entries_.empty()) {
+    Erase(std::prev(entries_.end()));
+    ++stats_.evictions;
+  }
+
+  entries_.push_front(Entry{std::vector<int32_t>(tokens.begin(), tokens.end()), std::move(hashes),
+                            std::move(presents), bytes});
+  auto entry = entries_.begin();
+  for (size_t block = 0; block < num_blocks; ++block) {
+    index_.emplace(entry->block_hashes[block], std::make_pair(entry, block + 1));
+  }
+  total_bytes_ += bytes;
+  ++stats_.insertions;
+}
+
+void PrefixKVCache::Erase(EntryList::iterator entry) {
+  for (uint64_t hash : entry->block_hashes) {
+    auto range = index_.equal_range(hash);
+    for (auto it = range.first; it != range.second;) {
+      it = it->second.first == entry ? index_.erase(it) : std::next(it);
+    }
+  }
+  total_bytes_ -= entry->bytes;
+  entries_.erase(entry);
+}
+
+PrefixKVCacheStats PrefixKVCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  PrefixKVCacheStats stats = stats_;
+  stats.bytes = total_bytes_;
+  return stats;
+}
+
+}  // namespace transformers
+}  // namespace contrib
+}  // namespace onnxruntime
@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "core/common/common.h"
+#include "core/framework/ort_value.h"
+
+namespace onnxruntime {
+namespace contrib {
+namespace transformers {
+
+struct PrefixKVCacheStats {
+  uint64_t lookups = 0;
+  uint64_t hits = 0;
+  uint64_t reused_tokens = 0;
+  uint64_t insertions = 0;
+  uint64_t evictions = 0;
+  size_t bytes = 0;  // size of the past state cached now, at most max_bytes
+};
+
+// Keeps the GPT past state of prompt prefixes, so that generation requests sharing a leading run of tokens
+// (a system prompt for example) only run the rest of the prompt through the first subgraph call.
+// Prompts are split into blocks of block_size tokens, and every leading run of whole blocks of a cached prompt is
+// indexed by a hash chained over its blocks. A lookup returns the longest cached block-aligned prefix.
+// Entries are evicted in least recently used order when their total size exceeds max_bytes.
+// The cache is shared by all Compute calls of a node, so every method is thread safe.
+class PrefixKVCache {
+ public:
+  PrefixKVCache(size_t max_bytes, int block_size);
+
+  // Finds the longest cached prefix of tokens that is at most max_length tokens long. On a hit, returns its length
+  // and sets presents to the per-layer past state of the entry, each of shape (2, 1, num_heads, length, head_size)
+  // where length is at least the returned length. Returns 0 on a miss.
+  int Lookup(gsl::span<const int32_t> tokens, int max_length, std::vector<OrtValue>& presents);
+
+  // Stores the past state of the whole blocks of tokens. presents has one tensor per layer of shape
+  // (2, 1, num_heads, length, head_size), where length is the number of tokens rounded down to whole blocks.
+  void Insert(gsl::span<const int32_t> tokens, std::vector<OrtValue> presents);
+
+  int BlockSize() const { return block_size_; }
+
+  PrefixKVCacheStats GetStats() const;
+
+ private:
+  struct Entry {
+    std::vector<int32_t> tokens;
+    std::vector<uint64_t> block_hashes;  // block_hashes[i] covers tokens[0, (i + 1) * block_size)
+    std::vector<OrtValue> presents;
+    size_t bytes;
+  };
+  using EntryList = std::list<Entry>;
+
+  std::vector<uint64_t> BlockHashes(gsl::span<const int32_t> tokens) const;
+
+  // Finds an entry holding tokens. Requires mutex_.
+  EntryList::iterator Find(gsl::span<const int32_t> tokens, uint64_t hash);
+
+  // Removes an entry and its index keys. Requires mutex_.
+  void Erase(EntryList::iterator entry);
+
+  const size_t max_bytes_;
+  const int block_size_;
+
+  mutable std::mutex mutex_;
+  EntryList entries_;  // most recently used first
+  std::unordered_multimap<uint64_t, std::pair<EntryList::iterator, size_t>> index_;  // hash -> (entry, blocks)
+  size_t total_bytes_ = 0;
+  PrefixKVCacheStats stats_;
+};
+
+}  // namespace transformers
+}  // namespace contrib
+}  // namespace onnxruntime
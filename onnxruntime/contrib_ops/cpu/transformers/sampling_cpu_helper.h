@@ -2,56 +2,146 @@
 // Licensed under the MIT License.
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "core/common/common.h"
+#include "core/mlas/inc/mlas.h"
+#include "core/platform/threadpool.h"
+#include "contrib_ops/cpu/transformers/generation_shared.h"
+#include "contrib_ops/cpu/utils/console_dumper.h"
+
 namespace onnxruntime {
 namespace contrib {
 namespace SamplingCpuHelper {
 
-template <typename T>
-void filter_scores(std::vector<size_t>& sorted_indice,
-                   gsl::span<T>& next_token_score,
-                   const transformers::IGenerationParameters* parameters,
-                   size_t chunk_offset,
-                   size_t offset) {
-  size_t real_index = sorted_indice[chunk_offset + offset];
-  next_token_score[chunk_offset + real_index] = (T)parameters->filter_value;
-}
+// Number of tokens that top-p filtering sorts first. Each further round sorts twice as many.
+constexpr size_t kTopPInitialChunk = 64;
 
+// Selects the tokens of a row that are kept by top-k, min-p and top-p filtering, given the softmax probabilities
+// of the row. candidates is scratch space with one element per token. Returns the number of kept tokens, which are
+// moved to the front of candidates.
+//
+// Each filter keeps the most probable tokens of the row, so the candidates are only partitioned or partially sorted
+// and the rest of the vocabulary is never ordered. The tokens kept by top-p add up to top_p of the probability mass
+// left after top-k, like filtering the logits with each warper in turn.
 template <typename T>
-void cumulate_and_filter_custom(gsl::span<T>& next_token_scores,
-                                gsl::span<T>& cumulative_probs,
-                                const transformers::IGenerationParameters* parameters,
-                                std::vector<size_t>& sorted_indices) {
-  for (size_t i = 0; i < static_cast<size_t>(parameters->batch_size); i++) {
-    size_t offset = i * parameters->vocab_size;
-    if (cumulative_probs[offset] > parameters->top_p) {
-      filter_scores(sorted_indices, next_token_scores, parameters, offset, 1);
+size_t SelectTokens(gsl::span<const T> probs,
+                    const transformers::IGenerationParameters* parameters,
+                    gsl::span<int32_t> candidates) {
+  // Ties prefer the lower token id.
+  auto more_probable = [&probs](int32_t a, int32_t b) {
+    return probs[a] > probs[b] || (probs[a] == probs[b] && a < b);
+  };
+
+  std::iota(candidates.begin(), candidates.end(), 0);
+  size_t count = candidates.size();
+  T total = T{1};
+
+  if (parameters->top_k > 0 && static_cast<size_t>(parameters->top_k) < count) {
+    count = static_cast<size_t>(parameters->top_k);
+    std::nth_element(candidates.begin(), candidates.begin() + (count - 1), candidates.end(), more_probable);
+    total = T{0};
+    for (size_t i = 0; i < count; i++) {
+      total += probs[candidates[i]];
     }
-    for (size_t j = 1; j < static_cast<size_t>(parameters->vocab_size) - 1; j++) {
-      cumulative_probs[j + offset] += cumulative_probs[j + offset - 1];
-      if (cumulative_probs[j + offset] > parameters->top_p) {
-        filter_scores(sorted_indices, next_token_scores, parameters, offset, j + 1);
+  }
+
+  if (parameters->min_p > 0.0f) {
+    T max_prob = T{0};
+    for (size_t i = 0; i < count; i++) {
+      max_prob = std::max(max_prob, probs[candidates[i]]);
+    }
+    const T threshold = static_cast<T>(parameters->min_p) * max_prob;
+    count = static_cast<size_t>(std::partition(candidates.begin(), candidates.begin() + count,
+                                               [&probs, threshold](int32_t token) {
+                                                 return probs[token] >= threshold;
+                                               }) -
+                                candidates.begin());
+  }
+
+  if (parameters->top_p < 1.0f) {
+    // A token is kept while the mass of the more probable tokens is below top_p (at most top_p for custom
+    // sampling), so only a prefix of the candidates has to be sorted. Peaked distributions stop in the first chunk.
+    const T threshold = static_cast<T>(parameters->top_p) * total;
+    const size_t min_tokens_to_keep = parameters->custom_sampling
+                                          ? 1
+                                          : std::max<size_t>(static_cast<size_t>(parameters->min_tokens_to_keep), 1);
+    T mass = T{0};
+    size_t kept = count;
+    size_t sorted = 0;
+    for (size_t chunk = kTopPInitialChunk; sorted < count && kept == count; chunk *= 2) {
+      const size_t end = std::min(count, sorted + chunk);
+      std::partial_sort(candidates.begin() + sorted, candidates.begin() + end, candidates.begin() + count,
+                        more_probable);
+      for (size_t i = sorted; i < end; i++) {
+        const bool keep = parameters->custom_sampling ? (i == 0 || mass <= threshold)
+                                                      : (i < min_tokens_to_keep || mass < threshold);
+        if (!keep) {
+          kept = i;
+          break;
+        }
+        mass += probs[candidates[i]];
       }
+      sorted = end;
     }
+    count = kept;
   }
+
+  return count;
 }
 
+// Sets the scores of the tokens that are not kept to filter_value, and draws a token from the softmax of the
+// filtered scores like torch.multinomial(). uniform is a random number in [0, 1).
 template <typename T>
-void cumulate_and_filter(gsl::span<T>& next_token_scores,
-                         gsl::span<T>& cumulative_probs,
-                         const transformers::IGenerationParameters* parameters,
-                         std::vector<size_t>& sorted_indices) {
-  for (size_t i = 0; i < static_cast<size_t>(parameters->batch_size); i++) {
-    size_t offset = i * parameters->vocab_size;
-    if (cumulative_probs[offset] <= 1 - parameters->top_p) {
-      filter_scores(sorted_indices, next_token_scores, parameters, offset, 0);
+int32_t FilterAndSample(gsl::span<T> scores,
+                        gsl::span<int32_t> kept,
+                        float filter_value,
+                        double uniform) {
+  // The cumulative distribution is built in token order, like the Multinomial operator.
+  std::sort(kept.begin(), kept.end());
+
+  float max_score = std::numeric_limits<float>::lowest();
+  size_t next_kept = 0;
+  for (size_t token = 0; token < scores.size(); token++) {
+    if (next_kept < kept.size() && static_cast<size_t>(kept[next_kept]) == token) {
+      next_kept++;
+    } else {
+      scores[token] = static_cast<T>(filter_value);
     }
-    for (size_t j = 1; j < static_cast<size_t>(parameters->vocab_size) - static_cast<size_t>(parameters->min_tokens_to_keep); j++) {
-      cumulative_probs[j + offset] += cumulative_probs[j + offset - 1];
-      if (cumulative_probs[j + offset] <= 1 - parameters->top_p) {
-        filter_scores(sorted_indices, next_token_scores, parameters, offset, j);
-      }
+    if (std::isfinite(static_cast<float>(scores[token]))) {
+      max_score = std::max(max_score, static_cast<float>(scores[token]));
+    }
+  }
+
+  auto weight = [max_score](T score) {
+    return std::isfinite(static_cast<float>(score)) ? std::exp(static_cast<double>(score) - max_score) : 0.0;
+  };
+
+  // The filtered tokens usually have no weight, so only the kept tokens need to be visited.
+  const bool filtered_have_weight = kept.size() < scores.size() && weight(static_cast<T>(filter_value)) > 0.0;
+  const size_t num_tokens = filtered_have_weight ? scores.size() : kept.size();
+  auto token_at = [&](size_t i) { return filtered_have_weight ? static_cast<int32_t>(i) : kept[i]; };
+
+  double total = 0.0;
+  for (size_t i = 0; i < num_tokens; i++) {
+    total += weight(scores[token_at(i)]);
+  }
+
+  const double target = uniform * total;
+  double cumulative = 0.0;
+  for (size_t i = 0; i < num_tokens; i++) {
+    const int32_t token = token_at(i);
+    cumulative += weight(scores[token]);
+    if (cumulative > target) {
+      return token;
     }
   }
+  return token_at(num_tokens - 1);
 }
 
 template <typename T>
@@ -62,99 +152,47 @@ Status Sample(AllocatorPtr& allocator,
               transformers::IGreedySearchState<T>* greedy_state,
               const transformers::IGenerationParameters* parameters,
               const IConsoleDumper* dumper) {
+  ORT_UNUSED_PARAMETER(allocator);
   ORT_UNUSED_PARAMETER(dumper);
 
-  gsl::span<T>& sorted_scores = sampling_state->sorted_scores;
-  memcpy(sorted_scores.data(), next_token_scores.data(), next_token_scores.size_bytes());
-  std::vector<size_t> sorted_indices(static_cast<size_t>(parameters->batch_size) * static_cast<size_t>(parameters->vocab_size));
-
-  std::function<bool(T, T)> predicator;
-  if (parameters->custom_sampling) {
-    predicator = std::greater<T>();
-  } else {
-    predicator = std::less<T>();
-  }
-
-  // TODO: This could be optimized with allocated buffer and handwritten sort algorithm
-  for (size_t i = 0; i < static_cast<size_t>(parameters->batch_size); i++) {
-    auto indices_begin = sorted_indices.begin() + i * parameters->vocab_size;
-    auto indices_end = sorted_indices.begin() + (i + 1) * parameters->vocab_size;
-    gsl::span<T> next_token_score = next_token_scores.subspan(i * parameters->vocab_size, parameters->vocab_size);
-    std::iota(indices_begin, indices_end, 0);
-    std::sort(indices_begin, indices_end,
-              [&next_token_score, &predicator](size_t i1, size_t i2) {
-                return predicator(next_token_score[i1], next_token_score[i2]);
-              });
-
-    std::sort(sorted_scores.begin() + i * parameters->vocab_size,
-              sorted_scores.begin() + (i + 1) * parameters->vocab_size,
-              predicator);
-  }
-
-#ifdef DEBUG_GENERATION
-  dumper->Print("sorted_scores", sorted_scores.data(), parameters->batch_size, parameters->vocab_size);
-  dumper->Print("sorted_indices", sorted_indices.data(), parameters->batch_size, parameters->vocab_size);
-#endif
-
-  gsl::span<T>& cumulative_probs = sampling_state->cumulative_probs;
+  const size_t batch_size = static_cast<size_t>(parameters->batch_size);
+  const size_t vocab_size = static_cast<size_t>(parameters->vocab_size);
 
-  ORT_RETURN_IF_ERROR(SoftmaxCPU<T>(parameters->batch_size,
-                                    parameters->vocab_size,
-                                    sorted_scores.data(),
-                                    cumulative_probs.data(),
-                                    false,
-                                    thread_pool));
-
-  if (parameters->custom_sampling) {
-    cumulate_and_filter_custom(next_token_scores, cumulative_probs, parameters, sorted_indices);
-  } else {
-    cumulate_and_filter(next_token_scores, cumulative_probs, parameters, sorted_indices);
+  // Draw the random numbers up front, in the same order as the Multinomial operator, so that the rows can be
+  // sampled in parallel and the results do not depend on the thread pool.
+  std::vector<double> uniforms(batch_size);
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+  for (size_t i = 0; i < batch_size; i++) {
+    uniforms[i] = distribution(parameters->seed_per_sequence ? sampling_state->sequence_generators[i]
+                                                             : sampling_state->generator);
   }
 
-#ifdef DEBUG_GENERATION
-  dumper->Print("cumulative_probs after filtering", cumulative_probs.data(), parameters->batch_size, parameters->vocab_size);
-  dumper->Print("next_token_scores after filtering", next_token_scores.data(), parameters->batch_size, parameters->vocab_size);
-#endif
+  gsl::span<T>& probs = sampling_state->probs;
+  gsl::span<int32_t>& candidates = sampling_state->candidates;
+  gsl::span<int32_t>& next_tokens = greedy_state->next_tokens;
+
+  const double row_bytes = static_cast<double>(vocab_size * sizeof(T));
+  concurrency::ThreadPool::TryParallelFor(
+      thread_pool, static_cast<std::ptrdiff_t>(batch_size),
+      TensorOpCost{row_bytes, row_bytes, static_cast<double>(vocab_size) * 16},
+      [&](std::ptrdiff_t first, std::ptrdiff_t last) {
+        for (std::ptrdiff_t i = first; i < last; i++) {
+          const size_t offset = static_cast<size_t>(i) * vocab_size;
+          gsl::span<T> row_scores = next_token_scores.subspan(offset, vocab_size);
+          gsl::span<T> row_probs = probs.subspan(offset, vocab_size);
+          gsl::span<int32_t> row_candidates = candidates.subspan(offset, vocab_size);
+
+          MlasComputeSoftmax(row_scores.data(), row_probs.data(), 1, vocab_size, false, false, nullptr);
+          const size_t kept = SelectTokens<T>(row_probs, parameters, row_candidates);
+          next_tokens[i] = FilterAndSample<T>(row_scores, row_candidates.first(kept), parameters->filter_value,
+                                              uniforms[i]);
+        }
+      });
 
-  // torch.multinomial()
-  int64_t next_token_probs_dims[] = {static_cast<int64_t>(parameters->batch_size), parameters->vocab_size};
-  TensorShape next_token_probs_shape(&next_token_probs_dims[0], 2);
-  auto element_type = DataTypeImpl::GetType<T>();
-  OrtValue next_token_probs_value;
-  Tensor::InitOrtValue(element_type,
-                       next_token_probs_shape,
-                       next_token_scores.data(),
-                       allocator->Info(),
-                       next_token_probs_value);
-  const Tensor& input = next_token_probs_value.Get<Tensor>();
-
-  std::default_random_engine& generator = sampling_state->generator;
-
-  int64_t sampled_idx_dims[] = {static_cast<int64_t>(parameters->batch_size), 1};
-  TensorShape sampled_idx_shape(&sampled_idx_dims[0], 2);
-
-  gsl::span<int32_t>& next_token_idx = greedy_state->next_tokens;
-
-  OrtValue sampled_idx_ov;
-  Tensor::InitOrtValue(DataTypeImpl::GetType<int32_t>(),
-                       sampled_idx_shape,
-                       next_token_idx.data(),
-                       allocator->Info(),
-                       sampled_idx_ov);
-  Tensor* sampled_idx = sampled_idx_ov.GetMutable<Tensor>();
-
-  // Copy the allocator because MultinomialComputeShared() uses move(allocator)
-  AllocatorPtr allocatortemp = allocator;
-  ORT_RETURN_IF_ERROR(MultinomialComputeShared<int32_t>(allocatortemp,
-                                                        input,
-                                                        parameters->batch_size,
-                                                        parameters->vocab_size,
-                                                        1,
-                                                        generator,
-                                                        *sampled_idx));
-  // TODO: update presence_mask()
 #ifdef DEBUG_GENERATION
-  dumper->Print("sampled_idx", *sampled_idx);
+  dumper->Print("next_token_scores after filtering", next_token_scores.data(), parameters->batch_size,
+                parameters->vocab_size);
+  dumper->Print("sampled_idx", next_tokens.data(), parameters->batch_size, 1);
 #endif
 
   return Status::OK();
@@ -14,6 +14,11 @@ void SamplingParameters::ParseFromAttributes(const OpKernelInfo& info) {
   no_repeat_ngram_size = static_cast<int>(info.GetAttrOrDefault<int64_t>("no_repeat_ngram_size", 0));
   temperature = info.GetAttrOrDefault<float>("temperature", 1.0f);
   top_p = info.GetAttrOrDefault<float>("top_p", 0.0f);
+  top_k = static_cast<int>(info.GetAttrOrDefault<int64_t>("top_k", 0));
+  ORT_ENFORCE(top_k >= 0, "top_k must be >= 0. Got ", top_k);
+  min_p = info.GetAttrOrDefault<float>("min_p", 0.0f);
+  ORT_ENFORCE(min_p >= 0.0f && min_p <= 1.0f, "min_p must be in the range [0, 1]. Got ", min_p);
+  seed_per_sequence = info.GetAttrOrDefault<int64_t>("seed_per_sequence", 0) != 0;
   filter_value = info.GetAttrOrDefault<float>("filter_value", -std::numeric_limits<float>::infinity());
   min_tokens_to_keep = static_cast<int>(info.GetAttrOrDefault<int64_t>("min_tokens_to_keep", 0));
   presence_penalty = info.GetAttrOrDefault<float>("presence_penalty", 0.0f);
@@ -0,0 +1,261 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+#include <gsl/gsl>
+
+namespace onnxruntime {
+namespace contrib {
+namespace transformers {
+
+// Index of the distinct tokens and of the n-grams of the sequences of all beams, which the repetition penalty and
+// no repeat ngram processors use instead of scanning whole sequences at every step.
+//
+// The history of the tokens is shared by the beams. Every appended token is a node whose parent is the node of the
+// previous token of its sequence, and a beam is the node of its last token, so selecting beams only selects nodes and
+// costs O(1) per beam however long the sequences are. The nodes of the sequences that are no longer selected are
+// dropped when they are half of the nodes, so the index grows with the selected sequences only.
+//
+// The distinct tokens and the n-grams are indexed over all nodes, and a lookup for a beam keeps the nodes on the path
+// of the beam. Whether a node is an ancestor is found in O(log length) with skew-binary jump pointers.
+class SequenceIndex {
+ public:
+  // ngram_size is the size of the n-grams to index, or 0. No repeat unigram only needs the distinct tokens.
+  SequenceIndex(bool index_tokens, int ngram_size)
+      : index_tokens_(index_tokens), ngram_size_(ngram_size > 1 ? ngram_size : 0) {
+    nodes_.push_back(Node{});  // the root is the empty sequence
+  }
+
+  bool IndexesTokens() const { return index_tokens_; }
+  int NGramSize() const { return ngram_size_; }
+
+  bool IsStarted() const { return !beams_.empty(); }
+
+  // Number of nodes, including the root and the nodes of unselected sequences that are not dropped yet.
+  size_t NumNodes() const { return nodes_.size(); }
+
+  // Starts the beams with their current sequences, from get_sequence(beam_index). A beam with the same sequence as
+  // the previous beam, like the beams of a batch after the prompt, shares its nodes.
+  template <typename GetSequence>
+  void Start(int num_beams, GetSequence&& get_sequence) {
+    beams_.clear();
+    nodes_.resize(1);
+    first_occurrences_.clear();
+    ngram_ends_.clear();
+    beams_.reserve(static_cast<size_t>(num_beams));
+    gsl::span<const int32_t> previous;
+    for (int i = 0; i < num_beams; ++i) {
+      gsl::span<const int32_t> sequence = get_sequence(i);
+      if (i > 0 && std::equal(sequence.begin(), sequence.end(), previous.begin(), previous.end())) {
+        beams_.push_back(beams_.back());
+      } else {
+        int32_t node = kRoot;
+        for (int32_t token : sequence) {
+          node = Append(node, token);
+        }
+        beams_.push_back(node);
+      }
+      previous = sequence;
+    }
+    num_nodes_after_compaction_ = nodes_.size();
+  }
+
+  // Beam i continues the sequence of beam beam_indices[i] with next_tokens[i].
+  void SelectBeams(gsl::span<const int32_t> beam_indices, gsl::span<const int32_t> next_tokens) {
+    std::vector<int32_t> selected(beams_.size());
+    for (size_t i = 0; i < beams_.size(); ++i) {
+      selected[i] = Append(beams_[static_cast<size_t>(beam_indices[i])], next_tokens[i]);
+    }
+    beams_.swap(selected);
+
+    if (nodes_.size() >= std::max(kMinNodesToCompact, 2 * num_nodes_after_compaction_)) {
+      Compact();
+    }
+  }
+
+  // Each beam continues its own sequence with next_tokens[i].
+  void AppendTokens(gsl::span<const int32_t> next_tokens) {
+    for (size_t i = 0; i < beams_.size(); ++i) {
+      beams_[i] = Append(beams_[i], next_tokens[i]);
+    }
+  }
+
+  // Calls fn(token) once for each distinct token of the sequence of the beam. Negative tokens are ignored.
+  template <typename Fn>
+  void ForEachToken(int beam_index, Fn&& fn) const {
+    for (int32_t node = nodes_[beams_[static_cast<size_t>(beam_index)]].last_new_token; node != kRoot;
+         node = nodes_[nodes_[node].parent].last_new_token) {
+      fn(nodes_[node].token);
+    }
+  }
+
+  // Calls fn(token) with the last token of each n-gram of the sequence of the beam that starts with the last
+  // ngram_size - 1 tokens of the sequence, which are the tokens that would repeat an n-gram. A token can be reported
+  // more than once.
+  template <typename Fn>
+  void ForEachBlockedToken(int beam_index, Fn&& fn) const {
+    const int32_t beam = beams_[static_cast<size_t>(beam_index)];
+    if (ngram_size_ == 0 || nodes_[beam].depth < ngram_size_) {
+      return;
+    }
+
+    auto it = ngram_ends_.find(HashPrefix(beam));
+    if (it == ngram_ends_.end()) {
+      return;
+    }
+
+    // The hash is verified against the tokens, so hash collisions never block a token.
+    for (int32_t node : it->second) {
+      if (IsOnPath(node, beam) && HasSamePrefix(nodes_[node].parent, beam)) {
+        fn(nodes_[node].token);
+      }
+    }
+  }
+
+ private:
+  static constexpr int32_t kRoot = 0;
+  static constexpr size_t kMinNodesToCompact = 256;
+
+  struct Node {
+    int32_t parent = kRoot;
+    int32_t jump = kRoot;            // ancestor to skip to when looking for an ancestor at a lower depth
+    int32_t depth = 0;               // length of the sequence ending with this node
+    int32_t token = -1;
+    int32_t last_new_token = kRoot;  // nearest node from here to the root whose token is new in its sequence
+  };
+
+  int32_t Append(int32_t parent, int32_t token) {
+    const int32_t index = static_cast<int32_t>(nodes_.size());
+    const Node& parent_node = nodes_[parent];
+    const Node& parent_jump = nodes_[parent_node.jump];
+
+    Node node;
+    node.parent = parent;
+    node.depth = parent_node.depth + 1;
+    node.token = token;
+    node.jump = parent_node.depth - parent_jump.depth == parent_jump.depth - nodes_[parent_jump.jump].depth
+                    ? parent_jump.jump
+                    : parent;
+    node.last_new_token = parent_node.last_new_token;
+    if (index_tokens_ && token >= 0 && !IsTokenOnPath(token, parent)) {
+      node.last_new_token = index;
+      first_occurrences_[token].push_back(index);
+    }
+
+    nodes_.push_back(node);
+
+    if (ngram_size_ != 0 && node.depth >= ngram_size_) {
+      ngram_ends_[HashPrefix(parent)].push_back(index);
+    }
+
+    return index;
+  }
+
+  // Drops the nodes that are not on the path of a beam. Nodes are renumbered in order, so parents stay before their
+  // children, and the jump and last_new_token of a kept node are its ancestors, which are kept too.
+  void Compact() {
+    constexpr int32_t kDropped = -1;
+    std::vector<int32_t> new_index(nodes_.size(), kDropped);
+    new_index[kRoot] = kRoot;
+    for (int32_t beam : beams_) {
+      for (int32_t node = beam; new_index[node] == kDropped; node = nodes_[node].parent) {
+        new_index[node] = kRoot;  // kept, numbered below
+      }
+    }
+
+    size_t num_kept = 0;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      if (new_index[i] == kDropped) {
+        continue;
+      }
+      new_index[i] = static_cast<int32_t>(num_kept);
+      Node node = nodes_[i];
+      node.parent = new_index[node.parent];
+      node.jump = new_index[node.jump];
+      node.last_new_token = new_index[node.last_new_token];
+      nodes_[num_kept++] = node;
+    }
+    nodes_.resize(num_kept);
+    num_nodes_after_compaction_ = num_kept;
+
+    for (int32_t& beam : beams_) {
+      beam = new_index[beam];
+    }
+
+    // Returns whether no node of the list is kept.
+    auto compact_list = [&new_index](std::vector<int32_t>& list) {
+      list.erase(std::remove_if(list.begin(), list.end(), [&](int32_t node) { return new_index[node] == kDropped; }),
+                 list.end());
+      for (int32_t& node : list) {
+        node = new_index[node];
+      }
+      return list.empty();
+    };
+    for (auto it = first_occurrences_.begin(); it != first_occurrences_.end();) {
+      it = compact_list(it->second) ? first_occurrences_.erase(it) : std::next(it);
+    }
+    for (auto it = ngram_ends_.begin(); it != ngram_ends_.end();) {
+      it = compact_list(it->second) ? ngram_ends_.erase(it) : std::next(it);
+    }
+  }
+
+  int32_t GetAncestor(int32_t node, int32_t depth) const {
+    while (nodes_[node].depth > depth) {
+      const int32_t jump = nodes_[node].jump;
+      node = nodes_[jump].depth >= depth ? jump : nodes_[node].parent;
+    }
+    return node;
+  }
+
+  bool IsOnPath(int32_t node, int32_t last) const {
+    return nodes_[node].depth <= nodes_[last].depth && GetAncestor(last, nodes_[node].depth) == node;
+  }
+
+  bool IsTokenOnPath(int32_t token, int32_t last) const {
+    // The first occurrence of the token in a sequence is one of the nodes where it was new.
+    auto it = first_occurrences_.find(token);
+    return it != first_occurrences_.end() &&
+           std::any_of(it->second.begin(), it->second.end(), [&](int32_t node) { return IsOnPath(node, last); });
+  }
+
+  // Hash of the ngram_size - 1 tokens ending with last, from the last one backwards.
+  uint64_t HashPrefix(int32_t last) const {
+    uint64_t hash = 14695981039346656037ULL;
+    for (int i = 0; i + 1 < ngram_size_; ++i, last = nodes_[last].parent) {
+      hash = (hash ^ static_cast<uint64_t>(nodes_[last].token)) * 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  bool HasSamePrefix(int32_t a, int32_t b) const {
+    for (int i = 0; i + 1 < ngram_size_; ++i, a = nodes_[a].parent, b = nodes_[b].parent) {
+      if (nodes_[a].token != nodes_[b].token) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool index_tokens_;
+  int ngram_size_;
+  std::vector<Node> nodes_;
+  std::vector<int32_t> beams_;  // node of the last token of each beam
+  size_t num_nodes_after_compaction_ = 1;
+
+  // Nodes whose token is new in their sequence, by token.
+  std::unordered_map<int32_t, std::vector<int32_t>> first_occurrences_;
+
+  // Nodes ending an n-gram, by the hash of the ngram_size - 1 tokens before them.
+  std::unordered_map<uint64_t, std::vector<int32_t>> ngram_ends_;
+};
+
+}  // namespace transformers
+}  // namespace contrib
+}  // namespace onnxruntime
@@ -40,6 +40,29 @@ int Sequences::GetMaxLength() const {
   return max_length_;
 }
 
+void Sequences::InitIndex(const IGenerationParameters& parameters) {
+  // No repeat unigram blocks every distinct token, so it only needs the distinct tokens.
+  const int ngram_size = parameters.no_repeat_ngram_size;
+  const bool index_tokens = parameters.repetition_penalty != 1.0f || ngram_size == 1;
+
+  index_.reset();
+  if (index_tokens || ngram_size > 1) {
+    index_.emplace(index_tokens, ngram_size);
+  }
+}
+
+const SequenceIndex* Sequences::GetIndex() const {
+  if (!index_.has_value()) {
+    return nullptr;
+  }
+
+  if (!index_->IsStarted()) {
+    index_->Start(batch_beam_size_, [this](int beam_index) { return GetSequence(beam_index); });
+  }
+
+  return &*index_;
+}
+
 #ifdef DEBUG_GENERATION
 void Sequences::PrintSequences(const IConsoleDumper* dumper) const {
   for (int i = 0; i < batch_beam_size_; i++) {
@@ -68,6 +91,11 @@ void Sequences::AppendNextTokenToSequences(
     output[SafeInt<size_t>(i) * max_length_ + current_length_] = beam_next_tokens[i];
   }
 
+  // Before it is started, the index picks up the appended tokens from the sequences.
+  if (index_.has_value() && index_->IsStarted()) {
+    index_->SelectBeams(beam_indices, beam_next_tokens);
+  }
+
   ++current_length_;
 
   // Rotate buffer for next round.
@@ -82,6 +110,10 @@ void Sequences::AppendNextTokenToSequences(gsl::span<int32_t>& next_tokens) {
     output[SafeInt<size_t>(i) * max_length_ + current_length_] = next_tokens[i];
   }
 
+  if (index_.has_value() && index_->IsStarted()) {
+    index_->AppendTokens(next_tokens);
+  }
+
   ++current_length_;
 }
 
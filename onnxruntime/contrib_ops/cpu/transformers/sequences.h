@@ -3,8 +3,11 @@
 
 #pragma once
 
+#include <optional>
+#include <vector>
 #include <gsl/gsl>
 #include "contrib_ops/cpu/transformers/generation_shared.h"
+#include "contrib_ops/cpu/transformers/sequence_index.h"
 #include "contrib_ops/cpu/utils/console_dumper.h"
 
 namespace onnxruntime {
@@ -29,6 +32,13 @@ class Sequences : public ISequences {
   // Returns max sequence length.
   int GetMaxLength() const override;
 
+  // Keep the index of the tokens of the sequences that the repetition penalty and no repeat ngram processors use.
+  // The index follows the sequences as tokens are appended and beams are selected, so the processors do not rescan
+  // whole sequences at every step. Only supported when tokens are appended on CPU.
+  void InitIndex(const IGenerationParameters& parameters);
+
+  const SequenceIndex* GetIndex() const override;
+
 #ifdef DEBUG_GENERATION
   // Print the sequences to StdOut in debug mode
   void PrintSequences(const IConsoleDumper* dumper) const;
@@ -57,6 +67,9 @@ class Sequences : public ISequences {
   int batch_beam_size_;
   int max_length_;
   int current_length_;
+
+  // Started with the current sequences on first access, or empty when InitIndex is not called.
+  mutable std::optional<SequenceIndex> index_;
 };
 
 }  // namespace transformers
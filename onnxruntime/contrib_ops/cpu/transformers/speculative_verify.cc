@@ -0,0 +1,218 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "contrib_ops/cpu/transformers/speculative_verify.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "core/common/narrow.h"
+#include "core/framework/random_seed.h"
+#include "core/mlas/inc/mlas.h"
+#include "core/platform/threadpool.h"
+
+namespace onnxruntime {
+namespace contrib {
+
+ONNX_OPERATOR_KERNEL_EX(
+    SpeculativeVerify,
+    kMSDomain,
+    1,
+    kCpuExecutionProvider,
+    KernelDefBuilder()
+        .TypeConstraint("T", DataTypeImpl::GetTensorType<float>())
+        .TypeConstraint("I", DataTypeImpl::GetTensorType<int32_t>()),
+    SpeculativeVerify);
+
+SpeculativeVerify::SpeculativeVerify(const OpKernelInfo& info)
+    : OpKernel(info),
+      do_sample_(info.GetAttrOrDefault<int64_t>("do_sample", 0) != 0),
+      temperature_(info.GetAttrOrDefault<float>("temperature", 1.0f)),
+      pad_token_id_(static_cast<int32_t>(info.GetAttrOrDefault<int64_t>("pad_token_id", 0))) {
+  ORT_ENFORCE(temperature_ > 0.0f, "temperature must be positive. Got ", temperature_);
+
+  // read optional seed attribute and generate if not provided
+  float seed = 0.f;
+  if (info.GetAttr<float>("seed", &seed).IsOK()) {
+    generator_ = std::default_random_engine{gsl::narrow_cast<uint32_t>(seed)};
+  } else {
+    // node index is added to the global seed to avoid two nodes generating the same sequence of random data
+    generator_ = std::default_random_engine{gsl::narrow_cast<uint32_t>(utils::GetRandomSeed() + info.node().Index())};
+  }
+}
+
+namespace {
+
+int32_t ArgMax(const float* logits, size_t vocab_size) {
+  return static_cast<int32_t>(std::max_element(logits, logits + vocab_size) - logits);
+}
+
+// Draws a token from an unnormalized non-negative distribution. Falls back to the last token with non-zero weight
+// when rounding leaves the draw past the accumulated total.
+int32_t SampleFrom(const float* weights, size_t vocab_size, float total, std::default_random_engine& generator) {
+  std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+  const float target = distribution(generator) * total;
+  float cumulative = 0.0f;
+  int32_t last_candidate = 0;
+  for (size_t i = 0; i < vocab_size; ++i) {
+    if (weights[i] > 0.0f) {
+      cumulative += weights[i];
+      last_candidate = static_cast<int32_t>(i);
+      if (target < cumulative) {
+        return last_candidate;
+      }
+    }
+  }
+  return last_candidate;
+}
+
+}  // namespace
+
+Status SpeculativeVerify::Compute(OpKernelContext* context) const {
+  const Tensor* draft_tokens = context->Input<Tensor>(0);
+  const Tensor* logits = context->Input<Tensor>(1);
+  const Tensor* draft_probs = context->Input<Tensor>(2);
+
+  const auto& draft_dims = draft_tokens->Shape().GetDims();
+  const auto& logits_dims = logits->Shape().GetDims();
+  if (draft_dims.size() != 2 || logits_dims.size() != 3 ||
+      logits_dims[0] != draft_dims[0] || logits_dims[1] != draft_dims[1] + 1) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Expected draft_tokens of shape (batch_size, k) and logits of shape "
+                           "(batch_size, k + 1, vocab_size). Got ",
+                           draft_tokens->Shape(), " and ", logits->Shape());
+  }
+
+  const int64_t batch_size = draft_dims[0];
+  const int64_t num_draft = draft_dims[1];
+  const int64_t vocab_size = logits_dims[2];
+  if (vocab_size <= 0) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "logits must have a non-empty vocabulary dimension");
+  }
+
+  if (do_sample_) {
+    if (draft_probs == nullptr) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "draft_probs is required when do_sample is 1");
+    }
+    if (draft_probs->Shape() != TensorShape({batch_size, num_draft, vocab_size})) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "Expected draft_probs of shape (batch_size, k, vocab_size). Got ", draft_probs->Shape());
+    }
+  }
+
+  Tensor* tokens = context->Output(0, {batch_size, num_draft + 1});
+  Tensor* accepted_lengths = context->Output(1, {batch_size});
+
+  const int32_t* draft_data = draft_tokens->Data<int32_t>();
+  const float* logits_data = logits->Data<float>();
+  int32_t* tokens_data = tokens->MutableData<int32_t>();
+  int32_t* accepted_data = accepted_lengths->MutableData<int32_t>();
+  std::fill_n(tokens_data, narrow<size_t>(tokens->Shape().Size()), pad_token_id_);
+
+  const size_t vocab = narrow<size_t>(vocab_size);
+  const size_t positions = narrow<size_t>(num_draft + 1);
+
+  if (!do_sample_) {
+    // Accept draft tokens while they match the argmax of the main model, then emit the main model's choice at the
+    // first mismatch, or at the position after the draft when every draft token is accepted.
+    auto verify_rows = [&](std::ptrdiff_t first, std::ptrdiff_t last) {
+      for (std::ptrdiff_t b = first; b < last; ++b) {
+        const int32_t* draft = draft_data + b * num_draft;
+        const float* row_logits = logits_data + static_cast<size_t>(b) * positions * vocab;
+        int32_t* row_tokens = tokens_data + static_cast<size_t>(b) * positions;
+
+        int64_t accepted = 0;
+        int32_t next_token = ArgMax(row_logits, vocab);
+        while (accepted < num_draft && next_token == draft[accepted]) {
+          row_tokens[accepted] = next_token;
+          ++accepted;
+          next_token = ArgMax(row_logits + static_cast<size_t>(accepted) * vocab, vocab);
+        }
+
+        row_tokens[accepted] = next_token;
+        accepted_data[b] = static_cast<int32_t>(accepted);
+      }
+    };
+
+    const double row_bytes = static_cast<double>(positions * vocab * sizeof(float));
+    concurrency::ThreadPool::TryParallelFor(context->GetOperatorThreadPool(), static_cast<std::ptrdiff_t>(batch_size),
+                                            TensorOpCost{row_bytes, static_cast<double>(positions * sizeof(int32_t)),
+                                                         static_cast<double>(positions * vocab)},
+                                            verify_rows);
+    return Status::OK();
+  }
+
+  // Rejection sampling: draft token x drawn from q is kept with probability min(1, p(x) / q(x)). The first rejected
+  // position is resampled from the residual max(0, p - q), and a fully accepted draft gets one extra token from p.
+  const float* draft_probs_data = draft_probs->Data<float>();
+  std::vector<float> probs(vocab);
+  std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+
+  auto target_probs = [&](const float* position_logits) {
+    if (temperature_ == 1.0f) {
+      MlasComputeSoftmax(position_logits, probs.data(), 1, vocab, false, false, nullptr);
+    } else {
+      for (size_t i = 0; i < vocab; ++i) {
+        probs[i] = position_logits[i] / temperature_;
+      }
+      MlasComputeSoftmax(probs.data(), probs.data(), 1, vocab, false, false, nullptr);
+    }
+  };
+
+  std::lock_guard<std::mutex> l(generator_mutex_);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    const int32_t* draft = draft_data + b * num_draft;
+    const float* row_logits = logits_data + static_cast<size_t>(b) * positions * vocab;
+    const float* row_draft_probs = draft_probs_data + static_cast<size_t>(b) * num_draft * vocab;
+    int32_t* row_tokens = tokens_data + static_cast<size_t>(b) * positions;
+
+    int64_t accepted = 0;
+    int32_t next_token = -1;
+    for (; accepted < num_draft; ++accepted) {
+      target_probs(row_logits + static_cast<size_t>(accepted) * vocab);
+      const float* q = row_draft_probs + static_cast<size_t>(accepted) * vocab;
+      const int32_t x = draft[accepted];
+      if (x < 0 || x >= vocab_size) {
+        return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "Draft token ", x, " is out of range [0, ",
+                               vocab_size, ")");
+      }
+
+      // p(x) >= q(x) always accepts, which also covers q(x) == 0.
+      const float p_x = probs[x];
+      const float q_x = q[x];
+      if (p_x >= q_x || distribution(generator_) * q_x < p_x) {
+        row_tokens[accepted] = x;
+        continue;
+      }
+
+      float residual_total = 0.0f;
+      for (size_t i = 0; i < vocab; ++i) {
+        probs[i] = std::max(probs[i] - q[i], 0.0f);
+        residual_total += probs[i];
+      }
+
+      // The residual is only empty when p == q, in which case the draft token would have been accepted.
+      // Guard against rounding by falling back to the target distribution.
+      if (residual_total <= 0.0f) {
+        target_probs(row_logits + static_cast<size_t>(accepted) * vocab);
+        residual_total = 1.0f;
+      }
+
+      next_token = SampleFrom(probs.data(), vocab, residual_total, generator_);
+      break;
+    }
+
+    if (next_token < 0) {
+      target_probs(row_logits + static_cast<size_t>(num_draft) * vocab);
+      next_token = SampleFrom(probs.data(), vocab, 1.0f, generator_);
+    }
+
+    row_tokens[accepted] = next_token;
+    accepted_data[b] = static_cast<int32_t>(accepted);
+  }
+
+  return Status::OK();
+}
+
+}  // namespace contrib
+}  // namespace onnxruntime
@@ -0,0 +1,40 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <mutex>
+#include <random>
+
+#include "core/common/common.h"
+#include "core/framework/op_kernel.h"
+
+namespace onnxruntime {
+namespace contrib {
+
+/**
+ * @brief Verification step of speculative decoding.
+ * Given k draft tokens and the logits of the main model over the k + 1 positions they cover, accepts the longest
+ * valid prefix of the draft and produces the next token from the main model. Greedy mode accepts a draft token when
+ * it is the argmax of the main model. Sampling mode uses rejection sampling against the draft probabilities, so the
+ * output follows the distribution of the main model.
+ */
+class SpeculativeVerify final : public OpKernel {
+ public:
+  SpeculativeVerify(const OpKernelInfo& info);
+
+  Status Compute(OpKernelContext* context) const override;
+
+ private:
+  bool do_sample_;
+  float temperature_;
+  int32_t pad_token_id_;
+
+  // generator_ is updated with every call to Compute() in sampling mode.
+  // use generator_mutex_ to ensure Compute() can be called concurrently.
+  mutable std::default_random_engine generator_;
+  mutable std::mutex generator_mutex_;
+};
+
+}  // namespace contrib
+}  // namespace onnxruntime
@@ -1,7 +1,9 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <cstring>
 #include <utility>
+#include "core/common/inlined_containers.h"
 #include "core/framework/framework_common.h"
 #include "core/framework/session_state.h"
 #include "core/framework/tensorprotoutils.h"
@@ -57,6 +59,35 @@ Subgraph::Subgraph(
   }
 }
 
+bool Subgraph::AreSharedCrossAttentionInputs(int first_input_index, int num_inputs) const {
+  if (num_inputs <= 0) {
+    return false;
+  }
+
+  InlinedHashSet<std::string_view> names;
+  for (int i = first_input_index; i < first_input_index + num_inputs; ++i) {
+    names.insert(subgraph_input_names[i]);
+  }
+
+  for (const auto& n : subgraph.Nodes()) {
+    for (const NodeArg* arg : n.ImplicitInputDefs()) {
+      if (names.count(arg->Name()) != 0) {
+        return false;
+      }
+    }
+
+    const auto& input_defs = n.InputDefs();
+    for (size_t i = 0; i < input_defs.size(); ++i) {
+      if (input_defs[i]->Exists() && names.count(input_defs[i]->Name()) != 0 &&
+          (n.OpType() != "DecoderMaskedMultiHeadAttention" || n.Domain() != kMSDomain || (i != 1 && i != 2))) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 Status Subgraph::Setup(const SessionState& session_state,
                        const SessionState& subgraph_session_state) {
   session_state_ = &session_state;
@@ -216,6 +247,11 @@ Status Subgraph::AppendBeamWidthAndCacheIndir(std::vector<OrtValue>& feeds,
   OrtValue default_cache_indirection;
   Tensor::InitOrtValue(DataTypeImpl::GetType<int32_t>(), cache_indirection_shape,
                        default_allocator, default_cache_indirection);
+  if (default_allocator->Info().device.Type() == OrtDevice::CPU) {
+    // The CUDA providers initialize it with InitCacheIndir. On CPU no beam has been reordered yet.
+    memset(default_cache_indirection.GetMutable<Tensor>()->MutableDataRaw(), 0,
+           default_cache_indirection.Get<Tensor>().SizeInBytes());
+  }
   feeds.push_back(default_cache_indirection);
 
   return Status::OK();
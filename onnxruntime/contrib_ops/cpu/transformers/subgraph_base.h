@@ -48,6 +48,9 @@ class Subgraph {
   bool has_decoder_masked_attention_;
   bool output_cross_qk_ = false;
 
+  // Whether the cross attention past inputs can be fed with one copy per batch entry instead of one per beam.
+  bool share_cross_attention_kv_ = false;
+
   // Setup execution
   Status Setup(const SessionState& session_state,
                const SessionState& subgraph_session_state);
@@ -68,6 +71,16 @@ class Subgraph {
                        const ONNX_NAMESPACE::TensorShapeProto* logits_shape,
                        bool merged_past);
 
+  // Whether the given subgraph inputs are only consumed as key or value of DecoderMaskedMultiHeadAttention nodes,
+  // which accept cross attention key and value shared by the beams of each batch entry.
+  bool AreSharedCrossAttentionInputs(int first_input_index, int num_inputs) const;
+
+  // Whether a cross attention key or value computed by the encoder can be fed to the decoder without expanding it
+  // for each beam. Only the CPU kernel of DecoderMaskedMultiHeadAttention reads shared key and value.
+  bool ShareCrossAttentionKV(const OrtValue& encoder_fetch) const {
+    return share_cross_attention_kv_ && encoder_fetch.Get<Tensor>().Location().device.Type() == OrtDevice::CPU;
+  }
+
   Status AppendPastSequenceLength(std::vector<OrtValue>& feeds,
                                   AllocatorPtr cpu_allocator,
                                   const int32_t init_value);
@@ -99,6 +99,11 @@ Status T5DecoderSubgraph::Validate(const std::vector<const NodeArg*>& subgraph_i
   ORT_RETURN_IF_ERROR(GetParameters(past_shape, logits_shape, false));
   num_layers = (static_cast<int>(subgraph_outputs.size()) - first_present_output_index_) / 2;
 
+  // Cross attention key and value are static during decoding, so the beams can share one copy when they only feed
+  // DecoderMaskedMultiHeadAttention.
+  share_cross_attention_kv_ = has_decoder_masked_attention_ &&
+                              AreSharedCrossAttentionInputs(first_past_input_index_ + 2 * num_layers, 2 * num_layers);
+
   // If input_ids's shape is ['batch_size', 1] then use next token as input_ids.
   // Otherwise in the case of shape ['batch_size', 'sequence'], use sequence as input_ids.
   const ONNX_NAMESPACE::TensorShapeProto* input_ids_shape = subgraph_inputs[0]->Shape();
@@ -311,6 +316,10 @@ Status T5DecoderSubgraph::CreateInitialFeeds(
 
     // Add cross inputs from encoder output.
     for (size_t j = 0; j < encoder_fetches.size(); j++) {
+      if (ShareCrossAttentionKV(encoder_fetches[j])) {
+        decoder_feeds.push_back(encoder_fetches[j]);
+        continue;
+      }
       ADD_DECODER_FEED(encoder_fetches[j], false);
     }
   } else {
@@ -318,6 +327,11 @@ Status T5DecoderSubgraph::CreateInitialFeeds(
     for (size_t j = 2; j < encoder_fetches.size(); j++) {
       // past key/value for cross attention does not need to be initialized with max_seq_len since they are static.
       bool is_dynamic_kv_cache = (j - first_past_input_index_) < 2 * static_cast<size_t>(num_layers);
+      // Encoder fetches are logits, encoder_hidden_states, self attention presents and then cross attention presents.
+      if (j >= 2 + 2 * static_cast<size_t>(num_layers) && ShareCrossAttentionKV(encoder_fetches[j])) {
+        decoder_feeds.push_back(encoder_fetches[j]);
+        continue;
+      }
       ADD_DECODER_FEED(encoder_fetches[j], is_dynamic_kv_cache);
     }
   }
@@ -100,6 +100,11 @@ Status WhisperDecoderSubgraph::Validate(const std::vector<const NodeArg*>& subgr
 
   num_layers = (static_cast<int>(subgraph_outputs.size()) - first_present_output_index_) / (output_cross_qk_ ? 3 : 2);
 
+  // Cross attention key and value are static during decoding, so the beams can share one copy when they only feed
+  // DecoderMaskedMultiHeadAttention.
+  share_cross_attention_kv_ = has_decoder_masked_attention_ &&
+                              AreSharedCrossAttentionInputs(first_past_input_index_ + 2 * num_layers, 2 * num_layers);
+
   // If input_ids's shape is ['batch_size', 1] then use next token as input_ids.
   // Otherwise in the case of shape ['batch_size', 'sequence'], use sequence as input_ids.
   const ONNX_NAMESPACE::TensorShapeProto* input_ids_shape = subgraph_inputs[0]->Shape();
@@ -228,6 +233,9 @@ Status WhisperDecoderSubgraph::CreateInitialFeeds(
                                                      0 /*max_sequence_length*/));
       }
       decoder_feeds.push_back(expanded_hidden_states);
+    } else if (j >= 2 + 2 * static_cast<size_t>(num_layers) && ShareCrossAttentionKV(encoder_fetches[j])) {
+      // Encoder fetches are logits, encoder_hidden_states, self attention presents and then cross attention presents.
+      decoder_feeds.push_back(encoder_fetches[j]);
     } else {
       // past key/value for cross attention does not need to be initialized with max_seq_len since they are static.
       bool use_max_seq_len = (j - first_past_input_index_) <= 2 * static_cast<size_t>(num_layers);
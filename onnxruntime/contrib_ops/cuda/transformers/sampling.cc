@@ -32,6 +32,10 @@ CudaTensorConsoleDumper g_cuda_dumper_sampling;
 
 Sampling::Sampling(const OpKernelInfo& info)
     : onnxruntime::contrib::transformers::Sampling(info) {
+  ORT_ENFORCE(info.GetAttrOrDefault<int64_t>("top_k", 0) == 0 && info.GetAttrOrDefault<float>("min_p", 0.0f) == 0.0f &&
+                  info.GetAttrOrDefault<int64_t>("seed_per_sequence", 0) == 0,
+              "top_k, min_p and seed_per_sequence are only supported by the CPU Sampling kernel.");
+
   SetDeviceHelpers(GenerationCudaDeviceHelper::AddToFeeds,
                    GenerationCudaDeviceHelper::TopK,
                    GenerationCudaDeviceHelper::DeviceCopy<float>,
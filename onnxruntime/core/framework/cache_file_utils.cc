@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/framework/cache_file_utils.h"
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#include "core/common/common.h"
+#include "core/common/path_string.h"
+#include "core/framework/murmurhash3.h"
+#include "core/platform/env.h"
+
+namespace onnxruntime {
+namespace utils {
+
+std::ostream& operator<<(std::ostream& stream, const CacheStatistics& statistics) {
+  return stream << "hits: " << statistics.num_hits.load() << " misses: " << statistics.num_misses.load();
+}
+
+std::string HashToHexString(const void* data, size_t size) {
+  uint32_t hash[4] = {0, 0, 0, 0};
+  MurmurHash3::x86_128(data, size, 0, hash);
+
+  std::ostringstream ss;
+  ss << std::hex << std::setfill('0');
+  for (uint32_t value : hash) {
+    ss << std::setw(8) << value;
+  }
+  return ss.str();
+}
+
+Status WriteCacheFile(const std::filesystem::path& path,
+                      const std::function<Status(const std::filesystem::path& temp_path)>& write_file) {
+  std::ostringstream temp_suffix;
+  temp_suffix << ".tmp." << Env::Default().GetSelfPid() << "." << std::this_thread::get_id() << "."
+              << std::chrono::steady_clock::now().time_since_epoch().count();
+  std::filesystem::path temp_path = path;
+  temp_path += temp_suffix.str();
+
+  Status status = write_file(temp_path);
+  std::error_code ec;
+  if (status.IsOK()) {
+    std::error_code rename_ec;
+    std::filesystem::rename(temp_path, path, rename_ec);
+    // renaming over an existing file fails on some platforms. keep the file another session added in that case.
+    if (rename_ec && !std::filesystem::is_regular_file(path, ec)) {
+      status = ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "Failed to rename ", PathToUTF8String(temp_path.native()), " to ",
+                               PathToUTF8String(path.native()), ": ", rename_ec.message());
+    }
+  }
+
+  std::filesystem::remove(temp_path, ec);
+  return status;
+}
+
+}  // namespace utils
+}  // namespace onnxruntime
@@ -0,0 +1,47 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <ostream>
+#include <string>
+
+#include "core/common/status.h"
+
+namespace onnxruntime {
+namespace utils {
+
+/**
+ * Hit and miss counts of an on-disk cache, logged with its lookups.
+ */
+struct CacheStatistics {
+  std::atomic<uint64_t> num_hits{0};
+  std::atomic<uint64_t> num_misses{0};
+
+  void AddLookup(bool found) {
+    ++(found ? num_hits : num_misses);
+  }
+};
+
+// Writes "hits: <num_hits> misses: <num_misses>".
+std::ostream& operator<<(std::ostream& stream, const CacheStatistics& statistics);
+
+// Returns the 128-bit MurmurHash3 of the data as a hex string, for the keys of the entries of on-disk caches.
+std::string HashToHexString(const void* data, size_t size);
+
+/**
+ * Writes a file of an on-disk cache that concurrent sessions may write too.
+ *
+ * write_file writes the contents to a temporary file that is then renamed to path, so readers never see a partially
+ * written file. The name of the temporary file is unique to the calling thread, and the last rename wins. If the
+ * rename fails because another session added the file already, that file is kept.
+ */
+Status WriteCacheFile(const std::filesystem::path& path,
+                      const std::function<Status(const std::filesystem::path& temp_path)>& write_file);
+
+}  // namespace utils
+}  // namespace onnxruntime
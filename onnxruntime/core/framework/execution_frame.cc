@@ -351,7 +351,8 @@ ExecutionFrame::ExecutionFrame(gsl::span<const int> feed_mlvalue_idxs, gsl::span
 #ifdef ORT_ENABLE_STREAM
                                const DeviceStreamCollection* device_streams,
 #endif
-                               const SessionState& session_state)
+                               const SessionState& session_state,
+                               const PrunedExecutionPlan* pruned_plan)
     : IExecutionFrame(session_state.GetOrtValueNameIdxMap(), session_state.GetNodeIndexInfo(), fetch_mlvalue_idxs),
 #ifdef ORT_ENABLE_STREAM
       device_streams_(device_streams),
@@ -406,7 +407,7 @@ ExecutionFrame::ExecutionFrame(gsl::span<const int> feed_mlvalue_idxs, gsl::span
 
     // if there are some traditional ml value type in inputs disable the memory pattern optimization.
     if (all_tensors) {
-      mem_patterns_ = session_state.GetMemoryPatternGroup(feeds, feed_mlvalue_idxs, inferred_shapes_);
+      mem_patterns_ = session_state.GetMemoryPatternGroup(feeds, feed_mlvalue_idxs, inferred_shapes_, pruned_plan);
       // if no existing patterns, generate one in this execution frame
       if (!mem_patterns_) {
         planner_.emplace(*session_state.GetExecutionPlan());
@@ -704,8 +705,8 @@ static Status AllocateSparseTensor(OrtValue& mlvalue, const DataTypeImpl& ml_typ
 #endif
 
 Status ExecutionFrame::AllocateReusedOrtValueIfNotAllocatedHelper(int reuse_mlvalue_index, const TensorShape* shape) {
-  // In case OrtRunOptions.only_execute_path_to_fetches == true, it is possible that 'reuse_value'
-  // is not allocated (its upstream op is not executed due to the option).
+  // In case the execution is pruned to the fetches, it is possible that 'reuse_value'
+  // is not allocated (its upstream op is not executed, or it was released after its last executed consumer).
   // In this case we need to allocate 'reuse_value' and then let 'ort_value' to reuse it.
   OrtValue& reuse_value = GetMutableMLValue(reuse_mlvalue_index);
   if (!reuse_value.IsAllocated()) {
@@ -23,6 +23,7 @@ class DataTransferManager;
 class SessionState;
 class OrtValueNameIdxMap;
 struct MemoryPatternGroup;
+struct PrunedExecutionPlan;
 class NodeIndexInfo;
 class Stream;
 #ifdef ORT_ENABLE_STREAM
@@ -148,7 +149,9 @@ class ExecutionFrame final : public IExecutionFrame {
 #ifdef ORT_ENABLE_STREAM
                  const DeviceStreamCollection* device_streams,
 #endif
-                 const SessionState& session_state);
+                 const SessionState& session_state,
+                 // the memory patterns of pruned runs are kept apart from those of full runs
+                 const PrunedExecutionPlan* pruned_plan = nullptr);
   ~ExecutionFrame() override;
 
   // TODO: These two AllocateMLValue... methods are in the API purely for unit test usage.
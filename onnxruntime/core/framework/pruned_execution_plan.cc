@@ -0,0 +1,112 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/framework/pruned_execution_plan.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "core/common/hash_combine.h"
+#include "core/framework/ort_value_name_idx_map.h"
+#include "core/framework/sequential_execution_plan.h"
+#include "core/graph/graph_viewer.h"
+
+namespace onnxruntime {
+
+Status PrunedExecutionPlan::Create(const GraphViewer& graph_viewer, const OrtValueNameIdxMap& ort_value_name_idx_map,
+                                   const SequentialExecutionPlan& execution_plan,
+                                   gsl::span<const int> fetch_mlvalue_idxs,
+                                   std::unique_ptr<PrunedExecutionPlan>& plan) {
+  plan.reset();
+
+  // Get the nodes producing the fetches. Fetches that are graph inputs or initializers do not need any node.
+  InlinedVector<const Node*> fetch_producers;
+  fetch_producers.reserve(fetch_mlvalue_idxs.size());
+  for (NodeIndex node_index : graph_viewer.GetNodesInTopologicalOrder()) {
+    const Node* node = graph_viewer.GetNode(node_index);
+    for (const NodeArg* output : node->OutputDefs()) {
+      int idx = -1;
+      if (output->Exists() && ort_value_name_idx_map.GetIdx(output->Name(), idx).IsOK() &&
+          std::find(fetch_mlvalue_idxs.begin(), fetch_mlvalue_idxs.end(), idx) != fetch_mlvalue_idxs.end()) {
+        fetch_producers.push_back(node);
+        break;
+      }
+    }
+  }
+
+  auto pruned_plan = std::make_unique<PrunedExecutionPlan>();
+  auto& nodes_to_execute = pruned_plan->nodes_to_execute;
+  nodes_to_execute.reserve(graph_viewer.NumberOfNodes());
+  graph_viewer.GetGraph().ReverseDFSFrom(
+      fetch_producers, {}, [&nodes_to_execute](const Node* n) { nodes_to_execute.insert(n->Index()); });
+
+  if (nodes_to_execute.size() == static_cast<size_t>(graph_viewer.NumberOfNodes())) {
+    return Status::OK();
+  }
+
+  const auto& alloc_plan = execution_plan.allocation_plan;
+  const auto& release_actions = execution_plan.release_actions;
+  InlinedHashMap<size_t, size_t> value_to_release_action;
+  value_to_release_action.reserve(release_actions.size());
+  for (size_t i = 0; i < release_actions.size(); ++i) {
+    value_to_release_action.emplace(release_actions[i].value_index, i);
+  }
+
+  auto& node_release_list = pruned_plan->node_release_list;
+  auto& release_ref_counts = pruned_plan->release_ref_counts;
+  node_release_list.resize(execution_plan.node_release_list.size());
+  release_ref_counts.resize(release_actions.size(), 0);
+
+  // Like the allocation planner, count the executed consumers of the buffer each input is allocated in.
+  for (NodeIndex node_index : nodes_to_execute) {
+    auto& releases = node_release_list[node_index];
+    auto process_input = [&](const NodeArg& input, size_t /*arg_idx*/) -> Status {
+      if (input.Exists()) {
+        int value_idx;
+        ORT_RETURN_IF_ERROR(ort_value_name_idx_map.GetIdx(input.Name(), value_idx));
+        auto it = value_to_release_action.find(static_cast<size_t>(alloc_plan[value_idx].reused_buffer));
+        if (it != value_to_release_action.end() &&
+            std::find(releases.begin(), releases.end(), it->second) == releases.end()) {
+          releases.push_back(it->second);
+          ++release_ref_counts[it->second];
+        }
+      }
+      return Status::OK();
+    };
+
+    const Node* node = graph_viewer.GetNode(node_index);
+    ORT_RETURN_IF_ERROR(Node::ForEachWithIndex(node->InputDefs(), process_input));
+    ORT_RETURN_IF_ERROR(Node::ForEachWithIndex(node->ImplicitInputDefs(), process_input));
+  }
+
+  // Outputs that are only consumed by skipped nodes are released right after they are produced.
+  for (NodeIndex node_index : nodes_to_execute) {
+    const Node* node = graph_viewer.GetNode(node_index);
+    for (const NodeArg* output : node->OutputDefs()) {
+      int value_idx;
+      if (!output->Exists() || !ort_value_name_idx_map.GetIdx(output->Name(), value_idx).IsOK() ||
+          alloc_plan[value_idx].alloc_kind != AllocKind::kAllocate) {
+        continue;
+      }
+
+      auto it = value_to_release_action.find(static_cast<size_t>(value_idx));
+      if (it != value_to_release_action.end() && release_ref_counts[it->second] == 0) {
+        node_release_list[node_index].push_back(it->second);
+        release_ref_counts[it->second] = 1;
+      }
+    }
+  }
+
+  size_t key = 0;
+  InlinedVector<int> sorted_idxs(fetch_mlvalue_idxs.begin(), fetch_mlvalue_idxs.end());
+  std::sort(sorted_idxs.begin(), sorted_idxs.end());
+  for (int idx : sorted_idxs) {
+    HashCombine(idx, key);
+  }
+  pruned_plan->memory_pattern_key = static_cast<int64_t>(key);
+
+  plan = std::move(pruned_plan);
+  return Status::OK();
+}
+
+}  // namespace onnxruntime
@@ -0,0 +1,49 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "core/common/inlined_containers.h"
+#include "core/common/status.h"
+#include "core/graph/basic_types.h"
+
+namespace onnxruntime {
+
+class GraphViewer;
+class OrtValueNameIdxMap;
+struct SequentialExecutionPlan;
+
+/**
+ * The part of a SequentialExecutionPlan that computes a subset of the outputs of the graph.
+ *
+ * The steps of the execution plan are kept, but the kernels of the nodes outside of the backward cone of the fetches
+ * are not launched, so their outputs are never allocated. The release actions of the execution plan are counted down
+ * by the executed consumers only, so that values shared with skipped nodes are released after their last executed
+ * consumer rather than at the end of the run.
+ */
+struct PrunedExecutionPlan {
+  // Creates the plan for the given fetches. plan is set to nullptr if all nodes are needed to compute them.
+  static Status Create(const GraphViewer& graph_viewer, const OrtValueNameIdxMap& ort_value_name_idx_map,
+                       const SequentialExecutionPlan& execution_plan, gsl::span<const int> fetch_mlvalue_idxs,
+                       std::unique_ptr<PrunedExecutionPlan>& plan);
+
+  bool IsNodeExecuted(NodeIndex node_index) const { return nodes_to_execute.count(node_index) != 0; }
+
+  // Nodes in the backward cone of the fetches.
+  InlinedHashSet<NodeIndex> nodes_to_execute;
+
+  // Replacements of SequentialExecutionPlan::node_release_list and of the ref_count of its release_actions.
+  std::vector<InlinedVector<size_t>> node_release_list;
+  std::vector<int> release_ref_counts;
+
+  // Mixed into the keys of the memory patterns, as the patterns traced in a pruned run do not cover the values of
+  // the skipped nodes.
+  int64_t memory_pattern_key{0};
+};
+
+}  // namespace onnxruntime
@@ -597,6 +597,12 @@ onnxruntime::Status ExecuteThePlan(const SessionState& session_state, gsl::span<
       valid_streams++;
   }
 
+  // the plan is shared with the cache of the session state, it is kept alive here in case it is evicted during the run
+  std::shared_ptr<const PrunedExecutionPlan> pruned_plan;
+  if (only_execute_path_to_fetches || session_state.GetPruneExecutionToFetches()) {
+    ORT_RETURN_IF_ERROR(session_state.GetPrunedExecutionPlan(fetch_mlvalue_idxs, pruned_plan));
+  }
+
   // prepare the execution context, notifications got initialized.
 #ifdef ORT_ENABLE_STREAM
   StreamExecutionContext ctx(session_state,
@@ -610,7 +616,8 @@ onnxruntime::Status ExecuteThePlan(const SessionState& session_state, gsl::span<
                              fetches,
                              fetch_allocators,
                              logger,
-                             single_thread_mode);
+                             single_thread_mode,
+                             pruned_plan.get());
 #else
   StreamExecutionContext ctx(session_state,
                              valid_streams,
@@ -620,15 +627,8 @@ onnxruntime::Status ExecuteThePlan(const SessionState& session_state, gsl::span<
                              fetches,
                              fetch_allocators,
                              logger,
-                             single_thread_mode);
-#endif
-#ifdef ENABLE_TRAINING
-  if (only_execute_path_to_fetches) {
-    auto* node_to_execute = session_state.GetToBeExecutedRange(fetch_mlvalue_idxs);
-    ctx.SetNodeToExecute(node_to_execute);
-  }
-#else
-  ORT_UNUSED_PARAMETER(only_execute_path_to_fetches);
+                             single_thread_mode,
+                             pruned_plan.get());
 #endif
 
   SessionScope session_scope(session_state, ctx.GetExecutionFrame());
@@ -663,7 +663,8 @@ onnxruntime::Status ExecuteThePlan(const SessionState& session_state, gsl::span<
     if (all_tensors) {
       MemoryPatternGroup mem_patterns;
       ORT_RETURN_IF_ERROR(ctx.GetExecutionFrame().GeneratePatterns(mem_patterns));
-      ORT_RETURN_IF_ERROR(session_state.UpdateMemoryPatternGroupCache(feeds, std::move(mem_patterns)));
+      ORT_RETURN_IF_ERROR(session_state.UpdateMemoryPatternGroupCache(feeds, std::move(mem_patterns),
+                                                                      pruned_plan.get()));
     }
   }
 
@@ -3,10 +3,12 @@
 
 #include "core/framework/session_state.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include <mutex>
 #include "core/common/logging/logging.h"
+#include "core/common/parse_string.h"
 #include "core/common/safeint.h"
 #include "core/flatbuffers/schema/ort.fbs.h"
 #include "core/framework/allocator.h"
@@ -103,6 +105,10 @@ SessionState::SessionState(Graph& graph,
 {
   enable_mem_pattern_ = sess_options_.enable_mem_pattern &&
                         sess_options_.execution_mode == ExecutionMode::ORT_SEQUENTIAL;
+  prune_execution_to_fetches_ =
+      sess_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsPruneExecutionToFetches, "0") == "1";
+  pruned_execution_plan_cache_size_ = ParseStringWithClassicLocale<size_t>(
+      sess_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsPrunedExecutionPlanCacheSize, "8"));
   if (parent_allocators) {
     allocators_ = parent_allocators;
   } else {
@@ -881,16 +887,22 @@ Status SessionState::GeneratePatternGroupCache(gsl::span<const OrtValue> tensor_
 const MemoryPatternGroup* SessionState::GetMemoryPatternGroup(
     gsl::span<const OrtValue> tensor_inputs,
     gsl::span<const int> feed_mlvalue_idxs,
-    const InlinedHashMap<int, TensorShape>*& out_inferred_shapes) const {
+    const InlinedHashMap<int, TensorShape>*& out_inferred_shapes,
+    const PrunedExecutionPlan* pruned_plan) const {
   out_inferred_shapes = nullptr;
   int64_t key = CalculateMemoryPatternsKey(tensor_inputs);
+  if (pruned_plan) {
+    key ^= pruned_plan->memory_pattern_key;
+  }
   std::lock_guard<std::mutex> lock(mem_patterns_lock_);
   auto it = mem_patterns_.find(key);
   if (it == mem_patterns_.end()) {
 #ifdef ENABLE_TRAINING
+    // the patterns generated from the shapes cover the whole plan, the ones of pruned runs are traced instead
     MemoryPatternGroup mem_patterns;
     InlinedHashMap<int, TensorShape> inferred_shapes;
-    if (GeneratePatternGroupCache(tensor_inputs, feed_mlvalue_idxs, mem_patterns, inferred_shapes).IsOK()) {
+    if (pruned_plan == nullptr &&
+        GeneratePatternGroupCache(tensor_inputs, feed_mlvalue_idxs, mem_patterns, inferred_shapes).IsOK()) {
       auto patt_insert = mem_patterns_.insert_or_assign(key, std::move(mem_patterns));
       auto ptr = &patt_insert.first->second;
       auto shape_insert = shape_patterns_.insert_or_assign(key, std::move(inferred_shapes));
@@ -957,8 +969,12 @@ void SessionState::ResolveMemoryPatternFlag() {
 }
 
 Status SessionState::UpdateMemoryPatternGroupCache(gsl::span<const OrtValue> tensor_inputs,
-                                                   MemoryPatternGroup mem_patterns) const {
+                                                   MemoryPatternGroup mem_patterns,
+                                                   const PrunedExecutionPlan* pruned_plan) const {
   int64_t key = CalculateMemoryPatternsKey(tensor_inputs);
+  if (pruned_plan) {
+    key ^= pruned_plan->memory_pattern_key;
+  }
 
   std::lock_guard<std::mutex> lock(mem_patterns_lock_);
   // Do not update if present, as the pointer to the existing one is cached
@@ -1095,47 +1111,47 @@ const NodeIndexInfo& SessionState::GetNodeIndexInfo() const {
   return *node_index_info_;
 }
 
-#ifdef ENABLE_TRAINING
-void SessionState::UpdateToBeExecutedRange(gsl::span<int const> fetch_mlvalue_idxs) {
-  InlinedVector<int> sorted_idxs;
-  sorted_idxs.reserve(fetch_mlvalue_idxs.size());
-  sorted_idxs.assign(fetch_mlvalue_idxs.begin(), fetch_mlvalue_idxs.end());
+Status SessionState::GetPrunedExecutionPlan(gsl::span<const int> fetch_mlvalue_idxs,
+                                            std::shared_ptr<const PrunedExecutionPlan>& plan) const {
+  InlinedVector<int> sorted_idxs(fetch_mlvalue_idxs.begin(), fetch_mlvalue_idxs.end());
   std::sort(sorted_idxs.begin(), sorted_idxs.end());
-  if (to_be_executed_nodes_.find(sorted_idxs) != to_be_executed_nodes_.end())
-    return;
-
-  // Get the nodes generating the fetches.
-  InlinedVector<const Node*> nodes;
-  nodes.reserve(fetch_mlvalue_idxs.size());
-  InlinedHashSet<NodeIndex> reachable_nodes;
-  reachable_nodes.reserve(graph_.NumberOfNodes());
 
-  for (auto idx : fetch_mlvalue_idxs) {
-    std::string node_arg_name;
-    const auto status = this->GetOrtValueNameIdxMap().GetName(idx, node_arg_name);
-    ORT_ENFORCE(status.IsOK(), status.ErrorMessage());
-    auto ending_node = graph_.GetProducerNode(node_arg_name);
-    nodes.push_back(ending_node);
+  {
+    std::lock_guard<std::mutex> lock(pruned_execution_plans_lock_);
+    auto it = std::find_if(pruned_execution_plans_.begin(), pruned_execution_plans_.end(),
+                           [&sorted_idxs](const PrunedExecutionPlanCacheEntry& entry) {
+                             return entry.fetch_mlvalue_idxs == sorted_idxs;
+                           });
+    if (it != pruned_execution_plans_.end()) {
+      pruned_execution_plans_.splice(pruned_execution_plans_.begin(), pruned_execution_plans_, it);
+      plan = it->plan;
+      return Status::OK();
+    }
   }
 
-  // Reversely traverse to get reachable nodes.
-  graph_.ReverseDFSFrom(
-      nodes, {}, [&reachable_nodes](const Node* n) { reachable_nodes.insert(n->Index()); });
-
-  // global start, end doesn't matters
-  to_be_executed_nodes_.emplace(std::move(sorted_idxs), std::move(reachable_nodes));
-}
+  // created without holding the lock, concurrent runs with other fetches are not blocked by it
+  std::unique_ptr<PrunedExecutionPlan> pruned_plan;
+  ORT_RETURN_IF_ERROR(PrunedExecutionPlan::Create(*graph_viewer_, GetOrtValueNameIdxMap(), *GetExecutionPlan(),
+                                                  sorted_idxs, pruned_plan));
+  plan = std::move(pruned_plan);
+
+  if (pruned_execution_plan_cache_size_ > 0) {
+    std::lock_guard<std::mutex> lock(pruned_execution_plans_lock_);
+    // another run may have added the plan for the same fetches in the meantime
+    auto it = std::find_if(pruned_execution_plans_.begin(), pruned_execution_plans_.end(),
+                           [&sorted_idxs](const PrunedExecutionPlanCacheEntry& entry) {
+                             return entry.fetch_mlvalue_idxs == sorted_idxs;
+                           });
+    if (it == pruned_execution_plans_.end()) {
+      pruned_execution_plans_.push_front({std::move(sorted_idxs), plan});
+      if (pruned_execution_plans_.size() > pruned_execution_plan_cache_size_) {
+        pruned_execution_plans_.pop_back();
+      }
+    }
+  }
 
-const InlinedHashSet<NodeIndex>* SessionState::GetToBeExecutedRange(
-    gsl::span<int const> fetch_mlvalue_idxs) const {
-  InlinedVector<int> sorted_idxs;
-  sorted_idxs.reserve(fetch_mlvalue_idxs.size());
-  sorted_idxs.assign(fetch_mlvalue_idxs.begin(), fetch_mlvalue_idxs.end());
-  std::sort(sorted_idxs.begin(), sorted_idxs.end());
-  auto it = to_be_executed_nodes_.find(sorted_idxs);
-  return (it != to_be_executed_nodes_.end()) ? &it->second : nullptr;
+  return Status::OK();
 }
-#endif
 
 Status SessionState::CreateSubgraphSessionState() {
   for (auto& node : graph_.Nodes()) {
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <list>
 #include <memory>
 #include <map>
 #include <unordered_map>
@@ -26,6 +27,7 @@
 #include "core/framework/feeds_fetches_manager.h"
 #include "core/framework/framework_common.h"
 #include "core/framework/prepacked_weights_container.h"
+#include "core/framework/pruned_execution_plan.h"
 #include "core/framework/fuse_nodes_funcs.h"
 #include "core/framework/kernel_registry_manager.h"
 #include "core/framework/mem_pattern.h"
@@ -228,7 +230,8 @@ class SessionState {
   const MemoryPatternGroup* GetMemoryPatternGroup(
       gsl::span<const OrtValue> tensor_inputs,
       gsl::span<const int> feed_mlvalue_idxs,
-      const InlinedHashMap<int, TensorShape>*& inferred_shapes) const;
+      const InlinedHashMap<int, TensorShape>*& inferred_shapes,
+      const PrunedExecutionPlan* pruned_plan = nullptr) const;
 
   /**
   Set generated memory pattern with a given input shapes.
@@ -236,7 +239,8 @@ class SessionState {
   All inputs must represent Tensors
   */
   Status UpdateMemoryPatternGroupCache(gsl::span<const OrtValue> tensor_inputs,
-                                       MemoryPatternGroup mem_patterns) const;
+                                       MemoryPatternGroup mem_patterns,
+                                       const PrunedExecutionPlan* pruned_plan = nullptr) const;
 
   bool GetUseDeterministicCompute() const { return sess_options_.use_deterministic_compute; }
 
@@ -305,10 +309,21 @@ class SessionState {
   InlinedVector<BufferUniquePtr>& GetMutableWeightsBuffers() noexcept { return weights_buffers_; }
 
   const NodeIndexInfo& GetNodeIndexInfo() const;
-#ifdef ENABLE_TRAINING
-  void UpdateToBeExecutedRange(gsl::span<int const> fetch_mlvalue_idxs);
-  const InlinedHashSet<NodeIndex>* GetToBeExecutedRange(gsl::span<int const> fetch_mlvalue_idxs) const;
-#endif
+
+  /**
+  Whether runs that request a subset of the graph outputs only execute the nodes needed to compute them.
+  Set by kOrtSessionOptionsPruneExecutionToFetches.
+  */
+  bool GetPruneExecutionToFetches() const noexcept { return prune_execution_to_fetches_; }
+
+  /**
+  Get the pruned execution plan that only computes the given fetches.
+  plan is set to nullptr if all the nodes are needed for them.
+  The plans of the most recently used fetch sets are cached, the size of the cache is set by
+  kOrtSessionOptionsPrunedExecutionPlanCacheSize. Thread safe.
+  */
+  Status GetPrunedExecutionPlan(gsl::span<const int> fetch_mlvalue_idxs,
+                                std::shared_ptr<const PrunedExecutionPlan>& plan) const;
 
   std::unordered_map<std::string, std::unique_ptr<Tensor>>* GetMutableBufferedTensors() {
     return &name_to_buffered_tensor_;
@@ -563,14 +578,20 @@ class SessionState {
   // prepacked_weights_container_ can be nullptr if no caching is required for prepacked weights
   PrepackedWeightsContainer* const prepacked_weights_container_{};
 
-#ifdef ENABLE_TRAINING
-// Needed for ORTTrainer. Should be removed along with ORTTrainer code
-#ifndef DISABLE_ABSEIL
-  InlinedHashMap<InlinedVector<int>, InlinedHashSet<NodeIndex>> to_be_executed_nodes_;
-#else
-  std::map<InlinedVector<int>, InlinedHashSet<NodeIndex>> to_be_executed_nodes_;
-#endif
-#endif
+  bool prune_execution_to_fetches_;
+
+  struct PrunedExecutionPlanCacheEntry {
+    // sorted OrtValue indices of the fetches
+    InlinedVector<int> fetch_mlvalue_idxs;
+    // nullptr if all the nodes are needed
+    std::shared_ptr<const PrunedExecutionPlan> plan;
+  };
+
+  // LRU cache of the pruned execution plans, the most recently used first.
+  // The plans are shared with the runs using them, so that they can be evicted while these are in progress.
+  mutable std::mutex pruned_execution_plans_lock_;
+  mutable std::list<PrunedExecutionPlanCacheEntry> pruned_execution_plans_;
+  size_t pruned_execution_plan_cache_size_;
 
   SessionState* parent_ = nullptr;
   // Assign each graph in each session an unique id.
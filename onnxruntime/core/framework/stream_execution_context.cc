@@ -20,7 +20,8 @@ StreamExecutionContext::StreamExecutionContext(const SessionState& sess_state,
                                                const std::unordered_map<size_t, IExecutor::CustomAllocator>&
                                                    fetch_allocators,
                                                const logging::Logger& sess_logger,
-                                               bool single_thread_mode)
+                                               bool single_thread_mode,
+                                               const PrunedExecutionPlan* pruned_plan)
     : session_state_(&sess_state),
       frame_(feed_mlvalue_idxs,
              feeds,
@@ -28,8 +29,10 @@ StreamExecutionContext::StreamExecutionContext(const SessionState& sess_state,
              fetches,
              fetch_allocators,
              device_stream_map,
-             sess_state),
+             sess_state,
+             pruned_plan),
       logger_(&sess_logger),
+      pruned_plan_(pruned_plan),
       single_thread_mode_(single_thread_mode),
       device_stream_map_(device_stream_map),
       count_down_barriers_(num_barriers) {
@@ -60,7 +63,8 @@ StreamExecutionContext::StreamExecutionContext(const SessionState& sess_state,
   // generate release plan (the ref counts)
   auto& release_actions = sess_state.GetExecutionPlan()->release_actions;
   for (size_t i = 0; i < release_actions.size(); ++i) {
-    release_plan_[i] = static_cast<int>(release_actions[i].ref_count);
+    release_plan_[i] = pruned_plan_ ? pruned_plan_->release_ref_counts[i]
+                                    : static_cast<int>(release_actions[i].ref_count);
   }
 }
 
@@ -88,15 +92,18 @@ StreamExecutionContext::StreamExecutionContext(const SessionState& sess_state,
                                                const std::unordered_map<size_t, IExecutor::CustomAllocator>&
                                                    fetch_allocators,
                                                const logging::Logger& sess_logger,
-                                               bool single_thread_mode)
+                                               bool single_thread_mode,
+                                               const PrunedExecutionPlan* pruned_plan)
     : session_state_(&sess_state),
       frame_(feed_mlvalue_idxs,
              feeds,
              fetch_mlvalue_idxs,
              fetches,
              fetch_allocators,
-             sess_state),
+             sess_state,
+             pruned_plan),
       logger_(&sess_logger),
+      pruned_plan_(pruned_plan),
       single_thread_mode_(single_thread_mode) {
 #ifdef _WIN32
 #pragma warning(push)
@@ -112,7 +119,8 @@ StreamExecutionContext::StreamExecutionContext(const SessionState& sess_state,
   // generate release plan (the ref counts)
   auto& release_actions = sess_state.GetExecutionPlan()->release_actions;
   for (size_t i = 0; i < release_actions.size(); ++i) {
-    release_plan_[i] = static_cast<int>(release_actions[i].ref_count);
+    release_plan_[i] = pruned_plan_ ? pruned_plan_->release_ref_counts[i]
+                                    : static_cast<int>(release_actions[i].ref_count);
   }
 }
 
@@ -165,11 +173,21 @@ StreamExecutionContext::~StreamExecutionContext() {}
 
 void StreamExecutionContext::RecycleNodeInputs(onnxruntime::NodeIndex node_index) {
   auto* execution_plan = session_state_->GetExecutionPlan();
-  for (auto idx : execution_plan->node_release_list[node_index]) {
+  auto release = [this, execution_plan](size_t idx) {
     if (--release_plan_[idx] == 0) {
       ORT_ENFORCE(frame_.ReleaseMLValue(static_cast<int>(execution_plan->release_actions[idx].value_index)).IsOK());
       VLOGS(*logger_, 0) << "ort value " << execution_plan->release_actions[idx].value_index << " released";
     }
+  };
+
+  if (pruned_plan_) {
+    for (auto idx : pruned_plan_->node_release_list[node_index]) {
+      release(idx);
+    }
+  } else {
+    for (auto idx : execution_plan->node_release_list[node_index]) {
+      release(idx);
+    }
   }
 }
 
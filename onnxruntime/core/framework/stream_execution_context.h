@@ -10,6 +10,7 @@
 #include "core/graph/basic_types.h"
 #include "core/common/inlined_containers.h"
 #include "core/framework/memory_info.h"
+#include "core/framework/pruned_execution_plan.h"
 #ifdef ENABLE_TRAINING
 #include "core/framework/partial_graph_execution_state.h"
 #endif
@@ -70,7 +71,8 @@ class StreamExecutionContext {
                          std::vector<OrtValue>& fetches,
                          const std::unordered_map<size_t, IExecutor::CustomAllocator>& fetch_allocators,
                          const logging::Logger& sess_logger,
-                         bool single_thread_mode);
+                         bool single_thread_mode,
+                         const PrunedExecutionPlan* pruned_plan = nullptr);
 
   const SessionState& GetSessionState() const;
 
@@ -137,16 +139,13 @@ class StreamExecutionContext {
     program_range_ = range;
   }
 
-  const InlinedHashSet<NodeIndex>* GetNodeToExecute() {
-    return node_to_execute_;
-  }
+#endif
 
-  void SetNodeToExecute(const InlinedHashSet<NodeIndex>* node_to_execute) {
-    node_to_execute_ = node_to_execute;
+  // The pruned execution plan of the run, or nullptr if all the nodes are executed.
+  const PrunedExecutionPlan* GetPrunedPlan() const {
+    return pruned_plan_;
   }
 
-#endif
-
  private:
   const SessionState* session_state_;
 
@@ -164,11 +163,8 @@ class StreamExecutionContext {
   const ProgramRegion* program_range_{nullptr};
 
   OrtValueCachePtr cache_{nullptr};
-
-  // TODO: this is mainly for ort trainer
-  // Should we deprecate it?
-  const InlinedHashSet<NodeIndex>* node_to_execute_{nullptr};
 #endif
+  const PrunedExecutionPlan* const pruned_plan_;
   const bool single_thread_mode_;
 
 #ifdef ORT_ENABLE_STREAM
@@ -1128,6 +1128,63 @@ Status GetExtDataFromTensorProto(const Env& env, const std::filesystem::path& mo
   return Status::OK();
 }
 
+bool HasExternalDataInMemory(const ONNX_NAMESPACE::TensorProto& tensor_proto) {
+  if (!HasExternalData(tensor_proto)) {
+    return false;
+  }
+
+  std::unique_ptr<ExternalDataInfo> external_data_info;
+  return ExternalDataInfo::Create(tensor_proto.external_data(), external_data_info).IsOK() &&
+         external_data_info->GetRelPath() == kTensorProtoMemoryAddressTag;
+}
+
+bool CanMapExternalData(const ONNX_NAMESPACE::TensorProto& tensor_proto) {
+#if defined(__wasm__)
+  ORT_UNUSED_PARAMETER(tensor_proto);
+  return false;
+#else
+  // the data is used as is, so it must not need a conversion to the native byte order
+  if constexpr (endian::native != endian::little) {
+    ORT_UNUSED_PARAMETER(tensor_proto);
+    return false;
+  } else {
+    if (!HasExternalData(tensor_proto) || !HasDataType(tensor_proto) || HasString(tensor_proto)) {
+      return false;
+    }
+
+    std::unique_ptr<ExternalDataInfo> external_data_info;
+    return ExternalDataInfo::Create(tensor_proto.external_data(), external_data_info).IsOK() &&
+           external_data_info->GetRelPath() != kTensorProtoMemoryAddressTag;
+  }
+#endif
+}
+
+Status MapExternalDataToOrtValue(const Env& env, const std::filesystem::path& model_path,
+                                 const ONNX_NAMESPACE::TensorProto& tensor_proto, OrtValue& value) {
+  ORT_RETURN_IF_NOT(CanMapExternalData(tensor_proto), "TensorProto: ", tensor_proto.name(),
+                    " does not have external data in a file that can be mapped.");
+
+  // GetExtDataFromTensorProto maps the file copy-on-write, or reads it into a new buffer if that fails. Either way
+  // writes to the data are private to the tensor.
+  void* ext_data_buf = nullptr;
+  SafeInt<size_t> ext_data_len = 0;
+  OrtCallback ext_data_deleter{nullptr, nullptr};
+  ORT_RETURN_IF_ERROR(GetExtDataFromTensorProto(env, model_path, tensor_proto, ext_data_buf, ext_data_len,
+                                                ext_data_deleter));
+
+  const DataTypeImpl* const type = DataTypeImpl::TensorTypeFromONNXEnum(tensor_proto.data_type())->GetElementType();
+  auto tensor = std::make_unique<Tensor>(type, GetTensorShapeFromTensorProto(tensor_proto), ext_data_buf,
+                                         OrtMemoryInfo(CPU, OrtAllocatorType::OrtDeviceAllocator));
+  value.Init(tensor.release(), DataTypeImpl::GetType<Tensor>(), [ext_data_deleter](void* p) {
+    delete static_cast<Tensor*>(p);
+    if (ext_data_deleter.f) {
+      ext_data_deleter.f(ext_data_deleter.param);
+    }
+  });
+
+  return Status::OK();
+}
+
 Status LoadExtDataToTensorFromTensorProto(const Env& env, const std::filesystem::path& model_path,
                                           const ONNX_NAMESPACE::TensorProto& tensor_proto,
                                           const IExternalDataLoader& ext_data_loader,
@@ -186,6 +186,19 @@ common::Status GetExtDataFromTensorProto(const Env& env, const std::filesystem::
                                          Tensor* buffered_tensor = nullptr,
                                          PrepackedWeightsForGraph* prepacked_for_graph = nullptr);
 
+// Whether the external data of the tensor proto is in memory, referred to by kTensorProtoMemoryAddressTag.
+bool HasExternalDataInMemory(const ONNX_NAMESPACE::TensorProto& tensor_proto);
+
+// Whether MapExternalDataToOrtValue can be used for the tensor proto: it must have external data in a file, as
+// opposed to in memory referred to by kTensorProtoMemoryAddressTag, and the data must not need conversion.
+bool CanMapExternalData(const ONNX_NAMESPACE::TensorProto& tensor_proto);
+
+// Given a tensor proto for which CanMapExternalData is true, create a CPU tensor that aliases a memory mapping of its
+// external data instead of reading it into a new buffer. The mapping is copy-on-write, so the tensor may be written
+// to without changing the file, and only the pages written to are copied. The OrtValue owns the mapping.
+common::Status MapExternalDataToOrtValue(const Env& env, const std::filesystem::path& model_path,
+                                         const ONNX_NAMESPACE::TensorProto& tensor_proto, OrtValue& value);
+
 // Given a tensor proto with external data obtain a tensor using the specified custom external data loader.
 common::Status LoadExtDataToTensorFromTensorProto(const Env& env, const std::filesystem::path& model_path,
                                                   const ONNX_NAMESPACE::TensorProto& tensor_proto,
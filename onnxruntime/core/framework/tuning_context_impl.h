@@ -4,7 +4,8 @@
 // This file contains the implementation of TuningContext. At the moment, there is no necessity to expose these
 // methods as OrtApis. This will cause missing symbols when loading provider dynamic libraries, because the libraries
 // are not whole-archive linked and these symbols are not referenced at framework level. To circumvent this problem,
-// the EP must has and only has one translation unit include this file.
+// the EP must has and only has one translation unit include this file. For the EPs that are built into onnxruntime,
+// this is core/providers/cpu/cpu_tuning_context.cc.
 #ifndef TUNING_CONTEXT_IMPL
 #error define TUNING_CONTEXT_IMPL to use this header (impl) file
 #endif
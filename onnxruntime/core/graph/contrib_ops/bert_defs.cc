@@ -847,6 +847,9 @@ constexpr const char* DecoderMaskedMultiHeadAttention_ver1_doc = R"DOC(
 Multihead attention that supports input sequence length of 1.
 Similar to DecoderMaskedSelfAttention but this op excludes QKV MatMul and Bias.
 This op supports both Self and Cross Attention.
+
+For cross attention, the CPU kernel also accepts key and value with fewer rows than query, in which case consecutive
+groups of query rows (the beams of a batch entry) share one row of key and value.
 )DOC";
 
 ONNX_MS_OPERATOR_SET_SCHEMA(
@@ -1206,6 +1209,166 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
           GroupQueryAttentionTypeAndShapeInference(ctx, 3);
         }));
 
+constexpr const char* PagedAttention_ver1_doc = R"DOC(
+Group Query Attention over a paged KV cache.
+
+The key and value caches are pools of fixed-size blocks shared by all sequences. Row b of block_table lists the blocks
+owned by sequence b, so token p of that sequence lives in slot (p % block_size) of block block_table[b, p / block_size].
+The new tokens of all sequences are packed token-major without padding, and cumulative_sequence_length gives where
+each sequence starts. The new key and value tokens are written into the cache right after the past tokens of their
+sequence, then causal attention is computed by gathering the cache through the block table.
+
+The caches are expected to share their buffers with key_cache_out and value_cache_out so that only the new tokens
+are written. Rotary position embedding is not applied by this operator.
+
+When the caches are int8, every token of every kv head is quantized symmetrically with its own scale, which is kept
+in key_cache_scale and value_cache_scale. A cached value is then cache[slot, h * head_size + i] * scale[slot, h].
+This quarters the memory of the cache and the bandwidth of reading it back, at the cost of quantization error.
+)DOC";
+
+ONNX_MS_OPERATOR_SET_SCHEMA(
+    PagedAttention, 1,
+    OpSchema()
+        .SetDoc(PagedAttention_ver1_doc)
+        .Attr("num_heads", "Number of attention heads for q", AttributeProto::INT)
+        .Attr("kv_num_heads", "Number of attention heads for k and v", AttributeProto::INT)
+        .Attr("scale",
+              "Custom scale will be used if specified. Default value is 1/sqrt(head_size)",
+              AttributeProto::FLOAT,
+              OPTIONAL_VALUE)
+        .Attr("softcap",
+              "Softcap value for attention weights. Default value is 0.",
+              AttributeProto::FLOAT,
+              OPTIONAL_VALUE)
+        .Attr("local_window_size",
+              "left_window_size for local attention (like Mistral). Default value is -1 meaning unused.",
+              AttributeProto::INT,
+              static_cast<int64_t>(-1))
+        .Attr("smooth_softmax",
+              "Use a smooth factor in softmax.",
+              AttributeProto::INT,
+              static_cast<int64_t>(-1))
+        .Input(0,
+               "query",
+               "Query with shape (token_count, hidden_size), or packed QKV with shape (token_count, d) "
+               "where d is (num_heads * head_size + 2 * kv_num_heads * head_size).",
+               "T")
+        .Input(1,
+               "key",
+               "Key with shape (token_count, kv_hidden_size)",
+               "T",
+               OpSchema::Optional)
+        .Input(2,
+               "value",
+               "Value with shape (token_count, kv_hidden_size)",
+               "T",
+               OpSchema::Optional)
+        .Input(3,
+               "key_cache",
+               "Block pool for keys with shape (num_blocks, block_size, kv_hidden_size).",
+               "C")
+        .Input(4,
+               "value_cache",
+               "Block pool for values with shape (num_blocks, block_size, kv_hidden_size).",
+               "C")
+        .Input(5,
+               "cumulative_sequence_length",
+               "1D tensor with shape (batch_size + 1). Offsets of the new tokens of each sequence in query.",
+               "M")
+        .Input(6,
+               "past_seqlens",
+               "1D tensor with shape (batch_size). Number of tokens of each sequence already in the cache.",
+               "M")
+        .Input(7,
+               "block_table",
+               "2D tensor with shape (batch_size, max_blocks_per_sequence). Block ids owned by each sequence.",
+               "M")
+        .Input(8,
+               "key_cache_scale",
+               "Scales of the int8 key cache with shape (num_blocks, block_size, kv_num_heads). "
+               "Required when the caches are int8.",
+               "T",
+               OpSchema::Optional)
+        .Input(9,
+               "value_cache_scale",
+               "Scales of the int8 value cache with shape (num_blocks, block_size, kv_num_heads). "
+               "Required when the caches are int8.",
+               "T",
+               OpSchema::Optional)
+        .Output(0,
+                "output",
+                "2D output tensor with shape (token_count, hidden_size)",
+                "T")
+        .Output(1,
+                "key_cache_out",
+                "Updated key block pool. Shares the buffer of key_cache when possible.",
+                "C")
+        .Output(2,
+                "value_cache_out",
+                "Updated value block pool. Shares the buffer of value_cache when possible.",
+                "C")
+        .Output(3,
+                "key_cache_scale_out",
+                "Updated key_cache_scale. Shares the buffer of key_cache_scale when possible.",
+                "T",
+                OpSchema::Optional)
+        .Output(4,
+                "value_cache_scale_out",
+                "Updated value_cache_scale. Shares the buffer of value_cache_scale when possible.",
+                "T",
+                OpSchema::Optional)
+        .TypeConstraint("T", {"tensor(float)"}, "Constrain input and output to float tensors.")
+        .TypeConstraint("C", {"tensor(float)", "tensor(int8)"}, "Constrain the caches to float or int8 tensors.")
+        .TypeConstraint("M", {"tensor(int32)"}, "Constrain sequence lengths and block table to int tensors.")
+        .TypeAndShapeInferenceFunction([](ONNX_NAMESPACE::InferenceContext& ctx) {
+          propagateElemTypeFromInputToOutput(ctx, 0, 0);
+          propagateElemTypeFromInputToOutput(ctx, 3, 1);
+          propagateElemTypeFromInputToOutput(ctx, 4, 2);
+          if (hasInputShape(ctx, 3)) {
+            propagateShapeFromInputToOutput(ctx, 3, 1);
+          }
+          if (hasInputShape(ctx, 4)) {
+            propagateShapeFromInputToOutput(ctx, 4, 2);
+          }
+          if (ctx.getNumOutputs() > 3 && ctx.hasInput(8)) {  // has scales of an int8 cache
+            propagateElemTypeFromInputToOutput(ctx, 8, 3);
+            if (hasInputShape(ctx, 8)) {
+              propagateShapeFromInputToOutput(ctx, 8, 3);
+            }
+          }
+          if (ctx.getNumOutputs() > 4 && ctx.hasInput(9)) {
+            propagateElemTypeFromInputToOutput(ctx, 9, 4);
+            if (hasInputShape(ctx, 9)) {
+              propagateShapeFromInputToOutput(ctx, 9, 4);
+            }
+          }
+
+          if (!hasInputShape(ctx, 0) || !hasInputShape(ctx, 3)) {
+            return;
+          }
+
+          const auto& query_shape = getInputShape(ctx, 0);
+          const auto& cache_shape = getInputShape(ctx, 3);
+          if (query_shape.dim_size() != 2) {
+            fail_shape_inference("query is expected to have 2 dimensions");
+          }
+          if (cache_shape.dim_size() != 3) {
+            fail_shape_inference("key_cache is expected to have 3 dimensions");
+          }
+
+          ONNX_NAMESPACE::TensorShapeProto output_shape;
+          *output_shape.add_dim() = query_shape.dim(0);
+          auto* hidden_dim = output_shape.add_dim();
+          if (cache_shape.dim(2).has_dim_value()) {
+            const int64_t num_heads = getAttribute(ctx, "num_heads", 0);
+            const int64_t kv_num_heads = getAttribute(ctx, "kv_num_heads", 0);
+            if (kv_num_heads > 0) {
+              hidden_dim->set_dim_value(cache_shape.dim(2).dim_value() / kv_num_heads * num_heads);
+            }
+          }
+          updateOutputShape(ctx, 0, output_shape);
+        }));
+
 constexpr const char* SparseAttention_ver1_doc = R"DOC(
 Block Sparse Attention used in Phi-3-small (https://arxiv.org/pdf/2404.14219).
 
@@ -631,6 +631,85 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
           return true;
         }));
 
+constexpr const char* ImputeScaleNormalize_ver1_doc = R"DOC(
+Fused form of the ai.onnx.ml Imputer -> Scaler -> Normalizer chain for float inputs of shape [N, C] or [C].
+Each stage is applied only when its attributes are present: imputation when 'imputed_values' is set,
+scaling when 'scale' and 'offset' are set, and normalization when 'norm' is set.
+The result is identical to running the individual ai.onnx.ml operators in sequence.
+)DOC";
+ONNX_MS_OPERATOR_SET_SCHEMA(
+    ImputeScaleNormalize, 1,
+    OpSchema()
+        .SetDoc(ImputeScaleNormalize_ver1_doc)
+        .Attr("imputed_values",
+              "Values to substitute for 'replaced_value'. Either a single value or one value per feature.",
+              AttributeProto::FLOATS, OPTIONAL_VALUE)
+        .Attr("replaced_value", "Value that needs replacing. NaN matches NaN inputs.", AttributeProto::FLOAT, 0.f)
+        .Attr("offset", "Subtracted from the input first. Must have the same length as 'scale'.",
+              AttributeProto::FLOATS, OPTIONAL_VALUE)
+        .Attr("scale", "Applied after the offset. Either a single value or one value per feature.",
+              AttributeProto::FLOATS, OPTIONAL_VALUE)
+        .Attr("norm", "Row normalization applied last: 'MAX', 'L1' or 'L2'.", AttributeProto::STRING, OPTIONAL_VALUE)
+        .Input(0, "X", "Input data of shape [N, C] or [C].", "T")
+        .Output(0, "Y", "Output data with the same shape as the input.", "T")
+        .TypeConstraint("T", {"tensor(float)"}, "Constrain input and output types to float tensors.")
+        .TypeAndShapeInferenceFunction(ONNX_NAMESPACE::propagateShapeAndTypeFromFirstInput));
+
+constexpr const char* RegexFullMatchSet_ver1_doc = R"DOC(
+Matches every element of a string tensor against several RE2 patterns in a single pass.
+Output i is identical to RegexFullMatch with 'patterns'[i] applied to the same input.
+)DOC";
+ONNX_MS_OPERATOR_SET_SCHEMA(
+    RegexFullMatchSet, 1,
+    OpSchema()
+        .SetDoc(RegexFullMatchSet_ver1_doc)
+        .Attr("patterns", "RE2 regular expressions to fully match, one per output.", AttributeProto::STRINGS)
+        .Input(0, "X", "Tensor with strings to match on.", "T1")
+        .Output(0, "Y", "One bool tensor per pattern with the same shape as the input.", "T2", OpSchema::Variadic)
+        .TypeConstraint("T1", {"tensor(string)"}, "Inputs must be UTF-8 strings")
+        .TypeConstraint("T2", {"tensor(bool)"}, "Outputs are bools and are True where there is a full regex match.")
+        .TypeAndShapeInferenceFunction([](ONNX_NAMESPACE::InferenceContext& ctx) {
+          for (size_t i = 0; i < ctx.getNumOutputs(); ++i) {
+            updateOutputElemType(ctx, i, ONNX_NAMESPACE::TensorProto::BOOL);
+            if (hasNInputShapes(ctx, 1)) {
+              propagateShapeFromInputToOutput(ctx, 0, i);
+            }
+          }
+        }));
+
+constexpr const char* FusedElementwise_ver1_doc = R"DOC(
+Evaluates a chain of float elementwise operators in a single pass over the output, without materializing the
+intermediate tensors. The chain is a list of instructions: instruction i applies 'op_types'[i] to the operands
+'operands'[2 * i] and 'operands'[2 * i + 1]. An operand index below the number of inputs refers to that input, and
+index (number of inputs + j) refers to the result of instruction j, which must come before instruction i. Unary
+operators ignore their second operand, which is -1 by convention. The output is the result of the last instruction.
+
+Supported operators are Add, Sub, Mul, Div, Sigmoid, Tanh, Exp, Relu, Neg, Abs, Sqrt and Erf with the semantics of
+the ONNX operators of the same name. Inputs are broadcast to the output shape, and each input must either have one
+element or, ignoring leading dimensions of size 1, match the trailing dimensions of the output.
+)DOC";
+ONNX_MS_OPERATOR_SET_SCHEMA(
+    FusedElementwise, 1,
+    OpSchema()
+        .SetDoc(FusedElementwise_ver1_doc)
+        .Attr("op_types", "Operator of each instruction, in evaluation order.", AttributeProto::STRINGS)
+        .Attr("operands", "Two operand indices per instruction.", AttributeProto::INTS)
+        .Input(0, "inputs", "Inputs of the chain.", "T", OpSchema::Variadic)
+        .Output(0, "Y", "Result of the last instruction.", "T")
+        .TypeConstraint("T", {"tensor(float)"}, "Constrain input and output types to float tensors.")
+        .TypeAndShapeInferenceFunction([](ONNX_NAMESPACE::InferenceContext& ctx) {
+          propagateElemTypeFromInputToOutput(ctx, 0, 0);
+          std::vector<const TensorShapeProto*> shapes;
+          for (size_t i = 0; i < ctx.getNumInputs(); ++i) {
+            if (!hasInputShape(ctx, i)) {
+              return;
+            }
+            shapes.push_back(&ctx.getInputType(i)->tensor_type().shape());
+          }
+          multidirectionalBroadcastShapeInference(
+              shapes, *ctx.getOutputType(0)->mutable_tensor_type()->mutable_shape());
+        }));
+
 // Used to be ONNX 1.7 Inverse(12)
 // Comment out docs not to increase the binary size
 //
@@ -1325,6 +1404,14 @@ ONNX_MS_OPERATOR_SET_SCHEMA(GreedySearch, 1,
                                       "Size of the vocabulary. "
                                       "If not provided, it will be inferred from the decoder subgraph's output shape",
                                       AttributeProto::INT, static_cast<int64_t>(-1))
+                                .Attr("prefix_cache_max_bytes",
+                                      "Memory limit in bytes of the cache of prompt prefix past state shared by all runs of the node. "
+                                      "Prompts starting with a cached prefix only run the rest of the prompt in the first decoder call. "
+                                      "Default value 0 disables the cache. Only used by the CPU execution provider.",
+                                      AttributeProto::INT, static_cast<int64_t>(0))
+                                .Attr("prefix_cache_block_size",
+                                      "Number of tokens per block of the prefix cache. Prefixes are cached and matched in whole blocks.",
+                                      AttributeProto::INT, static_cast<int64_t>(64))
                                 .Input(0, "input_ids", "The sequence used as a prompt for the generation. Shape is (batch_size, sequence_length)", "I")
                                 .Input(1, "max_length", "The maximum length of the sequence to be generated. Shape is (1)", "I")
                                 .Input(2, "min_length", "The minimum length below which the score of eos_token_id is set to -Inf. Shape is (1)", "I", OpSchema::Optional)
@@ -1351,10 +1438,18 @@ ONNX_MS_OPERATOR_SET_SCHEMA(Sampling, 1,
                                 .Attr("top_p",
                                       "If set to float < 1, only the smallest set of most probable tokens with probabilities that add up to `top_p` or higher are kept for generation.",
                                       AttributeProto::FLOAT, 0.0f)
+                                .Attr("top_k", "If set to int > 0, only the `top_k` most probable tokens are kept for generation. Only supported on CPU.",
+                                      AttributeProto::INT, static_cast<int64_t>(0))
+                                .Attr("min_p",
+                                      "If set to float > 0, only the tokens with a probability of at least `min_p` times the probability of the most probable token are kept for generation. Only supported on CPU.",
+                                      AttributeProto::FLOAT, 0.0f)
                                 .Attr("filter_value", "All filtered values will be set to this float value.", AttributeProto::FLOAT, -1e20f)
                                 .Attr("min_tokens_to_keep", "Minimumber of tokens we keep per batch example in the output.", AttributeProto::INT, static_cast<int64_t>(0))
                                 .Attr("presence_penalty", "Presence penalty for custom sampling", AttributeProto::FLOAT, 0.0f)
                                 .Attr("custom", "If 1 custom sampling logic", AttributeProto::INT, static_cast<int64_t>(0))
+                                .Attr("seed_per_sequence",
+                                      "If 1, each sequence of the batch uses its own random number generator, seeded from `seed` and its index in the batch, so that the tokens sampled for a sequence do not depend on the other sequences. Only supported on CPU.",
+                                      AttributeProto::INT, static_cast<int64_t>(0))
                                 .Attr("model_type", "Model type: 0 for decoder only like GPT-2; 1 for encoder decoder like Bart", AttributeProto::INT, static_cast<int64_t>(0))
                                 .Attr("encoder", "The subgraph for initialization of encoder and decoder. It will be called once before decoder subgraph.", AttributeProto::GRAPH, OPTIONAL_VALUE)
                                 .Attr("init_decoder",
@@ -1383,6 +1478,61 @@ ONNX_MS_OPERATOR_SET_SCHEMA(Sampling, 1,
                                   GreedySearchShapeInference(ctx);
                                 }));
 
+constexpr const char* SpeculativeVerify_ver1_doc = R"DOC(
+Verification step of speculative decoding.
+
+A draft model proposes k tokens per sequence, and the main model is run once over the k + 1 positions that end with
+them. This operator accepts the longest valid prefix of the draft and appends one token chosen by the main model, so
+every call produces between 1 and k + 1 tokens per sequence.
+
+When do_sample is 0, a draft token is accepted while it equals the argmax of the main model's logits.
+When do_sample is 1, draft token x is accepted with probability min(1, p(x) / q(x)), where p is the softmax of the
+main model's logits divided by temperature and q is draft_probs. The first rejected position is resampled from the
+normalized max(0, p - q), which keeps the output distributed as sampling from the main model.
+
+Key/value caches written by the main model for rejected positions are stale. With a shared past/present buffer
+they are rolled back by advancing the past sequence length by accepted_lengths + 1 only.
+)DOC";
+
+ONNX_MS_OPERATOR_SET_SCHEMA(SpeculativeVerify, 1,
+                            OpSchema()
+                                .SetDoc(SpeculativeVerify_ver1_doc)
+                                .Attr("do_sample", "Use rejection sampling (1) instead of greedy matching (0).", AttributeProto::INT, static_cast<int64_t>(0))
+                                .Attr("temperature", "The value used to module the next token probabilities of the main model.", AttributeProto::FLOAT, 1.0f)
+                                .Attr("pad_token_id", "The id of the padding token used after the last valid token.", AttributeProto::INT, static_cast<int64_t>(0))
+                                .Attr("seed", "Seed for the random generator used by sampling.", AttributeProto::FLOAT, OPTIONAL_VALUE)
+                                .Input(0, "draft_tokens", "Tokens proposed by the draft model. Shape is (batch_size, k)", "I")
+                                .Input(1, "logits", "Logits of the main model for the k + 1 verified positions. Shape is (batch_size, k + 1, vocab_size)", "T")
+                                .Input(2, "draft_probs", "Probabilities the draft model sampled draft_tokens from. Shape is (batch_size, k, vocab_size). Required when do_sample is 1", "T", OpSchema::Optional)
+                                .Output(0, "tokens", "Accepted draft tokens followed by the token of the main model, padded with pad_token_id. Shape is (batch_size, k + 1)", "I")
+                                .Output(1, "accepted_lengths", "Number of accepted draft tokens of each sequence. Shape is (batch_size)", "I")
+                                .TypeConstraint("T", {"tensor(float)"}, "Constrain input types to float tensors.")
+                                .TypeConstraint("I", {"tensor(int32)"}, "Constrain to integer types")
+                                .TypeAndShapeInferenceFunction([](ONNX_NAMESPACE::InferenceContext& ctx) {
+                                  updateOutputElemType(ctx, 0, ONNX_NAMESPACE::TensorProto::INT32);
+                                  updateOutputElemType(ctx, 1, ONNX_NAMESPACE::TensorProto::INT32);
+                                  if (!hasInputShape(ctx, 0)) {
+                                    return;
+                                  }
+
+                                  const auto& draft_shape = getInputShape(ctx, 0);
+                                  if (draft_shape.dim_size() != 2) {
+                                    fail_shape_inference("draft_tokens shall be 2 dimensions");
+                                  }
+
+                                  ONNX_NAMESPACE::TensorShapeProto tokens_shape;
+                                  *tokens_shape.add_dim() = draft_shape.dim(0);
+                                  auto* positions = tokens_shape.add_dim();
+                                  if (draft_shape.dim(1).has_dim_value()) {
+                                    positions->set_dim_value(draft_shape.dim(1).dim_value() + 1);
+                                  }
+                                  updateOutputShape(ctx, 0, tokens_shape);
+
+                                  ONNX_NAMESPACE::TensorShapeProto lengths_shape;
+                                  *lengths_shape.add_dim() = draft_shape.dim(0);
+                                  updateOutputShape(ctx, 1, lengths_shape);
+                                }));
+
 constexpr const char* MoE_ver1_doc = R"DOC(
       Mixture of experts. Examples: Switch transformer(https://arxiv.org/pdf/2101.03961.pdf) use top 1,
       GLaM(https://arxiv.org/abs/2112.06905) activates top 2 FFN, Vision MOE(https://arxiv.org/pdf/2106.05974.pdf)
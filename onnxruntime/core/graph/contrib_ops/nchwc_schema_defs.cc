@@ -226,6 +226,48 @@ void RegisterNchwcSchemas() {
           }
         }
       });
+
+  ONNX_CONTRIB_OPERATOR_SCHEMA(Pad)
+      .SetDomain(kMSNchwcDomain)
+      .SinceVersion(1)
+      .SetDoc(R"DOC(For internal use.)DOC")
+      .Attr("pads", "", AttributeProto::INTS)
+      .Attr("mode", "", AttributeProto::STRING, std::string("constant"))
+      .Attr("value", "", AttributeProto::FLOAT, 0.0f)
+      .Input(0, "X", "", "T")
+      .Output(0, "Y", "", "T")
+      .TypeConstraint("T", {"tensor(float)"}, "Constrain input and output types to float tensors")
+      .TypeAndShapeInferenceFunction([](ONNX_NAMESPACE::InferenceContext& ctx) {
+        ONNX_NAMESPACE::propagateElemTypeFromInputToOutput(ctx, 0, 0);
+        if (!hasNInputShapes(ctx, 1)) {
+          return;
+        }
+
+        const auto& input_shape = ctx.getInputType(0)->tensor_type().shape();
+        auto* output_shape = ctx.getOutputType(0)->mutable_tensor_type()->mutable_shape();
+
+        if (input_shape.dim_size() != 4) {
+          fail_shape_inference("tensor rank must be 4");
+        }
+
+        // The pads are ordered as [top, left, bottom, right].
+        std::vector<int64_t> pads;
+        if (!getRepeatedAttribute(ctx, "pads", pads) || pads.size() != 4) {
+          fail_shape_inference("invalid pads");
+        }
+
+        // Copy the batch and channel dimensions.
+        *output_shape->add_dim() = input_shape.dim(0);
+        *output_shape->add_dim() = input_shape.dim(1);
+
+        for (int i = 0; i < 2; i++) {
+          const auto& input_dim = input_shape.dim(2 + i);
+          auto* output_dim = output_shape->add_dim();
+          if (input_dim.has_dim_value()) {
+            output_dim->set_dim_value(input_dim.dim_value() + pads[i] + pads[2 + i]);
+          }
+        }
+      });
 }
 
 }  // namespace contrib
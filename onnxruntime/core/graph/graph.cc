@@ -3,6 +3,7 @@
 
 #include "core/graph/graph.h"
 
+#include <atomic>
 #include <cassert>
 #include <fstream>
 #include <iostream>
@@ -147,6 +148,25 @@ static Status MergeShapeInfo(const std::string& output_name,
   return status;
 }
 
+static bool IsSameShape(const TensorShapeProto& a, const TensorShapeProto& b) {
+  if (a.dim_size() != b.dim_size()) {
+    return false;
+  }
+
+  for (int i = 0; i < a.dim_size(); ++i) {
+    const auto& a_dim = a.dim(i);
+    const auto& b_dim = b.dim(i);
+    if (a_dim.value_case() != b_dim.value_case() ||
+        (utils::HasDimValue(a_dim) && a_dim.dim_value() != b_dim.dim_value()) ||
+        (utils::HasDimParam(a_dim) && a_dim.dim_param() != b_dim.dim_param()) ||
+        a_dim.denotation() != b_dim.denotation()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 static bool GraphLoadedFromModelFile(const GraphProto* graph_proto) {
   return graph_proto && (graph_proto->node_size() != 0 ||
                          graph_proto->output_size() != 0);
@@ -208,6 +228,11 @@ NodeArg::NodeArg(const std::string& name, const TypeProto* p_node_arg_type) {
 }
 #endif  // #if !defined(ORT_MINIMAL_BUILD) || defined(ORT_EXTENDED_MINIMAL_BUILD) || defined(ORT_MINIMAL_BUILD_CUSTOM_OPS)
 
+uint64_t NodeArg::NextTypeVersion() noexcept {
+  static std::atomic<uint64_t> next_type_version{0};
+  return ++next_type_version;
+}
+
 NodeArg::NodeArg(NodeArgInfo&& node_arg_info) {
   node_arg_info_ = std::move(node_arg_info);
 
@@ -299,6 +324,7 @@ bool NodeArg::HasTensorOrScalarShape() const {
 
 #if !defined(ORT_MINIMAL_BUILD) || defined(ORT_EXTENDED_MINIMAL_BUILD)
 void NodeArg::SetShape(const TensorShapeProto& shape) {
+  type_version_ = NextTypeVersion();
   const auto type_case = node_arg_info_.type().value_case();
   switch (type_case) {
     case TypeProto::kTensorType:
@@ -330,6 +356,7 @@ void NodeArg::SetShape(const TensorShapeProto& shape) {
 }
 
 void NodeArg::ClearShape() {
+  type_version_ = NextTypeVersion();
   const auto type_case = node_arg_info_.type().value_case();
   switch (type_case) {
     case TypeProto::kTensorType:
@@ -393,6 +420,7 @@ common::Status NodeArg::OverrideTypesHelper(const ONNX_NAMESPACE::TypeProto& inp
 
 common::Status NodeArg::UpdateTypeAndShape(const ONNX_NAMESPACE::TypeProto& input_type, bool strict,
                                            bool override_types, const logging::Logger& logger) {
+  type_version_ = NextTypeVersion();
   if (!utils::HasType(node_arg_info_)) {
     SetType(input_type);
     return Status::OK();
@@ -515,6 +543,7 @@ void NodeArg::SetType(DataType p_type) {
   }
 
   type_ = p_type;
+  type_version_ = NextTypeVersion();
   *(node_arg_info_.mutable_type()) = DataTypeUtils::ToTypeProto(p_type);
 }
 
@@ -524,6 +553,7 @@ void NodeArg::SetType(DataType p_type) {
 
 void NodeArg::SetType(const TypeProto& type_proto) {
   type_ = DataTypeUtils::ToType(type_proto);
+  type_version_ = NextTypeVersion();
   *(node_arg_info_.mutable_type()) = type_proto;
 }
 
@@ -994,6 +1024,7 @@ void Node::CreateSubgraph(const std::string& attr_name) {
 
 void Node::AddAttributeProto(AttributeProto value) {
   utils::SetNodeAttribute(std::move(value), attributes_);
+  ResetInferenceState();
   if (graph_) {
     graph_->SetGraphResolveNeeded();
     graph_->SetGraphProtoSyncNeeded();
@@ -1044,6 +1075,7 @@ void Node::AddAttribute(std::string attr_name, GraphProto value) {
 bool Node::ClearAttribute(const std::string& attr_name) {
   graph_->SetGraphResolveNeeded();
   graph_->SetGraphProtoSyncNeeded();
+  ResetInferenceState();
   return attributes_.erase(attr_name) > 0;
 }
 
@@ -1052,6 +1084,7 @@ bool Node::ClearAttribute(const std::string& attr_name) {
 int Node::PruneRemovableAttributes(gsl::span<const std::string> removable_attributes) {
   graph_->SetGraphResolveNeeded();
   graph_->SetGraphProtoSyncNeeded();
+  ResetInferenceState();
   int n_removed = 0;
   for (const auto& name : removable_attributes) {
     n_removed += static_cast<int>(attributes_.erase(name));
@@ -3026,11 +3059,15 @@ Status Graph::InferAndVerifyTypeMatch(Node& node, const OpSchema& op, const Reso
         if (!status.IsOK()) {
           return ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "Node:", node_name, " ", status.ErrorMessage());
         }
-        // we may have cleared the shape if there was a mismatch so handle that
-        if (utils::HasShape(merge_target))
-          output_def->SetShape(utils::GetShape(merge_target));
-        else
+        // we may have cleared the shape if there was a mismatch so handle that.
+        // leave an unchanged shape alone so the consumers of the output are not inferred again by the next Resolve.
+        if (utils::HasShape(merge_target)) {
+          if (!IsSameShape(utils::GetShape(merge_target), *output_def->Shape())) {
+            output_def->SetShape(utils::GetShape(merge_target));
+          }
+        } else {
           output_def->ClearShape();
+        }
       }
     }
   }
@@ -3038,6 +3075,47 @@ Status Graph::InferAndVerifyTypeMatch(Node& node, const OpSchema& op, const Reso
   return Status::OK();
 }
 
+Node::InferenceState Graph::GetInferenceState(const Node& node) const {
+  Node::InferenceState state;
+  state.op = node.Op();
+
+  const auto& input_defs = node.InputDefs();
+  const auto& output_defs = node.OutputDefs();
+  state.arg_versions.reserve(input_defs.size() + output_defs.size());
+  state.input_data.reserve(input_defs.size());
+
+  for (const NodeArg* input_def : input_defs) {
+    state.arg_versions.push_back(input_def->type_version_);
+    state.input_data.push_back(input_def->Exists() ? GetConstantInitializer(input_def->Name(), true) : nullptr);
+  }
+
+  for (const NodeArg* output_def : output_defs) {
+    state.arg_versions.push_back(output_def->type_version_);
+  }
+
+  return state;
+}
+
+Status Graph::VerifySkippedInferencing(Node& node, const OpSchema& op, const ResolveOptions& options) {
+  std::vector<std::string> skipped_outputs;
+  skipped_outputs.reserve(node.OutputDefs().size());
+  for (const NodeArg* output_def : node.OutputDefs()) {
+    skipped_outputs.push_back(output_def->ToProto().SerializeAsString());
+  }
+
+  ORT_RETURN_IF_ERROR(InferAndVerifyTypeMatch(node, op, options));
+
+  for (size_t i = 0; i < skipped_outputs.size(); ++i) {
+    const NodeArg& output_def = *node.OutputDefs()[i];
+    ORT_RETURN_IF_NOT(output_def.ToProto().SerializeAsString() == skipped_outputs[i],
+                      "Type and shape inferencing of node (", node.Name(), ") was skipped but changes output (",
+                      output_def.Name(), "). Some modification of the graph is not tracked.");
+  }
+
+  node.inference_state_ = GetInferenceState(node);
+  return Status::OK();
+}
+
 // Apply type-inference and type-checking to all inputs and initializers:
 common::Status Graph::TypeCheckInputsAndInitializers() {
   // Check that the type of every input is specified:
@@ -3232,7 +3310,21 @@ Status Graph::VerifyNodeAndOpMatch(const ResolveOptions& options) {
       }
     }
 
-    NO_CHANGE_ON_SYNC_FLAG(ORT_RETURN_IF_ERROR(InferAndVerifyTypeMatch(node, *p_op, options)));
+    // Skip type and shape inferencing if nothing it depends on changed since it last ran. Nodes in or with
+    // subgraphs also depend on values from another graph, and overriding types may change the outputs regardless,
+    // so they are always inferred.
+    const bool can_skip_inferencing = parent_node_ == nullptr && !node.ContainsSubgraph() && !options.override_types;
+    if (can_skip_inferencing && node.inference_state_.has_value() &&
+        *node.inference_state_ == GetInferenceState(node)) {
+      if (options.verify_skipped_inferencing) {
+        NO_CHANGE_ON_SYNC_FLAG(ORT_RETURN_IF_ERROR(VerifySkippedInferencing(node, *p_op, options)));
+      }
+    } else {
+      NO_CHANGE_ON_SYNC_FLAG(ORT_RETURN_IF_ERROR(InferAndVerifyTypeMatch(node, *p_op, options)));
+      if (can_skip_inferencing) {
+        node.inference_state_ = GetInferenceState(node);
+      }
+    }
 
     // Accumulate output names of the iterated Node
     for (const auto& output : node.OutputDefs()) {
@@ -3422,6 +3514,7 @@ void Graph::AddInitializedTensor(const TensorProto& tensor) {
   const gsl::not_null<TensorProto*> tensor_added{graph_proto_->add_initializer()};
   *(tensor_added) = tensor;
   name_to_initial_tensor_.emplace(tensor.name(), tensor_added);
+  InitializerDataChanged(tensor.name());
   SetGraphResolveNeeded();
   if (!is_loaded_from_model_file_ && GetNodeArg(tensor.name()) == nullptr) {
     // make sure there is a NodeArg for the initializer as SetGraphInputsOutputs may add it to the graph inputs.
@@ -3517,6 +3610,7 @@ void Graph::RemoveInitializedTensor(const std::string& tensor_name) {
     // doesn't matter if it existed or not
     ORT_IGNORE_RETURN_VALUE(ortvalue_initializers_.erase(tensor_name));
 
+    InitializerDataChanged(tensor_name);
     SetGraphResolveNeeded();
   } else {
 #if !defined(DISABLE_SPARSE_TENSORS)
@@ -3574,6 +3668,9 @@ Status Graph::ReplaceInitializedTensorImpl(ONNX_NAMESPACE::TensorProto new_initi
               "graph_proto_ is not in sync with name_to_initial_tensor_");
 
   **existing_entry = std::move(new_initializer);
+  // an OrtValue that held the data of the old initializer must not be used for the new one
+  ORT_IGNORE_RETURN_VALUE(ortvalue_initializers_.erase((*existing_entry)->name()));
+  InitializerDataChanged((*existing_entry)->name());
 
   return Status::OK();
 }
@@ -3582,6 +3679,16 @@ Status Graph::ReplaceInitializedTensor(ONNX_NAMESPACE::TensorProto new_initializ
   return ReplaceInitializedTensorImpl(std::move(new_initializer), false);
 }
 
+Status Graph::ReplaceInitializedTensor(const std::string& name, const OrtValue& value) {
+  ORT_RETURN_IF_NOT(value.IsTensor(), "Initializers must be Tensors");
+  const Tensor& tensor = value.Get<Tensor>();
+  ORT_RETURN_IF(tensor.IsDataTypeString(), "The data of string initializers can't be referred to in memory.");
+  ORT_RETURN_IF_ERROR(ReplaceInitializedTensorImpl(utils::TensorToTensorProto(tensor, name, /*use_tensor_buffer*/ true),
+                                                   false));
+  ortvalue_initializers_.insert_or_assign(name, value);
+  return Status::OK();
+}
+
 #if !defined(DISABLE_EXTERNAL_INITIALIZERS)
 Status Graph::InjectExternalInitializedTensors(const InlinedHashMap<std::string, OrtValue>& external_initializers) {
   for (const auto& e : external_initializers) {
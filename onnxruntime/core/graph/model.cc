@@ -9,6 +9,7 @@
 #include "core/graph/model.h"
 #include "core/graph/model_editor_api_types.h"
 #include "core/graph/model_load_utils.h"
+#include "core/graph/model_proto_parser.h"
 
 #ifdef _MSC_VER
 #pragma warning(push)
@@ -24,6 +25,7 @@
 #include <gsl/gsl>
 
 #include "core/platform/env.h"
+#include "core/platform/threadpool.h"
 
 #if !defined(ORT_MINIMAL_BUILD)
 #include "core/graph/schema_registry.h"
@@ -382,6 +384,12 @@ ModelProto Model::ToProto() const {
   return result;
 }
 
+ModelProto Model::ToProtoWithInMemoryInitializers() {
+  // the non-const ToGraphProto updates the GraphProto of model_proto_ in place and leaves the initializers alone.
+  ORT_IGNORE_RETURN_VALUE(graph_->ToGraphProto());
+  return model_proto_;
+}
+
 ModelProto Model::ToGraphProtoWithExternalInitializers(const std::filesystem::path& external_file_name,
                                                        const std::filesystem::path& file_path,
                                                        const ModelSavingOptions& model_saving_options) const {
@@ -538,6 +546,32 @@ static Status LoadModelHelper(const T& file_path, Loader loader) {
   return Env::Default().FileClose(fd);
 }
 
+// Large models are parsed from a memory mapping of the file, so their nodes and initializers can be parsed in
+// parallel on thread_pool. `parsed` is set to false if the file is smaller, can not be mapped, or there is no pool to
+// parse it in parallel, in which case it is streamed.
+static Status ParseMappedModelFile(const PathString& file_path, concurrency::ThreadPool* thread_pool,
+                                   ONNX_NAMESPACE::ModelProto& model_proto, bool& parsed) {
+  parsed = false;
+  size_t file_length = 0;
+  if (concurrency::ThreadPool::DegreeOfParallelism(thread_pool) < 2 ||
+      !Env::Default().GetFileLength(file_path.c_str(), file_length).IsOK() ||
+      file_length < kMinBytesForParallelModelParse) {
+    return Status::OK();
+  }
+
+  Env::MappedMemoryPtr mapped_model;
+  if (!Env::Default().MapFileIntoMemory(file_path.c_str(), 0, file_length, mapped_model).IsOK()) {
+    return Status::OK();
+  }
+
+  parsed = true;
+  if (!ParseModelProto(mapped_model.get(), file_length, model_proto, thread_pool)) {
+    return Status(ONNXRUNTIME, INVALID_PROTOBUF, "Protobuf parsing failed.");
+  }
+
+  return Status::OK();
+}
+
 template <typename T>
 static Status LoadModel(const T& file_path, ONNX_NAMESPACE::ModelProto& model_proto) {
   const auto loader = [&model_proto](int fd) {
@@ -551,6 +585,13 @@ template <typename T>
 static Status LoadModel(const T& file_path, std::shared_ptr<Model>& p_model,
                         const IOnnxRuntimeOpSchemaRegistryList* local_registries,
                         const logging::Logger& logger, const ModelOptions& options) {
+  ModelProto model_proto;
+  bool parsed = false;
+  ORT_RETURN_IF_ERROR(ParseMappedModelFile(ToPathString(file_path), options.thread_pool, model_proto, parsed));
+  if (parsed) {
+    return Model::Load(std::move(model_proto), ToPathString(file_path), p_model, local_registries, logger, options);
+  }
+
   const auto loader = [&file_path, &p_model, local_registries, &logger, &options](int fd) {
     return Model::Load(fd, ToPathString(file_path), p_model, local_registries, logger, options);
   };
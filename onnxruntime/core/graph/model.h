@@ -23,6 +23,10 @@ namespace onnxruntime {
 
 class PrepackedShareableWeightsContainer;
 
+namespace concurrency {
+class ThreadPool;
+}  // namespace concurrency
+
 namespace fbs {
 struct Model;
 }  // namespace fbs
@@ -41,6 +45,10 @@ struct ModelOptions {
 
   CheckLoadCancellationFn check_load_cancellation_fn;
 
+  // Pool to parse the nodes and initializers of a large model file on in parallel. The model is parsed on the calling
+  // thread if it is nullptr.
+  concurrency::ThreadPool* thread_pool = nullptr;
+
   ModelOptions(bool allow_released_opsets_only, bool strict_shape_type_inference,
                CheckLoadCancellationFn check_load_cancellation_fn)
       : allow_released_opsets_only(allow_released_opsets_only),
@@ -200,6 +208,11 @@ class Model {
   // Get model's serialization proto data.
   ONNX_NAMESPACE::ModelProto ToProto() const;
 
+  // Get model's serialization proto data with the initializers as they are in the graph. Unlike ToProto, initializers
+  // that refer to data in memory (utils::kTensorProtoMemoryAddressTag) are not copied, so the result is only valid
+  // while that data is.
+  ONNX_NAMESPACE::ModelProto ToProtoWithInMemoryInitializers();
+
   // Get model's serialization proto data.
   // Save initializer larger than the given threshold (in bytes) into an external binary file
   // with the given name. This function is useful to avoid hitting the size limit of protobuf files.
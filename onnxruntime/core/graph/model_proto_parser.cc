@@ -0,0 +1,180 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#if !defined(ORT_MINIMAL_BUILD)
+
+#include "core/graph/model_proto_parser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <string>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include <google/protobuf/io/coded_stream.h>
+
+#include "core/common/narrow.h"
+#include "core/platform/threadpool.h"
+
+namespace onnxruntime {
+
+namespace {
+
+using ::google::protobuf::io::CodedInputStream;
+
+// field numbers in onnx.proto
+constexpr uint32_t kModelProtoGraph = 7;
+constexpr uint32_t kGraphProtoNode = 1;
+constexpr uint32_t kGraphProtoInitializer = 5;
+
+constexpr uint32_t kWireTypeVarint = 0;
+constexpr uint32_t kWireTypeFixed64 = 1;
+constexpr uint32_t kWireTypeLengthDelimited = 2;
+constexpr uint32_t kWireTypeFixed32 = 5;
+
+// Splits a serialized message into the payloads of the length-delimited fields numbered split_fields[i], which are
+// added to payloads[i], and the serialized remaining fields. Returns false if the message can not be split, in which
+// case it should be parsed as a whole.
+bool SplitMessage(gsl::span<const uint8_t> message, gsl::span<const uint32_t> split_fields,
+                  std::vector<std::vector<gsl::span<const uint8_t>>>& payloads, std::string& remaining_fields) {
+  payloads.assign(split_fields.size(), {});
+  remaining_fields.clear();
+
+  CodedInputStream input(message.data(), narrow<int>(message.size()));
+  while (input.CurrentPosition() != narrow<int>(message.size())) {
+    const int field_begin = input.CurrentPosition();
+    const uint32_t tag = input.ReadTag();
+    if (tag == 0) {
+      return false;
+    }
+
+    const uint32_t field_number = tag >> 3;
+    const uint32_t wire_type = tag & 7;
+    bool valid = false;
+    switch (wire_type) {
+      case kWireTypeVarint: {
+        uint64_t value = 0;
+        valid = input.ReadVarint64(&value);
+        break;
+      }
+      case kWireTypeFixed64:
+        valid = input.Skip(8);
+        break;
+      case kWireTypeLengthDelimited: {
+        uint32_t length = 0;
+        valid = input.ReadVarint32(&length) && length <= static_cast<uint32_t>(INT_MAX);
+        const int payload_begin = input.CurrentPosition();
+        valid = valid && input.Skip(static_cast<int>(length));
+        if (valid) {
+          auto split_field = std::find(split_fields.begin(), split_fields.end(), field_number);
+          if (split_field != split_fields.end()) {
+            payloads[split_field - split_fields.begin()].push_back(message.subspan(payload_begin, length));
+            continue;
+          }
+        }
+        break;
+      }
+      case kWireTypeFixed32:
+        valid = input.Skip(4);
+        break;
+      default:
+        // groups are deprecated and not used by onnx.proto
+        break;
+    }
+
+    if (!valid) {
+      return false;
+    }
+
+    remaining_fields.append(reinterpret_cast<const char*>(message.data()) + field_begin,
+                            input.CurrentPosition() - field_begin);
+  }
+
+  return true;
+}
+
+struct ParseTask {
+  google::protobuf::MessageLite* message;
+  gsl::span<const uint8_t> payload;
+};
+
+bool ParseInParallel(gsl::span<const ParseTask> tasks, concurrency::ThreadPool* thread_pool) {
+  // the sizes of the messages vary a lot, so the tasks are handed out to the threads one at a time
+  std::atomic<bool> succeeded{true};
+  concurrency::ThreadPool::TrySimpleParallelFor(
+      thread_pool, narrow<std::ptrdiff_t>(tasks.size()), [&tasks, &succeeded](std::ptrdiff_t i) {
+        const auto& task = tasks[narrow<size_t>(i)];
+        if (succeeded.load(std::memory_order_relaxed) &&
+            !task.message->ParseFromArray(task.payload.data(), narrow<int>(task.payload.size()))) {
+          succeeded = false;
+        }
+      });
+
+  return succeeded.load();
+}
+
+}  // namespace
+
+bool ParseModelProto(const void* data, size_t size, ONNX_NAMESPACE::ModelProto& model_proto,
+                     concurrency::ThreadPool* thread_pool, size_t min_bytes_for_parallel_parse) {
+  if (size > static_cast<size_t>(INT_MAX)) {
+    return false;
+  }
+
+  if (size < min_bytes_for_parallel_parse || concurrency::ThreadPool::DegreeOfParallelism(thread_pool) < 2) {
+    return model_proto.ParseFromArray(data, static_cast<int>(size));
+  }
+
+  const auto model_bytes = gsl::make_span(static_cast<const uint8_t*>(data), size);
+
+  const uint32_t model_split_fields[] = {kModelProtoGraph};
+  std::vector<std::vector<gsl::span<const uint8_t>>> model_payloads;
+  std::string model_remaining_fields;
+  if (!SplitMessage(model_bytes, model_split_fields, model_payloads, model_remaining_fields) ||
+      model_payloads[0].size() != 1) {
+    // several occurrences of the graph field would have to be merged
+    return model_proto.ParseFromArray(data, static_cast<int>(size));
+  }
+
+  const uint32_t graph_split_fields[] = {kGraphProtoNode, kGraphProtoInitializer};
+  std::vector<std::vector<gsl::span<const uint8_t>>> graph_payloads;
+  std::string graph_remaining_fields;
+  if (!SplitMessage(model_payloads[0][0], graph_split_fields, graph_payloads, graph_remaining_fields)) {
+    return model_proto.ParseFromArray(data, static_cast<int>(size));
+  }
+
+  if (!model_proto.ParseFromString(model_remaining_fields)) {
+    return false;
+  }
+
+  auto& graph = *model_proto.mutable_graph();
+  if (!graph.ParseFromString(graph_remaining_fields)) {
+    return false;
+  }
+
+  const auto& node_payloads = graph_payloads[0];
+  const auto& initializer_payloads = graph_payloads[1];
+
+  std::vector<ParseTask> tasks;
+  tasks.reserve(node_payloads.size() + initializer_payloads.size());
+
+  auto& nodes = *graph.mutable_node();
+  nodes.Reserve(narrow<int>(node_payloads.size()));
+  for (const auto& payload : node_payloads) {
+    tasks.push_back({nodes.Add(), payload});
+  }
+
+  auto& initializers = *graph.mutable_initializer();
+  initializers.Reserve(narrow<int>(initializer_payloads.size()));
+  for (const auto& payload : initializer_payloads) {
+    tasks.push_back({initializers.Add(), payload});
+  }
+
+  return ParseInParallel(tasks, thread_pool);
+}
+
+}  // namespace onnxruntime
+
+#endif  // !defined(ORT_MINIMAL_BUILD)
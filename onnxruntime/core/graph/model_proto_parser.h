@@ -0,0 +1,35 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#if !defined(ORT_MINIMAL_BUILD)
+
+#include <cstddef>
+
+#include "core/graph/onnx_protobuf.h"
+
+namespace onnxruntime {
+
+namespace concurrency {
+class ThreadPool;
+}
+
+// Serialized models smaller than this are parsed on the calling thread only.
+constexpr size_t kMinBytesForParallelModelParse = 16 * 1024 * 1024;
+
+/**
+ * Parses a serialized ModelProto. Returns false if the data is not a valid ModelProto.
+ *
+ * If the data is at least min_bytes_for_parallel_parse bytes long and thread_pool can run work in parallel, the nodes
+ * and initializers of the main graph are parsed in parallel. The wire format is split at the boundaries of these
+ * repeated fields, the remaining fields are parsed as usual, and the messages of the repeated fields are parsed into
+ * preallocated entries on the threads of thread_pool. The result is the same as that of ModelProto::ParseFromArray.
+ */
+bool ParseModelProto(const void* data, size_t size, ONNX_NAMESPACE::ModelProto& model_proto,
+                     concurrency::ThreadPool* thread_pool,
+                     size_t min_bytes_for_parallel_parse = kMinBytesForParallelModelParse);
+
+}  // namespace onnxruntime
+
+#endif  // !defined(ORT_MINIMAL_BUILD)
@@ -1,9 +1,12 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <algorithm>
 #include <limits>
 
 #include "core/optimizer/constant_folding.h"
+#include "core/common/narrow.h"
+#include "core/common/parse_string.h"
 #include "core/optimizer/initializer.h"
 #include "core/optimizer/utils.h"
 #include "core/graph/graph_utils.h"
@@ -11,17 +14,102 @@
 #include "core/optimizer/utils.h"
 #include "core/framework/op_kernel.h"
 #include "core/framework/tensorprotoutils.h"
+#include "core/platform/threadpool.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
 
 using namespace onnxruntime::common;
 
 namespace onnxruntime {
 
+namespace {
+
+// Maximum number of independent foldable nodes that are computed together.
+constexpr size_t kMaxPendingFolds = 64;
+
+// Outputs smaller than this are always kept in memory. Most of them are shapes and indices, whose values are read by
+// shape inferencing.
+constexpr size_t kMinBytesForExternalOutput = 4096;
+
+// A foldable node with its kernel, waiting to be computed with the other independent nodes of its batch.
+struct PendingFold {
+  Node* node;
+  std::unique_ptr<OptimizerExecutionFrame::Info> info;
+  std::unique_ptr<const OpKernel> kernel;
+  std::vector<int> fetch_mlvalue_idxs;
+  std::string cache_key;
+  std::vector<OrtValue> fetches;
+  Status status;
+};
+
+Status ComputeFold(PendingFold& fold, const logging::Logger& logger) {
+  Status status;
+  ORT_TRY {
+    OptimizerExecutionFrame frame(*fold.info, fold.fetch_mlvalue_idxs);
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable : 6387)
+#endif
+    OpKernelContext op_kernel_context(&frame, fold.kernel.get(), /*stream*/ nullptr, nullptr, logger);
+    status = fold.kernel->Compute(&op_kernel_context);
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    if (status.IsOK()) {
+      status = frame.GetOutputs(fold.fetches);
+    }
+  }
+  ORT_CATCH(const std::exception& ex) {
+    ORT_HANDLE_EXCEPTION([&]() {
+      status = ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "Failed to constant fold ", fold.node->OpType(), " node '",
+                               fold.node->Name(), "': ", ex.what());
+    });
+  }
+
+  return status;
+}
+
+// Computes the folds on the threads of thread_pool. The kernels and execution frames of the folds are independent.
+void ComputeFolds(gsl::span<PendingFold> folds, concurrency::ThreadPool* thread_pool, const logging::Logger& logger) {
+  // the costs of the nodes vary a lot, so the nodes are handed out to the threads one at a time
+  auto compute = [folds, &logger](std::ptrdiff_t i) {
+    auto& fold = folds[narrow<size_t>(i)];
+    fold.status = ComputeFold(fold, logger);
+  };
+  concurrency::ThreadPool::TrySimpleParallelFor(thread_pool, narrow<std::ptrdiff_t>(folds.size()), compute);
+}
+
+bool ConsumesAnyOf(const Node& node, const InlinedHashSet<std::string>& values) {
+  auto is_consumed = [&values](const NodeArg* input) { return input->Exists() && values.count(input->Name()) != 0; };
+  return std::any_of(node.InputDefs().begin(), node.InputDefs().end(), is_consumed) ||
+         std::any_of(node.ImplicitInputDefs().begin(), node.ImplicitInputDefs().end(), is_consumed);
+}
+
+// Removes a node whose outputs were converted to initializers, and the single-output node chains of its inputs.
+void RemoveFoldedNode(Graph& graph, Node& node) {
+  auto p_ip_node = node.InputNodesBegin();
+  const auto p_ip_node_end = node.InputNodesEnd();
+  while (p_ip_node != p_ip_node_end) {
+    const auto& input_node = *p_ip_node;
+    // Update the node iterator before removing the corresponding node because removing
+    // the node will invalidate the node iterator
+    ++p_ip_node;
+    graph_utils::RemoveNodesWithOneOutputBottomUp(graph, input_node);
+  }
+
+  // Remove the output edges of the constant node and then remove the node itself.
+  graph_utils::RemoveNodeOutputEdges(graph, node);
+  graph.RemoveNode(node.Index());
+}
+
+}  // namespace
+
 ConstantFolding::ConstantFolding(const IExecutionProvider& execution_provider,
                                  bool skip_dequantize_linear,
                                  const ConfigOptions& config_options,
                                  const InlinedHashSet<std::string_view>& compatible_execution_providers,
-                                 const InlinedHashSet<std::string>& excluded_initializers) noexcept
-    : ConstantFolding("ConstantFolding", execution_provider, skip_dequantize_linear, config_options, compatible_execution_providers, excluded_initializers) {
+                                 const InlinedHashSet<std::string>& excluded_initializers,
+                                 concurrency::ThreadPool* thread_pool) noexcept
+    : ConstantFolding("ConstantFolding", execution_provider, skip_dequantize_linear, config_options, compatible_execution_providers, excluded_initializers, thread_pool) {
 }
 
 ConstantFolding::ConstantFolding(const std::string& name,
@@ -29,12 +117,25 @@ ConstantFolding::ConstantFolding(const std::string& name,
                                  bool skip_dequantize_linear,
                                  const ConfigOptions& config_options,
                                  const InlinedHashSet<std::string_view>& compatible_execution_providers,
-                                 const InlinedHashSet<std::string>& excluded_initializers) noexcept
+                                 const InlinedHashSet<std::string>& excluded_initializers,
+                                 concurrency::ThreadPool* thread_pool) noexcept
     : GraphTransformer(name, compatible_execution_providers),
       skip_dequantize_linear_(skip_dequantize_linear),
       config_options_(config_options),
       excluded_initializers_(excluded_initializers),
-      execution_provider_(execution_provider) {
+      execution_provider_(execution_provider),
+      thread_pool_(thread_pool) {
+  const std::string cache_dir = config_options.GetConfigOrDefault(kOrtSessionOptionsConstantFoldingCacheDir, "");
+  if (!cache_dir.empty()) {
+    cache_ = std::make_unique<ConstantFoldingCache>(ToPathString(cache_dir));
+  }
+
+  // invalid values fall back to the defaults, as the constructor can not fail
+  ORT_IGNORE_RETURN_VALUE(TryParseStringWithClassicLocale(
+      config_options.GetConfigOrDefault(kOrtSessionOptionsConstantFoldingMemoryBudgetInBytes, "0"),
+      memory_budget_in_bytes_));
+  ORT_IGNORE_RETURN_VALUE(TryParseStringWithClassicLocale(
+      config_options.GetConfigOrDefault(kOrtSessionOptionsConstantFoldingNumThreads, "0"), num_threads_));
 }
 
 // We need to handle a Shape node separately as the input doesn't need to be a constant initializer for
@@ -145,18 +246,144 @@ Status ConstantFolding::ApplyImpl(Graph& graph, bool& modified, int graph_level,
   GraphViewer graph_viewer(graph);
   auto& order = graph_viewer.GetNodesInTopologicalOrder();
 
+  // The execution frames of the pending folds keep a reference to this function.
 #if !defined(DISABLE_SPARSE_TENSORS)
   std::function<bool(const std::string&)> is_sparse_initializer_check = [&graph](const std::string& name) -> bool {
     return graph.IsSparseInitializer(name);
   };
+#else
+  std::function<bool(const std::string&)> is_sparse_initializer_check = [](const std::string&) { return false; };
 #endif
 
+  // Cache keys of the values consumed by the folded nodes, by name. The keys of the outputs of folded nodes are
+  // derived from the keys of the nodes, so their data is not hashed again.
+  InlinedHashMap<std::string, std::string> value_keys;
+
+  // The outputs folded by previous passes are counted against the budget while they remain in the graph. Resolving
+  // the graph removes the ones that are no longer consumed.
+  auto& outputs_in_memory = folded_outputs_in_memory_[&graph];
+  for (auto it = outputs_in_memory.begin(); it != outputs_in_memory.end();) {
+    const ONNX_NAMESPACE::TensorProto* initializer = nullptr;
+    if (graph.GetInitializedTensor(it->first, initializer)) {
+      ++it;
+    } else {
+      folded_bytes_in_memory_ -= it->second;
+      outputs_in_memory.erase(it++);
+    }
+  }
+
+  // Keeps an output in memory unless it exceeds the budget and can stay in a data file of the cache.
+  auto keep_in_memory = [&](const std::string& name, size_t size_in_bytes) {
+    if (cache_ && memory_budget_in_bytes_ != 0 && size_in_bytes >= kMinBytesForExternalOutput &&
+        folded_bytes_in_memory_ + size_in_bytes > memory_budget_in_bytes_) {
+      return false;
+    }
+
+    folded_bytes_in_memory_ += size_in_bytes;
+    outputs_in_memory[name] += size_in_bytes;
+    return true;
+  };
+
+  // Stops counting the folded outputs consumed only by a node that is folded, as they are removed from the graph
+  // when it is resolved.
+  auto release_inputs = [&](const Node& node) {
+    for (const auto* input : node.InputDefs()) {
+      const auto it = input->Exists() ? outputs_in_memory.find(input->Name()) : outputs_in_memory.end();
+      if (it != outputs_in_memory.end() && !graph.IsOutput(input) &&
+          graph.GetConsumerNodes(input->Name()).size() == 1) {
+        folded_bytes_in_memory_ -= it->second;
+        outputs_in_memory.erase(it);
+      }
+    }
+  };
+
+  // Adds the outputs of a folded node to the graph as initializers and removes the node.
+  auto commit_fold = [&](Node& node, const std::string& cache_key, std::vector<ONNX_NAMESPACE::TensorProto>& outputs) {
+    for (size_t fetch_idx = 0; fetch_idx < outputs.size(); ++fetch_idx) {
+      auto& out_tensorproto = outputs[fetch_idx];
+      auto* constant_arg_out = node.MutableOutputDefs()[fetch_idx];
+      out_tensorproto.set_name(constant_arg_out->Name());
+
+      ONNX_NAMESPACE::TensorShapeProto result_shape;
+      for (auto dim : out_tensorproto.dims()) {
+        result_shape.add_dim()->set_dim_value(dim);
+      }
+
+      constant_arg_out->SetShape(result_shape);
+      graph.AddInitializedTensor(out_tensorproto);
+
+      if (!cache_key.empty()) {
+        value_keys.insert_or_assign(constant_arg_out->Name(), ConstantFoldingCache::GetOutputKey(cache_key, fetch_idx));
+      }
+    }
+
+    RemoveFoldedNode(graph, node);
+    modified = true;
+    have_updated_nodes = true;
+  };
+
+  // Independent foldable nodes are batched and computed in parallel. The batch is computed before a node that
+  // consumes one of its outputs, and the outputs are added to the graph in topological order.
+  std::vector<PendingFold> pending_folds;
+  InlinedHashSet<std::string> pending_outputs;
+  // The size of a batch limits the number of nodes computed in parallel.
+  size_t max_pending_folds = 1;
+  if (concurrency::ThreadPool::DegreeOfParallelism(thread_pool_) > 1) {
+    max_pending_folds = num_threads_ == 0 ? kMaxPendingFolds : std::min(num_threads_, kMaxPendingFolds);
+  }
+
+  auto compute_pending_folds = [&]() -> Status {
+    ComputeFolds(pending_folds, thread_pool_, logger);
+    for (auto& fold : pending_folds) {
+      ORT_RETURN_IF_ERROR(fold.status);
+
+      // Go over all output node args and substitute them with the newly computed tensors, which will be
+      // added to the graph as initializers.
+      ORT_ENFORCE(fold.fetches.size() == fold.node->OutputDefs().size());
+
+      std::vector<ONNX_NAMESPACE::TensorProto> cached_outputs;
+      if (!fold.cache_key.empty()) {
+        auto status = cache_->Store(fold.cache_key, fold.fetches, cached_outputs, logger);
+        if (!status.IsOK()) {
+          LOGS(logger, WARNING) << "Failed to store the constant folded " << fold.node->OpType() << " node '"
+                                << fold.node->Name() << "' in the cache: " << status.ErrorMessage();
+          cached_outputs.clear();
+        }
+      }
+
+      release_inputs(*fold.node);
+      std::vector<ONNX_NAMESPACE::TensorProto> outputs;
+      outputs.reserve(fold.fetches.size());
+      for (size_t fetch_idx = 0; fetch_idx < fold.fetches.size(); ++fetch_idx) {
+        // Build the TensorProto that corresponds to the computed OrtValue, or use the one referencing its copy in
+        // the cache.
+        const Tensor& out_tensor = fold.fetches[fetch_idx].Get<Tensor>();
+        const std::string& name = fold.node->OutputDefs()[fetch_idx]->Name();
+        if (cached_outputs.empty() || keep_in_memory(name, out_tensor.SizeInBytes())) {
+          outputs.push_back(utils::TensorToTensorProto(out_tensor, name));
+        } else {
+          outputs.push_back(std::move(cached_outputs[fetch_idx]));
+        }
+      }
+
+      commit_fold(*fold.node, fold.cache_key, outputs);
+    }
+
+    pending_folds.clear();
+    pending_outputs.clear();
+    return Status::OK();
+  };
+
   for (NodeIndex i : order) {
     auto* node = graph.GetNode(i);
     if (!node || !AllowConstantFolding(*node)) {
       continue;
     }
 
+    if (!pending_folds.empty() && ConsumesAnyOf(*node, pending_outputs)) {
+      ORT_RETURN_IF_ERROR(compute_pending_folds());
+    }
+
     ORT_RETURN_IF_ERROR(Recurse(*node, modified, graph_level, logger));
 
     // Updating a node may allow shape inferencing to infer output shapes of following nodes,
@@ -174,6 +401,11 @@ Status ConstantFolding::ApplyImpl(Graph& graph, bool& modified, int graph_level,
       // It does not convert the node to a constant in a common sense.
       // We call it constant folding because the `If` node constant condition
       // may enable us to inline the corresponding branch graph.
+      // The pending folds are committed first, as inlining changes the graph right away.
+      if (!pending_folds.empty()) {
+        ORT_RETURN_IF_ERROR(compute_pending_folds());
+      }
+
       bool folded = false;
       ORT_RETURN_IF_ERROR(ConstantFoldIfNode(graph, *node, logger, folded));
       if (folded) {
@@ -233,20 +465,76 @@ Status ConstantFolding::ApplyImpl(Graph& graph, bool& modified, int graph_level,
         }
       }
 
-#if !defined(DISABLE_SPARSE_TENSORS)
-      // Create execution frame for executing constant nodes.
-      OptimizerExecutionFrame::Info info({node}, constant_inputs, graph.ModelPath(), execution_provider_,
-                                         is_sparse_initializer_check, logger);
-#else
+      // XXX: Add support for SparseTensors outputs when we have sparse outputs
+      const auto unsupported_output = std::find_if(
+          node->OutputDefs().begin(), node->OutputDefs().end(),
+          [](const NodeArg* output) { return !utils::HasTensorType(*output->TypeAsProto()); });
+      if (unsupported_output != node->OutputDefs().end()) {
+        LOGS(logger, INFO) << "Unsupported output type of " << (*unsupported_output)->Type()
+                           << ". Can't constant fold " << node->OpType() << " node '" << node->Name() << "'";
+        continue;
+      }
+
       // Create execution frame for executing constant nodes.
-      OptimizerExecutionFrame::Info info(
-          {node}, constant_inputs, graph.ModelPath(), execution_provider_, [](const std::string&) { return false; },
-          logger);
-#endif
+      auto info = std::make_unique<OptimizerExecutionFrame::Info>(
+          std::vector<const Node*>{node}, constant_inputs, graph.ModelPath(), execution_provider_,
+          is_sparse_initializer_check, logger);
+
+      // The outputs of a node with an input that can not be cached, such as a string tensor, are not cached.
+      std::string cache_key;
+      if (cache_) {
+        std::vector<std::string> input_keys;
+        input_keys.reserve(node->InputDefs().size());
+        for (const auto* input : node->InputDefs()) {
+          if (!input->Exists()) {
+            input_keys.emplace_back();
+            continue;
+          }
+
+          auto key_it = value_keys.find(input->Name());
+          if (key_it == value_keys.end()) {
+            const auto& initializers = info->GetInitializers();
+            const auto value_it = initializers.find(info->GetMLValueIndex(input->Name()));
+            std::string key;
+            if (value_it != initializers.end() && value_it->second.IsTensor()) {
+              key = ConstantFoldingCache::GetTensorKey(value_it->second.Get<Tensor>());
+            }
+
+            key_it = value_keys.emplace(input->Name(), std::move(key)).first;
+          }
+
+          if (key_it->second.empty()) {
+            input_keys.clear();
+            break;
+          }
+
+          input_keys.push_back(key_it->second);
+        }
+
+        if (input_keys.size() == node->InputDefs().size()) {
+          cache_key = ConstantFoldingCache::GetNodeKey(*node, input_keys);
+        }
+      }
+
+      std::vector<ONNX_NAMESPACE::TensorProto> cached_outputs;
+      if (!cache_key.empty() && cache_->Lookup(cache_key, node->OutputDefs().size(), cached_outputs, logger)) {
+        release_inputs(*node);
+        for (size_t output_idx = 0; output_idx < cached_outputs.size(); ++output_idx) {
+          auto& output = cached_outputs[output_idx];
+          size_t size_in_bytes = 0;
+          ORT_RETURN_IF_ERROR(utils::GetSizeInBytesFromTensorProto<0>(output, &size_in_bytes));
+          if (keep_in_memory(node->OutputDefs()[output_idx]->Name(), size_in_bytes)) {
+            ORT_RETURN_IF_ERROR(ConstantFoldingCache::LoadExternalData(output));
+          }
+        }
+
+        commit_fold(*node, cache_key, cached_outputs);
+        continue;
+      }
 
       std::vector<int> fetch_mlvalue_idxs;
       for (const auto* node_out : node->OutputDefs()) {
-        fetch_mlvalue_idxs.push_back(info.GetMLValueIndex(node_out->Name()));
+        fetch_mlvalue_idxs.push_back(info->GetMLValueIndex(node_out->Name()));
       }
 
       const bool node_on_cpu_ep = node->GetExecutionProviderType() == kCpuExecutionProvider;
@@ -261,12 +549,12 @@ Status ConstantFolding::ApplyImpl(Graph& graph, bool& modified, int graph_level,
         // override the EP assigned to the node so that it will use the CPU kernel for Compute.
         node->SetExecutionProviderType(kCpuExecutionProvider);
 
-        kernel = info.CreateKernel(node, config_options_);
+        kernel = info->CreateKernel(node, config_options_);
 
         // undo the EP change to the value that was assigned at graph partitioning time
         node->SetExecutionProviderType(ep_type);
       } else {
-        kernel = info.CreateKernel(node, config_options_);
+        kernel = info->CreateKernel(node, config_options_);
       }
 
       // We currently constant fold using the CPU EP only.
@@ -282,74 +570,33 @@ Status ConstantFolding::ApplyImpl(Graph& graph, bool& modified, int graph_level,
         continue;
       }
 
-      OptimizerExecutionFrame frame(info, fetch_mlvalue_idxs);
-#ifdef _WIN32
-#pragma warning(push)
-#pragma warning(disable : 6387)
-#endif
-      OpKernelContext op_kernel_context(&frame, kernel.get(), /*stream*/ nullptr, nullptr, logger);
-      ORT_RETURN_IF_ERROR(kernel->Compute(&op_kernel_context));
-#ifdef _WIN32
-#pragma warning(pop)
-#endif
-
-      std::vector<OrtValue> fetches;
-      ORT_RETURN_IF_ERROR(frame.GetOutputs(fetches));
-
-      // Go over all output node args and substitute them with the newly computed tensors, which will be
-      // added to the graph as initializers.
-      ORT_ENFORCE(fetches.size() == node->OutputDefs().size());
-      converted_to_constant = true;
-      for (size_t fetch_idx = 0; fetch_idx < fetches.size(); ++fetch_idx) {
-        const auto& constant_arg_out = *node->OutputDefs()[fetch_idx];
-        // XXX: Add support for SparseTensors outputs when we have sparse outputs
-        if (!utils::HasTensorType(*constant_arg_out.TypeAsProto())) {
-          LOGS(logger, INFO) << "Unsupported output type of " << constant_arg_out.Type()
-                             << ". Can't constant fold " << node->OpType() << " node '" << node->Name() << "'";
-          converted_to_constant = false;
-          break;
-        }
+      for (const auto* node_out : node->OutputDefs()) {
+        pending_outputs.insert(node_out->Name());
       }
 
-      if (converted_to_constant) {
-        for (size_t fetch_idx = 0; fetch_idx < fetches.size(); ++fetch_idx) {
-          OrtValue& ort_value = fetches[fetch_idx];
-          // Build the TensorProto that corresponds to the computed OrtValue and add it as initializer to the graph.
-          auto* constant_arg_out = node->MutableOutputDefs()[fetch_idx];
-          const Tensor& out_tensor = ort_value.Get<Tensor>();
-          ONNX_NAMESPACE::TensorProto out_tensorproto = utils::TensorToTensorProto(out_tensor, constant_arg_out->Name());
-
-          ONNX_NAMESPACE::TensorShapeProto result_shape;
-          for (auto& dim : out_tensor.Shape().GetDims()) {
-            result_shape.add_dim()->set_dim_value(dim);
-          }
-
-          constant_arg_out->SetShape(result_shape);
-          graph.AddInitializedTensor(out_tensorproto);
-        }
+      pending_folds.push_back(PendingFold{node, std::move(info), std::move(kernel), std::move(fetch_mlvalue_idxs),
+                                          std::move(cache_key), {}, Status::OK()});
+      if (pending_folds.size() >= max_pending_folds) {
+        ORT_RETURN_IF_ERROR(compute_pending_folds());
       }
     }
 
     if (converted_to_constant) {
-      // Remove single-output node chain for inputs of the node
-      auto p_ip_node = node->InputNodesBegin();
-      const auto p_ip_node_end = node->InputNodesEnd();
-      while (p_ip_node != p_ip_node_end) {
-        const auto& input_node = *p_ip_node;
-        // Update the node iterator before removing the corresponding node because removing
-        // the node will invalidate the node iterator
-        ++p_ip_node;
-        graph_utils::RemoveNodesWithOneOutputBottomUp(graph, input_node);
+      // Removing the node may remove the nodes of its input chain, so the pending folds are committed first.
+      if (!pending_folds.empty()) {
+        ORT_RETURN_IF_ERROR(compute_pending_folds());
       }
 
-      // Remove the output edges of the constant node and then remove the node itself.
-      graph_utils::RemoveNodeOutputEdges(graph, *node);
-      graph.RemoveNode(node->Index());
+      RemoveFoldedNode(graph, *node);
       modified = true;
       have_updated_nodes = true;
     }
   }
 
+  if (!pending_folds.empty()) {
+    ORT_RETURN_IF_ERROR(compute_pending_folds());
+  }
+
   return Status::OK();
 }
 }  // namespace onnxruntime
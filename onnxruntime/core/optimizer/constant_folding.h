@@ -7,26 +7,37 @@
 #include "core/framework/ort_value.h"
 #include <memory>
 #include "core/framework/execution_provider.h"
+#include "core/optimizer/constant_folding_cache.h"
 
 namespace onnxruntime {
 
+namespace concurrency {
+class ThreadPool;
+}
+
 /**
 @class ConstantFolding
 
 Transformer that traverses the graph top-down and performs constant folding, i.e.,
 it statically computes parts of the graph that rely only on constant initializers.
+
+Independent foldable nodes are computed in parallel on the given thread pool. The outputs can be cached on disk across
+sessions, and kept in the data files of that cache rather than in memory once a memory budget is exceeded. See the
+kOrtSessionOptionsConstantFolding* session config entries.
 */
 class ConstantFolding : public GraphTransformer {
  public:
   /*! Constant folding will not be applied to nodes that have one of initializers from excluded_initializers as input.
       For pre-training, the trainable weights are those initializers to be excluded.
       \param execution_provider Execution provider instance to execute constant folding.
+      \param thread_pool Thread pool to compute independent nodes on in parallel, or nullptr to compute one at a time.
   */
   ConstantFolding(const IExecutionProvider& execution_provider,
                   bool skip_dequantize_linear,
                   const ConfigOptions& config_options,
                   const InlinedHashSet<std::string_view>& compatible_execution_providers = {},
-                  const InlinedHashSet<std::string>& excluded_initializers = {}) noexcept;
+                  const InlinedHashSet<std::string>& excluded_initializers = {},
+                  concurrency::ThreadPool* thread_pool = nullptr) noexcept;
 
  protected:
   /**
@@ -37,7 +48,8 @@ class ConstantFolding : public GraphTransformer {
                   bool skip_dequantize_linear,
                   const ConfigOptions& config_options,
                   const InlinedHashSet<std::string_view>& compatible_execution_providers = {},
-                  const InlinedHashSet<std::string>& excluded_initializers = {}) noexcept;
+                  const InlinedHashSet<std::string>& excluded_initializers = {},
+                  concurrency::ThreadPool* thread_pool = nullptr) noexcept;
   /**
    * Derived class can implement this virtual function to limit the nodes that can be constant folded.
    */
@@ -53,6 +65,16 @@ class ConstantFolding : public GraphTransformer {
   const ConfigOptions& config_options_;
   const InlinedHashSet<std::string> excluded_initializers_;
   const IExecutionProvider& execution_provider_;
+  concurrency::ThreadPool* thread_pool_;
+
+  std::unique_ptr<ConstantFoldingCache> cache_;
+  size_t memory_budget_in_bytes_{0};
+  size_t num_threads_{0};
+
+  // Sizes of the folded outputs kept in memory, by graph and name, and their total, which is counted against
+  // memory_budget_in_bytes_. An output is counted while it remains in its graph.
+  mutable InlinedHashMap<const Graph*, InlinedHashMap<std::string, size_t>> folded_outputs_in_memory_;
+  mutable size_t folded_bytes_in_memory_{0};
 };
 
 }  // namespace onnxruntime
@@ -0,0 +1,207 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/optimizer/constant_folding_cache.h"
+
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <system_error>
+
+#include "core/common/logging/logging.h"
+#include "core/framework/cache_file_utils.h"
+#include "core/framework/tensor.h"
+#include "core/framework/tensor_external_data_info.h"
+#include "core/framework/tensorprotoutils.h"
+#include "core/graph/graph.h"
+#include "onnxruntime_config.h"
+
+namespace onnxruntime {
+
+namespace {
+
+// Process-wide statistics, logged with every lookup.
+utils::CacheStatistics statistics;
+
+constexpr const char* kGraphExtension = ".pb";
+constexpr const char* kDataExtension = ".bin";
+
+std::string HashString(const std::string& value) {
+  return utils::HashToHexString(value.data(), value.size());
+}
+
+Status WriteFile(const std::filesystem::path& path, const std::function<bool(std::ostream&)>& write) {
+  return utils::WriteCacheFile(path, [&write](const std::filesystem::path& temp_path) {
+    std::ofstream stream(temp_path, std::ios::binary | std::ios::trunc);
+    ORT_RETURN_IF(!stream || !write(stream) || !stream.flush(), "Failed to write ",
+                  PathToUTF8String(temp_path.native()));
+    return Status::OK();
+  });
+}
+
+}  // namespace
+
+ConstantFoldingCache::ConstantFoldingCache(std::filesystem::path cache_dir) : cache_dir_(std::move(cache_dir)) {
+}
+
+std::string ConstantFoldingCache::GetTensorKey(const Tensor& tensor) {
+  if (tensor.IsDataTypeString()) {
+    return {};
+  }
+
+  std::ostringstream key;
+  key << "type:" << tensor.GetElementType() << " shape:" << tensor.Shape().ToString()
+      << " data:" << utils::HashToHexString(tensor.DataRaw(), tensor.SizeInBytes());
+  return HashString(key.str());
+}
+
+std::string ConstantFoldingCache::GetNodeKey(const Node& node, gsl::span<const std::string> input_keys) {
+  std::ostringstream key;
+  key << "ort:" << ORT_VERSION << "\n"
+      << "op:" << node.Domain() << ":" << node.OpType() << ":" << node.SinceVersion() << "\n";
+
+  // Sort the attributes so the key does not depend on their iteration order.
+  const std::map<std::string, const ONNX_NAMESPACE::AttributeProto*> attributes = [&node]() {
+    std::map<std::string, const ONNX_NAMESPACE::AttributeProto*> sorted;
+    for (const auto& [name, attribute] : node.GetAttributes()) {
+      sorted.emplace(name, &attribute);
+    }
+    return sorted;
+  }();
+  for (const auto& [name, attribute] : attributes) {
+    key << "attribute:" << name << "=" << HashString(attribute->SerializeAsString()) << "\n";
+  }
+
+  for (const auto& input_key : input_keys) {
+    key << "input:" << input_key << "\n";
+  }
+
+  for (const auto* output : node.OutputDefs()) {
+    key << "output:" << output->Exists() << "\n";
+  }
+
+  return HashString(key.str());
+}
+
+std::string ConstantFoldingCache::GetOutputKey(const std::string& node_key, size_t output_index) {
+  return HashString(node_key + ":" + std::to_string(output_index));
+}
+
+bool ConstantFoldingCache::Lookup(const std::string& node_key, size_t num_outputs,
+                                  std::vector<ONNX_NAMESPACE::TensorProto>& outputs,
+                                  const logging::Logger& logger) const {
+  outputs.clear();
+  const auto graph_path = cache_dir_ / (node_key + kGraphExtension);
+  std::error_code ec;
+  const auto data_path = std::filesystem::absolute(cache_dir_ / (node_key + kDataExtension), ec);
+
+  bool found = !ec && std::filesystem::is_regular_file(graph_path, ec);
+  const uint64_t data_size = found ? std::filesystem::file_size(data_path, ec) : 0;
+  found = found && !ec;
+
+  ONNX_NAMESPACE::GraphProto graph_proto;
+  if (found) {
+    std::ifstream stream(graph_path, std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    found = graph_proto.ParseFromString(bytes) && static_cast<size_t>(graph_proto.initializer_size()) == num_outputs;
+  }
+
+  // Validate the references to the data file, so that an entry that does not match its data file is a miss.
+  for (int i = 0; found && i < graph_proto.initializer_size(); ++i) {
+    auto& output = *graph_proto.mutable_initializer(i);
+    std::unique_ptr<ExternalDataInfo> external_data_info;
+    found = utils::HasExternalData(output) &&
+            ExternalDataInfo::Create(output.external_data(), external_data_info).IsOK() &&
+            external_data_info->GetOffset() >= 0 &&
+            static_cast<uint64_t>(external_data_info->GetOffset()) + external_data_info->GetLength() <= data_size;
+    if (found) {
+      output.clear_external_data();
+      ExternalDataInfo::SetExternalLocationToProto(data_path, external_data_info->GetOffset(),
+                                                   external_data_info->GetLength(), output);
+      outputs.push_back(std::move(output));
+    }
+  }
+
+  statistics.AddLookup(found);
+  if (!found) {
+    outputs.clear();
+  }
+
+  LOGS(logger, VERBOSE) << "Constant folding cache " << (found ? "hit" : "miss") << " for " << node_key << ". "
+                        << statistics;
+  return found;
+}
+
+Status ConstantFoldingCache::Store(const std::string& node_key, gsl::span<const OrtValue> fetches,
+                                   std::vector<ONNX_NAMESPACE::TensorProto>& outputs,
+                                   const logging::Logger& logger) const {
+  outputs.clear();
+  std::error_code ec;
+  std::filesystem::create_directories(cache_dir_, ec);
+  ORT_RETURN_IF(ec, "Failed to create the constant folding cache directory ", PathToUTF8String(cache_dir_.native()),
+                ": ", ec.message());
+
+  const auto graph_path = cache_dir_ / (node_key + kGraphExtension);
+  const std::filesystem::path data_file_name = node_key + kDataExtension;
+  const auto data_path = std::filesystem::absolute(cache_dir_ / data_file_name, ec);
+  ORT_RETURN_IF(ec, "Failed to get the absolute path of ", PathToUTF8String((cache_dir_ / data_file_name).native()),
+                ": ", ec.message());
+
+  ONNX_NAMESPACE::GraphProto graph_proto;
+  ORT_RETURN_IF_ERROR(WriteFile(data_path, [&](std::ostream& stream) {
+    int64_t offset = 0;
+    for (size_t i = 0; i < fetches.size(); ++i) {
+      const Tensor& tensor = fetches[i].Get<Tensor>();
+      const size_t size = tensor.SizeInBytes();
+
+      // align the data so that it can be memory mapped
+      ExternalDataInfo::AlignAndPad(stream, 0, offset);
+      stream.write(static_cast<const char*>(tensor.DataRaw()), static_cast<std::streamsize>(size));
+
+      auto& output = *graph_proto.add_initializer();
+      output.set_name(std::to_string(i));
+      output.set_data_type(tensor.GetElementType());
+      for (auto dim : tensor.Shape().GetDims()) {
+        output.add_dims(dim);
+      }
+
+      ExternalDataInfo::SetExternalLocationToProto(data_file_name, offset, size, output);
+      offset += static_cast<int64_t>(size);
+    }
+
+    return stream.good();
+  }));
+
+  // the entry exists once the GraphProto is renamed, so it is written after the data file
+  ORT_RETURN_IF_ERROR(WriteFile(graph_path, [&graph_proto](std::ostream& stream) {
+    const std::string bytes = graph_proto.SerializeAsString();
+    return static_cast<bool>(stream.write(bytes.data(), static_cast<std::streamsize>(bytes.size())));
+  }));
+
+  for (auto& output : *graph_proto.mutable_initializer()) {
+    std::unique_ptr<ExternalDataInfo> external_data_info;
+    ORT_RETURN_IF_ERROR(ExternalDataInfo::Create(output.external_data(), external_data_info));
+    output.clear_external_data();
+    ExternalDataInfo::SetExternalLocationToProto(data_path, external_data_info->GetOffset(),
+                                                 external_data_info->GetLength(), output);
+    outputs.push_back(std::move(output));
+  }
+
+  LOGS(logger, VERBOSE) << "Added " << node_key << " to the constant folding cache in "
+                        << PathToUTF8String(cache_dir_.native());
+  return Status::OK();
+}
+
+Status ConstantFoldingCache::LoadExternalData(ONNX_NAMESPACE::TensorProto& output) {
+  // the location is an absolute path, so no model path is needed
+  std::vector<uint8_t> data;
+  ORT_RETURN_IF_ERROR(utils::UnpackInitializerData(output, std::filesystem::path(), data));
+  output.clear_external_data();
+  output.clear_data_location();
+  utils::SetRawDataInTensorProto(output, data.data(), data.size());
+  return Status::OK();
+}
+
+}  // namespace onnxruntime
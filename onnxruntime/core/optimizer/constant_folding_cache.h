@@ -0,0 +1,65 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "core/common/common.h"
+#include "core/framework/ort_value.h"
+#include "core/graph/onnx_protobuf.h"
+
+namespace onnxruntime {
+
+class Node;
+class Tensor;
+
+namespace logging {
+class Logger;
+}
+
+/**
+ * On-disk cache of the outputs of constant folded nodes. Enabled by the kOrtSessionOptionsConstantFoldingCacheDir
+ * session config entry.
+ *
+ * An entry is keyed by a hash of the operator and attributes of the node and of the keys of its inputs. The key of an
+ * initializer is a hash of its contents, and the key of an output of a node folded in the same pass is derived from
+ * the key of that node, so a chain of folded nodes only hashes the initializers it starts from.
+ *
+ * An entry consists of a data file with the raw data of the outputs at page aligned offsets, and of a GraphProto with
+ * the outputs as initializers referencing the data file as external data. Entries are never removed.
+ */
+class ConstantFoldingCache {
+ public:
+  explicit ConstantFoldingCache(std::filesystem::path cache_dir);
+
+  // Returns the key of the contents of the tensor, or an empty string if it can not be cached.
+  static std::string GetTensorKey(const Tensor& tensor);
+
+  // Returns the key of the outputs of the node. input_keys has an empty string for missing optional inputs.
+  static std::string GetNodeKey(const Node& node, gsl::span<const std::string> input_keys);
+
+  static std::string GetOutputKey(const std::string& node_key, size_t output_index);
+
+  // Returns true if the entry exists. The outputs reference the data file of the entry by its absolute path.
+  bool Lookup(const std::string& node_key, size_t num_outputs, std::vector<ONNX_NAMESPACE::TensorProto>& outputs,
+              const logging::Logger& logger) const;
+
+  // Writes a new entry for the fetches of the node. The data file and the GraphProto are written to temporary files
+  // that are then renamed, the GraphProto last, so concurrent sessions never see a partially written entry. The
+  // outputs are set like for Lookup.
+  Status Store(const std::string& node_key, gsl::span<const OrtValue> fetches,
+               std::vector<ONNX_NAMESPACE::TensorProto>& outputs, const logging::Logger& logger) const;
+
+  // Replaces the reference to the data file of an output by its data.
+  static Status LoadExternalData(ONNX_NAMESPACE::TensorProto& output);
+
+ private:
+  std::filesystem::path cache_dir_;
+};
+
+}  // namespace onnxruntime
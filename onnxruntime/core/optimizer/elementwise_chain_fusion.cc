@@ -0,0 +1,232 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/optimizer/elementwise_chain_fusion.h"
+
+#include "core/graph/graph_utils.h"
+
+using namespace ONNX_NAMESPACE;
+using namespace onnxruntime::common;
+
+namespace onnxruntime {
+
+namespace {
+
+// Operators implemented by the FusedElementwise kernel.
+bool IsFusableOpType(const Node& node) {
+  return graph_utils::IsSupportedOptypeVersionAndDomain(node, "Add", {7, 13, 14}) ||
+         graph_utils::IsSupportedOptypeVersionAndDomain(node, "Sub", {7, 13, 14}) ||
+         graph_utils::IsSupportedOptypeVersionAndDomain(node, "Mul", {7, 13, 14}) ||
+         graph_utils::IsSupportedOptypeVersionAndDomain(node, "Div", {7, 13, 14}) ||
+         graph_utils::IsSupportedOptypeVersionAndDomain(node, "Sigmoid", {6, 13}) ||
+         graph_utils::IsSupportedOptypeVersionAndDomain(node, "Tanh", {6, 13}) ||
+         graph_utils::IsSupportedOptypeVersionAndDomain(node, "Exp", {6, 13}) ||
+         graph_utils::IsSupportedOptypeVersionAndDomain(node, "Relu", {6, 13, 14}) ||
+         graph_utils::IsSupportedOptypeVersionAndDomain(node, "Neg", {6, 13}) ||
+         graph_utils::IsSupportedOptypeVersionAndDomain(node, "Abs", {6, 13}) ||
+         graph_utils::IsSupportedOptypeVersionAndDomain(node, "Sqrt", {6, 13}) ||
+         graph_utils::IsSupportedOptypeVersionAndDomain(node, "Erf", {9, 13});
+}
+
+bool IsFloatTensorWithShape(const NodeArg& arg) {
+  const auto* type = arg.TypeAsProto();
+  return type != nullptr && type->has_tensor_type() &&
+         type->tensor_type().elem_type() == TensorProto_DataType_FLOAT && arg.Shape() != nullptr;
+}
+
+bool IsFusableNode(const Node& node, const InlinedHashSet<std::string_view>& compatible_providers) {
+  if (!IsFusableOpType(node) || !graph_utils::IsSupportedProvider(node, compatible_providers)) {
+    return false;
+  }
+
+  for (const NodeArg* input : node.InputDefs()) {
+    if (!IsFloatTensorWithShape(*input)) {
+      return false;
+    }
+  }
+
+  // Values in the blocked layout of NchwcTransformer are left to the NCHWc kernels, which already fused what they
+  // can around the convolutions.
+  for (auto edge = node.InputEdgesBegin(); edge != node.InputEdgesEnd(); ++edge) {
+    if (edge->GetNode().Domain() == kMSNchwcDomain) {
+      return false;
+    }
+  }
+
+  return IsFloatTensorWithShape(*node.OutputDefs()[0]);
+}
+
+bool IsSameDim(const TensorShapeProto_Dimension& a, const TensorShapeProto_Dimension& b) {
+  if (a.has_dim_value()) {
+    return b.has_dim_value() && a.dim_value() == b.dim_value();
+  }
+  return a.has_dim_param() && b.has_dim_param() && a.dim_param() == b.dim_param();
+}
+
+// FusedElementwise only repeats an input along the leading dimensions of the output, so the input must match the
+// trailing dimensions of the output once its leading dimensions of size 1 are dropped.
+bool BroadcastsAlongLeadingDims(const TensorShapeProto& input, const TensorShapeProto& output) {
+  int first = 0;
+  while (first < input.dim_size() && input.dim(first).has_dim_value() && input.dim(first).dim_value() == 1) {
+    ++first;
+  }
+
+  const int rank = input.dim_size() - first;
+  if (rank > output.dim_size()) {
+    return false;
+  }
+
+  for (int i = 0; i < rank; ++i) {
+    if (!IsSameDim(input.dim(first + i), output.dim(output.dim_size() - rank + i))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool AllInputsBroadcast(const Node& node, const TensorShapeProto& output_shape) {
+  for (const NodeArg* input : node.InputDefs()) {
+    if (!BroadcastsAlongLeadingDims(*input->Shape(), output_shape)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+/**
+Fuse groups of elementwise nodes into FusedElementwise. A group is grown backwards from its last node and a producer
+joins it only when all of the producer's consumers are already in the group, so values computed inside the group are
+never needed outside of it.
+*/
+Status ElementwiseChainFusion::ApplyImpl(Graph& graph, bool& modified, int graph_level,
+                                         const logging::Logger& logger) const {
+  GraphViewer graph_viewer(graph);
+  const auto& node_topology_list = graph_viewer.GetNodesInTopologicalOrder();
+
+  // Visit consumers before producers so each group starts from the node that produces its output.
+  for (auto it = node_topology_list.rbegin(); it != node_topology_list.rend(); ++it) {
+    auto* p_node = graph.GetNode(*it);
+    if (!p_node) continue;  // node was removed as part of an earlier fusion
+
+    Node& root = *p_node;
+    ORT_RETURN_IF_ERROR(Recurse(root, modified, graph_level, logger));
+
+    if (!IsFusableNode(root, GetCompatibleExecutionProviders())) {
+      continue;
+    }
+
+    const TensorShapeProto& output_shape = *root.OutputDefs()[0]->Shape();
+    if (!AllInputsBroadcast(root, output_shape)) {
+      continue;
+    }
+
+    InlinedVector<const Node*> members{&root};
+    InlinedHashSet<NodeIndex> member_indices{root.Index()};
+
+    auto can_join = [&](const Node& producer) {
+      if (member_indices.count(producer.Index()) != 0 ||
+          producer.GetExecutionProviderType() != root.GetExecutionProviderType() ||
+          !IsFusableNode(producer, GetCompatibleExecutionProviders()) ||
+          graph.NodeProducesGraphOutput(producer) ||
+          !AllInputsBroadcast(producer, output_shape)) {
+        return false;
+      }
+
+      for (auto edge = producer.OutputEdgesBegin(); edge != producer.OutputEdgesEnd(); ++edge) {
+        if (member_indices.count(edge->GetNode().Index()) == 0) {
+          return false;
+        }
+      }
+      return true;
+    };
+
+    // A producer may only become eligible after its other consumers joined, so repeat until nothing changes.
+    bool grown = true;
+    while (grown) {
+      grown = false;
+      for (size_t i = 0; i < members.size(); ++i) {
+        for (auto edge = members[i]->InputEdgesBegin(); edge != members[i]->InputEdgesEnd(); ++edge) {
+          const Node& producer = edge->GetNode();
+          if (can_join(producer)) {
+            members.push_back(&producer);
+            member_indices.insert(producer.Index());
+            grown = true;
+          }
+        }
+      }
+    }
+
+    if (members.size() < 2) {
+      continue;
+    }
+
+    // Emit the instructions in topological order. The root consumes every other member, so it comes last.
+    InlinedVector<std::reference_wrapper<Node>> nodes_to_fuse;
+    for (auto index : node_topology_list) {
+      if (member_indices.count(index) != 0) {
+        nodes_to_fuse.emplace_back(*graph.GetNode(index));
+      }
+    }
+
+    InlinedHashMap<const NodeArg*, int64_t> results;
+    for (size_t i = 0; i < nodes_to_fuse.size(); ++i) {
+      results[nodes_to_fuse[i].get().OutputDefs()[0]] = static_cast<int64_t>(i);
+    }
+
+    InlinedVector<NodeArg*> inputs;
+    InlinedHashMap<const NodeArg*, int64_t> input_indices;
+    for (Node& node : nodes_to_fuse) {
+      for (NodeArg* input : node.MutableInputDefs()) {
+        if (results.count(input) == 0 && input_indices.count(input) == 0) {
+          input_indices[input] = static_cast<int64_t>(inputs.size());
+          inputs.push_back(input);
+        }
+      }
+    }
+
+    const int64_t num_inputs = static_cast<int64_t>(inputs.size());
+    auto operand_index = [&](const NodeArg* arg) {
+      auto result = results.find(arg);
+      return result != results.end() ? num_inputs + result->second : input_indices[arg];
+    };
+
+    std::vector<std::string> op_types;
+    std::vector<int64_t> operands;
+    for (const Node& node : nodes_to_fuse) {
+      const auto& input_defs = node.InputDefs();
+      op_types.push_back(node.OpType());
+      operands.push_back(operand_index(input_defs[0]));
+      operands.push_back(input_defs.size() > 1 ? operand_index(input_defs[1]) : -1);
+    }
+
+    Node& fused_node = graph.AddNode(graph.GenerateNodeName(root.Name() + "/ElementwiseChainFusion/"),
+                                     "FusedElementwise", "fused elementwise chain", inputs,
+                                     std::array{root.MutableOutputDefs()[0]}, nullptr, kMSDomain);
+    fused_node.AddAttribute("op_types", op_types);
+    fused_node.AddAttribute("operands", operands);
+    fused_node.SetExecutionProviderType(root.GetExecutionProviderType());
+
+    // FinalizeNodeFusion only moves the input edges of the first node, so connect the producers of the other
+    // nodes' external inputs here.
+    for (size_t i = 1; i < nodes_to_fuse.size(); ++i) {
+      const Node& node = nodes_to_fuse[i];
+      for (auto edge = node.InputEdgesBegin(); edge != node.InputEdgesEnd(); ++edge) {
+        if (member_indices.count(edge->GetNode().Index()) == 0) {
+          const std::string& arg_name = node.InputDefs()[edge->GetDstArgIndex()]->Name();
+          graph.AddEdge(edge->GetNode().Index(), fused_node.Index(), edge->GetSrcArgIndex(),
+                        graph_utils::GetNodeInputIndexFromInputName(fused_node, arg_name));
+        }
+      }
+    }
+
+    graph_utils::FinalizeNodeFusion(graph, nodes_to_fuse, fused_node);
+    modified = true;
+  }
+
+  return Status::OK();
+}
+
+}  // namespace onnxruntime
@@ -0,0 +1,27 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "core/optimizer/graph_transformer.h"
+
+namespace onnxruntime {
+
+/**
+ * @brief Fuse connected float elementwise nodes (Add, Sub, Mul, Div, Sigmoid, Tanh, Exp, Relu, Neg, Abs, Sqrt, Erf)
+ * into a single com.microsoft FusedElementwise node that evaluates them in one pass without writing the intermediate
+ * tensors. Only the last node of a fused group may have consumers outside the group, and every input of the group
+ * must broadcast to the output along leading dimensions only.
+ *
+ * It runs after the pattern fusions so that chains they recognize, such as Gelu or QuickGelu, keep their dedicated
+ * kernels.
+ */
+class ElementwiseChainFusion : public GraphTransformer {
+ public:
+  ElementwiseChainFusion(const InlinedHashSet<std::string_view>& compatible_execution_providers = {}) noexcept
+      : GraphTransformer("ElementwiseChainFusion", compatible_execution_providers) {}
+
+  Status ApplyImpl(Graph& graph, bool& modified, int graph_level, const logging::Logger& logger) const override;
+};
+
+}  // namespace onnxruntime
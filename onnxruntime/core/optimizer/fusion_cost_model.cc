@@ -0,0 +1,381 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/optimizer/fusion_cost_model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <random>
+#include <sstream>
+#include <unordered_set>
+
+#include "core/framework/murmurhash3.h"
+#include "core/framework/op_kernel.h"
+#include "core/framework/tensorprotoutils.h"
+#include "core/framework/tuning_context.h"
+#include "core/graph/graph_utils.h"
+#include "core/graph/model.h"
+#include "core/optimizer/optimizer_execution_frame.h"
+
+namespace onnxruntime {
+
+namespace {
+
+constexpr const char* kOpSignaturePrefix = "CpuFusion_";
+
+// values of the decisions in the tuning results
+constexpr int kDoNotFuse = 0;
+constexpr int kFuse = 1;
+
+// same limits as TunableOp uses for the candidates of an op
+constexpr int kMaxProfileRuns = 100;
+constexpr int kApproxProfileRuns = 3;
+
+uint32_t HashAttributes(const NodeAttributes& attributes) {
+  // NodeAttributes is unordered, the hash must not depend on the iteration order
+  std::map<std::string, const ONNX_NAMESPACE::AttributeProto*> sorted_attributes;
+  for (const auto& [name, attribute] : attributes) {
+    sorted_attributes.emplace(name, &attribute);
+  }
+
+  std::string serialized;
+  for (const auto& [name, attribute] : sorted_attributes) {
+    serialized += attribute->SerializeAsString();
+  }
+
+  uint32_t hash = 0;
+  MurmurHash3::x86_32(serialized.data(), serialized.size(), 0, &hash);
+  return hash;
+}
+
+Status CreateRandomTensor(const ONNX_NAMESPACE::TypeProto& type, const AllocatorPtr& allocator,
+                          std::mt19937& generator, OrtValue& value) {
+  ORT_RETURN_IF_NOT(utils::HasTensorType(type) && utils::HasShape(type.tensor_type()),
+                    "Inputs must be tensors with a known shape.");
+  const auto shape = utils::GetTensorShapeFromTensorShapeProto(type.tensor_type().shape());
+  ORT_RETURN_IF(shape.Size() < 0, "Input shape ", shape, " is not concrete.");
+
+  const auto* tensor_type = DataTypeImpl::TensorTypeFromONNXEnum(type.tensor_type().elem_type());
+  ORT_RETURN_IF(tensor_type == nullptr, "Unsupported input type ", type.tensor_type().elem_type());
+  const auto* element_type = tensor_type->GetElementType();
+  ORT_RETURN_IF(element_type == DataTypeImpl::GetType<std::string>(), "String inputs are not supported.");
+
+  Tensor::InitOrtValue(element_type, shape, allocator, value);
+  auto& tensor = *value.GetMutable<Tensor>();
+  if (tensor.IsDataType<float>()) {
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    auto data = tensor.MutableDataAsSpan<float>();
+    std::generate(data.begin(), data.end(), [&]() { return distribution(generator); });
+  } else {
+    std::memset(tensor.MutableDataRaw(), 0, tensor.SizeInBytes());
+  }
+
+  return Status::OK();
+}
+
+}  // namespace
+
+FusionCostModel::Subgraph FusionCostModel::Subgraph::FromNodes(gsl::span<const Node* const> nodes) {
+  Subgraph subgraph;
+  auto add_values = [&subgraph](const ConstPointerContainer<std::vector<NodeArg*>>& defs) {
+    std::vector<std::string> names;
+    names.reserve(defs.size());
+    for (const NodeArg* def : defs) {
+      if (def->Exists()) {
+        subgraph.AddValue(*def);
+      }
+      names.push_back(def->Exists() ? def->Name() : std::string{});
+    }
+    return names;
+  };
+
+  for (const Node* node : nodes) {
+    auto inputs = add_values(node->InputDefs());
+    auto outputs = add_values(node->OutputDefs());
+    subgraph.AddNode(node->OpType(), node->Domain(), inputs, outputs, node->GetAttributes());
+  }
+
+  return subgraph;
+}
+
+void FusionCostModel::Subgraph::AddValue(const NodeArg& node_arg) {
+  const auto* type = node_arg.TypeAsProto();
+  AddValue(node_arg.Name(), type != nullptr ? *type : ONNX_NAMESPACE::TypeProto{});
+}
+
+void FusionCostModel::Subgraph::AddValue(const std::string& name, const ONNX_NAMESPACE::TypeProto& type) {
+  value_types_.insert_or_assign(name, type);
+}
+
+void FusionCostModel::Subgraph::AddNode(const std::string& op_type, const std::string& domain,
+                                        const std::vector<std::string>& inputs,
+                                        const std::vector<std::string>& outputs,
+                                        const NodeAttributes& attributes) {
+  nodes_.push_back(NodeDef{op_type, domain, inputs, outputs, attributes});
+}
+
+std::vector<std::string> FusionCostModel::Subgraph::GetInputs() const {
+  std::unordered_set<std::string> produced;
+  for (const auto& node : nodes_) {
+    produced.insert(node.outputs.begin(), node.outputs.end());
+  }
+
+  std::vector<std::string> inputs;
+  std::unordered_set<std::string> seen;
+  for (const auto& node : nodes_) {
+    for (const auto& input : node.inputs) {
+      if (!input.empty() && produced.count(input) == 0 && seen.insert(input).second) {
+        inputs.push_back(input);
+      }
+    }
+  }
+
+  return inputs;
+}
+
+bool FusionCostModel::IsEnabled(const Node& node) const {
+  if (cpu_execution_provider_ == nullptr) {
+    return false;
+  }
+
+  const auto& ep_type = node.GetExecutionProviderType();
+  if (!ep_type.empty() && ep_type != kCpuExecutionProvider) {
+    return false;
+  }
+
+  const auto* tuning_context = cpu_execution_provider_->GetTuningContext();
+  return tuning_context != nullptr && tuning_context->IsTunableOpEnabled();
+}
+
+std::optional<std::string> FusionCostModel::GetParamsSignature(const Graph& graph, const Subgraph& unfused) {
+  const auto inputs = unfused.GetInputs();
+  const std::unordered_set<std::string> input_set(inputs.begin(), inputs.end());
+
+  // e.g. "MatMul(1:128x768,1:768x3072c)Add(*,1:3072c)" for the element types, shapes and constness of the inputs of
+  // each node. The shapes of the intermediate values follow from these.
+  std::ostringstream oss;
+  for (const auto& node : unfused.nodes_) {
+    oss << node.op_type << '(';
+    for (size_t i = 0; i < node.inputs.size(); ++i) {
+      const auto& name = node.inputs[i];
+      oss << (i > 0 ? "," : "");
+      if (name.empty()) {
+        continue;
+      }
+
+      if (input_set.count(name) == 0) {
+        oss << '*';
+        continue;
+      }
+
+      const auto& type = unfused.value_types_.at(name);
+      if (!utils::HasTensorType(type) || !utils::HasShape(type.tensor_type())) {
+        return std::nullopt;
+      }
+
+      oss << type.tensor_type().elem_type() << ':';
+      const auto& shape = type.tensor_type().shape();
+      for (int d = 0; d < shape.dim_size(); ++d) {
+        if (!utils::HasDimValue(shape.dim(d))) {
+          return std::nullopt;
+        }
+        oss << (d > 0 ? "x" : "") << shape.dim(d).dim_value();
+      }
+
+      if (graph_utils::IsConstantInitializer(graph, name)) {
+        oss << 'c';
+      }
+    }
+    oss << ')';
+
+    if (!node.attributes.empty()) {
+      oss << '{' << std::hex << HashAttributes(node.attributes) << std::dec << '}';
+    }
+  }
+
+  return oss.str();
+}
+
+bool FusionCostModel::ShouldFuse(std::string_view fusion_name, const Graph& graph, const Subgraph& unfused,
+                                 const Subgraph& fused, const logging::Logger& logger) const {
+  auto* tuning_context = cpu_execution_provider_ != nullptr ? cpu_execution_provider_->GetTuningContext() : nullptr;
+  if (tuning_context == nullptr || !tuning_context->IsTunableOpEnabled()) {
+    return true;
+  }
+
+  const auto params_signature = GetParamsSignature(graph, unfused);
+  if (!params_signature.has_value()) {
+    return true;
+  }
+
+  const std::string op_signature = kOpSignaturePrefix + std::string{fusion_name};
+  auto& manager = tuning_context->GetTuningResultsManager();
+  int decision = manager.Lookup(op_signature, *params_signature);
+  if (decision < 0 && tuning_context->IsTuningEnabled()) {
+    double unfused_duration_ms = 0.0;
+    double fused_duration_ms = 0.0;
+    Status status;
+    ORT_TRY {
+      status = Profile(graph, unfused, logger, unfused_duration_ms);
+      if (status.IsOK()) {
+        status = Profile(graph, fused, logger, fused_duration_ms);
+      }
+    }
+    ORT_CATCH(const std::exception& ex) {
+      ORT_HANDLE_EXCEPTION([&]() {
+        status = ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, ex.what());
+      });
+    }
+
+    if (!status.IsOK()) {
+      LOGS(logger, WARNING) << "Could not profile " << op_signature << '(' << *params_signature
+                            << "), the fusion is applied. " << status.ErrorMessage();
+      return true;
+    }
+
+    decision = fused_duration_ms <= unfused_duration_ms ? kFuse : kDoNotFuse;
+    LOGS(logger, VERBOSE) << op_signature << '(' << *params_signature << "): fused " << fused_duration_ms
+                          << "ms, unfused " << unfused_duration_ms << "ms";
+    manager.Add(op_signature, *params_signature, decision);
+  }
+
+  return decision != kDoNotFuse;
+}
+
+Status FusionCostModel::Profile(const Graph& graph, const Subgraph& subgraph, const logging::Logger& logger,
+                                double& duration_ms) const {
+  // the nodes created by fusions can be in the contrib op domain even if the model does not import it
+  auto domain_to_version = graph.DomainToVersionMap();
+  domain_to_version.emplace(kMSDomain, 1);
+
+  Model model("FusionCostModel", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+              domain_to_version, {}, logger);
+  Graph& scratch_graph = model.MainGraph();
+
+  auto get_node_args = [&](const std::vector<std::string>& names, std::vector<NodeArg*>& node_args) -> Status {
+    node_args.clear();
+    for (const auto& name : names) {
+      if (name.empty()) {
+        node_args.push_back(&scratch_graph.GetOrCreateNodeArg(name, nullptr));
+        continue;
+      }
+
+      auto type = subgraph.value_types_.find(name);
+      ORT_RETURN_IF(type == subgraph.value_types_.end(), "The type of ", name, " was not added to the subgraph.");
+      const bool has_type = type->second.value_case() != ONNX_NAMESPACE::TypeProto::VALUE_NOT_SET;
+      node_args.push_back(&scratch_graph.GetOrCreateNodeArg(name, has_type ? &type->second : nullptr));
+    }
+    return Status::OK();
+  };
+
+  std::vector<NodeArg*> inputs;
+  std::vector<NodeArg*> outputs;
+  for (size_t i = 0; i < subgraph.nodes_.size(); ++i) {
+    const auto& node_def = subgraph.nodes_[i];
+    ORT_RETURN_IF_ERROR(get_node_args(node_def.inputs, inputs));
+    ORT_RETURN_IF_ERROR(get_node_args(node_def.outputs, outputs));
+    Node& node = scratch_graph.AddNode("node_" + std::to_string(i), node_def.op_type, "", inputs, outputs,
+                                       &node_def.attributes, node_def.domain);
+    node.SetExecutionProviderType(kCpuExecutionProvider);
+  }
+
+  ORT_RETURN_IF_ERROR(scratch_graph.Resolve());
+
+  // constant initializers of the graph are used as such, so that the kernels can prepack them. the other inputs get
+  // random values.
+  const auto allocator = std::make_shared<CPUAllocator>();
+  std::unordered_map<std::string, OrtValue> constants;
+  std::vector<std::string> feed_names;
+  std::vector<OrtValue> feeds;
+  std::mt19937 generator{42};
+  for (const auto& name : subgraph.GetInputs()) {
+    OrtValue value;
+    if (const auto* tensor_proto = graph_utils::GetConstantInitializer(graph, name)) {
+      ORT_RETURN_IF_ERROR(utils::TensorProtoToOrtValue(Env::Default(), graph.ModelPath(), *tensor_proto, allocator,
+                                                       value));
+      constants.emplace(name, std::move(value));
+    } else {
+      ORT_RETURN_IF_ERROR(CreateRandomTensor(subgraph.value_types_.at(name), allocator, generator, value));
+      feed_names.push_back(name);
+      feeds.push_back(std::move(value));
+    }
+  }
+
+  std::vector<const Node*> nodes;
+  GraphViewer graph_viewer(scratch_graph);
+  for (auto index : graph_viewer.GetNodesInTopologicalOrder()) {
+    nodes.push_back(scratch_graph.GetNode(index));
+  }
+
+  const std::function<bool(const std::string&)> is_sparse_initializer = [](const std::string&) { return false; };
+  OptimizerExecutionFrame::Info info(nodes, constants, graph.ModelPath(), *cpu_execution_provider_,
+                                     is_sparse_initializer, logger);
+
+  const ConfigOptions config_options;
+  std::vector<std::unique_ptr<const OpKernel>> kernels;
+  for (const Node* node : nodes) {
+    auto kernel = info.CreateKernel(node, config_options);
+    ORT_RETURN_IF(kernel == nullptr, "Could not find a CPU kernel for ", node->OpType(), " node.");
+
+    // the session state prepacks the constant inputs before the first run, so that the kernels are profiled the way
+    // they are run.
+    auto& mutable_kernel = const_cast<OpKernel&>(*kernel);
+    const auto& input_defs = node->InputDefs();
+    for (size_t i = 0; i < input_defs.size(); ++i) {
+      auto constant = constants.find(input_defs[i]->Name());
+      if (constant != constants.end()) {
+        bool is_packed = false;
+        ORT_RETURN_IF_ERROR(mutable_kernel.PrePack(constant->second.Get<Tensor>(), static_cast<int>(i), allocator,
+                                                   is_packed, nullptr));
+      }
+    }
+
+    kernels.push_back(std::move(kernel));
+  }
+
+  std::vector<int> feed_idxs;
+  for (const auto& name : feed_names) {
+    feed_idxs.push_back(info.GetMLValueIndex(name));
+  }
+
+  const std::vector<int> fetch_idxs;
+  OptimizerExecutionFrame frame(info, feed_idxs, feeds, fetch_idxs);
+
+  // the outputs are allocated by the first run and reused by the others
+  auto profile = [&](int num_runs, double& average_ms) -> Status {
+    const auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < num_runs; ++run) {
+      for (const auto& kernel : kernels) {
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable : 6387)
+#endif
+        OpKernelContext op_kernel_context(&frame, kernel.get(), /*stream*/ nullptr, /*threadpool*/ nullptr, logger);
+        ORT_RETURN_IF_ERROR(kernel->Compute(&op_kernel_context));
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+      }
+    }
+    average_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                 num_runs;
+    return Status::OK();
+  };
+
+  double warmup_ms = 0.0;
+  ORT_RETURN_IF_ERROR(profile(1, warmup_ms));
+
+  double approx_duration_ms = 0.0;
+  ORT_RETURN_IF_ERROR(profile(kApproxProfileRuns, approx_duration_ms));
+
+  const auto* tuning_context = cpu_execution_provider_->GetTuningContext();
+  const double max_runs = approx_duration_ms > 0.0
+                              ? tuning_context->GetMaxTuningDurationMs() / approx_duration_ms
+                              : static_cast<double>(kMaxProfileRuns);
+  const int num_runs = std::max(1, static_cast<int>(std::min(static_cast<double>(kMaxProfileRuns), max_runs)));
+  return profile(num_runs, duration_ms);
+}
+
+}  // namespace onnxruntime
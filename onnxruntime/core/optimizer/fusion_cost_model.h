@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "core/common/logging/logging.h"
+#include "core/framework/execution_provider.h"
+#include "core/graph/graph.h"
+
+namespace onnxruntime {
+
+/**
+ * Cost model that decides whether a fusion pays off on the CPU EP for the concrete shapes of a pattern.
+ *
+ * The decisions are kept in the TuningResults of the tuning context of the CPU EP, with the op signature
+ * "CpuFusion_<fusion name>", a params signature describing the nodes and input shapes of the unfused pattern, and 1
+ * if the fused subgraph is faster or 0 if it is not. Without a decision for a pattern the fusion is applied, like it
+ * is when TunableOp of the CPU EP is disabled. Nodes without an EP are treated as nodes of the CPU EP, so sessions
+ * only enable TunableOp of the CPU EP if it is their only EP.
+ *
+ * If tuning is enabled, missing decisions are made by running both subgraphs with the CPU kernels on random inputs.
+ * This is meant for an offline tuning run whose TuningResults are saved to the model metadata, from where they are
+ * loaded before the graph is optimized at session creation. The kernels run single threaded during tuning, so the
+ * decisions are best for models that run with few intra-op threads.
+ */
+class FusionCostModel {
+ public:
+  // A subgraph that computes the outputs of a pattern. Values are referred to by name, and the types of all of them
+  // are recorded so that the subgraph can be built and run on its own. Values that are constant initializers of the
+  // graph being optimized are used as such.
+  class Subgraph {
+   public:
+    // Subgraph with copies of nodes of the graph being optimized.
+    static Subgraph FromNodes(gsl::span<const Node* const> nodes);
+
+    void AddValue(const NodeArg& node_arg);
+    void AddValue(const std::string& name, const ONNX_NAMESPACE::TypeProto& type);
+
+    // The types of the inputs and outputs must have been added.
+    void AddNode(const std::string& op_type, const std::string& domain,
+                 const std::vector<std::string>& inputs, const std::vector<std::string>& outputs,
+                 const NodeAttributes& attributes = {});
+
+    // The values that are consumed but not produced by the nodes, in the order of their first use.
+    std::vector<std::string> GetInputs() const;
+
+   private:
+    friend class FusionCostModel;
+
+    struct NodeDef {
+      std::string op_type;
+      std::string domain;
+      std::vector<std::string> inputs;
+      std::vector<std::string> outputs;
+      NodeAttributes attributes;
+    };
+
+    std::vector<NodeDef> nodes_;
+    std::unordered_map<std::string, ONNX_NAMESPACE::TypeProto> value_types_;
+  };
+
+  // cpu_execution_provider may be nullptr, in which case all fusions are applied.
+  explicit FusionCostModel(const IExecutionProvider* cpu_execution_provider) noexcept
+      : cpu_execution_provider_(cpu_execution_provider) {}
+
+  // Whether the decision for a fusion of node has to be looked up. This is checked first so that the subgraphs are
+  // only described if they are used.
+  bool IsEnabled(const Node& node) const;
+
+  // Whether the pattern computed by unfused should be replaced by fused.
+  bool ShouldFuse(std::string_view fusion_name, const Graph& graph, const Subgraph& unfused, const Subgraph& fused,
+                  const logging::Logger& logger) const;
+
+  // Returns the params signature of the pattern, or std::nullopt if the shapes of its inputs are not concrete.
+  static std::optional<std::string> GetParamsSignature(const Graph& graph, const Subgraph& unfused);
+
+ private:
+  // Returns the average duration of a run of the subgraph in milliseconds.
+  Status Profile(const Graph& graph, const Subgraph& subgraph, const logging::Logger& logger,
+                 double& duration_ms) const;
+
+  const IExecutionProvider* cpu_execution_provider_;
+};
+
+}  // namespace onnxruntime
@@ -4,6 +4,7 @@
 #include "core/optimizer/initializer.h"
 #include "core/optimizer/gemm_activation_fusion.h"
 #include "core/graph/graph_utils.h"
+#include "core/graph/node_attr_utils.h"
 
 using namespace ONNX_NAMESPACE;
 using namespace ::onnxruntime::common;
@@ -75,24 +76,42 @@ Status GemmActivationFusion::ApplyImpl(Graph& graph, bool& modified, int graph_l
     Node& gemm_node = node;
     Node& act_node = *graph.GetNode(next_node.Index());  // get mutable reference
 
+    // Add a new attribute to specify the activation type, and the optional attributes for activations
+    NodeAttributes fused_gemm_attrs = gemm_node.GetAttributes();
+    fused_gemm_attrs["activation"] = utils::MakeAttribute("activation", act_node.OpType());
+    for (const auto& attr : act_node.GetAttributes()) {
+      AttributeProto fused_gemm_attr(attr.second);
+      fused_gemm_attr.set_name("activation_" + attr.first);
+      fused_gemm_attrs[fused_gemm_attr.name()] = std::move(fused_gemm_attr);
+    }
+
+    if (cost_model_.IsEnabled(gemm_node)) {
+      const Node* pattern_nodes[] = {&gemm_node, &act_node};
+      const auto unfused = FusionCostModel::Subgraph::FromNodes(pattern_nodes);
+
+      FusionCostModel::Subgraph fused;
+      std::vector<std::string> fused_gemm_inputs;
+      for (const NodeArg* def : gemm_node.InputDefs()) {
+        if (def->Exists()) {
+          fused.AddValue(*def);
+        }
+        fused_gemm_inputs.push_back(def->Exists() ? def->Name() : std::string{});
+      }
+      fused.AddValue(*act_node.OutputDefs()[0]);
+      fused.AddNode("FusedGemm", kMSDomain, fused_gemm_inputs, {act_node.OutputDefs()[0]->Name()}, fused_gemm_attrs);
+
+      if (!cost_model_.ShouldFuse("GemmActivation", graph, unfused, fused, logger)) {
+        continue;
+      }
+    }
+
     Node& fused_gemm = graph.AddNode(graph.GenerateNodeName("fused " + gemm_node.Name()), "FusedGemm",
                                      "fused Gemm " + gemm_node.Name() + "with activation " + act_node.OpType(),
-                                     gemm_node.MutableInputDefs(), {}, &gemm_node.GetAttributes(), kMSDomain);
-
-    // Add a new attribute to specify the activation type
-    fused_gemm.AddAttribute("activation", act_node.OpType());
+                                     gemm_node.MutableInputDefs(), {}, &fused_gemm_attrs, kMSDomain);
 
     // Assign provider to this new node. Provider should be same as the provider for old node.
     fused_gemm.SetExecutionProviderType(gemm_node.GetExecutionProviderType());
 
-    // Add optional attributes for activations
-    const NodeAttributes& attrs = act_node.GetAttributes();
-    for (const auto& attr : attrs) {
-      AttributeProto fused_gemm_attr(attr.second);
-      fused_gemm_attr.set_name("activation_" + attr.first);
-      fused_gemm.AddAttributeProto(std::move(fused_gemm_attr));
-    }
-
     // move output definitions and edges from act_node to fused_gemm. delete gemm_node and act_node.
     graph_utils::FinalizeNodeFusion(graph, {gemm_node, act_node}, fused_gemm);
 
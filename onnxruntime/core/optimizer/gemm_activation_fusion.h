@@ -3,16 +3,24 @@
 
 #pragma once
 
+#include "core/optimizer/fusion_cost_model.h"
 #include "core/optimizer/graph_transformer.h"
 
 namespace onnxruntime {
 
 class GemmActivationFusion : public GraphTransformer {
  public:
-  GemmActivationFusion(const InlinedHashSet<std::string_view>& compatible_execution_providers = {}) noexcept
-      : GraphTransformer("GemmActivationFusion", compatible_execution_providers) {}
+  // If cpu_execution_provider is given, its tuning results decide whether the fusion pays off for the shapes of a
+  // Gemm and activation on the CPU EP. See FusionCostModel.
+  GemmActivationFusion(const InlinedHashSet<std::string_view>& compatible_execution_providers = {},
+                       const IExecutionProvider* cpu_execution_provider = nullptr) noexcept
+      : GraphTransformer("GemmActivationFusion", compatible_execution_providers),
+        cost_model_(cpu_execution_provider) {}
 
   Status ApplyImpl(Graph& graph, bool& modified, int graph_level, const logging::Logger& logger) const override;
+
+ private:
+  FusionCostModel cost_model_;
 };
 
 }  // namespace onnxruntime
@@ -0,0 +1,146 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/optimizer/impute_scale_normalize_fusion.h"
+
+#include "core/graph/graph_utils.h"
+
+using namespace ONNX_NAMESPACE;
+using namespace onnxruntime::common;
+
+namespace onnxruntime {
+
+namespace {
+
+enum class Stage : int {
+  Imputer = 0,
+  Scaler = 1,
+  Normalizer = 2,
+  None = 3,
+};
+
+// Returns the stage of the fused chain that 'node' can be, or Stage::None if it can't be fused.
+Stage GetFusableStage(const Node& node) {
+  if (graph_utils::IsSupportedOptypeVersionAndDomain(node, "Imputer", {1}, kMLDomain)) {
+    const auto* imputed = graph_utils::GetNodeAttribute(node, "imputed_value_floats");
+    const auto* replaced = graph_utils::GetNodeAttribute(node, "replaced_value_float");
+    if (imputed != nullptr && imputed->floats_size() > 0 && replaced != nullptr &&
+        graph_utils::GetNodeAttribute(node, "imputed_value_int64s") == nullptr) {
+      return Stage::Imputer;
+    }
+  } else if (graph_utils::IsSupportedOptypeVersionAndDomain(node, "Scaler", {1}, kMLDomain)) {
+    const auto* scale = graph_utils::GetNodeAttribute(node, "scale");
+    const auto* offset = graph_utils::GetNodeAttribute(node, "offset");
+    if (scale != nullptr && offset != nullptr && scale->floats_size() > 0 &&
+        scale->floats_size() == offset->floats_size()) {
+      return Stage::Scaler;
+    }
+  } else if (graph_utils::IsSupportedOptypeVersionAndDomain(node, "Normalizer", {1}, kMLDomain)) {
+    const auto* norm = graph_utils::GetNodeAttribute(node, "norm");
+    if (norm == nullptr || norm->s() == "MAX" || norm->s() == "L1" || norm->s() == "L2") {
+      return Stage::Normalizer;
+    }
+  }
+
+  return Stage::None;
+}
+
+// The fused kernel handles float input of rank 1 or 2, which is also what Normalizer requires.
+bool IsSupportedInput(const NodeArg& input_arg) {
+  const auto* type = input_arg.TypeAsProto();
+  const auto* shape = input_arg.Shape();
+  return type != nullptr && type->has_tensor_type() &&
+         type->tensor_type().elem_type() == TensorProto_DataType_FLOAT &&
+         shape != nullptr && (shape->dim_size() == 1 || shape->dim_size() == 2);
+}
+
+}  // namespace
+
+/**
+Rewrite Imputer -> Scaler -> Normalizer (any ordered subset of at least two) to ImputeScaleNormalize.
+*/
+Status ImputeScaleNormalizeFusion::ApplyImpl(Graph& graph, bool& modified, int graph_level,
+                                             const logging::Logger& logger) const {
+  GraphViewer graph_viewer(graph);
+  const auto& node_topology_list = graph_viewer.GetNodesInTopologicalOrder();
+  for (auto node_index : node_topology_list) {
+    auto* p_node = graph.GetNode(node_index);
+    if (!p_node) continue;
+
+    Node& node = *p_node;
+    ORT_RETURN_IF_ERROR(Recurse(node, modified, graph_level, logger));
+
+    Stage stage = GetFusableStage(node);
+    if (stage == Stage::None || stage == Stage::Normalizer ||
+        !graph_utils::IsSupportedProvider(node, GetCompatibleExecutionProviders()) ||
+        !IsSupportedInput(*node.InputDefs()[0])) {
+      continue;
+    }
+
+    InlinedVector<std::reference_wrapper<Node>> nodes_to_fuse;
+    nodes_to_fuse.emplace_back(node);
+    const Node* imputer = stage == Stage::Imputer ? &node : nullptr;
+    const Node* scaler = stage == Stage::Scaler ? &node : nullptr;
+    const Node* normalizer = nullptr;
+
+    // Extend the chain while each intermediate output feeds exactly one later stage.
+    Node* p_last = &node;
+    while (p_last->GetOutputEdgesCount() == 1 && !graph.NodeProducesGraphOutput(*p_last)) {
+      Node& next = *graph.GetNode(p_last->OutputNodesBegin()->Index());
+      const Stage next_stage = GetFusableStage(next);
+      if (next_stage == Stage::None || static_cast<int>(next_stage) <= static_cast<int>(stage) ||
+          next.GetExecutionProviderType() != node.GetExecutionProviderType()) {
+        break;
+      }
+
+      if (next_stage == Stage::Scaler) {
+        scaler = &next;
+      } else {
+        normalizer = &next;
+      }
+
+      nodes_to_fuse.emplace_back(next);
+      stage = next_stage;
+      p_last = &next;
+    }
+
+    if (nodes_to_fuse.size() < 2) {
+      continue;
+    }
+
+    Node& fused_node = graph.AddNode(graph.GenerateNodeName(p_last->Name() + "/ImputeScaleNormalizeFusion/"),
+                                     "ImputeScaleNormalize", "fused ai.onnx.ml preprocessing",
+                                     std::array{node.MutableInputDefs()[0]},
+                                     std::array{p_last->MutableOutputDefs()[0]}, nullptr, kMSDomain);
+
+    // The attributes keep their values and are only renamed to the fused op's attribute names.
+    auto copy_attribute = [&fused_node](const Node& source, const std::string& from, const std::string& to) {
+      AttributeProto attr = *graph_utils::GetNodeAttribute(source, from);
+      attr.set_name(to);
+      fused_node.AddAttributeProto(std::move(attr));
+    };
+
+    if (imputer != nullptr) {
+      copy_attribute(*imputer, "imputed_value_floats", "imputed_values");
+      copy_attribute(*imputer, "replaced_value_float", "replaced_value");
+    }
+
+    if (scaler != nullptr) {
+      copy_attribute(*scaler, "offset", "offset");
+      copy_attribute(*scaler, "scale", "scale");
+    }
+
+    if (normalizer != nullptr) {
+      const auto* norm = graph_utils::GetNodeAttribute(*normalizer, "norm");
+      fused_node.AddAttribute("norm", norm != nullptr ? norm->s() : std::string("MAX"));
+    }
+
+    fused_node.SetExecutionProviderType(node.GetExecutionProviderType());
+    graph_utils::FinalizeNodeFusion(graph, nodes_to_fuse, fused_node);
+    modified = true;
+  }
+
+  return Status::OK();
+}
+
+}  // namespace onnxruntime
@@ -0,0 +1,23 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "core/optimizer/graph_transformer.h"
+
+namespace onnxruntime {
+
+/**
+ * @brief Rewrite chains of ai.onnx.ml Imputer -> Scaler -> Normalizer on float [N, C] inputs to a single
+ * com.microsoft ImputeScaleNormalize node. At least two of the three ops must be present, in that order.
+ * Chains with attribute combinations the fused kernel does not support are left unchanged.
+ */
+class ImputeScaleNormalizeFusion : public GraphTransformer {
+ public:
+  ImputeScaleNormalizeFusion(const InlinedHashSet<std::string_view>& compatible_execution_providers = {}) noexcept
+      : GraphTransformer("ImputeScaleNormalizeFusion", compatible_execution_providers) {}
+
+  Status ApplyImpl(Graph& graph, bool& modified, int graph_level, const logging::Logger& logger) const override;
+};
+
+}  // namespace onnxruntime
@@ -30,8 +30,8 @@ Initializer::Initializer(const ONNX_NAMESPACE::TensorProto& tensor_proto, const
   ORT_ENFORCE(utils::HasDataType(tensor_proto), "Initializer must have a datatype");
 #if !defined(__wasm__)
   // using full filepath is required by utils::TensorProtoToTensor(). One exception is WebAssembly platform, where
-  // external data is not loaded from real file system.
-  if (utils::HasExternalData(tensor_proto)) {
+  // external data is not loaded from real file system. External data in memory doesn't need it either.
+  if (utils::HasExternalData(tensor_proto) && !utils::HasExternalDataInMemory(tensor_proto)) {
     ORT_ENFORCE(!model_path.empty(),
                 "model_path must not be empty. Ensure that a path is provided when the model is created or loaded.");
   }
@@ -44,6 +44,15 @@ Initializer::Initializer(const ONNX_NAMESPACE::TensorProto& tensor_proto, const
 
   auto proto_shape = utils::GetTensorShapeFromTensorProto(tensor_proto);
 
+  // Alias a copy-on-write mapping of external data instead of reading it, so large initializers that are only
+  // inspected are not copied, and ones that are modified only copy the pages written to.
+  if (utils::CanMapExternalData(tensor_proto)) {
+    ORT_THROW_IF_ERROR(utils::MapExternalDataToOrtValue(Env::Default(), model_path, tensor_proto, external_data_));
+    auto& mapped = *external_data_.GetMutable<Tensor>();
+    data_ = Tensor(mapped.DataType(), proto_shape, mapped.MutableDataRaw(), mapped.Location());
+    return;
+  }
+
   // This must be pre-allocated
   Tensor w(DataTypeImpl::TensorTypeFromONNXEnum(proto_data_type)->GetElementType(), proto_shape,
            std::make_shared<CPUAllocator>());
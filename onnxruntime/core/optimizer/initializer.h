@@ -92,6 +92,8 @@ class Initializer final {
  private:
   std::string name_;
   Tensor data_;
+  // owns the mapping of external data that data_ aliases, if any
+  OrtValue external_data_;
 };
 
 }  // namespace onnxruntime
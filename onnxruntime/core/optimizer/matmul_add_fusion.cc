@@ -177,6 +177,39 @@ Status MatMulAddFusion::ApplyImpl(Graph& graph, bool& modified, int graph_level,
       continue;
     }
 
+    if (cost_model_.IsEnabled(matmul_node)) {
+      const Node* pattern_nodes[] = {&matmul_node, &add_node};
+      const auto unfused = FusionCostModel::Subgraph::FromNodes(pattern_nodes);
+
+      // the Reshape nodes around the Gemm only change the shape of contiguous tensors and are left out
+      FusionCostModel::Subgraph fused;
+      std::vector<std::string> gemm_inputs;
+      for (const NodeArg* def : gemm_input_defs) {
+        fused.AddValue(*def);
+        gemm_inputs.push_back(def->Name());
+      }
+      std::string gemm_output = add_node.OutputDefs()[0]->Name();
+      fused.AddValue(*add_node.OutputDefs()[0]);
+      if (need_reshape) {
+        const auto element_type = gemm_input_defs[0]->TypeAsProto()->tensor_type().elem_type();
+        auto add_matrix = [&](const std::string& name, int64_t rows, int64_t columns) {
+          ONNX_NAMESPACE::TypeProto type;
+          type.mutable_tensor_type()->set_elem_type(element_type);
+          type.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_value(rows);
+          type.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_value(columns);
+          fused.AddValue(name, type);
+          return name;
+        };
+        gemm_inputs[0] = add_matrix("gemm_input", m, k);
+        gemm_output = add_matrix("gemm_output", m, n);
+      }
+      fused.AddNode("Gemm", kOnnxDomain, gemm_inputs, {gemm_output});
+
+      if (!cost_model_.ShouldFuse("MatMulAdd", graph, unfused, fused, logger)) {
+        continue;
+      }
+    }
+
     auto gemm_output_defs = add_node.MutableOutputDefs();
     Node* input_node = nullptr;
     Node* output_node = nullptr;
@@ -3,16 +3,24 @@
 
 #pragma once
 
+#include "core/optimizer/fusion_cost_model.h"
 #include "core/optimizer/graph_transformer.h"
 
 namespace onnxruntime {
 
 class MatMulAddFusion : public GraphTransformer {
  public:
-  MatMulAddFusion(const InlinedHashSet<std::string_view>& compatible_execution_providers = {}) noexcept
-      : GraphTransformer("MatMulAddFusion", compatible_execution_providers) {}
+  // If cpu_execution_provider is given, its tuning results decide whether the fusion pays off for the shapes of a
+  // MatMul and Add on the CPU EP. See FusionCostModel.
+  MatMulAddFusion(const InlinedHashSet<std::string_view>& compatible_execution_providers = {},
+                  const IExecutionProvider* cpu_execution_provider = nullptr) noexcept
+      : GraphTransformer("MatMulAddFusion", compatible_execution_providers),
+        cost_model_(cpu_execution_provider) {}
 
   Status ApplyImpl(Graph& graph, bool& modified, int graph_level, const logging::Logger& logger) const override;
+
+ private:
+  FusionCostModel cost_model_;
 };
 
 }  // namespace onnxruntime
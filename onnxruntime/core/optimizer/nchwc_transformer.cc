@@ -1,7 +1,10 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <algorithm>
 #include <deque>
+#include <iterator>
+#include <string_view>
 #include "core/graph/graph_utils.h"
 #include "core/optimizer/initializer.h"
 #include "core/optimizer/nchwc_transformer.h"
@@ -127,7 +130,9 @@ class NchwcTransformerImpl {
   void TransformBatchNormalization(Node& node);
   void TransformTransposeToNhwc(Node& node);
   void TransformResize(Node& node);
+  void TransformPad(Node& node);
   void TrackTransposeFromNhwc(Node& node);
+  bool OutputMayStayInNchwc(const Node& node) const;
 
   Graph& graph_;
 
@@ -534,6 +539,15 @@ void NchwcTransformerImpl::TransformPool(Node& node) {
     return;
   }
 
+  // Reordering an input to NCHWc and the output back to NCHW costs more than the
+  // NCHWc pooling saves, so a pooling node with an input in NCHW format that has
+  // not already been reordered for another node is only converted if its output
+  // may remain in NCHWc format.
+  auto* nchwc_input = LookupNchwcArgument(input_defs[0]);
+  if ((nchwc_input == nullptr) && (reorder_inputs_.count(input_defs[0]) == 0) && !OutputMayStayInNchwc(node)) {
+    return;
+  }
+
   // Create the replacement node.
   std::string nchwc_node_name = graph_.GenerateNodeName(output_defs[0]->Name() + "_nchwc");
   Node& nchwc_node = graph_.AddNode(nchwc_node_name,
@@ -547,7 +561,6 @@ void NchwcTransformerImpl::TransformPool(Node& node) {
 
   NchwcArgument::Shape output_shape(output_defs[0]);
 
-  auto* nchwc_input = LookupNchwcArgument(input_defs[0]);
   if (nchwc_input == nullptr) {
     InsertReorderInput(nchwc_node);
   } else {
@@ -778,7 +791,10 @@ void NchwcTransformerImpl::TransformConcat(Node& node) {
 
 // After doing a Conv/Add fusion, there may be an activation node that could now
 // be fused into the Conv node as well. Otherwise, this is an elementwise
-// operation that can directly use the NCHWc input.
+// operation that can directly use the NCHWc input. The elementwise operation is
+// also applied to the padding channels of the NCHWc tensor, so it must map finite
+// values to finite values: a following NCHWc convolution multiplies the padding
+// channels by zero filter weights.
 void NchwcTransformerImpl::TransformActivation(Node& node) {
   auto& input_defs = node.MutableInputDefs();
 
@@ -790,10 +806,24 @@ void NchwcTransformerImpl::TransformActivation(Node& node) {
     // Check if this is a single use NCHWc convolution that hasn't already
     // been fused with another activation.
     auto& nchwc_node = nchwc_input->output_node_;
-    if ((nchwc_node.OpType() == "Conv") && (nchwc_node.Domain() == kMSNchwcDomain) &&
+    const bool fusable_activation = node.OpType() == "Relu" || node.OpType() == "Sigmoid" ||
+                                    node.OpType() == "Tanh" || node.OpType() == "LeakyRelu" ||
+                                    node.OpType() == "HardSigmoid";
+    if (fusable_activation && (nchwc_node.OpType() == "Conv") && (nchwc_node.Domain() == kMSNchwcDomain) &&
         (nchwc_input->starting_original_uses_ == 1) &&
         (graph_utils::GetNodeAttribute(nchwc_node, "activation") == nullptr)) {
       nchwc_node.AddAttribute("activation", node.OpType());
+      if (node.OpType() == "LeakyRelu") {
+        const auto* alpha_attr = graph_utils::GetNodeAttribute(node, "alpha");
+        nchwc_node.AddAttribute("activation_params",
+                                std::vector<float>{alpha_attr != nullptr ? alpha_attr->f() : 0.01f});
+      } else if (node.OpType() == "HardSigmoid") {
+        const auto* alpha_attr = graph_utils::GetNodeAttribute(node, "alpha");
+        const auto* beta_attr = graph_utils::GetNodeAttribute(node, "beta");
+        nchwc_node.AddAttribute("activation_params",
+                                std::vector<float>{alpha_attr != nullptr ? alpha_attr->f() : 0.2f,
+                                                   beta_attr != nullptr ? beta_attr->f() : 0.5f});
+      }
       FuseNchwcArgument(node, *nchwc_input);
       removed_nodes_.push_front(node.Index());
     } else {
@@ -1000,27 +1030,40 @@ void NchwcTransformerImpl::TransformResize(Node& node) {
     }
 
     transformation_mode_attr = graph_utils::GetNodeAttribute(node, "coordinate_transformation_mode");
-    if ((transformation_mode_attr == nullptr) ||
-        !utils::HasString(*transformation_mode_attr)) {
+    if ((transformation_mode_attr != nullptr) && !utils::HasString(*transformation_mode_attr)) {
       return;
     }
-    if (transformation_mode_attr->s() != "asymmetric") {
-      // Nearest mode kernel support asymmetric transformation mode only.
-      if (nearest_mode) {
+    const std::string transformation_mode =
+        (transformation_mode_attr != nullptr) ? transformation_mode_attr->s() : "half_pixel";
+
+    if (nearest_mode) {
+      const auto* nearest_mode_attr = graph_utils::GetNodeAttribute(node, "nearest_mode");
+      if ((nearest_mode_attr != nullptr) && !utils::HasString(*nearest_mode_attr)) {
         return;
       }
-      if ((transformation_mode_attr->s() != "align_corners") &&
-          (transformation_mode_attr->s() != "half_pixel")) {
+      const std::string nearest_rounding_mode =
+          (nearest_mode_attr != nullptr) ? nearest_mode_attr->s() : "round_prefer_floor";
+
+      // The nearest mode kernel implements the asymmetric transformation mode with
+      // floor rounding. For the integer scales supported here, an output index o
+      // maps to (o + 0.5) / scale - 0.5 with the half pixel modes, which is never
+      // more than 0.5 away from floor(o / scale) and never exactly halfway, so
+      // rounding it to the nearest integer gives the same input index.
+      if (transformation_mode == "asymmetric") {
+        if (nearest_rounding_mode != "floor") {
+          return;
+        }
+      } else if ((transformation_mode == "half_pixel") || (transformation_mode == "pytorch_half_pixel")) {
+        if ((nearest_rounding_mode != "round_prefer_floor") && (nearest_rounding_mode != "round_prefer_ceil")) {
+          return;
+        }
+      } else {
         return;
       }
-    }
-
-    if (nearest_mode) {
-      // Only support the floor rounding mode.
-      const auto* nearest_mode_attr = graph_utils::GetNodeAttribute(node, "nearest_mode");
-      if ((nearest_mode_attr == nullptr) ||
-          !utils::HasString(*nearest_mode_attr) ||
-          (nearest_mode_attr->s() != "floor")) {
+    } else {
+      if ((transformation_mode != "asymmetric") &&
+          (transformation_mode != "align_corners") &&
+          (transformation_mode != "half_pixel")) {
         return;
       }
     }
@@ -1109,8 +1152,9 @@ void NchwcTransformerImpl::TransformResize(Node& node) {
   nchwc_node.AddAttribute("scales", scales_attr);
   if (!nearest_mode) {
     nchwc_node.AddAttribute("mode", mode_attr->s());
-    if (transformation_mode_attr != nullptr) {
-      nchwc_node.AddAttribute("coordinate_transformation_mode", transformation_mode_attr->s());
+    if (node.SinceVersion() >= 11) {
+      nchwc_node.AddAttribute("coordinate_transformation_mode",
+                              (transformation_mode_attr != nullptr) ? transformation_mode_attr->s() : "half_pixel");
     }
   }
 
@@ -1122,6 +1166,129 @@ void NchwcTransformerImpl::TransformResize(Node& node) {
   removed_nodes_.push_front(node.Index());
 }
 
+void NchwcTransformerImpl::TransformPad(Node& node) {
+  auto& input_defs = node.MutableInputDefs();
+  auto& output_defs = node.MutableOutputDefs();
+
+  // Don't transform the node if the input is not already in NCHWc format.
+  auto* nchwc_input = LookupNchwcArgument(input_defs[0]);
+  if (nchwc_input == nullptr) {
+    return;
+  }
+
+  std::string mode = "constant";
+  const auto* mode_attr = graph_utils::GetNodeAttribute(node, "mode");
+  if (mode_attr != nullptr && utils::HasString(*mode_attr)) {
+    mode = mode_attr->s();
+  }
+  if (mode != "constant" && mode != "reflect" && mode != "edge") {
+    return;
+  }
+
+  InlinedVector<int64_t> pads;
+  float value = 0.0f;
+
+  if (node.SinceVersion() >= 11) {
+    // Bail out if the optional axes input is specified.
+    if (input_defs.size() > 3 && input_defs[3]->Exists()) {
+      return;
+    }
+
+    // Require that the pads tensor be static.
+    const auto* pads_tensor_proto = graph_utils::GetConstantInitializer(graph_, input_defs[1]->Name());
+    if ((pads_tensor_proto == nullptr) ||
+        (pads_tensor_proto->data_type() != ONNX_NAMESPACE::TensorProto_DataType_INT64) ||
+        (pads_tensor_proto->dims_size() != 1) ||
+        (pads_tensor_proto->dims(0) != 2 * kNchwcDims)) {
+      return;
+    }
+
+    Initializer pads_initializer{*pads_tensor_proto, graph_.ModelPath()};
+    auto pads_data = pads_initializer.DataAsSpan<int64_t>();
+    pads.assign(pads_data.begin(), pads_data.end());
+
+    // Also require that the optional constant value be static.
+    if (input_defs.size() > 2 && input_defs[2]->Exists()) {
+      const auto* value_tensor_proto = graph_utils::GetConstantInitializer(graph_, input_defs[2]->Name());
+      if ((value_tensor_proto == nullptr) ||
+          (value_tensor_proto->data_type() != ONNX_NAMESPACE::TensorProto_DataType_FLOAT)) {
+        return;
+      }
+
+      Initializer value_initializer{*value_tensor_proto, graph_.ModelPath()};
+      if (value_initializer.size() != 1) {
+        return;
+      }
+      value = value_initializer.data<float>()[0];
+    }
+  } else {
+    const auto* pads_attr = graph_utils::GetNodeAttribute(node, "pads");
+    if (pads_attr == nullptr || pads_attr->ints_size() != 2 * kNchwcDims) {
+      return;
+    }
+    pads.assign(pads_attr->ints().begin(), pads_attr->ints().end());
+
+    const auto* value_attr = graph_utils::GetNodeAttribute(node, "value");
+    if (value_attr != nullptr && utils::HasFloat(*value_attr)) {
+      value = value_attr->f();
+    }
+  }
+
+  // Only support padding of the spatial dimensions. Negative pads would crop the
+  // tensor, which is also not supported.
+  if (pads[0] != 0 || pads[1] != 0 || pads[kNchwcDims] != 0 || pads[kNchwcDims + 1] != 0) {
+    return;
+  }
+  if (std::any_of(pads.begin(), pads.end(), [](int64_t pad) { return pad < 0; })) {
+    return;
+  }
+
+  std::string nchwc_node_name = graph_.GenerateNodeName(output_defs[0]->Name() + "_nchwc");
+  Node& nchwc_node = graph_.AddNode(nchwc_node_name,
+                                    "Pad",
+                                    nchwc_node_name,
+                                    {nchwc_input->nchwc_arg_},
+                                    output_defs,
+                                    nullptr,
+                                    kMSNchwcDomain);
+  nchwc_node.SetExecutionProviderType(kCpuExecutionProvider);
+  nchwc_node.AddAttribute("pads", std::vector<int64_t>{pads[2], pads[3], pads[kNchwcDims + 2], pads[kNchwcDims + 3]});
+  nchwc_node.AddAttribute("mode", mode);
+  if (mode == "constant") {
+    nchwc_node.AddAttribute("value", value);
+  }
+
+  nchwc_input->remaining_original_uses_--;
+
+  // The batch and channel dimensions are unchanged.
+  NchwcArgument::Shape output_shape(output_defs[0]);
+  output_shape.dims_[0] = nchwc_input->shape_.dims_[0];
+  output_shape.dims_[1] = nchwc_input->shape_.dims_[1];
+
+  CreateNchwcArgument(node, nchwc_node, nchwc_input->channels_, output_shape);
+  removed_nodes_.push_front(node.Index());
+}
+
+// Returns true if a consumer of the node's output is an operator that this
+// transformer may convert to NCHWc format, so the output may not need to be
+// reordered back to NCHW format.
+bool NchwcTransformerImpl::OutputMayStayInNchwc(const Node& node) const {
+  static constexpr std::string_view nchwc_op_types[] = {
+      "Conv", "FusedConv", "MaxPool", "AveragePool", "GlobalMaxPool", "GlobalAveragePool", "Add", "Sum", "Mul",
+      "Concat", "BatchNormalization", "Upsample", "Resize", "Pad", "Relu", "Sigmoid", "Tanh", "LeakyRelu",
+      "HardSigmoid", "Elu", "Selu", "Softplus", "Softsign"};
+
+  for (auto it = node.OutputNodesBegin(); it != node.OutputNodesEnd(); ++it) {
+    const Node& consumer = *it;
+    if ((consumer.GetExecutionProviderType() == kCpuExecutionProvider) &&
+        (std::find(std::begin(nchwc_op_types), std::end(nchwc_op_types), consumer.OpType()) !=
+         std::end(nchwc_op_types))) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void NchwcTransformerImpl::TrackTransposeFromNhwc(Node& node) {
   const auto* perm_attr = graph_utils::GetNodeAttribute(node, "perm");
   if (perm_attr == nullptr || perm_attr->ints_size() != 4) {
@@ -1170,7 +1337,13 @@ void NchwcTransformerImpl::Transform(Node& node) {
       TransformConcat(node);
     } else if (graph_utils::IsSupportedOptypeVersionAndDomain(node, "Relu", {6, 13, 14}) ||
                graph_utils::IsSupportedOptypeVersionAndDomain(node, "Sigmoid", {6, 13}) ||
-               graph_utils::IsSupportedOptypeVersionAndDomain(node, "Tanh", {6, 13})) {
+               graph_utils::IsSupportedOptypeVersionAndDomain(node, "Tanh", {6, 13}) ||
+               graph_utils::IsSupportedOptypeVersionAndDomain(node, "LeakyRelu", {6, 16}) ||
+               graph_utils::IsSupportedOptypeVersionAndDomain(node, "HardSigmoid", {6, 22}) ||
+               graph_utils::IsSupportedOptypeVersionAndDomain(node, "Elu", {6, 22}) ||
+               graph_utils::IsSupportedOptypeVersionAndDomain(node, "Selu", {6, 22}) ||
+               graph_utils::IsSupportedOptypeVersionAndDomain(node, "Softplus", {1, 22}) ||
+               graph_utils::IsSupportedOptypeVersionAndDomain(node, "Softsign", {1, 22})) {
       TransformActivation(node);
     } else if (graph_utils::IsSupportedOptypeVersionAndDomain(node, "BatchNormalization", {7, 9, 14})) {
       TransformBatchNormalization(node);
@@ -1179,6 +1352,8 @@ void NchwcTransformerImpl::Transform(Node& node) {
     } else if (graph_utils::IsSupportedOptypeVersionAndDomain(node, "Upsample", {9, 13}) ||
                graph_utils::IsSupportedOptypeVersionAndDomain(node, "Resize", {10, 11, 13})) {
       TransformResize(node);
+    } else if (graph_utils::IsSupportedOptypeVersionAndDomain(node, "Pad", {2, 11, 13, 18, 19})) {
+      TransformPad(node);
     } else if (graph_utils::IsSupportedOptypeVersionAndDomain(node, "GlobalMaxPool", {1}) ||
                graph_utils::IsSupportedOptypeVersionAndDomain(node, "GlobalAveragePool", {1})) {
       // Convert these pooling types only if the input is already in NCHWc format.
@@ -52,10 +52,15 @@ OptimizerExecutionFrame::Info::Info(const std::vector<const Node*>& nodes,
     if (it != initialized_tensor_set.cend()) {
       const auto& tensor_proto = *(it->second);
       OrtValue ort_value;
-      ORT_RETURN_IF_ERROR(
-          utils::TensorProtoToOrtValue(Env::Default(),
-                                       model_path,
-                                       tensor_proto, allocator_ptr_, ort_value));
+      // kernels only read their inputs, so external data can be used from the mapped file without a copy
+      if (utils::CanMapExternalData(tensor_proto)) {
+        ORT_RETURN_IF_ERROR(utils::MapExternalDataToOrtValue(Env::Default(), model_path, tensor_proto, ort_value));
+      } else {
+        ORT_RETURN_IF_ERROR(
+            utils::TensorProtoToOrtValue(Env::Default(),
+                                         model_path,
+                                         tensor_proto, allocator_ptr_, ort_value));
+      }
 
       initializers_[idx] = std::move(ort_value);
     }
@@ -180,6 +185,16 @@ OptimizerExecutionFrame::OptimizerExecutionFrame(const Info& info,
   Init(gsl::span<const int>(), gsl::span<const OrtValue>(), info.GetInitializers(), info.GetSparseInitializerLookupFunc(), fetches);
 }
 
+OptimizerExecutionFrame::OptimizerExecutionFrame(const Info& info,
+                                                 const std::vector<int>& feed_mlvalue_idxs,
+                                                 const std::vector<OrtValue>& feeds,
+                                                 const std::vector<int>& fetch_mlvalue_idxs)
+    : IExecutionFrame(info.GetMLValueNameIdxMap(), info.GetNodeIndexInfo(), fetch_mlvalue_idxs),
+      info_(info) {
+  Init(feed_mlvalue_idxs, feeds, info.GetInitializers(), info.GetSparseInitializerLookupFunc(),
+       gsl::span<const OrtValue>());
+}
+
 AllocatorPtr OptimizerExecutionFrame::GetAllocatorImpl(const OrtDevice&) const {
   return info_.GetAllocator();
 }
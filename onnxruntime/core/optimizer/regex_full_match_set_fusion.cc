@@ -0,0 +1,89 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/optimizer/regex_full_match_set_fusion.h"
+
+#include "core/graph/graph_utils.h"
+
+using namespace ONNX_NAMESPACE;
+using namespace onnxruntime::common;
+
+namespace onnxruntime {
+
+/**
+Group RegexFullMatch nodes by their input and replace every group of two or more with RegexFullMatchSet.
+The outputs of the original nodes become the outputs of the new node, so consumers are unchanged.
+*/
+Status RegexFullMatchSetFusion::ApplyImpl(Graph& graph, bool& modified, int graph_level,
+                                          const logging::Logger& logger) const {
+  GraphViewer graph_viewer(graph);
+  const auto& node_topology_list = graph_viewer.GetNodesInTopologicalOrder();
+
+  // Groups are kept in the order their first node appears so the rewrite is deterministic.
+  InlinedVector<const NodeArg*> inputs;
+  InlinedHashMap<const NodeArg*, InlinedVector<NodeIndex>> nodes_by_input;
+  for (auto node_index : node_topology_list) {
+    auto* p_node = graph.GetNode(node_index);
+    if (p_node == nullptr) continue;
+
+    Node& node = *p_node;
+    ORT_RETURN_IF_ERROR(Recurse(node, modified, graph_level, logger));
+
+    if (!graph_utils::IsSupportedOptypeVersionAndDomain(node, "RegexFullMatch", {20}) ||
+        !graph_utils::IsSupportedProvider(node, GetCompatibleExecutionProviders())) {
+      continue;
+    }
+
+    const NodeArg* input = node.InputDefs()[0];
+    auto& group = nodes_by_input[input];
+    if (group.empty()) {
+      inputs.push_back(input);
+    }
+    group.push_back(node.Index());
+  }
+
+  for (const NodeArg* input : inputs) {
+    const auto& group = nodes_by_input[input];
+    if (group.size() < 2) continue;
+
+    std::vector<std::string> patterns;
+    InlinedVector<NodeArg*> outputs;
+    patterns.reserve(group.size());
+    outputs.reserve(group.size());
+    for (NodeIndex index : group) {
+      Node& node = *graph.GetNode(index);
+      patterns.push_back(graph_utils::GetNodeAttribute(node, "pattern")->s());
+      outputs.push_back(node.MutableOutputDefs()[0]);
+    }
+
+    Node& first_node = *graph.GetNode(group[0]);
+    Node& set_node = graph.AddNode(graph.GenerateNodeName(first_node.Name() + "/RegexFullMatchSetFusion"),
+                                   "RegexFullMatchSet", "Fused RegexFullMatch nodes with a shared input",
+                                   {graph.GetNodeArg(input->Name())}, outputs, nullptr, kMSDomain);
+    set_node.AddAttribute("patterns", patterns);
+    set_node.SetExecutionProviderType(first_node.GetExecutionProviderType());
+
+    // The input edge of the first node moves to the new node, and the output edges of every node move to the
+    // matching output of the new node.
+    graph_utils::MoveAllNodeInputEdges(graph, first_node, set_node);
+    graph.AddConsumerNode(input->Name(), &set_node);
+    for (size_t i = 0; i < group.size(); ++i) {
+      Node& node = *graph.GetNode(group[i]);
+      const auto output_edges = graph_utils::GraphEdge::GetNodeOutputEdges(node);
+      graph_utils::GraphEdge::RemoveGraphEdges(graph, output_edges);
+      for (const auto& edge : output_edges) {
+        graph.AddEdge(set_node.Index(), edge.dst_node, static_cast<int>(i), edge.dst_arg_index);
+      }
+
+      graph.UpdateProducerNode(outputs[i]->Name(), set_node.Index());
+      graph.RemoveConsumerNode(input->Name(), &node);
+      graph.RemoveNode(node.Index());
+    }
+
+    modified = true;
+  }
+
+  return Status::OK();
+}
+
+}  // namespace onnxruntime
@@ -0,0 +1,22 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "core/optimizer/graph_transformer.h"
+
+namespace onnxruntime {
+
+/**
+ * @brief Rewrite RegexFullMatch nodes that consume the same input to a single RegexFullMatchSet node,
+ * so each string is scanned once by an RE2::Set instead of once per pattern.
+ */
+class RegexFullMatchSetFusion : public GraphTransformer {
+ public:
+  RegexFullMatchSetFusion(const InlinedHashSet<std::string_view>& compatible_execution_providers = {}) noexcept
+      : GraphTransformer("RegexFullMatchSetFusion", compatible_execution_providers) {}
+
+  Status ApplyImpl(Graph& graph, bool& modified, int graph_level, const logging::Logger& logger) const override;
+};
+
+}  // namespace onnxruntime
@@ -431,7 +431,7 @@ Status WindowsEnv::MapFileIntoMemory(_In_z_ const ORTCHAR_T* file_path,
   wil::unique_hfile file_mapping_handle{
       CreateFileMappingW(file_handle.get(),
                          nullptr,
-                         PAGE_READONLY,
+                         PAGE_WRITECOPY,
                          0,
                          0,
                          nullptr)};
@@ -446,26 +446,27 @@ Status WindowsEnv::MapFileIntoMemory(_In_z_ const ORTCHAR_T* file_path,
   SYSTEM_INFO sysinfo;
   GetSystemInfo(&sysinfo);
 
-  static const DWORD page_size = sysinfo.dwPageSize;
+  // views must start at a multiple of the allocation granularity, so map from the preceding multiple
   static const DWORD allocation_granularity = sysinfo.dwAllocationGranularity;
-  const FileOffsetType offset_to_page = offset % static_cast<FileOffsetType>(page_size);
+  const FileOffsetType offset_to_page = offset % static_cast<FileOffsetType>(allocation_granularity);
   const size_t mapped_length = length + static_cast<size_t>(offset_to_page);
   const FileOffsetType mapped_offset = offset - offset_to_page;
-  if (mapped_offset % allocation_granularity != 0) {
+
+  // map copy-on-write like MAP_PRIVATE on POSIX, so writes to the memory do not change the file
+  void* const mapped_base = MapViewOfFile(file_mapping_handle.get(),
+                                          FILE_MAP_COPY,
+                                          static_cast<DWORD>((mapped_offset >> 32) & 0xFFFFFFFF),
+                                          static_cast<DWORD>(mapped_offset & 0xFFFFFFFF),
+                                          mapped_length);
+  if (mapped_base == nullptr) {
     const auto error_code = GetLastError();
     return ORT_MAKE_STATUS(ONNXRUNTIME, FAIL,
-                           "mapped offset must be a multiple of the allocation granularity",
-                           " , mapped_offset = ", mapped_offset,
-                           " , allocation_granularity = ", allocation_granularity,
+                           "map view of file ", ToUTF8String(Basename(file_path)),
+                           " fail, mapped_offset = ", mapped_offset,
                            " , errcode = ", error_code,
                            " - ", std::system_category().message(error_code));
   }
 
-  void* const mapped_base = MapViewOfFile(file_mapping_handle.get(),
-                                          FILE_MAP_READ,
-                                          static_cast<DWORD>((mapped_offset >> 32) & 0xFFFFFFFF),
-                                          static_cast<DWORD>(mapped_offset & 0xFFFFFFFF),
-                                          mapped_length);
   GSL_SUPPRESS(r.11)
   mapped_memory =
       MappedMemoryPtr{reinterpret_cast<char*>(mapped_base) + offset_to_page,
@@ -121,23 +121,15 @@ Status CastMap::ComputeImpl(OpKernelContext& context, TTo pad_value) const {
     // sparse map puts pad_value in all entries that aren't present in the input, up to map_max_
     auto cur_input = X.cbegin();
     auto end_input = X.cend();
-    auto out_end = out.end();
-    int64_t cur_idx = 0;
 
     ORT_ENFORCE(cur_input == end_input || cur_input->first >= 0,
                 "Negative index values are not permitted. First entry in map has index value of ", cur_input->first);
 
-    // for each output value, see if we have an input value, if not use the pad value
-    while (out_iter < out_end) {
-      if (cur_input != end_input && cur_input->first == cur_idx) {
-        *out_iter = Cast<TFrom, TTo>(cur_input->second);
-        ++cur_input;
-      } else {
-        *out_iter = pad_value;
-      }
-
-      ++out_iter;
-      ++cur_idx;
+    // keys are unique and sorted, so pad everything once and scatter the
+    // input values until the first key past the end of the output
+    std::fill(out.begin(), out.end(), pad_value);
+    for (; cur_input != end_input && cur_input->first < num_dims; ++cur_input) {
+      out[onnxruntime::narrow<size_t>(cur_input->first)] = Cast<TFrom, TTo>(cur_input->second);
     }
   }
 
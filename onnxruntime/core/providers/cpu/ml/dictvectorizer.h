@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include "core/common/common.h"
+#include "core/common/inlined_containers.h"
 #include "core/framework/op_kernel.h"
 
 namespace onnxruntime {
@@ -16,11 +17,30 @@ class DictVectorizerOp final : public OpKernel {
     // In some stupid models, the vocabulary could have duplicated elements.
     // We must support that, otherwise some tests will be break.
     ORT_ENFORCE(info.GetAttrs(std::is_same<AttrType, std::string>::value ? "string_vocabulary" : "int64_vocabulary", vocabulary_).IsOK());
+    vocabulary_index_.reserve(vocabulary_.size());
+    for (size_t i = 0, end = vocabulary_.size(); i < end; ++i) {
+      vocabulary_index_[vocabulary_[i]].push_back(i);
+    }
   }
   common::Status Compute(OpKernelContext* ctx) const override {
     const auto* map = ctx->Input<std::map<AttrType, TargetType> >(0);
     auto* Y = ctx->Output(0, {1, static_cast<int64_t>(vocabulary_.size())});
     auto* y_data = Y->MutableData<TargetType>();
+    if (map->size() < vocabulary_.size()) {
+      // Typical sparse input: zero the output once and scatter
+      // the input entries through the vocabulary hash index.
+      std::fill_n(y_data, vocabulary_.size(), TargetType());
+      for (const auto& entry : *map) {
+        auto hit = vocabulary_index_.find(entry.first);
+        if (hit != vocabulary_index_.end()) {
+          for (size_t i : hit->second) {
+            y_data[i] = entry.second;
+          }
+        }
+      }
+      return Status::OK();
+    }
+
     for (size_t i = 0, end = vocabulary_.size(); i < end; ++i) {
       auto index = map->find(vocabulary_[i]);
       if (index != map->end()) {
@@ -34,6 +54,8 @@ class DictVectorizerOp final : public OpKernel {
   }
 
   std::vector<AttrType> vocabulary_;
+  // Output positions of every vocabulary entry, more than one if it is duplicated.
+  InlinedHashMap<AttrType, InlinedVector<size_t, 1> > vocabulary_index_;
 };
 
 }  // namespace ml
@@ -2,7 +2,11 @@
 // Licensed under the MIT License.
 
 #include "core/providers/cpu/ml/zipmap.h"
+#include "core/platform/threadpool.h"
 #include "core/util/math_cpuonly.h"
+
+#include <algorithm>
+#include <numeric>
 /**
 https://github.com/onnx/onnx/blob/main/onnx/defs/traditionalml/defs.cc
 ONNX_OPERATOR_SCHEMA(ZipMap)
@@ -28,6 +32,31 @@ using namespace ::onnxruntime::common;
 using namespace std;
 namespace onnxruntime {
 namespace ml {
+
+namespace {
+
+// Returns the label positions sorted by label. When a label is repeated only
+// the last position is kept, as that is the value the map ends up holding.
+template <typename TKey>
+std::vector<size_t> SortLabelIndices(const std::vector<TKey>& classlabels) {
+  std::vector<size_t> indices(classlabels.size());
+  std::iota(indices.begin(), indices.end(), size_t{0});
+  std::stable_sort(indices.begin(), indices.end(),
+                   [&classlabels](size_t a, size_t b) { return classlabels[a] < classlabels[b]; });
+
+  std::vector<size_t> unique_indices;
+  unique_indices.reserve(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    if (i + 1 < indices.size() && !(classlabels[indices[i]] < classlabels[indices[i + 1]])) {
+      continue;
+    }
+    unique_indices.push_back(indices[i]);
+  }
+  return unique_indices;
+}
+
+}  // namespace
+
 ONNX_CPU_OPERATOR_ML_KERNEL(
     ZipMap,
     1,
@@ -42,6 +71,44 @@ ZipMapOp::ZipMapOp(const OpKernelInfo& info)
   ORT_ENFORCE(classlabels_strings_.empty() ^ classlabels_int64s_.empty(),
               "Must provide classlabels_strings or classlabels_int64s but not both.");
   using_strings_ = !classlabels_strings_.empty();
+  sorted_label_indices_ = using_strings_ ? SortLabelIndices(classlabels_strings_)
+                                         : SortLabelIndices(classlabels_int64s_);
+}
+
+template <typename TKey>
+common::Status ZipMapOp::ComputeImpl(OpKernelContext* context, const std::vector<TKey>& classlabels,
+                                     int64_t batch_size, int64_t features_per_batch) const {
+  if (features_per_batch != static_cast<int64_t>(classlabels.size())) {
+    return Status(ONNXRUNTIME,
+                  INVALID_ARGUMENT,
+                  "Input features_per_batch[" + std::to_string(features_per_batch) +
+                      "] != number of classlabels[" + std::to_string(classlabels.size()) + "]");
+  }
+  auto* y_data = context->Output<std::vector<std::map<TKey, float>>>(0);
+  if (y_data == nullptr) return Status(common::ONNXRUNTIME, common::FAIL, "input count mismatch");
+
+  const auto* x_data = context->Input<Tensor>(0)->Data<float>();
+  y_data->resize(onnxruntime::narrow<size_t>(batch_size));
+
+  // Every row is an independent map, so rows are built in parallel.
+  const size_t features = onnxruntime::narrow<size_t>(features_per_batch);
+  concurrency::ThreadPool::TryParallelFor(
+      context->GetOperatorThreadPool(), static_cast<std::ptrdiff_t>(batch_size),
+      TensorOpCost{static_cast<double>(features * sizeof(float)),
+                   static_cast<double>(features * sizeof(typename std::map<TKey, float>::value_type)),
+                   static_cast<double>(features * 64)},
+      [this, &classlabels, x_data, y_data, features](std::ptrdiff_t first, std::ptrdiff_t last) {
+        for (std::ptrdiff_t n = first; n < last; ++n) {
+          const float* row = x_data + static_cast<size_t>(n) * features;
+          std::map<TKey, float> row_map;
+          for (size_t j : sorted_label_indices_) {
+            row_map.emplace_hint(row_map.end(), classlabels[j], row[j]);
+          }
+          (*y_data)[static_cast<size_t>(n)] = std::move(row_map);
+        }
+      });
+
+  return common::Status::OK();
 }
 
 common::Status ZipMapOp::Compute(OpKernelContext* context) const {
@@ -65,51 +132,10 @@ common::Status ZipMapOp::Compute(OpKernelContext* context) const {
                   "Zipmap only supports 1D or 2D input tensors");
   }
 
-  const auto* x_data = X.Data<float>();
-
   if (using_strings_) {
-    if (features_per_batch != static_cast<int64_t>(classlabels_strings_.size())) {
-      return Status(ONNXRUNTIME,
-                    INVALID_ARGUMENT,
-                    "Input features_per_batch[" + std::to_string(features_per_batch) +
-                        "] != number of classlabels[" + std::to_string(classlabels_strings_.size()) + "]");
-    }
-    auto* y_data = context->Output<std::vector<std::map<std::string, float>>>(0);
-    if (y_data == nullptr) return Status(common::ONNXRUNTIME, common::FAIL, "input count mismatch");
-
-    // auto* y_data = Y->MutableData<std::vector<std::map<std::string, float>>>();
-    y_data->resize(onnxruntime::narrow<size_t>(batch_size));
-    int64_t current_weight_0 = 0;
-    for (int64_t n = 0; n < batch_size; n++) {
-      std::map<std::string, float> map1;
-      for (int64_t j = 0; j < features_per_batch; j++) {
-        map1[classlabels_strings_[onnxruntime::narrow<size_t>(j)]] = x_data[current_weight_0 + j];
-      }
-      current_weight_0 += features_per_batch;
-      (*y_data)[onnxruntime::narrow<size_t>(n)] = std::move(map1);
-    }
-  } else {
-    if (features_per_batch != static_cast<int64_t>(classlabels_int64s_.size())) {
-      return Status(ONNXRUNTIME,
-                    INVALID_ARGUMENT,
-                    "Input features_per_batch[" + std::to_string(features_per_batch) +
-                        "] != number of classlabels[" + std::to_string(classlabels_int64s_.size()) + "]");
-    }
-    auto* y_data = context->Output<std::vector<std::map<std::int64_t, float>>>(0);
-    if (y_data == nullptr) return Status(common::ONNXRUNTIME, common::FAIL, "input count mismatch");
-    // auto* y_data = Y->MutableData<std::vector<std::map<int64_t, float>>>();
-    y_data->resize(onnxruntime::narrow<size_t>(batch_size));
-    int64_t current_weight_0 = 0;
-    for (int n = 0; n < batch_size; n++) {
-      std::map<int64_t, float> map2;
-      for (int j = 0; j < features_per_batch; j++) {
-        map2[classlabels_int64s_[j]] = x_data[current_weight_0 + j];
-      }
-      current_weight_0 += features_per_batch;
-      (*y_data)[n] = std::move(map2);
-    }
+    return ComputeImpl(context, classlabels_strings_, batch_size, features_per_batch);
   }
-  return common::Status::OK();
+  return ComputeImpl(context, classlabels_int64s_, batch_size, features_per_batch);
 }
 }  // namespace ml
 }  // namespace onnxruntime
@@ -7,15 +7,26 @@
 namespace onnxruntime {
 namespace ml {
 
+// The output is a std::vector of std::map, the type registered for seq(map(string, float)) and
+// seq(map(int64, float)), so downstream kernels and the C, C++ and Python APIs consume it unchanged.
+// There is no columnar output (shared keys plus a contiguous values buffer). That would need its own
+// OrtValue type and accessors in each API.
 class ZipMapOp final : public OpKernel {
  public:
   explicit ZipMapOp(const OpKernelInfo& info);
   common::Status Compute(OpKernelContext* context) const override;
 
  private:
+  template <typename TKey>
+  common::Status ComputeImpl(OpKernelContext* context, const std::vector<TKey>& classlabels,
+                             int64_t batch_size, int64_t features_per_batch) const;
+
   bool using_strings_;
   std::vector<int64_t> classlabels_int64s_;
   std::vector<std::string> classlabels_strings_;
+  // Feature indices ordered by class label, one per distinct label.
+  // The maps are filled in key order so each insertion is amortized O(1).
+  std::vector<size_t> sorted_label_indices_;
 };
 
 }  // namespace ml
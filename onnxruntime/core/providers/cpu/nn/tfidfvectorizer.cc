@@ -9,6 +9,7 @@
 #include "core/platform/threadpool.h"
 
 #include <functional>
+#include <limits>
 #include <string_view>
 
 namespace onnxruntime {
@@ -25,66 +26,118 @@ ONNX_CPU_OPERATOR_KERNEL(
 
 namespace ngram_details {
 
-// NgrampPart implements a Trie like structure
-// for a unigram (1) it would insert into a root map with a valid id.
-// for (1,2,3) node 2 would be a child of 1 but have id == 0
+// NgramTable implements a Trie like structure stored in a single flat
+// open-addressed hash table. Every trie node is identified by its index
+// in nodes_, the root being 0. The child of a node for a given item is found
+// by hashing the (parent node, item) pair, so extending an n-gram by one item
+// is a single probe into contiguous memory regardless of n.
+// For a unigram (1) the node hangs off the root with a valid id.
+// For (1,2,3) node 2 would be a child of 1 but have id == 0
 // because (1,2) does not exists. Node 3 would have a valid id.
-template <class T>
-struct NgramPart;
-
-template <>
-struct NgramPart<int64_t>;
-
-template <>
-struct NgramPart<std::string>;
-
-using NgramPartInt = NgramPart<int64_t>;
-using NgramPartString = NgramPart<std::string>;
-
-// Avoid recursive class definitions using unique_ptr + forward declaration
-using IntMap = InlinedHashMap<int64_t, std::unique_ptr<NgramPartInt>>;
-
-#ifndef DISABLE_ABSEIL
-using StrMap = absl::flat_hash_map<std::reference_wrapper<const std::string>, std::unique_ptr<NgramPartString>,
-                                   std::hash<std::string>, std::equal_to<std::string>>;
-#else
-using StrMap = std::unordered_map<std::reference_wrapper<const std::string>, std::unique_ptr<NgramPartString>,
-                                  std::hash<std::string>, std::equal_to<std::string>>;
-#endif
-
-template <>
-struct NgramPart<int64_t> {
-  size_t id_;  // 0 - means no entry, search for a bigger N
-  IntMap leafs_;
-  explicit NgramPart(size_t id) : id_(id) {}
-};
+class NgramTable {
+ public:
+  static constexpr uint32_t kRoot = 0;
+  static constexpr uint32_t kNotFound = std::numeric_limits<uint32_t>::max();
+
+  NgramTable() : nodes_(1) {}
+
+  bool empty() const noexcept { return nodes_.size() == 1; }
+
+  bool HasChildren(uint32_t node) const noexcept { return nodes_[node].num_children != 0; }
+
+  // 0 - means no entry, search for a bigger N
+  size_t NgramId(uint32_t node) const noexcept { return nodes_[node].ngram_id; }
+  size_t& NgramId(uint32_t node) noexcept { return nodes_[node].ngram_id; }
+
+  // Returns the child of parent for item, kNotFound if there is none.
+  uint32_t Find(uint32_t parent, int64_t item) const noexcept {
+    if (slots_.empty()) {
+      return kNotFound;
+    }
+    for (size_t pos = Hash(parent, item) & mask_;; pos = (pos + 1) & mask_) {
+      const Slot& slot = slots_[pos];
+      if (slot.node == kNotFound) {
+        return kNotFound;
+      }
+      if (slot.parent == parent && slot.item == item) {
+        return slot.node;
+      }
+    }
+  }
+
+  // Returns the child of parent for item, creating it if needed.
+  uint32_t Insert(uint32_t parent, int64_t item) {
+    // Keep the load factor at or below 1/2 so probe sequences stay short.
+    if ((nodes_.size() + 1) * 2 > slots_.size()) {
+      Rehash(std::max<size_t>(16, slots_.size() * 2));
+    }
+    size_t pos = Hash(parent, item) & mask_;
+    for (; slots_[pos].node != kNotFound; pos = (pos + 1) & mask_) {
+      if (slots_[pos].parent == parent && slots_[pos].item == item) {
+        return slots_[pos].node;
+      }
+    }
+    ORT_ENFORCE(nodes_.size() < kNotFound, "Too many n-gram entries");
+    const auto node = static_cast<uint32_t>(nodes_.size());
+    slots_[pos] = Slot{item, parent, node};
+    nodes_.push_back(Node{});
+    ++nodes_[parent].num_children;
+    return node;
+  }
+
+ private:
+  struct Slot {
+    int64_t item;
+    uint32_t parent;
+    uint32_t node;  // kNotFound - means empty slot
+  };
+
+  struct Node {
+    size_t ngram_id = 0;
+    uint32_t num_children = 0;
+  };
+
+  static size_t Hash(uint32_t parent, int64_t item) noexcept {
+    // splitmix64 finalizer over the combined key
+    uint64_t h = static_cast<uint64_t>(item) ^ (uint64_t{parent} * 0x9E3779B97F4A7C15ULL);
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return static_cast<size_t>(h ^ (h >> 31));
+  }
+
+  void Rehash(size_t new_size) {
+    std::vector<Slot> old_slots(new_size, Slot{0, 0, kNotFound});
+    old_slots.swap(slots_);
+    mask_ = new_size - 1;
+    for (const Slot& slot : old_slots) {
+      if (slot.node != kNotFound) {
+        size_t pos = Hash(slot.parent, slot.item) & mask_;
+        while (slots_[pos].node != kNotFound) {
+          pos = (pos + 1) & mask_;
+        }
+        slots_[pos] = slot;
+      }
+    }
+  }
 
-template <>
-struct NgramPart<std::string> {
-  size_t id_;  // 0 - means no entry, search for a bigger N
-  StrMap leafs_;
-  explicit NgramPart(size_t id) : id_(id) {}
+  std::vector<Slot> slots_;
+  size_t mask_ = 0;
+  std::vector<Node> nodes_;
 };
 
 // Returns next ngram_id
-template <class K, class ForwardIter, class Map>
+template <class ForwardIter>
 inline size_t PopulateGrams(ForwardIter first, size_t ngrams, size_t ngram_size, size_t ngram_id,
-                            Map& c) {
+                            NgramTable& table) {
   for (; ngrams > 0; --ngrams) {
-    size_t n = 1;
-    Map* m = &c;
-    while (true) {
-      auto p = m->emplace(*first, std::make_unique<NgramPart<K>>(0));
-      ++first;
-      if (n == ngram_size) {
-        ORT_ENFORCE(p.first->second->id_ == 0, "Duplicate ngram detected, size: ", ngram_size, " id: ", ngram_id);
-        p.first->second->id_ = ngram_id;
-        ++ngram_id;
-        break;
-      }
-      ++n;
-      m = &p.first->second->leafs_;
+    uint32_t node = NgramTable::kRoot;
+    for (size_t n = 1; n <= ngram_size; ++n, ++first) {
+      node = table.Insert(node, *first);
     }
+    auto& id = table.NgramId(node);
+    ORT_ENFORCE(id == 0, "Duplicate ngram detected, size: ", ngram_size, " id: ", ngram_id);
+    id = ngram_id;
+    ++ngram_id;
   }
   return ngram_id;
 }
@@ -96,10 +149,6 @@ using namespace onnxruntime::ngram_details;
 
 namespace onnxruntime {
 
-inline const void* AdvanceElementPtr(const void* p, size_t elements, size_t element_size) {
-  return reinterpret_cast<const uint8_t*>(p) + elements * element_size;
-}
-
 // The weighting criteria.
 // "TF"(term frequency),
 //    the counts are propagated to output
@@ -134,11 +183,12 @@ struct TfIdfVectorizer::Impl {
   gsl::span<const int64_t> ngram_indexes_;
   gsl::span<const float> weights_;
 
-  // This map contains references to pool_string_ entries
-  // of pool_strings attribute
-  StrMap str_map_;
-  // This map contains pool_int64s entries
-  IntMap int64_map_;
+  // n-grams of either pool_int64s or the ids of pool_strings entries
+  NgramTable ngram_table_;
+  bool pool_is_string_ = false;
+  // Maps the distinct pool_strings entries to the item ids used in ngram_table_.
+  // Keys reference the strings of the pool_strings attribute.
+  InlinedHashMap<std::string_view, int64_t> str_ids_;
 
   size_t output_size_ = 0;
 
@@ -221,6 +271,18 @@ TfIdfVectorizer::TfIdfVectorizer(const OpKernelInfo& info) : OpKernel(info), imp
     ORT_ENFORCE(status.IsOK() && !pool_int64s.empty(), "non-empty pool_int64s is required if pool_strings not provided");
   }
 
+  // Strings are interned once so the n-gram table only deals with integer items.
+  std::vector<int64_t> pool_string_ids;
+  if (!pool_strings.empty()) {
+    impl_->pool_is_string_ = true;
+    impl_->str_ids_.reserve(pool_strings.size());
+    pool_string_ids.reserve(pool_strings.size());
+    for (const std::string& str : pool_strings) {
+      auto p = impl_->str_ids_.emplace(str, static_cast<int64_t>(impl_->str_ids_.size()));
+      pool_string_ids.push_back(p.first->second);
+    }
+  }
+
   // Iterator via the pool. Insert 1 item for 1-grams, 2 items for 2-grams, etc.
   const auto total_items = (pool_strings.empty()) ? pool_int64s.size() : pool_strings.size();
   size_t ngram_id = 1;  // start with 1, 0 - means no n-gram
@@ -241,9 +303,9 @@ TfIdfVectorizer::TfIdfVectorizer(const OpKernelInfo& info) : OpKernel(info), imp
       // Skip loading into hash_set ngrams that are not in the range of [min_gram_length-max_gram_length]
       if (ngram_size >= min_gram_length && ngram_size <= max_gram_length) {
         if (pool_strings.empty()) {
-          ngram_id = PopulateGrams<int64_t>(pool_int64s.begin() + start_idx, ngrams, ngram_size, ngram_id, impl_->int64_map_);
+          ngram_id = PopulateGrams(pool_int64s.begin() + start_idx, ngrams, ngram_size, ngram_id, impl_->ngram_table_);
         } else {
-          ngram_id = PopulateGrams<std::string>(pool_strings.begin() + start_idx, ngrams, ngram_size, ngram_id, impl_->str_map_);
+          ngram_id = PopulateGrams(pool_string_ids.begin() + start_idx, ngrams, ngram_size, ngram_id, impl_->ngram_table_);
         }
       } else {
         ngram_id += ngrams;
@@ -255,69 +317,38 @@ TfIdfVectorizer::TfIdfVectorizer(const OpKernelInfo& info) : OpKernel(info), imp
 
 TfIdfVectorizer::~TfIdfVectorizer() = default;
 
-void TfIdfVectorizer::ComputeImpl(const void* x_data_raw, size_t elem_size, ptrdiff_t row_num, size_t row_size,
-                                  bool is_input_string, gsl::span<float> output_data,
-                                  std::function<void(size_t, gsl::span<float>&)>& fn_weight) const {
-  const void* const row_begin = AdvanceElementPtr(x_data_raw, row_num * row_size, elem_size);
-  const void* const row_end = AdvanceElementPtr(row_begin, row_size, elem_size);
-
+template <typename T>
+void TfIdfVectorizer::ComputeImpl(gsl::span<const T> row, gsl::span<float> output_data) const {
   const auto& impl = *impl_;
-  const auto max_gram_length = impl.max_gram_length_;
-  const auto max_skip_distance = impl.max_skip_count_ + 1;  // Convert to distance
-  auto start_ngram_size = impl.min_gram_length_;
-  size_t output_idx;
-
-  for (auto skip_distance = 1; skip_distance <= max_skip_distance; ++skip_distance) {
-    auto ngram_start = row_begin;
-    auto const ngram_row_end = row_end;
-
-    while (ngram_start < ngram_row_end) {
+  const auto& table = impl.ngram_table_;
+  const size_t row_size = row.size();
+  const auto max_gram_length = onnxruntime::narrow<size_t>(impl.max_gram_length_);
+  const auto max_skip_distance = onnxruntime::narrow<size_t>(impl.max_skip_count_) + 1;  // Convert to distance
+  auto start_ngram_size = onnxruntime::narrow<size_t>(impl.min_gram_length_);
+
+  for (size_t skip_distance = 1; skip_distance <= max_skip_distance; ++skip_distance) {
+    for (size_t ngram_start = 0; ngram_start < row_size; ++ngram_start) {
       // We went far enough so no n-grams of any size can be gathered
-      auto at_least_this = AdvanceElementPtr(ngram_start, SafeInt<size_t>(skip_distance) * (start_ngram_size - 1), elem_size);
-      if (at_least_this >= ngram_row_end) {
+      if (ngram_start + SafeInt<size_t>(skip_distance) * (start_ngram_size - 1) >= row_size) {
         break;
       }
 
-      auto ngram_item = ngram_start;
-      if (is_input_string) {
-        const std::string* str_item = reinterpret_cast<const std::string*>(ngram_item);
-        const StrMap* str_map = &impl.str_map_;
-        for (auto ngram_size = 1;
-             !str_map->empty() &&
-             ngram_size <= max_gram_length &&
-             str_item < ngram_row_end;
-             ++ngram_size, str_item += skip_distance) {
-          auto hit = str_map->find(*str_item);
-          if (hit == str_map->end()) {
-            break;
-          }
-          if (ngram_size >= start_ngram_size && hit->second->id_ != 0) {
-            output_idx = impl.OutputIdToIncrement(hit->second->id_);
-            fn_weight(output_idx, output_data);
-          }
-          str_map = &hit->second->leafs_;
+      // Each step extends the n-gram found so far by one item
+      uint32_t node = NgramTable::kRoot;
+      for (size_t ngram_size = 1, pos = ngram_start;
+           table.HasChildren(node) &&
+           ngram_size <= max_gram_length &&
+           pos < row_size;
+           ++ngram_size, pos += skip_distance) {
+        node = table.Find(node, static_cast<int64_t>(row[pos]));
+        if (node == NgramTable::kNotFound) {
+          break;
         }
-      } else {
-        const IntMap* int_map = &impl.int64_map_;
-        for (auto ngram_size = 1;
-             !int_map->empty() &&
-             ngram_size <= max_gram_length &&
-             ngram_item < ngram_row_end;
-             ++ngram_size, ngram_item = AdvanceElementPtr(ngram_item, skip_distance, elem_size)) {
-          int64_t val = (elem_size == 4) ? int64_t{*reinterpret_cast<const int32_t*>(ngram_item)} : *reinterpret_cast<const int64_t*>(ngram_item);
-          auto hit = int_map->find(val);
-          if (hit == int_map->end()) {
-            break;
-          }
-          if (ngram_size >= start_ngram_size && hit->second->id_ != 0) {
-            output_idx = impl.OutputIdToIncrement(hit->second->id_);
-            fn_weight(output_idx, output_data);
-          }
-          int_map = &hit->second->leafs_;
+        const size_t ngram_id = table.NgramId(node);
+        if (ngram_size >= start_ngram_size && ngram_id != 0) {
+          output_data[impl.OutputIdToIncrement(ngram_id)] += 1.0f;
         }
       }
-      // Sliding window shift
-      ngram_start = AdvanceElementPtr(ngram_start, 1, elem_size);
     }
     // We count UniGrams only once since they are not affected
     // by skip distance
@@ -327,6 +358,37 @@ void TfIdfVectorizer::ComputeImpl(const void* x_data_raw, size_t elem_size, ptrd
   }
 }
 
+void TfIdfVectorizer::ApplyWeights(gsl::span<float> output_data) const {
+  const auto& w = impl_->weights_;
+  float* out = output_data.data();
+  const size_t size = output_data.size();
+  // Output entries past the end of weights are treated as unweighted
+  const size_t weighted = std::min(size, w.size());
+  const float* weights = w.data();
+
+  switch (impl_->weighting_criteria_) {
+    case kTF:
+      // The counts are the output
+      break;
+    case kIDF:
+      for (size_t i = 0; i < weighted; ++i) {
+        out[i] = out[i] > 0.0f ? weights[i] : 0.0f;
+      }
+      for (size_t i = weighted; i < size; ++i) {
+        out[i] = out[i] > 0.0f ? 1.0f : 0.0f;
+      }
+      break;
+    case kTFIDF:
+      for (size_t i = 0; i < weighted; ++i) {
+        out[i] *= weights[i];
+      }
+      break;
+    case kNone:  // fall-through
+    default:
+      assert(false);
+  }
+}
+
 Status TfIdfVectorizer::Compute(OpKernelContext* ctx) const {
   auto X = ctx->Input<Tensor>(0);
   auto& input_shape = X->Shape();
@@ -373,8 +435,8 @@ Status TfIdfVectorizer::Compute(OpKernelContext* ctx) const {
   const bool is_input_string = X->IsDataTypeString();
 
   if (total_items == 0 ||
-      (is_input_string && impl_->str_map_.empty()) ||
-      ((X->IsDataType<int32_t>() || X->IsDataType<int64_t>()) && impl_->int64_map_.empty())) {
+      impl_->ngram_table_.empty() ||
+      is_input_string != impl_->pool_is_string_) {
     // TfidfVectorizer may receive an empty input when it follows a Tokenizer
     // (for example for a string containing only stopwords).
     // TfidfVectorizer returns a zero tensor of shape
@@ -384,44 +446,38 @@ Status TfIdfVectorizer::Compute(OpKernelContext* ctx) const {
     return Status::OK();
   }
 
-  auto x_data_raw = ctx->Input<Tensor>(0)->DataRaw();
-  const auto elem_size = X->DataType()->Size();
   int32_t num_batches = std::min<int32_t>(concurrency::ThreadPool::DegreeOfParallelism(ctx->GetOperatorThreadPool()) * 2, num_rows);
+  const size_t output_size = impl.output_size_;
+
+  std::function<void(ptrdiff_t)> fn = [this, X, C, output_data, output_size,
+                                       is_input_string, num_batches, num_rows](ptrdiff_t batch_num) {
+    // Item ids of a row of strings, reused across the rows of this batch
+    InlinedVector<int64_t> row_ids;
+    if (is_input_string) {
+      row_ids.resize(C);
+    }
 
-  const auto& w = impl.weights_;
-  std::function<void(size_t, gsl::span<float>&)> fn_weight;
-
-  switch (impl.weighting_criteria_) {
-    case kTF:
-      fn_weight = [](size_t i, gsl::span<float>& out) { out[i] += 1.0f; };
-      break;
-    case kIDF:
-      if (!w.empty()) {
-        fn_weight = [&w](size_t i, gsl::span<float>& out) { out[i] = w[i]; };
-      } else {
-        fn_weight = [](size_t i, gsl::span<float>& out) { out[i] = 1.0f; };
-      }
-      break;
-    case kTFIDF:
-      if (!w.empty()) {
-        fn_weight = [&w](size_t i, gsl::span<float>& out) { out[i] += w[i]; };
-      } else {
-        fn_weight = [](size_t i, gsl::span<float>& out) { out[i] += 1.0f; };
-      }
-      break;
-    case kNone:  // fall-through
-    default:
-      assert(false);
-  }
-
-  std::function<void(ptrdiff_t)> fn = [this, C, output_data, x_data_raw, elem_size,
-                                       is_input_string, num_batches, num_rows, &fn_weight](ptrdiff_t batch_num) {
-    // Frequency holder allocate [B..output_size_] and init all to zero.
     auto work = concurrency::ThreadPool::PartitionWork(batch_num, num_batches, static_cast<size_t>(num_rows));
     for (auto row_num = work.start; row_num < work.end; ++row_num) {
-      auto out = gsl::span<float>(output_data + row_num * this->impl_->output_size_, this->impl_->output_size_);
+      // Frequency holder allocate [B..output_size_] and init all to zero.
+      auto out = gsl::span<float>(output_data + row_num * output_size, output_size);
       std::fill(out.begin(), out.end(), 0.0f);
-      ComputeImpl(x_data_raw, elem_size, row_num, C, is_input_string, out, fn_weight);
+      const size_t row_offset = SafeInt<size_t>(row_num) * C;
+      if (is_input_string) {
+        const auto& str_ids = this->impl_->str_ids_;
+        const auto row = X->DataAsSpan<std::string>().subspan(row_offset, C);
+        for (size_t i = 0; i < C; ++i) {
+          auto hit = str_ids.find(std::string_view(row[i]));
+          // -1 never matches an interned id and ends any n-gram going through it
+          row_ids[i] = (hit == str_ids.end()) ? -1 : hit->second;
+        }
+        ComputeImpl(gsl::span<const int64_t>(row_ids.data(), C), out);
+      } else if (X->IsDataType<int32_t>()) {
+        ComputeImpl(X->DataAsSpan<int32_t>().subspan(row_offset, C), out);
+      } else {
+        ComputeImpl(X->DataAsSpan<int64_t>().subspan(row_offset, C), out);
+      }
+      ApplyWeights(out);
     }
   };
 
@@ -19,8 +19,12 @@ class TfIdfVectorizer final : public OpKernel {
   Status Compute(OpKernelContext* ctx) const override;
 
  private:
-  void ComputeImpl(const void* x_data_raw, size_t elem_size, ptrdiff_t row_num, size_t row_size, bool is_input_string,
-                   gsl::span<float> output_data, std::function<void(size_t, gsl::span<float>&)>& fn_weight) const;
+  // Counts n-gram occurrences of a single row of item ids into output_data.
+  template <typename T>
+  void ComputeImpl(gsl::span<const T> row, gsl::span<float> output_data) const;
+
+  // Converts the counts of a single row according to the weighting criteria.
+  void ApplyWeights(gsl::span<float> output_data) const;
 
   struct Impl;
   std::unique_ptr<Impl> impl_;
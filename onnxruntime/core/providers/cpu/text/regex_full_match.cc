@@ -3,6 +3,7 @@
 
 #include "regex_full_match.h"
 #include "core/common/common.h"
+#include "core/platform/threadpool.h"
 
 namespace onnxruntime {
 ONNX_CPU_OPERATOR_KERNEL(
@@ -13,7 +14,21 @@ ONNX_CPU_OPERATOR_KERNEL(
         .TypeConstraint("T2", DataTypeImpl::GetTensorType<bool>()),
     RegexFullMatch);
 
-RegexFullMatch::RegexFullMatch(const OpKernelInfo& info) : OpKernel(info), re_{info.GetAttr<std::string>("pattern")} {
+namespace regex_full_match {
+
+// Prefix length used for the match range. Longer prefixes reject more strings but cost more per comparison.
+constexpr int kMatchRangeMaxLength = 16;
+
+MatchRangeFilter::MatchRangeFilter(const RE2& re) {
+  if (re.ok()) {
+    enabled_ = re.PossibleMatchRange(&min_, &max_, kMatchRangeMaxLength);
+  }
+}
+
+}  // namespace regex_full_match
+
+RegexFullMatch::RegexFullMatch(const OpKernelInfo& info)
+    : OpKernel(info), re_{info.GetAttr<std::string>("pattern")}, filter_{re_} {
   ORT_ENFORCE(re_.ok(), "Invalid regex pattern: ", re_.pattern());
 }
 
@@ -22,13 +37,17 @@ Status RegexFullMatch::Compute(OpKernelContext* context) const {
   const auto input_data = input_tensor->template DataAsSpan<std::string>();
   auto* output_tensor = context->Output(0, input_tensor->Shape());
   auto output_data = output_tensor->template MutableDataAsSpan<bool>();
-  auto output_iter = output_data.begin();
-  auto input_iter = input_data.begin();
-  while (input_iter != input_data.end()) {
-    *output_iter = RE2::FullMatch(*input_iter, re_);
-    input_iter++;
-    output_iter++;
-  }
+
+  concurrency::ThreadPool::TryParallelFor(
+      context->GetOperatorThreadPool(), static_cast<std::ptrdiff_t>(input_data.size()),
+      TensorOpCost{static_cast<double>(sizeof(std::string)), 1.0, regex_full_match::kMatchCostCycles},
+      [&](std::ptrdiff_t first, std::ptrdiff_t last) {
+        for (auto i = static_cast<size_t>(first), end = static_cast<size_t>(last); i < end; ++i) {
+          const std::string& s = input_data[i];
+          output_data[i] = filter_.MayMatch(s) && RE2::FullMatch(s, re_);
+        }
+      });
+
   return Status::OK();
 }
 
@@ -3,11 +3,40 @@
 
 #pragma once
 
+#include <string>
+#include <string_view>
+
 #include "core/framework/op_kernel.h"
 #include "re2/re2.h"
 
 namespace onnxruntime {
 
+namespace regex_full_match {
+
+// Rough cost of one RE2 full match in cycles, used to size the parallel batches.
+constexpr double kMatchCostCycles = 256.0;
+
+/**
+ * Byte range [min, max] that every string fully matching a pattern lies in, from RE2::PossibleMatchRange.
+ * Strings outside the range are rejected with two comparisons instead of running the regex.
+ * Patterns without a useful range (e.g. ones starting with .*) accept every string.
+ */
+class MatchRangeFilter {
+ public:
+  explicit MatchRangeFilter(const RE2& re);
+
+  bool MayMatch(std::string_view s) const {
+    return !enabled_ || (s >= min_ && s <= max_);
+  }
+
+ private:
+  bool enabled_{false};
+  std::string min_;
+  std::string max_;
+};
+
+}  // namespace regex_full_match
+
 class RegexFullMatch final : public OpKernel {
  public:
   explicit RegexFullMatch(const OpKernelInfo& info);
@@ -15,6 +44,7 @@ class RegexFullMatch final : public OpKernel {
 
  private:
   RE2 re_;
+  regex_full_match::MatchRangeFilter filter_;
 };
 
 }  // namespace onnxruntime
@@ -4,6 +4,7 @@
 #include "string_normalizer.h"
 #include "core/common/common.h"
 #include "core/framework/tensor.h"
+#include "core/platform/threadpool.h"
 // Used below HAS_DEPRECATED_DECLARATIONS
 #include "onnxruntime_config.h"
 
@@ -12,7 +13,9 @@
 #include <locale.h>
 #endif  // _MSC_VER
 
+#include <cctype>
 #include <codecvt>
+#include <cstring>
 #include <locale>
 #include <functional>
 
@@ -436,6 +439,113 @@ const std::string default_locale("en_US.UTF-8");  // All non-MS and not Apple
 #endif
 
 #endif  // _MSC_VER
+
+// Below this number of input strings the work is done on the calling thread.
+constexpr std::ptrdiff_t kMinStringsPerBatch = 256;
+
+// Checks eight bytes at a time whether any of them has the high bit set.
+inline bool IsAscii(const std::string& s) {
+  constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+  const char* p = s.data();
+  const size_t len = s.length();
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+    uint64_t chunk;
+    std::memcpy(&chunk, p + i, sizeof(chunk));
+    if ((chunk & kHighBits) != 0) {
+      return false;
+    }
+  }
+  for (; i < len; ++i) {
+    if ((static_cast<unsigned char>(p[i]) & 0x80) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Branchless ASCII case change so the compiler can vectorize the loop.
+inline void AsciiChangeCase(StringNormalizer::CaseAction caseaction,
+                            const std::string& src, std::string& dest) {
+  assert(caseaction != StringNormalizer::NONE);
+  const unsigned char first = (caseaction == StringNormalizer::LOWER) ? 'A' : 'a';
+  dest.resize(src.length());
+  const auto* s = reinterpret_cast<const unsigned char*>(src.data());
+  auto* d = reinterpret_cast<unsigned char*>(dest.data());
+  for (size_t i = 0, lim = src.length(); i < lim; ++i) {
+    const unsigned char ch = s[i];
+    d[i] = static_cast<unsigned char>(ch ^ ((static_cast<unsigned char>(ch - first) < 26) << 5));
+  }
+}
+
+// Turkic locales map 'I' and 'i' outside of ASCII.
+inline bool LocaleHasAsciiCaseMapping(const std::string& locale_name) {
+  if (locale_name.length() < 2) {
+    return true;
+  }
+  const auto lang0 = static_cast<char>(std::tolower(static_cast<unsigned char>(locale_name[0])));
+  const auto lang1 = static_cast<char>(std::tolower(static_cast<unsigned char>(locale_name[1])));
+  const bool lang_only = locale_name.length() == 2 || !std::isalpha(static_cast<unsigned char>(locale_name[2]));
+  const bool turkic = lang_only && ((lang0 == 't' && lang1 == 'r') || (lang0 == 'a' && lang1 == 'z'));
+  return !turkic;
+}
+
+// Changes case of UTF-8 strings. ASCII strings are handled in place on bytes,
+// everything else goes through wchar_t and the locale.
+// Not thread-safe, create one instance per thread.
+class CaseChanger {
+ public:
+  CaseChanger(const Locale* locale, bool ascii_case_mapping)
+      : locale_(locale), ascii_case_mapping_(ascii_case_mapping) {}
+
+  Status ChangeCase(StringNormalizer::CaseAction caseaction, const std::string& src, std::string& dest) {
+    if (ascii_case_mapping_ && IsAscii(src)) {
+      AsciiChangeCase(caseaction, src, dest);
+      return Status::OK();
+    }
+
+    ORT_RETURN_IF(locale_ == nullptr, "Locale is required for non-ASCII case change");
+    size_t wchars = 0;
+    // Checks for invalid UTF-8 characters on Windows
+    ORT_RETURN_IF_ERROR(converter_.ComputeRequiredSizeToWideChar(src, wchars));
+    wchar_buffer_.resize(wchars);
+    ORT_RETURN_IF_ERROR(converter_.ConvertToWideChar(src, wchar_buffer_));
+    locale_->ChangeCase(caseaction, wchar_buffer_);
+
+    dest.resize(converter_.ComputeRequiredSizeToUtf8(wchar_buffer_));
+    return converter_.ConvertToUtf8(wchar_buffer_, dest);
+  }
+
+ private:
+  const Locale* locale_;
+  bool ascii_case_mapping_;
+  Utf8Converter converter_;
+  // Reused across calls
+  std::wstring wchar_buffer_;
+};
+
+// Runs fn(begin, end) over batches of [0, total) and returns the first failure, if any.
+template <typename F>
+Status ParallelForBatches(concurrency::ThreadPool* tp, std::ptrdiff_t total, F&& fn) {
+  const std::ptrdiff_t num_batches =
+      std::max<std::ptrdiff_t>(1, std::min<std::ptrdiff_t>(concurrency::ThreadPool::DegreeOfParallelism(tp),
+                                                           total / kMinStringsPerBatch));
+  if (num_batches == 1) {
+    return fn(std::ptrdiff_t{0}, total);
+  }
+
+  InlinedVector<Status> statuses(narrow<size_t>(num_batches));
+  concurrency::ThreadPool::TrySimpleParallelFor(tp, num_batches, [&](std::ptrdiff_t batch) {
+    auto work = concurrency::ThreadPool::PartitionWork(batch, num_batches, total);
+    statuses[narrow<size_t>(batch)] = fn(work.start, work.end);
+  });
+
+  for (auto& status : statuses) {
+    ORT_RETURN_IF_ERROR(status);
+  }
+  return Status::OK();
+}
+
 }  // namespace string_normalizer
 
 using namespace string_normalizer;
@@ -460,25 +570,30 @@ StringNormalizer::StringNormalizer(const OpKernelInfo& info) : OpKernel(info) {
   }
 
   locale_name_ = info.GetAttrOrDefault("locale", default_locale);
+  ascii_case_mapping_ = LocaleHasAsciiCaseMapping(locale_name_);
 
   std::vector<std::string> stop_words = info.GetAttrsOrDefault<std::string>("stopwords");
+  if (case_change_action_ != NONE || (!is_case_sensitive_ && !stop_words.empty())) {
+    locale_ = std::make_unique<Locale>(locale_name_);
+  }
+
+  stopwords_.reserve(stop_words.size());
   if (is_case_sensitive_) {
-    stopwords_.reserve(stop_words.size());
     for (std::string& s : stop_words) {
       stopwords_.insert(std::move(s));
     }
   } else {
-    Locale locale(locale_name_);
-    Utf8Converter converter;
-    wstopwords_.reserve(stop_words.size());
-    for (std::string& s : stop_words) {
-      std::wstring wstr = converter.from_bytes(s);
-      locale.ChangeCase(compare_caseaction_, wstr);
-      wstopwords_.insert(std::move(wstr));
+    CaseChanger case_changer(locale_.get(), ascii_case_mapping_);
+    std::string folded;
+    for (const std::string& s : stop_words) {
+      ORT_THROW_IF_ERROR(case_changer.ChangeCase(compare_caseaction_, s, folded));
+      stopwords_.insert(folded);
     }
   }
 }
 
+StringNormalizer::~StringNormalizer() = default;
+
 Status StringNormalizer::Compute(OpKernelContext* ctx) const {
   using namespace string_normalizer;
 
@@ -507,9 +622,7 @@ Status StringNormalizer::Compute(OpKernelContext* ctx) const {
   }
 
   // Special case, no filtering and no case change
-  if (case_change_action_ == NONE &&
-      ((is_case_sensitive_ && stopwords_.empty()) ||
-       (!is_case_sensitive_ && wstopwords_.empty()))) {
+  if (case_change_action_ == NONE && stopwords_.empty()) {
     output_shape.push_back(C);
     auto output_tensor = ctx->Output(0, output_shape);
     auto const output_data = output_tensor->MutableData<std::string>();
@@ -517,121 +630,65 @@ Status StringNormalizer::Compute(OpKernelContext* ctx) const {
     return Status::OK();
   }
 
+  concurrency::ThreadPool* tp = ctx->GetOperatorThreadPool();
+  const auto total = narrow<std::ptrdiff_t>(input_span.size());
+
   // We need to know the result dimension, and for that we need to filter
   // the words first. If comparison mode is case sensitive, we just go ahead
-  // and compare with the original strings. Otherwise, we need to convert the string
-  // to widechar, lowercase it and then compare. Case-insensitive comparison is complicated
-  // for UTF-8 and requires additional dependency.
+  // and compare with the original strings. Otherwise, we change case of the input
+  // to compare_caseaction_ the same way the stopwords were at construction.
+  InlinedVector<size_t> filtered_strings_indices;
+  if (!stopwords_.empty()) {
+    InlinedVector<uint8_t> keep(input_span.size());
+    ORT_RETURN_IF_ERROR(ParallelForBatches(tp, total, [&](std::ptrdiff_t begin, std::ptrdiff_t end) -> Status {
+      if (is_case_sensitive_) {
+        for (auto i = begin; i < end; ++i) {
+          keep[static_cast<size_t>(i)] = stopwords_.count(input_span[i]) == 0;
+        }
+      } else {
+        CaseChanger case_changer(locale_.get(), ascii_case_mapping_);
+        std::string folded;
+        for (auto i = begin; i < end; ++i) {
+          ORT_RETURN_IF_ERROR(case_changer.ChangeCase(compare_caseaction_, input_span[i], folded));
+          keep[static_cast<size_t>(i)] = stopwords_.count(folded) == 0;
+        }
+      }
+      return Status::OK();
+    }));
 
-  Locale locale(locale_name_);
-  Utf8Converter converter;
+    filtered_strings_indices.reserve(input_span.size());
+    for (size_t i = 0, lim = input_span.size(); i < lim; ++i) {
+      if (keep[i]) {
+        filtered_strings_indices.push_back(i);
+      }
+    }
 
-  // Compute the largest widestring buffer needed.
-  size_t max_wide_buffer_len = 0;
-  for (const auto& s : input_span) {
-    size_t wchars = 0;
-    // Checks for invalid UTF-8 characters on Windows
-    ORT_RETURN_IF_ERROR(converter.ComputeRequiredSizeToWideChar(s, wchars));
-    max_wide_buffer_len = std::max(max_wide_buffer_len, wchars);
+    // According to the spec, if all strings are filtered out
+    // the output must have a shape of {1} with a single empty string.
+    const int64_t filtered_count = std::max<int64_t>(1, narrow<int64_t>(filtered_strings_indices.size()));
+    output_shape.push_back(filtered_count);
+  } else {
+    assert(case_change_action_ != NONE);
+    output_shape.push_back(C);
   }
 
-  // Reuse reserved space
-  std::wstring wchar_buffer;
-  wchar_buffer.reserve(max_wide_buffer_len);
-
-  // Output everything and change case as required
-  auto output_no_filtering = [&](const TensorShape& output_shape) {
-    auto output_tensor = ctx->Output(0, output_shape);
-    auto const output_data = output_tensor->MutableData<std::string>();
-    for (size_t i = 0, lim = input_span.size(); i < lim; ++i) {
-      const std::string& s = input_span[i];
-      wchar_buffer.resize(max_wide_buffer_len);
-      ORT_RETURN_IF_ERROR(converter.ConvertToWideChar(s, wchar_buffer));
-      locale.ChangeCase(case_change_action_, wchar_buffer);
-
-      auto& dest = output_data[i];
-      size_t utf8_buffer_len = converter.ComputeRequiredSizeToUtf8(wchar_buffer);
-      dest.resize(utf8_buffer_len);
-      ORT_RETURN_IF_ERROR(converter.ConvertToUtf8(wchar_buffer, dest));
-    }
-    return Status::OK();
-  };
+  auto output_tensor = ctx->Output(0, output_shape);
+  auto output_data = output_tensor->MutableData<std::string>();
+  const bool filtering = !stopwords_.empty();
+  const auto output_count = filtering ? narrow<std::ptrdiff_t>(filtered_strings_indices.size()) : total;
 
-  auto output_filtered = [&](const TensorShape& output_shape, gsl::span<const size_t> filtered_indices) {
-    auto output_tensor = ctx->Output(0, output_shape);
-    auto output_data = output_tensor->MutableData<std::string>();
-    for (size_t i : filtered_indices) {
-      const std::string& s = input_span[i];
+  // Output the remaining strings and change case as required
+  return ParallelForBatches(tp, output_count, [&](std::ptrdiff_t begin, std::ptrdiff_t end) -> Status {
+    CaseChanger case_changer(locale_.get(), ascii_case_mapping_);
+    for (auto i = begin; i < end; ++i) {
+      const std::string& s = input_span[filtering ? filtered_strings_indices[static_cast<size_t>(i)] : static_cast<size_t>(i)];
       if (case_change_action_ != NONE) {
-        wchar_buffer.resize(max_wide_buffer_len);
-        ORT_RETURN_IF_ERROR(converter.ConvertToWideChar(s, wchar_buffer));
-        locale.ChangeCase(case_change_action_, wchar_buffer);
-
-        auto& dest = *output_data++;
-        size_t utf8_buffer_len = converter.ComputeRequiredSizeToUtf8(wchar_buffer);
-        dest.resize(utf8_buffer_len);
-        ORT_RETURN_IF_ERROR(converter.ConvertToUtf8(wchar_buffer, dest));
+        ORT_RETURN_IF_ERROR(case_changer.ChangeCase(case_change_action_, s, output_data[i]));
       } else {
-        *output_data++ = s;
+        output_data[i] = s;
       }
     }
     return Status::OK();
-  };
-
-  Status status;
-
-  if (is_case_sensitive_) {
-    if (stopwords_.empty()) {
-      assert(case_change_action_ != NONE);
-      output_shape.push_back(C);
-      status = output_no_filtering(output_shape);
-    } else {
-      // we need to filter
-      InlinedVector<size_t> filtered_strings_indices;
-      filtered_strings_indices.reserve(input_span.size());
-
-      for (size_t i = 0, lim = input_span.size(); i < lim; ++i) {
-        const std::string& s = input_span[i];
-        if (stopwords_.count(s) == 0) {
-          filtered_strings_indices.push_back(i);
-        }
-      }
-
-      // According to the spec, if all strings are filtered out
-      // the output must have a shape of {1} with a single empty string.
-      const int64_t filtered_count = std::max<int64_t>(1, narrow<int64_t>(filtered_strings_indices.size()));
-      output_shape.push_back(filtered_count);
-      status = output_filtered(output_shape, filtered_strings_indices);
-    }
-  } else {
-    if (wstopwords_.empty()) {
-      assert(case_change_action_ != NONE);
-      output_shape.push_back(C);
-      status = output_no_filtering(output_shape);
-    } else {
-      // Case insensitive filtering is performed by converting the input strings
-      // to compare_caseaction_. For that we convert to wchar_t UNICODE.
-      // Otherwise, we need to pull ICU library on all platforms.
-      InlinedVector<size_t> filtered_strings_indices;
-      filtered_strings_indices.reserve(input_span.size());
-      for (size_t i = 0, lim = input_span.size(); i < lim; ++i) {
-        const std::string& s = input_span[i];
-        wchar_buffer.resize(max_wide_buffer_len);
-        ORT_RETURN_IF_ERROR(converter.ConvertToWideChar(s, wchar_buffer));
-        locale.ChangeCase(compare_caseaction_, wchar_buffer);
-        if (wstopwords_.count(wchar_buffer) == 0) {
-          filtered_strings_indices.push_back(i);
-        }
-      }
-
-      // According to the spec, if all strings are filtered out
-      // the output must have a shape of {1} with a single empty string.
-      const int64_t filtered_count = std::max<int64_t>(1, narrow<int64_t>(filtered_strings_indices.size()));
-      output_shape.push_back(filtered_count);
-      status = output_filtered(output_shape, filtered_strings_indices);
-    }
-  }
-
-  return status;
+  });
 }
 }  // namespace onnxruntime
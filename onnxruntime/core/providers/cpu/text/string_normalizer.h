@@ -7,10 +7,15 @@
 #include "core/framework/op_kernel.h"
 
 #include <locale>
+#include <memory>
 #include <string>
 
 namespace onnxruntime {
 
+namespace string_normalizer {
+class Locale;
+}  // namespace string_normalizer
+
 class StringNormalizer : public OpKernel {
  public:
   enum CaseAction {
@@ -20,7 +25,7 @@ class StringNormalizer : public OpKernel {
   };
 
   explicit StringNormalizer(const OpKernelInfo& info);
-  ~StringNormalizer() override = default;
+  ~StringNormalizer() override;
 
   Status Compute(OpKernelContext* ctx) const override;
 
@@ -31,9 +36,16 @@ class StringNormalizer : public OpKernel {
   // used for case-insensitive compare
   CaseAction compare_caseaction_{LOWER};
   std::string locale_name_;
-  // Either if these are populated but not both
+  // Created once at construction when either a case change or a case-insensitive
+  // comparison is required. Only consulted for strings that are not pure ASCII
+  // or when the locale does not allow ASCII case mapping.
+  std::unique_ptr<string_normalizer::Locale> locale_;
+  // True when ASCII characters map to their ASCII counterparts in locale_name_,
+  // which is the case for all locales except Turkic ones (dotted/dotless i).
+  bool ascii_case_mapping_{true};
+  // UTF-8 stopwords. For case-insensitive comparison they are stored
+  // already converted to compare_caseaction_.
   InlinedHashSet<std::string> stopwords_;
-  InlinedHashSet<std::wstring> wstopwords_;
 };
 
 }  // namespace onnxruntime
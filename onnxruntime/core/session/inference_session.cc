@@ -40,6 +40,7 @@
 #include "core/graph/model.h"
 #include "core/graph/model_editor_api_types.h"
 #include "core/graph/model_saving_options.h"
+#include "core/graph/model_proto_parser.h"
 #include "core/optimizer/graph_transformer_utils.h"
 #include "core/optimizer/graph_transformer.h"
 #include "core/optimizer/graph_optimizer_registry.h"
@@ -673,6 +674,10 @@ InferenceSession::InferenceSession(const SessionOptions& session_options, const
 #endif  // !defined(ORT_MINIMAL_BUILD)
 
 InferenceSession::~InferenceSession() {
+#if !defined(ORT_MINIMAL_BUILD)
+  shape_specializations_.reset();
+#endif
+
   if (session_options_.enable_profiling) {
     ORT_TRY {
       EndProfiling();
@@ -846,7 +851,9 @@ common::Status InferenceSession::RegisterGraphTransformer(
                           "Graph transformers must be registered before the session is initialized.");
   }
 
-  return graph_transformer_mgr_.Register(std::move(p_graph_transformer), level);
+  ORT_RETURN_IF_ERROR(graph_transformer_mgr_.Register(std::move(p_graph_transformer), level));
+  has_custom_graph_transformers_ = true;
+  return Status::OK();
 }
 
 common::Status InferenceSession::SaveToOrtFormat(const std::filesystem::path& filepath) const {
@@ -893,6 +900,225 @@ common::Status InferenceSession::SaveToOrtFormat(const std::filesystem::path& fi
   return Status::OK();
 }
 
+common::Status InferenceSession::LoadFromOptimizedModelCache() {
+  const auto& config_options = session_options_.config_options;
+  const std::string cache_dir = config_options.GetConfigOrDefault(kOrtSessionOptionsOptimizedModelCacheDir, "");
+  if (cache_dir.empty() || !ort_format_model_bytes_.empty()) {
+    return Status::OK();
+  }
+
+  bool has_external_initializers = false;
+#if !defined(DISABLE_EXTERNAL_INITIALIZERS)
+  has_external_initializers = !session_options_.external_initializers.empty() ||
+                              !session_options_.external_initializer_files_mmap.empty();
+#endif
+  if (!session_options_.optimized_model_filepath.empty() || has_external_initializers) {
+    LOGS(*session_logger_, INFO) << "The optimized model cache is not used as the session saves the optimized model "
+                                 << "or was given external initializers.";
+    return Status::OK();
+  }
+
+  // The key can't capture what custom graph transformers do, and an entry would store copies of the shared
+  // initializers rather than share them.
+  if (has_custom_graph_transformers_ || !session_options_.initializers_to_share_map.empty()) {
+    LOGS(*session_logger_, INFO) << "The optimized model cache is not used as the session has custom graph "
+                                 << "transformers or shared initializers.";
+    return Status::OK();
+  }
+
+  std::string model_hash = optimized_model_cache_model_hash_;
+  if (model_hash.empty()) {
+    std::error_code ec;
+    if (model_location_.empty() || !std::filesystem::is_regular_file(model_location_, ec)) {
+      LOGS(*session_logger_, INFO) << "The optimized model cache is only used for models loaded from a file or from "
+                                   << "a memory buffer.";
+      return Status::OK();
+    }
+
+    ORT_RETURN_IF_ERROR(OptimizedModelCache::HashModelFile(model_location_, model_hash));
+  }
+
+  const uint64_t max_size_in_bytes = ParseStringWithClassicLocale<uint64_t>(
+      config_options.GetConfigOrDefault(kOrtSessionOptionsOptimizedModelCacheMaxSizeInBytes, "1073741824"));
+  optimized_model_cache_ = std::make_unique<OptimizedModelCache>(ToPathString(cache_dir), max_size_in_bytes,
+                                                                 *session_logger_);
+  optimized_model_cache_entry_path_ = optimized_model_cache_->GetEntryPath(model_hash, session_options_,
+                                                                           optimizers_to_disable_,
+                                                                           execution_providers_);
+  if (!optimized_model_cache_->Lookup(optimized_model_cache_entry_path_)) {
+    return Status::OK();
+  }
+
+  // the ORT format model replaces the ONNX model, which is kept in case the entry can't be loaded.
+  std::shared_ptr<onnxruntime::Model> onnx_model = std::move(model_);
+  const PathString onnx_model_location = model_location_;
+  is_model_loaded_ = false;
+
+  Status status = LoadOrtModel(optimized_model_cache_entry_path_.native());
+  if (status.IsOK()) {
+    optimized_model_cache_.reset();
+    return Status::OK();
+  }
+
+  LOGS(*session_logger_, WARNING) << "Failed to load " << ToUTF8String(optimized_model_cache_entry_path_.native())
+                                  << " from the optimized model cache. The model will be optimized and stored again. "
+                                  << status.ErrorMessage();
+  optimized_model_cache_->Remove(optimized_model_cache_entry_path_);
+
+  model_ = std::move(onnx_model);
+  model_location_ = onnx_model_location;
+  is_model_loaded_ = true;
+  ort_format_model_bytes_ = gsl::span<const uint8_t>();
+  std::vector<uint8_t>().swap(ort_format_model_bytes_data_holder_);
+  return Status::OK();
+}
+
+void InferenceSession::StoreInOptimizedModelCache() {
+  // the entry would lack the compiled nodes, and the ORT format model can't be saved with them.
+  if (session_state_->GetFuncMgr().NumFuncs() > 0) {
+    LOGS(*session_logger_, INFO) << "The optimized model is not stored in the optimized model cache as it contains "
+                                 << "compiled nodes.";
+    return;
+  }
+
+  Status status = optimized_model_cache_->Store(
+      optimized_model_cache_entry_path_,
+      [this](const std::filesystem::path& path) { return SaveToOrtFormat(path); });
+  if (!status.IsOK()) {
+    LOGS(*session_logger_, WARNING) << "Failed to store the optimized model in the optimized model cache. "
+                                    << status.ErrorMessage();
+  }
+
+  optimized_model_cache_.reset();
+}
+
+Status InferenceSession::EnableShapeSpecializations() {
+  const auto& config_options = session_options_.config_options;
+  const size_t min_run_count = ParseStringWithClassicLocale<size_t>(
+      config_options.GetConfigOrDefault(kOrtSessionOptionsShapeSpecializationMinRunCount, "0"));
+  if (min_run_count == 0) {
+    return Status::OK();
+  }
+
+  Graph& graph = model_->MainGraph();
+  const auto& model_inputs = graph.GetInputs();
+  if (!ShapeSpecializations::HasSymbolicDims(model_inputs)) {
+    return Status::OK();
+  }
+
+  // Specialized sessions are created from the loaded ONNX model with the default CPU execution provider, so sessions
+  // that loaded an ORT format model, were given other execution providers or custom ops can't be reproduced. A session
+  // that stores its optimized model in the optimized model cache would store the shared initializers too.
+  if (!ort_format_model_bytes_.empty() || optimized_model_cache_ != nullptr ||
+      execution_providers_.NumProviders() != 1 ||
+      execution_providers_.Get(onnxruntime::kCpuExecutionProvider) == nullptr || HasLocalSchema()) {
+    LOGS(*session_logger_, WARNING) << "Shape specialization is only supported for ONNX models that only use the CPU "
+                                    << "execution provider and no custom ops, and not with the optimized model "
+                                    << "cache. It is disabled.";
+    return Status::OK();
+  }
+
+  // Move the initializers of the main graph to OrtValues that the graph refers to in memory, so the specialized
+  // sessions are created from the loaded model without copying them and share them with this session. Initializers
+  // that were shared with the session already are shared with the specialized sessions as they are.
+  const AllocatorPtr allocator = std::make_shared<CPUAllocator>();
+  std::vector<std::string> initializer_names;
+  initializer_names.reserve(graph.GetAllInitializedTensors().size());
+  for (const auto& initializer : graph.GetAllInitializedTensors()) {
+    initializer_names.push_back(initializer.first);
+  }
+
+  for (const auto& name : initializer_names) {
+    const ONNX_NAMESPACE::TensorProto* tensor_proto = nullptr;
+    ORT_RETURN_IF_NOT(graph.GetInitializedTensor(name, tensor_proto), "Failed to find initializer ", name);
+    if (tensor_proto->data_type() == ONNX_NAMESPACE::TensorProto_DataType_STRING ||
+#if !defined(DISABLE_SPARSE_TENSORS)
+        graph.IsSparseInitializer(name) ||
+#endif
+        session_options_.initializers_to_share_map.count(name) != 0) {
+      continue;
+    }
+
+    OrtValue value;
+    if (!graph.GetOrtValueInitializer(name, value)) {
+      if (utils::CanMapExternalData(*tensor_proto)) {
+        ORT_RETURN_IF_ERROR(utils::MapExternalDataToOrtValue(Env::Default(), graph.ModelPath(), *tensor_proto, value));
+      } else {
+        ORT_RETURN_IF_ERROR(utils::TensorProtoToOrtValue(Env::Default(), graph.ModelPath(), *tensor_proto, allocator,
+                                                         value));
+      }
+      ORT_RETURN_IF_ERROR(graph.ReplaceInitializedTensor(name, value));
+    }
+    shape_specialization_initializers_.emplace(name, std::move(value));
+  }
+
+  // the pre-packed weights of the shared initializers are shared through the container
+  if (prepacked_weights_container_ == nullptr) {
+    shape_specialization_prepacked_weights_container_ = std::make_unique<PrepackedWeightsContainer>();
+    prepacked_weights_container_ = shape_specialization_prepacked_weights_container_.get();
+  }
+
+  // the model is taken before it is optimized, as the specialized sessions optimize it for their shapes
+  auto model_proto = std::make_shared<const ONNX_NAMESPACE::ModelProto>(model_->ToProtoWithInMemoryInitializers());
+
+  const size_t max_sessions = ParseStringWithClassicLocale<size_t>(
+      config_options.GetConfigOrDefault(kOrtSessionOptionsShapeSpecializationMaxSessions, "4"));
+
+  auto create_session = [this, model_proto](const std::vector<FreeDimensionOverride>& free_dimension_overrides,
+                                            std::unique_ptr<InferenceSession>& session) {
+    SessionOptions session_options = session_options_;
+    session_options.optimized_model_filepath.clear();
+    session_options.enable_profiling = false;
+    auto& configurations = session_options.config_options.configurations;
+    configurations[kOrtSessionOptionsShapeSpecializationMinRunCount] = "0";
+    configurations.erase(kOrtSessionOptionsOptimizedModelCacheDir);
+    // the specialized session shares the initializers its graph transformers leave unchanged itself
+    for (const auto& initializer : shape_specialization_initializers_) {
+      session_options.initializers_to_share_map.erase(initializer.first);
+    }
+    for (const auto& free_dim : free_dimension_overrides) {
+      session_options.free_dimension_overrides.push_back(free_dim);
+      session_options.session_logid += (session_options.session_logid.empty() ? "" : ":") +
+                                       free_dim.dim_identifier + "=" + std::to_string(free_dim.dim_value);
+    }
+
+    // the thread pools of this session are ignored if the sessions use the global thread pools
+    auto specialized_session = std::make_unique<InferenceSession>(session_options, environment_,
+                                                                  GetIntraOpThreadPoolToUse(),
+                                                                  GetInterOpThreadPoolToUse());
+    ORT_RETURN_IF_ERROR(specialized_session->AddPrePackedWeightsContainer(prepacked_weights_container_));
+
+    // external data of the initializers that are not shared is relative to the model path
+    specialized_session->model_location_ = model_location_;
+    ORT_RETURN_IF_ERROR(specialized_session->LoadOnnxModel(*model_proto));
+    Graph& specialized_graph = specialized_session->model_->MainGraph();
+    for (const auto& initializer : shape_specialization_initializers_) {
+      ORT_RETURN_IF_ERROR(specialized_graph.ReplaceInitializedTensor(initializer.first, initializer.second));
+    }
+    specialized_session->shape_specialization_initializers_ = shape_specialization_initializers_;
+
+    ORT_RETURN_IF_ERROR(specialized_session->Initialize());
+    session = std::move(specialized_session);
+    return Status::OK();
+  };
+
+  shape_specializations_ = std::make_unique<ShapeSpecializations>(model_inputs, min_run_count, max_sessions,
+                                                                  std::move(create_session), *session_logger_);
+  return Status::OK();
+}
+
+void InferenceSession::ShareShapeSpecializationInitializers() {
+  const Graph& graph = model_->MainGraph();
+  for (const auto& initializer : shape_specialization_initializers_) {
+    // graph transformers that change an initializer replace it, which drops its OrtValue
+    OrtValue value;
+    if (graph.GetOrtValueInitializer(initializer.first, value) &&
+        value.Get<Tensor>().DataRaw() == initializer.second.Get<Tensor>().DataRaw()) {
+      session_options_.initializers_to_share_map.emplace(initializer.first, &initializer.second);
+    }
+  }
+}
+
 common::Status InferenceSession::LoadWithLoader(std::function<common::Status(std::shared_ptr<Model>&)> loader,
                                                 const std::string& event_name) {
   Status status = Status::OK();
@@ -952,10 +1178,10 @@ common::Status InferenceSession::LoadOnnxModel(const PathString& model_uri) {
 
     const bool strict_shape_type_inference = session_options_.config_options.GetConfigOrDefault(
                                                  kOrtSessionOptionsConfigStrictShapeTypeInference, "0") == "1";
+    ModelOptions model_options(true, strict_shape_type_inference, check_load_cancellation_fn_);
+    model_options.thread_pool = GetIntraOpThreadPoolToUse();
     return onnxruntime::Model::Load(model_location_, model, HasLocalSchema() ? &custom_schema_registries_ : nullptr,
-                                    *session_logger_,
-                                    ModelOptions(true, strict_shape_type_inference,
-                                                 check_load_cancellation_fn_));
+                                    *session_logger_, model_options);
   };
 
   common::Status st = LoadWithLoader(loader, "model_loading_uri");
@@ -1024,11 +1250,17 @@ common::Status InferenceSession::Load(const void* model_data, int model_data_len
   auto loader = [this, model_data, model_data_len](std::shared_ptr<onnxruntime::Model>& model) {
     ModelProto model_proto;
 
-    const bool result = model_proto.ParseFromArray(model_data, model_data_len);
+    const bool result = model_data_len >= 0 &&
+                        ParseModelProto(model_data, static_cast<size_t>(model_data_len), model_proto,
+                                        GetIntraOpThreadPoolToUse());
     if (!result) {
       return Status(common::ONNXRUNTIME, common::INVALID_PROTOBUF,
                     "Failed to load model because protobuf parsing failed.");
     }
+
+    if (!session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsOptimizedModelCacheDir, "").empty()) {
+      optimized_model_cache_model_hash_ = OptimizedModelCache::HashModelBytes(model_data, model_data_len);
+    }
 #ifdef ENABLE_LANGUAGE_INTEROP_OPS
     LoadInterOp(model_proto, interop_domains_, [&](const char* msg) { LOGS(*session_logger_, WARNING) << msg; });
     InlinedVector<OrtCustomOpDomain*> domain_ptrs;
@@ -1836,18 +2068,6 @@ common::Status InferenceSession::Initialize() {
       have_cpu_ep = execution_providers_.Get(onnxruntime::kCpuExecutionProvider) != nullptr;
     }
 
-    // Verify that there are no external initializers in the graph if external data is disabled.
-    onnxruntime::Graph& graph = model_->MainGraph();
-#ifdef DISABLE_EXTERNAL_INITIALIZERS
-    const InitializedTensorSet& initializers = graph.GetAllInitializedTensors();
-    for (const auto& it : initializers) {
-      if (utils::HasExternalData(*it.second)) {
-        return common::Status(common::ONNXRUNTIME, common::FAIL,
-                              "Initializer tensors with external data is not allowed.");
-      }
-    }
-#endif
-
     // Register default CPUExecutionProvider if user didn't provide it through the Register() calls.
     // RegisterExecutionProvider locks the session_mutex_ so we can't be holding it when we call that
     if (!have_cpu_ep) {
@@ -1863,6 +2083,24 @@ common::Status InferenceSession::Initialize() {
     // This check is placed here because it serves as a common place for all language bindings.
     ORT_RETURN_IF_ERROR_SESSIONID_(HasInvalidCombinationOfExecutionProviders());
 
+#if !defined(ORT_MINIMAL_BUILD)
+    // the cache key includes the execution providers, so this has to wait until the default CPU EP was added.
+    // LoadOrtModel locks the session_mutex_ so we can't be holding it when we call this.
+    ORT_RETURN_IF_ERROR_SESSIONID_(LoadFromOptimizedModelCache());
+#endif
+
+    // Verify that there are no external initializers in the graph if external data is disabled.
+    onnxruntime::Graph& graph = model_->MainGraph();
+#ifdef DISABLE_EXTERNAL_INITIALIZERS
+    const InitializedTensorSet& initializers = graph.GetAllInitializedTensors();
+    for (const auto& it : initializers) {
+      if (utils::HasExternalData(*it.second)) {
+        return common::Status(common::ONNXRUNTIME, common::FAIL,
+                              "Initializer tensors with external data is not allowed.");
+      }
+    }
+#endif
+
     // re-acquire mutex
     std::lock_guard<std::mutex> l(session_mutex_);
 
@@ -1885,6 +2123,11 @@ common::Status InferenceSession::Initialize() {
     session_activity_started_ = true;
 #endif
 
+#if !defined(ORT_MINIMAL_BUILD)
+    // this has to happen before the session state is created, as it may add a pre-packed weights container
+    ORT_RETURN_IF_ERROR_SESSIONID_(EnableShapeSpecializations());
+#endif
+
     // now that we have all the execution providers, create the session state
     session_state_ = std::make_unique<SessionState>(
         model_->MainGraph(),
@@ -1938,6 +2181,38 @@ common::Status InferenceSession::Initialize() {
     // Register 2nd registries into KernelRegistryManager.
     ORT_RETURN_IF_ERROR_SESSIONID_(kernel_registry_manager_.RegisterKernels(execution_providers_));
 
+#if !defined(ORT_MINIMAL_BUILD)
+    // the tuning results of the CPU EP decide whether the graph transformers apply some fusions, so TunableOp has to
+    // be configured and the tuning results in the model metadata have to be loaded before the graph is optimized.
+    // The Level1 transformers run before the nodes are assigned to EPs, so the decisions are only used if the CPU EP
+    // is the only EP.
+    auto* cpu_tuning_ctx = execution_providers_.Get(onnxruntime::kCpuExecutionProvider)->GetTuningContext();
+    const bool use_cpu_tuning_ctx = cpu_tuning_ctx != nullptr && execution_providers_.NumProviders() == 1;
+    if (use_cpu_tuning_ctx) {
+      const auto& config_options = session_options_.config_options;
+      if (config_options.GetConfigOrDefault(kOrtSessionOptionsCpuTunableOpTuningEnable, "0") == "1") {
+        cpu_tuning_ctx->EnableTunableOpAndTuning();
+      } else if (config_options.GetConfigOrDefault(kOrtSessionOptionsCpuTunableOpEnable, "0") == "1") {
+        cpu_tuning_ctx->EnableTunableOp();
+      }
+      cpu_tuning_ctx->SetMaxTuningDurationMs(ParseStringWithClassicLocale<int>(
+          config_options.GetConfigOrDefault(kOrtSessionOptionsCpuTunableOpMaxTuningDurationMs, "0")));
+    }
+
+    std::vector<TuningResults> tuning_results;
+    bool found_tuning_results = false;
+    ORT_RETURN_IF_ERROR_SESSIONID_(inference_session_utils::ParseTuningResultsFromModelMetadata(
+        model_metadata_, tuning_results, found_tuning_results, *session_logger_));
+    if (found_tuning_results) {
+      ORT_RETURN_IF_ERROR_SESSIONID_(SetTuningResults(tuning_results, /*error_on_invalid*/ false, /*auto_enable*/ true));
+    }
+
+    if (cpu_tuning_ctx != nullptr && !use_cpu_tuning_ctx && cpu_tuning_ctx->IsTunableOpEnabled()) {
+      LOGS(*session_logger_, INFO) << "TunableOp of the CPU EP is disabled as the session has other EPs.";
+      cpu_tuning_ctx->DisableTunableOp();
+    }
+#endif  // !defined(ORT_MINIMAL_BUILD)
+
     const bool loading_ort_format = !ort_format_model_bytes_.empty();
     const bool saving_model = !session_options_.optimized_model_filepath.empty();
     const bool saving_ort_format = [&]() {
@@ -2037,6 +2312,9 @@ common::Status InferenceSession::Initialize() {
                                "Session initialization canceled due to user request.");
       }
 
+      // the initializers of the specialized sessions are only shared once the graph transformers are done with them
+      ShareShapeSpecializationInitializers();
+
       // Currently graph capture is only considered by CUDA EP, TRT EP, ROCM EP and JS EP.
       //
       // Check for CUDA EP:
@@ -2198,10 +2476,16 @@ common::Status InferenceSession::Initialize() {
 #endif  // !defined(ORT_MINIMAL_BUILD) || defined(ORT_EXTENDED_MINIMAL_BUILD)
     }
 
+#if !defined(ORT_MINIMAL_BUILD)
+    const bool storing_in_model_cache = optimized_model_cache_ != nullptr;
+#else
+    const bool storing_in_model_cache = false;
+#endif
+
     ORT_RETURN_IF_ERROR_SESSIONID_(
         session_state_->FinalizeSessionState(model_location_, kernel_registry_manager_,
                                              // need to keep the initializers if saving the optimized model
-                                             !saving_model,
+                                             !saving_model && !storing_in_model_cache,
                                              saving_ort_format));
 
 #if !defined(ORT_MINIMAL_BUILD)
@@ -2244,12 +2528,8 @@ common::Status InferenceSession::Initialize() {
       }
     }
 
-    std::vector<TuningResults> tuning_results;
-    bool found_tuning_results = false;
-    ORT_RETURN_IF_ERROR_SESSIONID_(inference_session_utils::ParseTuningResultsFromModelMetadata(
-        model_metadata_, tuning_results, found_tuning_results, *session_logger_));
-    if (found_tuning_results) {
-      ORT_RETURN_IF_ERROR_SESSIONID_(SetTuningResults(tuning_results, /*error_on_invalid*/ false, /*auto_enable*/ true));
+    if (storing_in_model_cache) {
+      StoreInOptimizedModelCache();
     }
 #endif  // !defined(ORT_MINIMAL_BUILD)
 
@@ -2670,6 +2950,14 @@ Status InferenceSession::Run(const RunOptions& run_options,
                              gsl::span<const std::string> feed_names, gsl::span<const OrtValue> feeds,
                              gsl::span<const std::string> output_names, std::vector<OrtValue>* p_fetches,
                              const std::vector<OrtDevice>* p_fetches_device_info) {
+#if !defined(ORT_MINIMAL_BUILD)
+  if (shape_specializations_) {
+    if (auto* specialized_session = shape_specializations_->GetSession(feed_names, feeds)) {
+      return specialized_session->Run(run_options, feed_names, feeds, output_names, p_fetches, p_fetches_device_info);
+    }
+  }
+#endif
+
   TimePoint tp;
   if (session_profiler_.IsEnabled()) {
     tp = session_profiler_.Start();
@@ -2777,15 +3065,6 @@ Status InferenceSession::Run(const RunOptions& run_options,
         ORT_CHECK_AND_SET_RETVAL(start_func());
       }
 
-#ifdef ENABLE_TRAINING
-      if (run_options.only_execute_path_to_fetches) {
-        // TODO: this method is not thread safe, if multiple Run happened in parallel we might hit race condition issue.
-        // currently it only used in training, there is no parallel run execution in training so it is ok.
-        // but it is better we can fix it with a better solution.
-        session_state_->UpdateToBeExecutedRange(feeds_fetches_manager.GetFeedsFetchesInfo().fetches_mlvalue_idxs);
-      }
-#endif
-
       // execute the graph
 #ifdef DEBUG_NODE_INPUTS_OUTPUTS
       session_state_->IncrementGraphExecutionCounter();
@@ -30,6 +30,8 @@
 #include "core/optimizer/graph_transformer_level.h"
 #include "core/optimizer/graph_transformer_mgr.h"
 #include "core/optimizer/insert_cast_transformer.h"
+#include "core/session/optimized_model_cache.h"
+#include "core/session/shape_specialization.h"
 #include <mutex>
 #ifdef ENABLE_LANGUAGE_INTEROP_OPS
 #include "core/language_interop_ops/language_interop_ops.h"
@@ -565,6 +567,18 @@ class InferenceSession {
     return *session_state_;
   }
 
+#if !defined(ORT_MINIMAL_BUILD)
+  /**
+   * Get the session specialized for the shapes of the feeds, if kOrtSessionOptionsShapeSpecializationMinRunCount
+   * enabled shape specialization and Runs with these shapes created it. Unlike Run, it doesn't count as a Run.
+   * @return the specialized session or nullptr.
+   */
+  const InferenceSession* GetSpecializedSession(gsl::span<const std::string> feed_names,
+                                                gsl::span<const OrtValue> feeds) const {
+    return shape_specializations_ ? shape_specializations_->FindSession(feed_names, feeds) : nullptr;
+  }
+#endif
+
   /**
    * Add a PrepackedWeightsContainer instance to the session so as to store the pre-packed weights
    *  of shared initializers to be shared across sessions.
@@ -690,6 +704,22 @@ class InferenceSession {
   }
 
   common::Status SaveToOrtFormat(const std::filesystem::path& filepath) const;
+
+  // If the optimized model cache is enabled, replace the loaded ONNX model with the optimized model from the cache.
+  // On a cache miss, optimized_model_cache_ is left set so Initialize stores the optimized model.
+  [[nodiscard]] common::Status LoadFromOptimizedModelCache();
+
+  // Store the optimized model after a cache miss. Failures are logged as the session itself is usable.
+  void StoreInOptimizedModelCache();
+
+  // Set up shape_specializations_ if kOrtSessionOptionsShapeSpecializationMinRunCount is set and the session supports
+  // it. Moves the initializers of the main graph to shape_specialization_initializers_ and takes the loaded model the
+  // specialized sessions are created from, so it has to be called before the graph is optimized.
+  [[nodiscard]] common::Status EnableShapeSpecializations();
+
+  // Share the initializers of shape_specialization_initializers_ that the graph transformers left unchanged through
+  // session_options_.initializers_to_share_map, which also shares their pre-packed weights.
+  void ShareShapeSpecializationInitializers();
 #endif
 
   /**
@@ -770,7 +800,29 @@ class InferenceSession {
 
   onnxruntime::GraphTransformerManager graph_transformer_mgr_;
 
+  // Set by RegisterGraphTransformer. The optimized model cache can't key the results of custom transformers.
+  bool has_custom_graph_transformers_ = false;
+
   InlinedHashSet<gsl::not_null<const ONNX_NAMESPACE::OpSchema*>> saved_runtime_optimization_produced_node_op_schemas_;
+
+  // Hash of the ONNX model for the optimized model cache. Set when the model is loaded from a memory buffer, as the
+  // bytes are not available in Initialize. Models loaded from a file are hashed by Initialize.
+  std::string optimized_model_cache_model_hash_;
+
+  // Set during Initialize if the optimized model has to be stored in the optimized model cache.
+  std::unique_ptr<OptimizedModelCache> optimized_model_cache_;
+  std::filesystem::path optimized_model_cache_entry_path_;
+
+  // Initializers of the main graph that the session shares with the sessions specialized for input shapes.
+  std::unordered_map<std::string, OrtValue> shape_specialization_initializers_;
+
+  // Pre-packed weights shared with the specialized sessions if the session was not given a container. Declared before
+  // session_state_, so the kernels using them are destroyed first.
+  std::unique_ptr<PrepackedWeightsContainer> shape_specialization_prepacked_weights_container_;
+
+  // Sessions specialized for frequently seen input shapes. Reset first in the destructor, as they use the thread pools
+  // and the pre-packed weights of this session.
+  std::unique_ptr<ShapeSpecializations> shape_specializations_;
 #endif
   // Any GraphTransformer/RewriteRule name in this set will not be enabled.
   InlinedHashSet<std::string> optimizers_to_disable_;
@@ -0,0 +1,211 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#if !defined(ORT_MINIMAL_BUILD)
+
+#include "core/session/optimized_model_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <sstream>
+#include <system_error>
+#include <vector>
+
+#include "core/common/cpuid_info.h"
+#include "core/common/logging/logging.h"
+#include "core/flatbuffers/ort_format_version.h"
+#include "core/framework/cache_file_utils.h"
+#include "core/framework/execution_providers.h"
+#include "core/framework/session_options.h"
+#include "core/platform/env.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
+
+namespace onnxruntime {
+
+namespace {
+
+// Process-wide statistics, logged with every lookup and store.
+utils::CacheStatistics statistics;
+std::atomic<uint64_t> num_evictions{0};
+
+constexpr const char* kEntryExtension = ".ort";
+
+std::string HashString(const std::string& value) {
+  return utils::HashToHexString(value.data(), value.size());
+}
+
+// Level 3 optimizers such as the NCHWc transformer choose their kernels by the instruction sets of the CPU.
+void AppendCpuFeatures(std::ostream& key) {
+  const auto& cpu_info = CPUIDInfo::GetCPUIDInfo();
+  key << "cpu:" << cpu_info.GetCPUVendor()
+      << " avx:" << cpu_info.HasAVX()
+      << " avx2:" << cpu_info.HasAVX2()
+      << " avx512f:" << cpu_info.HasAVX512f()
+      << " avx512_skylake:" << cpu_info.HasAVX512Skylake()
+      << " avx512_bf16:" << cpu_info.HasAVX512_BF16()
+      << " amx_bf16:" << cpu_info.HasAMX_BF16()
+      << " f16c:" << cpu_info.HasF16C()
+      << " neon_dot:" << cpu_info.HasArmNeonDot()
+      << " neon_i8mm:" << cpu_info.HasArmNeon_I8MM()
+      << " sve_i8mm:" << cpu_info.HasArmSVE_I8MM()
+      << " neon_bf16:" << cpu_info.HasArmNeon_BF16()
+      << " fp16:" << cpu_info.HasFp16VectorAcceleration() << "\n";
+}
+
+}  // namespace
+
+OptimizedModelCache::OptimizedModelCache(std::filesystem::path cache_dir, uint64_t max_size_in_bytes,
+                                         const logging::Logger& logger)
+    : cache_dir_(std::move(cache_dir)), max_size_in_bytes_(max_size_in_bytes), logger_(logger) {
+}
+
+std::string OptimizedModelCache::HashModelBytes(const void* model_data, size_t model_data_len) {
+  return utils::HashToHexString(model_data, model_data_len);
+}
+
+Status OptimizedModelCache::HashModelFile(const PathString& model_path, std::string& model_hash) {
+  const Env& env = Env::Default();
+  size_t length = 0;
+  ORT_RETURN_IF_ERROR(env.GetFileLength(model_path.c_str(), length));
+
+  Env::MappedMemoryPtr mapped_model;
+  if (length > 0) {
+    ORT_RETURN_IF_ERROR(env.MapFileIntoMemory(model_path.c_str(), 0, length, mapped_model));
+  }
+
+  model_hash = HashModelBytes(mapped_model.get(), length);
+  return Status::OK();
+}
+
+std::filesystem::path OptimizedModelCache::GetEntryPath(const std::string& model_hash,
+                                                        const SessionOptions& session_options,
+                                                        const InlinedHashSet<std::string>& optimizers_to_disable,
+                                                        const ExecutionProviders& execution_providers) const {
+  std::ostringstream key;
+  key << "ort:" << ORT_VERSION << " ort_format:" << kOrtModelVersion << "\n"
+      << "model:" << model_hash << "\n"
+      << "optimization_level:" << static_cast<int>(session_options.graph_optimization_level) << "\n";
+
+  // Sort the unordered containers so the key does not depend on their iteration order.
+  std::vector<std::string> disabled(optimizers_to_disable.begin(), optimizers_to_disable.end());
+  std::sort(disabled.begin(), disabled.end());
+  for (const auto& name : disabled) {
+    key << "disabled_optimizer:" << name << "\n";
+  }
+
+  for (const auto& free_dim : session_options.free_dimension_overrides) {
+    key << "free_dimension:" << free_dim.dim_identifier << " type:" << static_cast<int>(free_dim.dim_identifier_type)
+        << " value:" << free_dim.dim_value << "\n";
+  }
+
+  const std::map<std::string, std::string> config_entries(
+      session_options.config_options.GetConfigOptionsMap().begin(),
+      session_options.config_options.GetConfigOptionsMap().end());
+  for (const auto& [config_key, config_value] : config_entries) {
+    if (config_key != kOrtSessionOptionsOptimizedModelCacheDir &&
+        config_key != kOrtSessionOptionsOptimizedModelCacheMaxSizeInBytes) {
+      key << "config:" << config_key << "=" << config_value << "\n";
+    }
+  }
+
+  for (const auto& ep : execution_providers) {
+    key << "ep:" << ep->Type() << "\n";
+    const auto provider_options = ep->GetProviderOptions();
+    const std::map<std::string, std::string> sorted_options(provider_options.begin(), provider_options.end());
+    for (const auto& [option_key, option_value] : sorted_options) {
+      key << "ep_option:" << option_key << "=" << option_value << "\n";
+    }
+  }
+
+  AppendCpuFeatures(key);
+
+  return cache_dir_ / (HashString(key.str()) + kEntryExtension);
+}
+
+bool OptimizedModelCache::Lookup(const std::filesystem::path& entry_path) const {
+  std::error_code ec;
+  const bool found = std::filesystem::is_regular_file(entry_path, ec);
+  if (found) {
+    // the modification time orders the entries for eviction
+    std::filesystem::last_write_time(entry_path, std::filesystem::file_time_type::clock::now(), ec);
+  }
+
+  statistics.AddLookup(found);
+  LOGS(logger_, INFO) << "Optimized model cache " << (found ? "hit" : "miss") << " for "
+                      << PathToUTF8String(entry_path.native()) << ". " << statistics
+                      << " evictions: " << num_evictions.load();
+  return found;
+}
+
+void OptimizedModelCache::Remove(const std::filesystem::path& entry_path) const {
+  std::error_code ec;
+  std::filesystem::remove(entry_path, ec);
+}
+
+Status OptimizedModelCache::Store(const std::filesystem::path& entry_path,
+                                  const std::function<Status(const std::filesystem::path&)>& save_model) const {
+  std::error_code ec;
+  std::filesystem::create_directories(cache_dir_, ec);
+  ORT_RETURN_IF(ec, "Failed to create the optimized model cache directory ", PathToUTF8String(cache_dir_.native()),
+                ": ", ec.message());
+
+  ORT_RETURN_IF_ERROR(utils::WriteCacheFile(entry_path, save_model));
+
+  Evict(entry_path);
+  return Status::OK();
+}
+
+void OptimizedModelCache::Evict(const std::filesystem::path& new_entry_path) const {
+  struct Entry {
+    std::filesystem::path path;
+    std::filesystem::file_time_type last_used;
+    uint64_t size;
+  };
+
+  std::vector<Entry> entries;
+  uint64_t total_size = 0;
+  std::error_code ec;
+  for (const auto& dir_entry : std::filesystem::directory_iterator(cache_dir_, ec)) {
+    if (!dir_entry.is_regular_file(ec) || dir_entry.path().extension() != kEntryExtension) {
+      continue;
+    }
+
+    std::error_code size_ec;
+    std::error_code time_ec;
+    const uint64_t size = dir_entry.file_size(size_ec);
+    const auto last_used = dir_entry.last_write_time(time_ec);
+    if (!size_ec && !time_ec) {
+      entries.push_back({dir_entry.path(), last_used, size});
+      total_size += size;
+    }
+  }
+
+  size_t num_evicted = 0;
+  if (max_size_in_bytes_ != 0 && total_size > max_size_in_bytes_) {
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.last_used < b.last_used; });
+
+    // never evict the new entry, even if it alone exceeds the limit
+    for (const auto& entry : entries) {
+      if (total_size <= max_size_in_bytes_) {
+        break;
+      }
+
+      if (entry.path != new_entry_path && std::filesystem::remove(entry.path, ec)) {
+        total_size -= entry.size;
+        ++num_evicted;
+      }
+    }
+  }
+
+  num_evictions += num_evicted;
+  LOGS(logger_, INFO) << "Added " << PathToUTF8String(new_entry_path.native())
+                      << " to the optimized model cache. entries: " << entries.size() - num_evicted
+                      << " size: " << total_size << " bytes evicted: " << num_evicted << ". " << statistics
+                      << " evictions: " << num_evictions.load();
+}
+
+}  // namespace onnxruntime
+
+#endif  // !defined(ORT_MINIMAL_BUILD)
@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#if !defined(ORT_MINIMAL_BUILD)
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+#include "core/common/common.h"
+#include "core/common/inlined_containers.h"
+#include "core/common/path_string.h"
+
+namespace onnxruntime {
+
+class ExecutionProviders;
+struct SessionOptions;
+
+namespace logging {
+class Logger;
+}
+
+/**
+ * On-disk cache of optimized models in ORT format. Enabled by the kOrtSessionOptionsOptimizedModelCacheDir session
+ * config entry.
+ *
+ * An entry is keyed by a hash of the model bytes and of everything that can change the result of optimizing them:
+ * the session options and config entries, the execution providers and their options, the CPU features and the ORT
+ * version. External data files are not part of the key and must not change while the model is unchanged.
+ */
+class OptimizedModelCache {
+ public:
+  OptimizedModelCache(std::filesystem::path cache_dir, uint64_t max_size_in_bytes, const logging::Logger& logger);
+
+  static std::string HashModelBytes(const void* model_data, size_t model_data_len);
+  static Status HashModelFile(const PathString& model_path, std::string& model_hash);
+
+  std::filesystem::path GetEntryPath(const std::string& model_hash, const SessionOptions& session_options,
+                                     const InlinedHashSet<std::string>& optimizers_to_disable,
+                                     const ExecutionProviders& execution_providers) const;
+
+  // Returns true if the entry exists, and marks it as recently used.
+  bool Lookup(const std::filesystem::path& entry_path) const;
+
+  // Removes an entry that could not be loaded.
+  void Remove(const std::filesystem::path& entry_path) const;
+
+  // Writes a new entry with save_model to a temporary file that is then renamed, so concurrent sessions never see a
+  // partially written entry. Afterwards, the least recently used entries are removed until the cache fits its size
+  // limit.
+  Status Store(const std::filesystem::path& entry_path,
+               const std::function<Status(const std::filesystem::path&)>& save_model) const;
+
+ private:
+  void Evict(const std::filesystem::path& new_entry_path) const;
+
+  std::filesystem::path cache_dir_;
+  uint64_t max_size_in_bytes_;
+  const logging::Logger& logger_;
+};
+
+}  // namespace onnxruntime
+
+#endif  // !defined(ORT_MINIMAL_BUILD)
@@ -0,0 +1,188 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#if !defined(ORT_MINIMAL_BUILD)
+
+#include "core/session/shape_specialization.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "core/common/logging/logging.h"
+#include "core/framework/tensor.h"
+#include "core/graph/node_arg.h"
+#include "core/session/inference_session.h"
+
+namespace onnxruntime {
+
+namespace {
+
+// Limit on the number of distinct shapes that are counted, so models with many different shapes do not grow the
+// counters without bound. Shapes seen after the limit was reached are not counted.
+constexpr size_t kMaxTrackedShapes = 256;
+
+std::string ToString(const std::vector<std::string>& dim_params, const std::vector<int64_t>& dim_values) {
+  std::ostringstream ss;
+  for (size_t i = 0; i < dim_params.size(); ++i) {
+    ss << (i > 0 ? ", " : "") << dim_params[i] << "=" << dim_values[i];
+  }
+  return ss.str();
+}
+
+}  // namespace
+
+ShapeSpecializations::ShapeSpecializations(gsl::span<const NodeArg* const> model_inputs, size_t min_run_count,
+                                           size_t max_sessions, CreateSessionFn create_session,
+                                           const logging::Logger& logger)
+    : min_run_count_(min_run_count),
+      max_sessions_(max_sessions),
+      create_session_(std::move(create_session)),
+      logger_(logger) {
+  ORT_ENFORCE(min_run_count_ > 0, "The minimum run count must be positive.");
+
+  for (const NodeArg* input : model_inputs) {
+    const auto* shape = input->Shape();
+    if (shape == nullptr) {
+      continue;
+    }
+
+    for (int i = 0; i < shape->dim_size(); ++i) {
+      const auto& dim = shape->dim(i);
+      if (!dim.has_dim_param() || dim.dim_param().empty()) {
+        continue;
+      }
+
+      auto param = std::find(dim_params_.begin(), dim_params_.end(), dim.dim_param());
+      if (param == dim_params_.end()) {
+        param = dim_params_.insert(dim_params_.end(), dim.dim_param());
+      }
+
+      symbolic_dims_.push_back({input->Name(), static_cast<size_t>(i),
+                                static_cast<size_t>(param - dim_params_.begin())});
+    }
+  }
+}
+
+bool ShapeSpecializations::HasSymbolicDims(gsl::span<const NodeArg* const> model_inputs) {
+  return std::any_of(model_inputs.begin(), model_inputs.end(), [](const NodeArg* input) {
+    const auto* shape = input->Shape();
+    return shape != nullptr && std::any_of(shape->dim().begin(), shape->dim().end(), [](const auto& dim) {
+             return dim.has_dim_param() && !dim.dim_param().empty();
+           });
+  });
+}
+
+bool ShapeSpecializations::GetDimValues(gsl::span<const std::string> feed_names, gsl::span<const OrtValue> feeds,
+                                        std::vector<int64_t>& dim_values) const {
+  constexpr int64_t kUnset = -1;
+  dim_values.assign(dim_params_.size(), kUnset);
+
+  for (const auto& symbolic_dim : symbolic_dims_) {
+    auto feed_name = std::find(feed_names.begin(), feed_names.end(), symbolic_dim.input_name);
+    if (feed_name == feed_names.end()) {
+      return false;
+    }
+
+    const OrtValue& feed = feeds[static_cast<size_t>(feed_name - feed_names.begin())];
+    if (!feed.IsTensor()) {
+      return false;
+    }
+
+    const auto& shape = feed.Get<Tensor>().Shape();
+    if (symbolic_dim.dim_index >= shape.NumDimensions()) {
+      return false;
+    }
+
+    int64_t& value = dim_values[symbolic_dim.param_index];
+    const int64_t feed_value = shape[symbolic_dim.dim_index];
+    if (value != kUnset && value != feed_value) {
+      return false;
+    }
+    value = feed_value;
+  }
+
+  return true;
+}
+
+InferenceSession* ShapeSpecializations::GetSession(gsl::span<const std::string> feed_names,
+                                                   gsl::span<const OrtValue> feeds) {
+  std::vector<int64_t> dim_values;
+  if (!GetDimValues(feed_names, feeds, dim_values)) {
+    return nullptr;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto session = sessions_.find(dim_values);
+    if (session != sessions_.end()) {
+      return session->second.get();
+    }
+
+    if (requested_.size() >= max_sessions_ || requested_.count(dim_values) != 0) {
+      return nullptr;
+    }
+
+    auto run_count = run_counts_.find(dim_values);
+    if (run_count == run_counts_.end()) {
+      if (run_counts_.size() >= kMaxTrackedShapes) {
+        return nullptr;
+      }
+      run_count = run_counts_.emplace(dim_values, 0).first;
+    }
+
+    if (++run_count->second < min_run_count_) {
+      return nullptr;
+    }
+
+    run_counts_.erase(run_count);
+    requested_.insert(dim_values);
+  }
+
+  return CreateSession(std::move(dim_values));
+}
+
+const InferenceSession* ShapeSpecializations::FindSession(gsl::span<const std::string> feed_names,
+                                                          gsl::span<const OrtValue> feeds) const {
+  std::vector<int64_t> dim_values;
+  if (!GetDimValues(feed_names, feeds, dim_values)) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto session = sessions_.find(dim_values);
+  return session != sessions_.end() ? session->second.get() : nullptr;
+}
+
+InferenceSession* ShapeSpecializations::CreateSession(std::vector<int64_t> dim_values) {
+  std::vector<FreeDimensionOverride> overrides;
+  overrides.reserve(dim_params_.size());
+  for (size_t i = 0; i < dim_params_.size(); ++i) {
+    overrides.push_back({dim_params_[i], onnxruntime::FreeDimensionOverrideType::Name, dim_values[i]});
+  }
+
+  std::unique_ptr<InferenceSession> session;
+  Status status;
+  ORT_TRY {
+    status = create_session_(overrides, session);
+  }
+  ORT_CATCH(const std::exception& ex) {
+    ORT_HANDLE_EXCEPTION([&]() {
+      status = ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, ex.what());
+    });
+  }
+
+  // A shape whose session failed stays in requested_, so it is not tried again.
+  if (!status.IsOK()) {
+    LOGS(logger_, WARNING) << "Failed to create the session specialized for " << ToString(dim_params_, dim_values)
+                           << ": " << status.ErrorMessage();
+    return nullptr;
+  }
+
+  LOGS(logger_, INFO) << "Created the session specialized for " << ToString(dim_params_, dim_values);
+  std::lock_guard<std::mutex> lock(mutex_);
+  return sessions_.emplace(std::move(dim_values), std::move(session)).first->second.get();
+}
+
+}  // namespace onnxruntime
+
+#endif  // !defined(ORT_MINIMAL_BUILD)
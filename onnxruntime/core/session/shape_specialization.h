@@ -0,0 +1,94 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#if !defined(ORT_MINIMAL_BUILD)
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gsl/gsl>
+
+#include "core/common/common.h"
+#include "core/framework/ort_value.h"
+#include "core/framework/session_options.h"
+
+namespace onnxruntime {
+
+class InferenceSession;
+class NodeArg;
+
+namespace logging {
+class Logger;
+}
+
+/**
+ * Sessions specialized for frequently seen values of the symbolic dimensions of the model inputs. Enabled by the
+ * kOrtSessionOptionsShapeSpecializationMinRunCount session config entry.
+ *
+ * The Runs of the generic session are counted per combination of values of the symbolic dimensions. The Run that
+ * reaches the minimum count for a combination creates a session that overrides the free dimensions with these values,
+ * so constant folding, shape dependent fusions and memory planning see fixed shapes, and is executed by it. Concurrent
+ * Runs with the same values use the generic session until it is created. The specialized sessions share the
+ * initializers, pre-packed weights and thread pools of the generic session, see InferenceSession.
+ */
+class ShapeSpecializations {
+ public:
+  // Create and initialize a session for the model with the given free dimension overrides.
+  using CreateSessionFn = std::function<Status(const std::vector<FreeDimensionOverride>& free_dimension_overrides,
+                                               std::unique_ptr<InferenceSession>& session)>;
+
+  ShapeSpecializations(gsl::span<const NodeArg* const> model_inputs, size_t min_run_count, size_t max_sessions,
+                       CreateSessionFn create_session, const logging::Logger& logger);
+
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(ShapeSpecializations);
+
+  // Whether any of the model inputs has a symbolic dimension.
+  static bool HasSymbolicDims(gsl::span<const NodeArg* const> model_inputs);
+
+  // Returns the session specialized for the shapes of the feeds, or nullptr if the generic session should run them.
+  // Counts the Run, and creates the specialized session if the Run reaches the minimum count.
+  InferenceSession* GetSession(gsl::span<const std::string> feed_names, gsl::span<const OrtValue> feeds);
+
+  // Returns the session specialized for the shapes of the feeds if it was created, without counting a Run.
+  const InferenceSession* FindSession(gsl::span<const std::string> feed_names,
+                                      gsl::span<const OrtValue> feeds) const;
+
+ private:
+  struct SymbolicDim {
+    std::string input_name;
+    size_t dim_index;
+    size_t param_index;  // index in dim_params_
+  };
+
+  // Values of dim_params_ for the feeds. Returns false if a feed is missing or not a tensor, or the values of a
+  // dimension parameter do not agree, in which case the generic session handles the Run.
+  bool GetDimValues(gsl::span<const std::string> feed_names, gsl::span<const OrtValue> feeds,
+                    std::vector<int64_t>& dim_values) const;
+
+  // Called without holding mutex_, so Runs with other shapes are not blocked while the session is initialized.
+  InferenceSession* CreateSession(std::vector<int64_t> dim_values);
+
+  std::vector<std::string> dim_params_;
+  std::vector<SymbolicDim> symbolic_dims_;
+  const size_t min_run_count_;
+  const size_t max_sessions_;
+  const CreateSessionFn create_session_;
+  const logging::Logger& logger_;
+
+  mutable std::mutex mutex_;
+  std::map<std::vector<int64_t>, size_t> run_counts_;
+  // Shapes whose session was created, is being created or failed to be created.
+  std::set<std::vector<int64_t>> requested_;
+  std::map<std::vector<int64_t>, std::unique_ptr<InferenceSession>> sessions_;
+};
+
+}  // namespace onnxruntime
+
+#endif  // !defined(ORT_MINIMAL_BUILD)
@@ -1,15 +1,22 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include "gtest/gtest.h"
 #include <gsl/gsl>
+#include "core/framework/allocator.h"
 #include "core/session/onnxruntime_cxx_api.h"
 #include "test/common/cuda_op_test_utils.h"
+#include "test/contrib_ops/gpt_subgraph_test_utils.h"
 #include "test/providers/model_tester.h"
+#include "test/providers/provider_test_utils.h"
+#include "test/util/include/asserts.h"
 #include "test/util/include/current_test_name.h"
+#include "test/util/include/default_providers.h"
 #include "test/util/include/scoped_env_vars.h"
+#include "contrib_ops/cpu/transformers/generation_device_helper.h"
 #include "contrib_ops/cpu/transformers/generation_shared.h"
 
 #ifdef USE_CUDA
@@ -454,5 +461,99 @@ TEST(BeamSearchTest, DummyT5PointerGenerator) {
   tester.RunWithConfig();
 }
 
+// Hand-computed tables for 2 batches of 2 beams after a prompt of 1 token.
+TEST(BeamSearchTest, UpdateCacheIndirection) {
+  constexpr int kBatchSize = 2;
+  constexpr int kNumBeams = 2;
+  constexpr int kMaxSequenceLength = 5;
+  constexpr int kInputSequenceLength = 1;
+
+  AllocatorPtr allocator = std::make_shared<CPUAllocator>();
+  OrtValue cache_indirection;
+  Tensor::InitOrtValue(DataTypeImpl::GetType<int32_t>(), TensorShape({kBatchSize, kNumBeams, kMaxSequenceLength}),
+                       allocator, cache_indirection);
+  auto* data = cache_indirection.GetMutable<Tensor>()->MutableData<int32_t>();
+  std::fill_n(data, kBatchSize * kNumBeams * kMaxSequenceLength, 0);
+
+  // Beam indices are over all the beams of the batch, and expected rows are [b, i, 0:current_length].
+  const std::vector<std::vector<int32_t>> steps_beam_indices = {{1, 1, 3, 2}, {1, 0, 2, 2}, {0, 0, 3, 2}};
+  const std::vector<std::vector<std::vector<int32_t>>> steps_expected = {
+      {{0, 0}, {0, 1}, {0, 0}, {0, 1}},
+      {{0, 1, 0}, {0, 0, 1}, {0, 0, 0}, {0, 0, 1}},
+      {{0, 1, 0, 0}, {0, 1, 0, 1}, {0, 0, 1, 0}, {0, 0, 0, 1}}};
+
+  for (size_t step = 0; step < steps_beam_indices.size(); step++) {
+    const int current_length = kInputSequenceLength + static_cast<int>(step) + 1;
+    ASSERT_STATUS_OK(contrib::GenerationCpuDeviceHelper::UpdateCacheIndirection(
+        allocator, cache_indirection, steps_beam_indices[step], kNumBeams, kInputSequenceLength, current_length));
+
+    const int32_t* table = cache_indirection.Get<Tensor>().Data<int32_t>();
+    for (int row = 0; row < kBatchSize * kNumBeams; row++) {
+      const std::vector<int32_t> actual(table + row * kMaxSequenceLength,
+                                        table + row * kMaxSequenceLength + current_length);
+      EXPECT_EQ(actual, steps_expected[step][row]) << "step " << step << " row " << row;
+    }
+  }
+}
+
+namespace {
+
+// Runs BeamSearch on CPU and returns its sequences and sequences_scores.
+std::vector<OrtValue> RunTinyGptBeamSearch(bool use_decoder_masked_attention) {
+  constexpr int64_t kBatchSize = 2;
+  constexpr int kNumBeams = 4;
+  constexpr int64_t kNumReturnSequences = 2;
+
+  OpTester tester("BeamSearch", 1, kMSDomain);
+  tester.AddAttribute<int64_t>("eos_token_id", kTinyGptVocabSize - 1);
+  tester.AddAttribute<int64_t>("pad_token_id", 0);
+  tester.AddAttribute<int64_t>("model_type", 0);
+  tester.AddAttribute("decoder", CreateTinyGptSubgraph(use_decoder_masked_attention));
+
+  tester.AddInput<int32_t>("input_ids", {kBatchSize, 1}, {3, 7});
+  tester.AddInput<int32_t>("max_length", {1}, {kTinyGptMaxLength});
+  tester.AddInput<int32_t>("min_length", {1}, {1});
+  tester.AddInput<int32_t>("num_beams", {1}, {kNumBeams});
+  tester.AddInput<int32_t>("num_return_sequences", {1}, {static_cast<int32_t>(kNumReturnSequences)});
+  tester.AddInput<float>("length_penalty", {1}, {1.0f});
+  tester.AddInput<float>("repetition_penalty", {1}, {1.0f});
+
+  // The outputs are compared between the runs, so the expected values are not checked.
+  tester.AddOutput<int32_t>("sequences", {kBatchSize, kNumReturnSequences, kTinyGptMaxLength},
+                            std::vector<int32_t>(kBatchSize * kNumReturnSequences * kTinyGptMaxLength));
+  tester.AddOutput<float>("sequences_scores", {kBatchSize, kNumReturnSequences},
+                          std::vector<float>(kBatchSize * kNumReturnSequences));
+
+  std::vector<OrtValue> outputs;
+  tester.SetCustomOutputVerifier([&outputs](const std::vector<OrtValue>& fetches, const std::string& /*provider*/) {
+    outputs = fetches;
+  });
+  tester.ConfigEp(DefaultCpuExecutionProvider()).RunWithConfig();
+  return outputs;
+}
+
+}  // namespace
+
+// Reordering beams through the cache indirection of a shared past/present buffer gives the same sequences and
+// scores as copying the past state of the selected beams.
+TEST(BeamSearchTest, GptDecoderMaskedAttentionSharedBufferCpu) {
+  const std::vector<OrtValue> expected = RunTinyGptBeamSearch(false);
+  const std::vector<OrtValue> actual = RunTinyGptBeamSearch(true);
+  ASSERT_EQ(expected.size(), 2u);
+  ASSERT_EQ(actual.size(), 2u);
+
+  const auto expected_sequences = expected[0].Get<Tensor>().DataAsSpan<int32_t>();
+  const auto actual_sequences = actual[0].Get<Tensor>().DataAsSpan<int32_t>();
+  EXPECT_EQ(std::vector<int32_t>(actual_sequences.begin(), actual_sequences.end()),
+            std::vector<int32_t>(expected_sequences.begin(), expected_sequences.end()));
+
+  const auto expected_scores = expected[1].Get<Tensor>().DataAsSpan<float>();
+  const auto actual_scores = actual[1].Get<Tensor>().DataAsSpan<float>();
+  ASSERT_EQ(actual_scores.size(), expected_scores.size());
+  for (size_t i = 0; i < expected_scores.size(); i++) {
+    EXPECT_NEAR(actual_scores[i], expected_scores[i], 1e-4f) << "sequence " << i;
+  }
+}
+
 }  // namespace test
 }  // namespace onnxruntime
@@ -897,6 +897,68 @@ static void TestDecoderMaskedMultiHeadAttention(bool is_cross_attn = true, bool
   }
 }
 
+// Cross-attention where key and value have one copy per batch entry that is shared by all of its beams.
+static void TestDecoderMaskedCrossAttentionWithSharedKV(bool use_mask) {
+  int batch_size = 2;
+  int beam_width = 3;
+  int kv_sequence_length = 5;
+  int head_size = 8;
+  int num_heads = 2;
+  int hidden_size = head_size * num_heads;
+  int batch_beam_size = batch_size * beam_width;
+  int kv_size = num_heads * kv_sequence_length * head_size;
+
+  OpTester tester("DecoderMaskedMultiHeadAttention", 1, onnxruntime::kMSDomain);
+  FixedPatternValueGenerator generator{};
+  tester.AddAttribute<int64_t>("num_heads", static_cast<int64_t>(num_heads));
+  tester.AddAttribute<int64_t>("output_qk", 1);
+
+  auto query = CreateRandom<float>(batch_beam_size * hidden_size);
+  auto key = CreateRandom<float>(batch_size * kv_size);
+  auto value = CreateRandom<float>(batch_size * kv_size);
+  tester.AddInput<float>("query", {batch_beam_size, 1, hidden_size}, query);
+  tester.AddInput<float>("key", {batch_size, num_heads, kv_sequence_length, head_size}, key);
+  tester.AddInput<float>("value", {batch_size, num_heads, kv_sequence_length, head_size}, value);
+
+  // The reference attends to key and value expanded for each beam, with the same mask for the beams of an entry.
+  std::vector<float> expanded_key;
+  std::vector<float> expanded_value;
+  std::vector<int32_t> mask_index(static_cast<size_t>(batch_beam_size) * kv_sequence_length, 1);
+  const std::vector<int64_t> batch_mask_dims = {batch_size, kv_sequence_length};
+  auto batch_mask = generator.Discrete<int32_t>(batch_mask_dims, AsSpan({0, 1}));
+  for (int b = 0; b < batch_beam_size; ++b) {
+    const int batch_index = b / beam_width;
+    expanded_key.insert(expanded_key.end(), key.begin() + batch_index * kv_size,
+                        key.begin() + (batch_index + 1) * kv_size);
+    expanded_value.insert(expanded_value.end(), value.begin() + batch_index * kv_size,
+                          value.begin() + (batch_index + 1) * kv_size);
+    if (use_mask) {
+      std::copy_n(batch_mask.begin() + batch_index * kv_sequence_length, kv_sequence_length,
+                  mask_index.begin() + b * kv_sequence_length);
+    }
+  }
+  if (use_mask) {
+    tester.AddInput<int32_t>("mask_index", {batch_beam_size, kv_sequence_length}, mask_index);
+  }
+
+  std::vector<float> empty_attention_bias;
+  auto output_qk = CalculateOutputQK(query, expanded_key, mask_index, empty_attention_bias, batch_beam_size,
+                                     num_heads, kv_sequence_length, kv_sequence_length, head_size);
+  auto softmax = Softmax_QK_Transpose<float>(output_qk.data(), batch_beam_size, num_heads, 1, kv_sequence_length);
+  auto output = CalculateOutput<float>(softmax, expanded_value, batch_beam_size, num_heads,
+                                       kv_sequence_length, kv_sequence_length, head_size);
+
+  tester.AddOutput<float>("output", {batch_beam_size, 1, hidden_size}, output);
+  tester.AddOptionalOutputEdge<float>();  // optional present_key
+  tester.AddOptionalOutputEdge<float>();  // optional present_value
+  tester.AddOutput<float>("qk", {batch_beam_size, num_heads, 1, kv_sequence_length}, output_qk);
+  tester.SetOutputTolerance(0.0001f, 0.0001f);
+
+  std::vector<std::unique_ptr<IExecutionProvider>> execution_providers;
+  execution_providers.push_back(DefaultCpuExecutionProvider());
+  tester.Run(OpTester::ExpectResult::kExpectSuccess, "", {}, nullptr, &execution_providers);
+}
+
 #ifdef USE_CUDA
 
 TEST(DecoderMaskedSelfAttentionTest, Test_fp32) {
@@ -933,5 +995,10 @@ TEST(DecoderMaskedMultiHeadAttentionTest, cpu_self_attn_fp32) {
   TestDecoderMaskedMultiHeadAttention<float>(/* is_cross_attn = */ false, /* use_cuda = */ false);
 }
 
+TEST(DecoderMaskedMultiHeadAttentionTest, cpu_cross_attn_shared_kv_fp32) {
+  TestDecoderMaskedCrossAttentionWithSharedKV(/* use_mask = */ false);
+  TestDecoderMaskedCrossAttentionWithSharedKV(/* use_mask = */ true);
+}
+
 }  // namespace test
 }  // namespace onnxruntime
@@ -0,0 +1,87 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cmath>
+
+#include "gtest/gtest.h"
+#include "test/providers/provider_test_utils.h"
+
+namespace onnxruntime {
+namespace test {
+
+TEST(FusedElementwiseOpTest, BroadcastChain) {
+  // Y = Relu((X + B) * C) - X
+  OpTester test("FusedElementwise", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("op_types", std::vector<std::string>{"Add", "Mul", "Relu", "Sub"});
+  test.AddAttribute("operands", std::vector<int64_t>{0, 1, 3, 2, 4, -1, 5, 0});
+  test.AddInput<float>("X", {2, 3}, {1.f, -2.f, 3.f, -4.f, 5.f, -6.f});
+  test.AddInput<float>("B", {3}, {0.5f, 1.f, -1.f});
+  test.AddInput<float>("C", {1}, {2.f});
+  test.AddOutput<float>("Y", {2, 3}, {2.f, 2.f, 1.f, 4.f, 7.f, 6.f});
+  test.Run();
+}
+
+TEST(FusedElementwiseOpTest, UnaryOps) {
+  // Y = Erf(Sqrt(Abs(Neg(Exp(Tanh(Sigmoid(X)))))))
+  const std::vector<float> x = {-3.f, -1.f, -0.25f, 0.f, 0.5f, 2.f};
+  std::vector<float> y;
+  for (float value : x) {
+    const float sigmoid = 1.f / (1.f + std::exp(-value));
+    y.push_back(std::erf(std::sqrt(std::abs(-std::exp(std::tanh(sigmoid))))));
+  }
+
+  OpTester test("FusedElementwise", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("op_types", std::vector<std::string>{"Sigmoid", "Tanh", "Exp", "Neg", "Abs", "Sqrt", "Erf"});
+  test.AddAttribute("operands", std::vector<int64_t>{0, -1, 1, -1, 2, -1, 3, -1, 4, -1, 5, -1, 6, -1});
+  test.AddInput<float>("X", {6}, x);
+  test.AddOutput<float>("Y", {6}, y);
+  test.Run();
+}
+
+TEST(FusedElementwiseOpTest, BlocksWrapAroundBroadcastInput) {
+  // The rows of B do not line up with the blocks the kernel processes.
+  constexpr int64_t rows = 3;
+  constexpr int64_t cols = 700;
+  std::vector<float> x(rows * cols);
+  std::vector<float> b(cols);
+  std::vector<float> y(rows * cols);
+  for (int64_t i = 0; i < cols; ++i) {
+    b[i] = static_cast<float>(i % 13) - 6.f;
+  }
+  for (int64_t i = 0; i < rows * cols; ++i) {
+    x[i] = static_cast<float>(i % 17) * 0.25f;
+    y[i] = (x[i] - b[i % cols]) / 2.f;
+  }
+
+  OpTester test("FusedElementwise", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("op_types", std::vector<std::string>{"Sub", "Div"});
+  test.AddAttribute("operands", std::vector<int64_t>{0, 1, 3, 2});
+  test.AddInput<float>("X", {rows, cols}, x);
+  test.AddInput<float>("B", {1, cols}, b);
+  test.AddInput<float>("C", {}, {2.f});
+  test.AddOutput<float>("Y", {rows, cols}, y);
+  test.Run();
+}
+
+TEST(FusedElementwiseOpTest, InnerBroadcastIsNotSupported) {
+  OpTester test("FusedElementwise", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("op_types", std::vector<std::string>{"Add", "Tanh"});
+  test.AddAttribute("operands", std::vector<int64_t>{0, 1, 2, -1});
+  test.AddInput<float>("X", {2, 1}, {1.f, 2.f});
+  test.AddInput<float>("B", {3}, {1.f, 2.f, 3.f});
+  test.AddOutput<float>("Y", {2, 3}, std::vector<float>(6, 0.f));
+  test.Run(OpTester::ExpectResult::kExpectFailure, "must match the trailing dimensions of the output shape");
+}
+
+TEST(FusedElementwiseOpTest, InvalidOperand) {
+  OpTester test("FusedElementwise", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("op_types", std::vector<std::string>{"Add"});
+  test.AddAttribute("operands", std::vector<int64_t>{0, 1});
+  test.AddInput<float>("X", {2}, {1.f, 2.f});
+  test.AddOutput<float>("Y", {2}, {0.f, 0.f});
+  test.Run(OpTester::ExpectResult::kExpectFailure, "Invalid operands for instruction 0");
+}
+
+}  // namespace test
+}  // namespace onnxruntime
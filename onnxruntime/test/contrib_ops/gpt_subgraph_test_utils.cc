@@ -0,0 +1,138 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "test/contrib_ops/gpt_subgraph_test_utils.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/graph/model.h"
+#include "test/util/include/asserts.h"
+#include "test/util/include/test_environment.h"
+
+namespace onnxruntime {
+namespace test {
+
+ONNX_NAMESPACE::GraphProto CreateTinyGptSubgraph(bool use_decoder_masked_attention) {
+  Model model("tiny gpt decoder", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+              {{kOnnxDomain, 17}, {kMSDomain, 1}}, {}, DefaultLoggingManager().DefaultLogger());
+  Graph& graph = model.MainGraph();
+
+  // Dimensions of -1 have no value.
+  auto tensor_type = [](int32_t elem_type, const std::vector<int64_t>& dims) {
+    ONNX_NAMESPACE::TypeProto type;
+    type.mutable_tensor_type()->set_elem_type(elem_type);
+    auto* shape = type.mutable_tensor_type()->mutable_shape();
+    for (int64_t dim : dims) {
+      auto* shape_dim = shape->add_dim();
+      if (dim >= 0) {
+        shape_dim->set_dim_value(dim);
+      }
+    }
+    return type;
+  };
+  constexpr int32_t kFloat = ONNX_NAMESPACE::TensorProto_DataType_FLOAT;
+  constexpr int32_t kInt32 = ONNX_NAMESPACE::TensorProto_DataType_INT32;
+  const ONNX_NAMESPACE::TypeProto int32_2d = tensor_type(kInt32, {-1, -1});
+  const ONNX_NAMESPACE::TypeProto past_type =
+      tensor_type(kFloat, {2, -1, kTinyGptNumHeads, -1, kTinyGptHeadSize});
+
+  std::mt19937 generator(17);
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  auto add_weight = [&](const std::string& name, const std::vector<int64_t>& dims, bool zero = false) {
+    ONNX_NAMESPACE::TensorProto tensor;
+    tensor.set_name(name);
+    tensor.set_data_type(kFloat);
+    int64_t size = 1;
+    for (int64_t dim : dims) {
+      tensor.add_dims(dim);
+      size *= dim;
+    }
+    for (int64_t i = 0; i < size; i++) {
+      tensor.add_float_data(zero ? 0.0f : distribution(generator));
+    }
+    graph.AddInitializedTensor(tensor);
+    return &graph.GetOrCreateNodeArg(name, nullptr);
+  };
+  auto add_axes = [&graph](const std::string& name) {
+    ONNX_NAMESPACE::TensorProto tensor;
+    tensor.set_name(name);
+    tensor.set_data_type(ONNX_NAMESPACE::TensorProto_DataType_INT64);
+    tensor.add_dims(1);
+    tensor.add_int64_data(0);
+    graph.AddInitializedTensor(tensor);
+    return &graph.GetOrCreateNodeArg(name, nullptr);
+  };
+  auto arg = [&graph](const std::string& name) { return &graph.GetOrCreateNodeArg(name, nullptr); };
+
+  NodeArg* input_ids = &graph.GetOrCreateNodeArg("input_ids", &int32_2d);
+  NodeArg* position_ids = &graph.GetOrCreateNodeArg("position_ids", &int32_2d);
+  NodeArg* attention_mask = &graph.GetOrCreateNodeArg("attention_mask", &int32_2d);
+  NodeArg* past = &graph.GetOrCreateNodeArg("past_0", &past_type);
+  const ONNX_NAMESPACE::TypeProto logits_type = tensor_type(kFloat, {-1, -1, kTinyGptVocabSize});
+  NodeArg* logits = &graph.GetOrCreateNodeArg("logits", &logits_type);
+  NodeArg* present = &graph.GetOrCreateNodeArg("present_0", &past_type);
+
+  // The weights are created in the same order for both variants, so they get the same values.
+  NodeArg* token_embedding = add_weight("wte", {kTinyGptVocabSize, kTinyGptHiddenSize});
+  NodeArg* position_embedding = add_weight("wpe", {kTinyGptMaxLength, kTinyGptHiddenSize});
+  NodeArg* qkv_weight = add_weight("qkv_weight", {kTinyGptHiddenSize, 3 * kTinyGptHiddenSize});
+  NodeArg* output_weight = add_weight("output_weight", {kTinyGptHiddenSize, kTinyGptVocabSize});
+
+  graph.AddNode("token_embedding", "Gather", "", {token_embedding, input_ids}, {arg("token_hidden")});
+  graph.AddNode("position_embedding", "Gather", "", {position_embedding, position_ids}, {arg("position_hidden")});
+  graph.AddNode("embedding", "Add", "", {arg("token_hidden"), arg("position_hidden")}, {arg("hidden")});
+
+  std::vector<const NodeArg*> inputs = {input_ids, position_ids, attention_mask, past};
+  if (use_decoder_masked_attention) {
+    const ONNX_NAMESPACE::TypeProto int32_1d = tensor_type(kInt32, {1});
+    NodeArg* past_sequence_length = &graph.GetOrCreateNodeArg("past_sequence_length", &int32_1d);
+    NodeArg* beam_width = &graph.GetOrCreateNodeArg("beam_width", &int32_1d);
+    const ONNX_NAMESPACE::TypeProto cache_indirection_type = tensor_type(kInt32, {-1, -1, -1});
+    NodeArg* cache_indirection = &graph.GetOrCreateNodeArg("cache_indirection", &cache_indirection_type);
+    inputs.insert(inputs.end(), {past_sequence_length, beam_width, cache_indirection});
+
+    graph.AddNode("qkv", "MatMul", "", {arg("hidden"), qkv_weight}, {arg("qkv")});
+    graph.AddNode("split_qkv", "Split", "", {arg("qkv")}, {arg("query"), arg("key"), arg("value")})
+        .AddAttribute("axis", static_cast<int64_t>(2));
+    graph.AddNode("split_past", "Split", "", {past}, {arg("past_key_4d"), arg("past_value_4d")})
+        .AddAttribute("axis", static_cast<int64_t>(0));
+    NodeArg* axes = add_axes("axes");
+    graph.AddNode("squeeze_past_key", "Squeeze", "", {arg("past_key_4d"), axes}, {arg("past_key")});
+    graph.AddNode("squeeze_past_value", "Squeeze", "", {arg("past_value_4d"), axes}, {arg("past_value")});
+
+    Node& attention = graph.AddNode(
+        "attention", "DecoderMaskedMultiHeadAttention", "",
+        {arg("query"), arg("key"), arg("value"), attention_mask, arg(""), arg("past_key"), arg("past_value"),
+         past_sequence_length, beam_width, cache_indirection},
+        {arg("attention_output"), arg("present_key"), arg("present_value")}, nullptr, kMSDomain);
+    attention.AddAttribute("num_heads", kTinyGptNumHeads);
+    attention.AddAttribute("past_present_share_buffer", static_cast<int64_t>(1));
+
+    graph.AddNode("unsqueeze_present_key", "Unsqueeze", "", {arg("present_key"), axes}, {arg("present_key_5d")});
+    graph.AddNode("unsqueeze_present_value", "Unsqueeze", "", {arg("present_value"), axes},
+                  {arg("present_value_5d")});
+    graph.AddNode("present", "Concat", "", {arg("present_key_5d"), arg("present_value_5d")}, {present})
+        .AddAttribute("axis", static_cast<int64_t>(0));
+  } else {
+    NodeArg* qkv_bias = add_weight("qkv_bias", {3 * kTinyGptHiddenSize}, true);
+    Node& attention = graph.AddNode("attention", "Attention", "",
+                                    {arg("hidden"), qkv_weight, qkv_bias, attention_mask, past},
+                                    {arg("attention_output"), present}, nullptr, kMSDomain);
+    attention.AddAttribute("num_heads", kTinyGptNumHeads);
+    attention.AddAttribute("unidirectional", static_cast<int64_t>(1));
+  }
+
+  graph.AddNode("residual", "Add", "", {arg("hidden"), arg("attention_output")}, {arg("residual_output")});
+  graph.AddNode("logits", "MatMul", "", {arg("residual_output"), output_weight}, {logits});
+
+  graph.SetInputs(inputs);
+  graph.SetOutputs({logits, present});
+  EXPECT_STATUS_OK(graph.Resolve());
+  return graph.ToGraphProto();
+}
+
+
+}  // namespace test
+}  // namespace onnxruntime
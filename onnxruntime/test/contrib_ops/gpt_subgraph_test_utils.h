@@ -0,0 +1,28 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "core/graph/onnx_protobuf.h"
+
+namespace onnxruntime {
+namespace test {
+
+constexpr int64_t kTinyGptVocabSize = 16;
+constexpr int64_t kTinyGptNumHeads = 2;
+constexpr int64_t kTinyGptHeadSize = 4;
+constexpr int64_t kTinyGptHiddenSize = kTinyGptNumHeads * kTinyGptHeadSize;
+constexpr int kTinyGptMaxLength = 10;  // number of position embeddings
+
+// Creates the decoder subgraph of a GPT model with one attention layer, for BeamSearch, GreedySearch and Sampling.
+// The random weights are the same for both attention variants.
+//
+// With use_decoder_masked_attention, past and present share a buffer of max_length, beams are reordered through the
+// cache indirection of DecoderMaskedMultiHeadAttention, and the prompt must be one token long. Otherwise the
+// unidirectional Attention op grows the past state and takes prompts of any length.
+ONNX_NAMESPACE::GraphProto CreateTinyGptSubgraph(bool use_decoder_masked_attention);
+
+}  // namespace test
+}  // namespace onnxruntime
@@ -2,11 +2,19 @@
 // Licensed under the MIT License.
 
 #include <memory>
+#include <string>
 #include <vector>
 #include "gtest/gtest.h"
 #include <gsl/gsl>
+#include "core/graph/model.h"
 #include "core/session/onnxruntime_cxx_api.h"
 #include "test/common/cuda_op_test_utils.h"
+#include "test/contrib_ops/gpt_subgraph_test_utils.h"
+#include "test/framework/test_utils.h"
+#include "test/util/include/asserts.h"
+#include "test/util/include/inference_session_wrapper.h"
+#include "test/util/include/test_environment.h"
+#include "contrib_ops/cpu/transformers/greedy_search.h"
 
 #ifdef USE_CUDA
 #include "core/providers/cuda/cuda_provider_options.h"
@@ -183,5 +191,121 @@ TEST(GreedySearchTest, GptGreedySearchFp32) {
   }
 }
 
+namespace {
+
+constexpr int64_t kPrefixCacheBatchSize = 2;
+constexpr int64_t kPrefixCachePromptLength = 5;
+
+// Runs GreedySearch over the tiny GPT decoder for each prompt in turn within one session, and returns the sequences
+// of each run and the statistics of the prefix cache. prefix_cache_max_bytes of 0 disables the cache.
+void RunTinyGptGreedySearch(const std::vector<std::vector<int32_t>>& prompts, int64_t prefix_cache_max_bytes,
+                            std::vector<std::vector<int32_t>>& sequences,
+                            contrib::transformers::PrefixKVCacheStats& stats) {
+  Model model("tiny gpt greedy search", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+              {{kOnnxDomain, 17}, {kMSDomain, 1}}, {}, DefaultLoggingManager().DefaultLogger());
+  Graph& graph = model.MainGraph();
+
+  ONNX_NAMESPACE::TypeProto int32_tensor;
+  int32_tensor.mutable_tensor_type()->set_elem_type(ONNX_NAMESPACE::TensorProto_DataType_INT32);
+  ONNX_NAMESPACE::TypeProto float_tensor;
+  float_tensor.mutable_tensor_type()->set_elem_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+  NodeArg* input_ids = &graph.GetOrCreateNodeArg("input_ids", &int32_tensor);
+  NodeArg* max_length = &graph.GetOrCreateNodeArg("max_length", &int32_tensor);
+  NodeArg* min_length = &graph.GetOrCreateNodeArg("min_length", &int32_tensor);
+  NodeArg* repetition_penalty = &graph.GetOrCreateNodeArg("repetition_penalty", &float_tensor);
+  NodeArg* output = &graph.GetOrCreateNodeArg("sequences", &int32_tensor);
+
+  Node& node = graph.AddNode("greedy_search", "GreedySearch", "",
+                             {input_ids, max_length, min_length, repetition_penalty}, {output}, nullptr, kMSDomain);
+  node.AddAttribute("decoder", CreateTinyGptSubgraph(false));
+  node.AddAttribute("eos_token_id", kTinyGptVocabSize - 1);
+  node.AddAttribute("pad_token_id", static_cast<int64_t>(0));
+  node.AddAttribute("model_type", static_cast<int64_t>(0));
+  node.AddAttribute("prefix_cache_max_bytes", prefix_cache_max_bytes);
+  node.AddAttribute("prefix_cache_block_size", static_cast<int64_t>(2));
+  ASSERT_STATUS_OK(graph.Resolve());
+
+  std::string model_data;
+  ASSERT_TRUE(model.ToProto().SerializeToString(&model_data));
+  SessionOptions so;
+  InferenceSessionWrapper session{so, GetEnvironment()};
+  ASSERT_STATUS_OK(session.Load(model_data.data(), static_cast<int>(model_data.size())));
+  ASSERT_STATUS_OK(session.Initialize());
+
+  AllocatorPtr allocator = TestCPUExecutionProvider()->CreatePreferredAllocators()[0];
+  const std::vector<std::string> output_names = {"sequences"};
+  sequences.clear();
+  for (const std::vector<int32_t>& prompt : prompts) {
+    NameMLValMap feeds;
+    CreateMLValue<int32_t>(allocator, {kPrefixCacheBatchSize, kPrefixCachePromptLength}, gsl::make_span(prompt),
+                           &feeds["input_ids"]);
+    CreateMLValue<int32_t>(allocator, {1}, {kTinyGptMaxLength}, &feeds["max_length"]);
+    CreateMLValue<int32_t>(allocator, {1}, {1}, &feeds["min_length"]);
+    CreateMLValue<float>(allocator, {1}, {1.0f}, &feeds["repetition_penalty"]);
+
+    std::vector<OrtValue> fetches;
+    ASSERT_STATUS_OK(session.Run(RunOptions{}, feeds, output_names, &fetches));
+    const auto result = fetches[0].Get<Tensor>().DataAsSpan<int32_t>();
+    sequences.emplace_back(result.begin(), result.end());
+  }
+
+  const Node* greedy_search = nullptr;
+  for (const Node& session_node : session.GetGraph().Nodes()) {
+    if (session_node.OpType() == "GreedySearch") {
+      greedy_search = &session_node;
+    }
+  }
+  ASSERT_NE(greedy_search, nullptr);
+  const auto* kernel = static_cast<const contrib::transformers::GreedySearch*>(
+      session.GetSessionState().GetKernel(greedy_search->Index()));
+  if (prefix_cache_max_bytes > 0) {
+    ASSERT_NE(kernel->GetPrefixCache(), nullptr);
+    stats = kernel->GetPrefixCache()->GetStats();
+  } else {
+    EXPECT_EQ(kernel->GetPrefixCache(), nullptr);
+  }
+}
+
+}  // namespace
+
+// Prompts that start with a cached prefix generate the same sequences as without the cache, and the cache stays
+// within its memory limit by evicting the least recently used prefix.
+TEST(GreedySearchTest, GptPrefixCacheCpu) {
+  // Blocks of 2 tokens. Both rows of a prompt share their first 4 tokens, and the first row is cached.
+  const std::vector<std::vector<int32_t>> prompts = {
+      {1, 2, 3, 4, 5, 1, 2, 3, 4, 6},      // miss, caches 1 2 3 4
+      {1, 2, 3, 4, 7, 1, 2, 3, 4, 8},      // reuses 1 2 3 4
+      {1, 2, 9, 10, 11, 1, 2, 9, 10, 12},  // reuses 1 2, caches 1 2 9 10
+      {1, 2, 3, 4, 5, 1, 2, 3, 4, 6}};     // reuses 1 2 3 4 when it was not evicted
+
+  std::vector<std::vector<int32_t>> expected;
+  contrib::transformers::PrefixKVCacheStats stats;
+  RunTinyGptGreedySearch(prompts, 0, expected, stats);
+  ASSERT_EQ(expected.size(), prompts.size());
+
+  // An entry of 4 tokens holds the keys and values of one layer: 2 * 4 * hidden size floats.
+  constexpr size_t kEntryBytes = 2 * 4 * kTinyGptHiddenSize * sizeof(float);
+
+  std::vector<std::vector<int32_t>> actual;
+  RunTinyGptGreedySearch(prompts, 1 << 20, actual, stats);
+  EXPECT_EQ(actual, expected);
+  EXPECT_EQ(stats.lookups, 4u);
+  EXPECT_EQ(stats.hits, 3u);
+  EXPECT_EQ(stats.reused_tokens, 10u);
+  EXPECT_EQ(stats.insertions, 2u);
+  EXPECT_EQ(stats.evictions, 0u);
+  EXPECT_EQ(stats.bytes, 2 * kEntryBytes);
+
+  // With room for one entry, 1 2 9 10 evicts 1 2 3 4, so the last prompt only reuses 1 2 and evicts it back.
+  RunTinyGptGreedySearch(prompts, static_cast<int64_t>(kEntryBytes), actual, stats);
+  EXPECT_EQ(actual, expected);
+  EXPECT_EQ(stats.lookups, 4u);
+  EXPECT_EQ(stats.hits, 3u);
+  EXPECT_EQ(stats.reused_tokens, 8u);
+  EXPECT_EQ(stats.insertions, 3u);
+  EXPECT_EQ(stats.evictions, 2u);
+  EXPECT_EQ(stats.bytes, kEntryBytes);
+}
+
 }  // namespace test
 }  // namespace onnxruntime
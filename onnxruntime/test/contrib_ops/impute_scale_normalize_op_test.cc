@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <limits>
+
+#include "gtest/gtest.h"
+#include "test/providers/provider_test_utils.h"
+
+namespace onnxruntime {
+namespace test {
+
+TEST(ImputeScaleNormalizeOpTest, ImputeScaleL2) {
+  constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+  OpTester test("ImputeScaleNormalize", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("imputed_values", std::vector<float>{10.f, 20.f, 30.f});
+  test.AddAttribute("replaced_value", nan);
+  test.AddAttribute("offset", std::vector<float>{1.f, 2.f, 3.f});
+  test.AddAttribute("scale", std::vector<float>{0.5f, 1.f, 2.f});
+  test.AddAttribute("norm", std::string("L2"));
+  test.AddInput<float>("X", {2, 3}, {1.f, nan, 3.f, nan, 5.f, -2.f});
+  test.AddOutput<float>("Y", {2, 3}, {0.f, 1.f, 0.f, 0.39581955f, 0.26387970f, -0.87959899f});
+  test.Run();
+}
+
+TEST(ImputeScaleNormalizeOpTest, BroadcastScaleMax1D) {
+  OpTester test("ImputeScaleNormalize", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("offset", std::vector<float>{2.f});
+  test.AddAttribute("scale", std::vector<float>{0.25f});
+  test.AddAttribute("norm", std::string("MAX"));
+  test.AddInput<float>("X", {3}, {4.f, -2.f, 8.f});
+  test.AddOutput<float>("Y", {3}, {1.f / 3.f, -2.f / 3.f, 1.f});
+  test.Run();
+}
+
+TEST(ImputeScaleNormalizeOpTest, BroadcastImputeL1) {
+  OpTester test("ImputeScaleNormalize", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("imputed_values", std::vector<float>{4.f});
+  test.AddAttribute("replaced_value", 0.f);
+  test.AddAttribute("norm", std::string("L1"));
+  test.AddInput<float>("X", {3, 3}, {0.f, 2.f, 6.f, 0.f, 0.f, 0.f, 1.f, -3.f, 0.f});
+  test.AddOutput<float>("Y", {3, 3},
+                        {1.f / 3.f, 1.f / 6.f, 0.5f,
+                         1.f / 3.f, 1.f / 3.f, 1.f / 3.f,
+                         0.125f, -0.375f, 0.5f});
+  test.Run();
+}
+
+TEST(ImputeScaleNormalizeOpTest, ZeroRowIsNotNormalized) {
+  OpTester test("ImputeScaleNormalize", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("offset", std::vector<float>{1.f});
+  test.AddAttribute("scale", std::vector<float>{3.f});
+  test.AddAttribute("norm", std::string("L2"));
+  test.AddInput<float>("X", {2, 2}, {1.f, 1.f, 1.f, 2.f});
+  test.AddOutput<float>("Y", {2, 2}, {0.f, 0.f, 0.f, 1.f});
+  test.Run();
+}
+
+TEST(ImputeScaleNormalizeOpTest, InvalidScaleSize) {
+  OpTester test("ImputeScaleNormalize", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("offset", std::vector<float>{1.f, 2.f});
+  test.AddAttribute("scale", std::vector<float>{1.f, 2.f});
+  test.AddInput<float>("X", {1, 3}, {1.f, 2.f, 3.f});
+  test.AddOutput<float>("Y", {1, 3}, {0.f, 0.f, 0.f});
+  test.Run(OpTester::ExpectResult::kExpectFailure, "Either both scale and offset can be of feature size");
+}
+
+}  // namespace test
+}  // namespace onnxruntime
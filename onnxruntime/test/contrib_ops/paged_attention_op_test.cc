@@ -0,0 +1,316 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test/providers/provider_test_utils.h"
+
+namespace onnxruntime {
+namespace test {
+
+namespace {
+
+struct PagedAttentionTestCase {
+  int num_heads;
+  int kv_num_heads;
+  int head_size;
+  int block_size;
+  int num_blocks;
+  std::vector<int32_t> past_seqlens;
+  std::vector<int32_t> new_seqlens;
+  std::vector<int32_t> block_table;  // (batch_size, max_blocks_per_sequence)
+  int local_window_size = -1;
+};
+
+std::vector<float> MakeValues(size_t size, float seed) {
+  std::vector<float> values(size);
+  for (size_t i = 0; i < size; ++i) {
+    values[i] = std::sin(seed + 0.37f * static_cast<float>(i));
+  }
+  return values;
+}
+
+// Symmetric int8 quantization of each head of each row, matching the int8 caches of the kernel.
+void QuantizeRows(const float* x, size_t rows, int kv_num_heads, int head_size, int8_t* quantized, float* scales) {
+  for (size_t row = 0; row < rows * kv_num_heads; ++row) {
+    const float* head = x + row * head_size;
+    float max_abs = 0.f;
+    for (int i = 0; i < head_size; ++i) {
+      max_abs = std::max(max_abs, std::fabs(head[i]));
+    }
+    const float inverse_scale = max_abs > 0.f ? 127.f / max_abs : 0.f;
+    for (int i = 0; i < head_size; ++i) {
+      quantized[row * head_size + i] =
+          static_cast<int8_t>(std::min(127.f, std::max(-127.f, std::nearbyint(head[i] * inverse_scale))));
+    }
+    scales[row] = max_abs / 127.f;
+  }
+}
+
+void DequantizeRows(const int8_t* quantized, const float* scales, size_t rows, int kv_num_heads, int head_size,
+                    float* x) {
+  for (size_t row = 0; row < rows * kv_num_heads; ++row) {
+    for (int i = 0; i < head_size; ++i) {
+      x[row * head_size + i] = static_cast<float>(quantized[row * head_size + i]) * scales[row];
+    }
+  }
+}
+
+// Attention over contiguous per-sequence K/V, used as the reference for the paged kernel.
+void ReferenceAttention(const PagedAttentionTestCase& c, const std::vector<float>& query,
+                        const std::vector<std::vector<float>>& keys, const std::vector<std::vector<float>>& values,
+                        std::vector<float>& output) {
+  const int hidden_size = c.num_heads * c.head_size;
+  const int kv_hidden_size = c.kv_num_heads * c.head_size;
+  const int group = c.num_heads / c.kv_num_heads;
+  const float scale = 1.0f / std::sqrt(static_cast<float>(c.head_size));
+
+  int token = 0;
+  for (size_t b = 0; b < c.past_seqlens.size(); ++b) {
+    for (int s = 0; s < c.new_seqlens[b]; ++s, ++token) {
+      const int causal_length = c.past_seqlens[b] + s + 1;
+      const int start = c.local_window_size >= 0 ? std::max(0, causal_length - c.local_window_size - 1) : 0;
+      for (int h = 0; h < c.num_heads; ++h) {
+        const float* q = query.data() + token * hidden_size + h * c.head_size;
+        const int kv_offset = (h / group) * c.head_size;
+
+        std::vector<float> scores(causal_length - start);
+        float max_score = -INFINITY;
+        for (int j = start; j < causal_length; ++j) {
+          float dot = 0.f;
+          for (int d = 0; d < c.head_size; ++d) {
+            dot += q[d] * keys[b][j * kv_hidden_size + kv_offset + d];
+          }
+          scores[j - start] = dot * scale;
+          max_score = std::max(max_score, scores[j - start]);
+        }
+
+        float sum = 0.f;
+        for (auto& score : scores) {
+          score = std::exp(score - max_score);
+          sum += score;
+        }
+
+        float* out = output.data() + token * hidden_size + h * c.head_size;
+        for (int d = 0; d < c.head_size; ++d) {
+          float acc = 0.f;
+          for (int j = start; j < causal_length; ++j) {
+            acc += scores[j - start] / sum * values[b][j * kv_hidden_size + kv_offset + d];
+          }
+          out[d] = acc;
+        }
+      }
+    }
+  }
+}
+
+void RunPagedAttentionTest(const PagedAttentionTestCase& c, bool packed_qkv, bool quantized_cache = false) {
+  const int batch_size = static_cast<int>(c.past_seqlens.size());
+  const int max_blocks = static_cast<int>(c.block_table.size()) / batch_size;
+  const int hidden_size = c.num_heads * c.head_size;
+  const int kv_hidden_size = c.kv_num_heads * c.head_size;
+
+  std::vector<int32_t> cumulative_seqlens(batch_size + 1, 0);
+  for (int b = 0; b < batch_size; ++b) {
+    cumulative_seqlens[b + 1] = cumulative_seqlens[b] + c.new_seqlens[b];
+  }
+  const int token_count = cumulative_seqlens[batch_size];
+
+  const std::vector<float> query = MakeValues(static_cast<size_t>(token_count) * hidden_size, 0.1f);
+  const std::vector<float> key = MakeValues(static_cast<size_t>(token_count) * kv_hidden_size, 1.3f);
+  const std::vector<float> value = MakeValues(static_cast<size_t>(token_count) * kv_hidden_size, 2.9f);
+
+  // Slots that no sequence uses keep their value and must come out unchanged.
+  const size_t cache_slots = static_cast<size_t>(c.num_blocks) * c.block_size;
+  const size_t cache_size = cache_slots * kv_hidden_size;
+  const size_t scale_size = cache_slots * c.kv_num_heads;
+  const std::vector<float> key_cache = MakeValues(cache_size, 4.1f);
+  const std::vector<float> value_cache = MakeValues(cache_size, 5.7f);
+  std::vector<float> key_cache_out = key_cache;
+  std::vector<float> value_cache_out = value_cache;
+
+  // With int8 caches, key_cache_out and value_cache_out hold the dequantized values the kernel attends to.
+  std::vector<int8_t> key_cache_int8(quantized_cache ? cache_size : 0);
+  std::vector<int8_t> value_cache_int8(quantized_cache ? cache_size : 0);
+  std::vector<float> key_cache_scale(quantized_cache ? scale_size : 0);
+  std::vector<float> value_cache_scale(quantized_cache ? scale_size : 0);
+  if (quantized_cache) {
+    QuantizeRows(key_cache.data(), cache_slots, c.kv_num_heads, c.head_size, key_cache_int8.data(),
+                 key_cache_scale.data());
+    QuantizeRows(value_cache.data(), cache_slots, c.kv_num_heads, c.head_size, value_cache_int8.data(),
+                 value_cache_scale.data());
+    DequantizeRows(key_cache_int8.data(), key_cache_scale.data(), cache_slots, c.kv_num_heads, c.head_size,
+                   key_cache_out.data());
+    DequantizeRows(value_cache_int8.data(), value_cache_scale.data(), cache_slots, c.kv_num_heads, c.head_size,
+                   value_cache_out.data());
+  }
+  std::vector<int8_t> key_cache_int8_out = key_cache_int8;
+  std::vector<int8_t> value_cache_int8_out = value_cache_int8;
+  std::vector<float> key_cache_scale_out = key_cache_scale;
+  std::vector<float> value_cache_scale_out = value_cache_scale;
+
+  std::vector<std::vector<float>> keys(batch_size);
+  std::vector<std::vector<float>> values(batch_size);
+  for (int b = 0; b < batch_size; ++b) {
+    const int total_length = c.past_seqlens[b] + c.new_seqlens[b];
+    for (int position = 0; position < total_length; ++position) {
+      const size_t slot = static_cast<size_t>(c.block_table[b * max_blocks + position / c.block_size]) * c.block_size +
+                          position % c.block_size;
+      if (position >= c.past_seqlens[b]) {
+        const size_t token = static_cast<size_t>(cumulative_seqlens[b] + position - c.past_seqlens[b]);
+        if (quantized_cache) {
+          QuantizeRows(key.data() + token * kv_hidden_size, 1, c.kv_num_heads, c.head_size,
+                       key_cache_int8_out.data() + slot * kv_hidden_size,
+                       key_cache_scale_out.data() + slot * c.kv_num_heads);
+          QuantizeRows(value.data() + token * kv_hidden_size, 1, c.kv_num_heads, c.head_size,
+                       value_cache_int8_out.data() + slot * kv_hidden_size,
+                       value_cache_scale_out.data() + slot * c.kv_num_heads);
+          DequantizeRows(key_cache_int8_out.data() + slot * kv_hidden_size,
+                         key_cache_scale_out.data() + slot * c.kv_num_heads, 1, c.kv_num_heads, c.head_size,
+                         key_cache_out.data() + slot * kv_hidden_size);
+          DequantizeRows(value_cache_int8_out.data() + slot * kv_hidden_size,
+                         value_cache_scale_out.data() + slot * c.kv_num_heads, 1, c.kv_num_heads, c.head_size,
+                         value_cache_out.data() + slot * kv_hidden_size);
+        } else {
+          std::copy_n(key.begin() + token * kv_hidden_size, kv_hidden_size,
+                      key_cache_out.begin() + slot * kv_hidden_size);
+          std::copy_n(value.begin() + token * kv_hidden_size, kv_hidden_size,
+                      value_cache_out.begin() + slot * kv_hidden_size);
+        }
+      }
+      keys[b].insert(keys[b].end(), key_cache_out.begin() + slot * kv_hidden_size,
+                     key_cache_out.begin() + (slot + 1) * kv_hidden_size);
+      values[b].insert(values[b].end(), value_cache_out.begin() + slot * kv_hidden_size,
+                       value_cache_out.begin() + (slot + 1) * kv_hidden_size);
+    }
+  }
+
+  std::vector<float> output(static_cast<size_t>(token_count) * hidden_size);
+  ReferenceAttention(c, query, keys, values, output);
+
+  OpTester test("PagedAttention", 1, onnxruntime::kMSDomain);
+  test.AddAttribute<int64_t>("num_heads", c.num_heads);
+  test.AddAttribute<int64_t>("kv_num_heads", c.kv_num_heads);
+  test.AddAttribute<int64_t>("local_window_size", c.local_window_size);
+
+  if (packed_qkv) {
+    const int packed_size = hidden_size + 2 * kv_hidden_size;
+    std::vector<float> packed(static_cast<size_t>(token_count) * packed_size);
+    for (int t = 0; t < token_count; ++t) {
+      float* row = packed.data() + static_cast<size_t>(t) * packed_size;
+      std::copy_n(query.data() + static_cast<size_t>(t) * hidden_size, hidden_size, row);
+      std::copy_n(key.data() + static_cast<size_t>(t) * kv_hidden_size, kv_hidden_size, row + hidden_size);
+      std::copy_n(value.data() + static_cast<size_t>(t) * kv_hidden_size, kv_hidden_size,
+                  row + hidden_size + kv_hidden_size);
+    }
+    test.AddInput<float>("query", {token_count, packed_size}, packed);
+    test.AddOptionalInputEdge<float>();
+    test.AddOptionalInputEdge<float>();
+  } else {
+    test.AddInput<float>("query", {token_count, hidden_size}, query);
+    test.AddInput<float>("key", {token_count, kv_hidden_size}, key);
+    test.AddInput<float>("value", {token_count, kv_hidden_size}, value);
+  }
+
+  const std::vector<int64_t> cache_dims = {c.num_blocks, c.block_size, kv_hidden_size};
+  const std::vector<int64_t> scale_dims = {c.num_blocks, c.block_size, c.kv_num_heads};
+  if (quantized_cache) {
+    test.AddInput<int8_t>("key_cache", cache_dims, key_cache_int8);
+    test.AddInput<int8_t>("value_cache", cache_dims, value_cache_int8);
+  } else {
+    test.AddInput<float>("key_cache", cache_dims, key_cache);
+    test.AddInput<float>("value_cache", cache_dims, value_cache);
+  }
+  test.AddInput<int32_t>("cumulative_sequence_length", {batch_size + 1}, cumulative_seqlens);
+  test.AddInput<int32_t>("past_seqlens", {batch_size}, c.past_seqlens);
+  test.AddInput<int32_t>("block_table", {batch_size, max_blocks}, c.block_table);
+  if (quantized_cache) {
+    test.AddInput<float>("key_cache_scale", scale_dims, key_cache_scale);
+    test.AddInput<float>("value_cache_scale", scale_dims, value_cache_scale);
+  }
+
+  // The reference attends to the same dequantized values, so int8 caches only add float rounding differences.
+  test.AddOutput<float>("output", {token_count, hidden_size}, output, false, 1e-5f, 1e-5f);
+  if (quantized_cache) {
+    test.AddOutput<int8_t>("key_cache_out", cache_dims, key_cache_int8_out);
+    test.AddOutput<int8_t>("value_cache_out", cache_dims, value_cache_int8_out);
+    test.AddOutput<float>("key_cache_scale_out", scale_dims, key_cache_scale_out);
+    test.AddOutput<float>("value_cache_scale_out", scale_dims, value_cache_scale_out);
+  } else {
+    test.AddOutput<float>("key_cache_out", cache_dims, key_cache_out);
+    test.AddOutput<float>("value_cache_out", cache_dims, value_cache_out);
+  }
+  test.Run();
+}
+
+}  // namespace
+
+// Prompt, decode and chunked-prefill sequences packed together, with blocks scattered over the pool.
+TEST(PagedAttentionTest, MixedBatch) {
+  PagedAttentionTestCase c{4, 2, 8, 4, 12, {0, 5, 9}, {3, 1, 2}, {7, -1, -1, 2, 10, -1, 0, 11, 4}};
+  RunPagedAttentionTest(c, false);
+}
+
+TEST(PagedAttentionTest, MixedBatchPackedQKV) {
+  PagedAttentionTestCase c{4, 2, 8, 4, 12, {0, 5, 9}, {3, 1, 2}, {7, -1, -1, 2, 10, -1, 0, 11, 4}};
+  RunPagedAttentionTest(c, true);
+}
+
+TEST(PagedAttentionTest, MultiHeadDecode) {
+  PagedAttentionTestCase c{2, 2, 16, 2, 8, {6, 3}, {1, 1}, {5, 1, 6, 3, 0, 2, 4, 7}};
+  RunPagedAttentionTest(c, false);
+}
+
+TEST(PagedAttentionTest, LocalWindow) {
+  PagedAttentionTestCase c{4, 1, 4, 3, 6, {4, 0}, {2, 5}, {3, 5, -1, 0, 1, -1}};
+  c.local_window_size = 2;
+  RunPagedAttentionTest(c, false);
+}
+
+TEST(PagedAttentionTest, Int8Cache) {
+  PagedAttentionTestCase c{4, 2, 8, 4, 12, {0, 5, 9}, {3, 1, 2}, {7, -1, -1, 2, 10, -1, 0, 11, 4}};
+  RunPagedAttentionTest(c, false, true);
+  RunPagedAttentionTest(c, true, true);
+}
+
+TEST(PagedAttentionTest, Int8CacheRequiresScales) {
+  OpTester test("PagedAttention", 1, onnxruntime::kMSDomain);
+  test.AddAttribute<int64_t>("num_heads", 1);
+  test.AddAttribute<int64_t>("kv_num_heads", 1);
+  test.AddInput<float>("query", {1, 2}, {1.f, 2.f});
+  test.AddInput<float>("key", {1, 2}, {1.f, 2.f});
+  test.AddInput<float>("value", {1, 2}, {1.f, 2.f});
+  test.AddInput<int8_t>("key_cache", {1, 2, 2}, {0, 0, 0, 0});
+  test.AddInput<int8_t>("value_cache", {1, 2, 2}, {0, 0, 0, 0});
+  test.AddInput<int32_t>("cumulative_sequence_length", {2}, {0, 1});
+  test.AddInput<int32_t>("past_seqlens", {1}, {0});
+  test.AddInput<int32_t>("block_table", {1, 1}, {0});
+  test.AddOutput<float>("output", {1, 2}, {0.f, 0.f});
+  test.AddOutput<int8_t>("key_cache_out", {1, 2, 2}, {0, 0, 0, 0});
+  test.AddOutput<int8_t>("value_cache_out", {1, 2, 2}, {0, 0, 0, 0});
+  test.Run(OpTester::ExpectResult::kExpectFailure, "are required when the caches are int8");
+}
+
+TEST(PagedAttentionTest, BlockIdOutOfRange) {
+  OpTester test("PagedAttention", 1, onnxruntime::kMSDomain);
+  test.AddAttribute<int64_t>("num_heads", 1);
+  test.AddAttribute<int64_t>("kv_num_heads", 1);
+  test.AddInput<float>("query", {1, 2}, {1.f, 2.f});
+  test.AddInput<float>("key", {1, 2}, {1.f, 2.f});
+  test.AddInput<float>("value", {1, 2}, {1.f, 2.f});
+  test.AddInput<float>("key_cache", {1, 2, 2}, {0.f, 0.f, 0.f, 0.f});
+  test.AddInput<float>("value_cache", {1, 2, 2}, {0.f, 0.f, 0.f, 0.f});
+  test.AddInput<int32_t>("cumulative_sequence_length", {2}, {0, 1});
+  test.AddInput<int32_t>("past_seqlens", {1}, {0});
+  test.AddInput<int32_t>("block_table", {1, 1}, {3});
+  test.AddOutput<float>("output", {1, 2}, {0.f, 0.f});
+  test.AddOutput<float>("key_cache_out", {1, 2, 2}, {0.f, 0.f, 0.f, 0.f});
+  test.AddOutput<float>("value_cache_out", {1, 2, 2}, {0.f, 0.f, 0.f, 0.f});
+  test.Run(OpTester::ExpectResult::kExpectFailure, "is out of range");
+}
+
+}  // namespace test
+}  // namespace onnxruntime
@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "core/framework/allocator.h"
+#include "core/framework/tensor.h"
+#include "contrib_ops/cpu/transformers/prefix_kv_cache.h"
+
+namespace onnxruntime {
+namespace contrib {
+namespace transformers {
+namespace test {
+
+namespace {
+
+// Past state of one layer with a single head of size 1, where every value is set to value.
+std::vector<OrtValue> MakePresents(int64_t length, float value) {
+  OrtValue present;
+  Tensor::InitOrtValue(DataTypeImpl::GetType<float>(), TensorShape{2, 1, 1, length, 1},
+                       std::make_shared<CPUAllocator>(), present);
+  auto data = present.GetMutable<Tensor>()->MutableDataAsSpan<float>();
+  std::fill(data.begin(), data.end(), value);
+  return {present};
+}
+
+float FirstValue(const std::vector<OrtValue>& presents) {
+  return presents[0].Get<Tensor>().Data<float>()[0];
+}
+
+}  // namespace
+
+TEST(PrefixKVCacheTest, LookupFindsLongestBlockAlignedPrefix) {
+  PrefixKVCache cache(1024, 2);
+  const std::vector<int32_t> prompt = {1, 2, 3, 4, 5};
+  cache.Insert(prompt, MakePresents(4, 1.f));
+
+  std::vector<OrtValue> presents;
+  const std::vector<int32_t> same_start = {1, 2, 3, 4, 9, 9};
+  EXPECT_EQ(cache.Lookup(same_start, 5, presents), 4);
+  EXPECT_EQ(FirstValue(presents), 1.f);
+
+  // The match is limited by max_length and by the first block that differs.
+  EXPECT_EQ(cache.Lookup(same_start, 3, presents), 2);
+  const std::vector<int32_t> diverges = {1, 2, 3, 7, 5};
+  EXPECT_EQ(cache.Lookup(diverges, 5, presents), 2);
+
+  const std::vector<int32_t> other = {2, 1, 3, 4};
+  EXPECT_EQ(cache.Lookup(other, 4, presents), 0);
+
+  const PrefixKVCacheStats stats = cache.GetStats();
+  EXPECT_EQ(stats.lookups, 4u);
+  EXPECT_EQ(stats.hits, 3u);
+  EXPECT_EQ(stats.reused_tokens, 8u);
+  EXPECT_EQ(stats.insertions, 1u);
+}
+
+TEST(PrefixKVCacheTest, EvictsLeastRecentlyUsed) {
+  // Each entry of 2 tokens takes 16 bytes, so two of them fit.
+  PrefixKVCache cache(32, 2);
+  const std::vector<int32_t> a = {1, 1};
+  const std::vector<int32_t> b = {2, 2};
+  const std::vector<int32_t> c = {3, 3};
+  cache.Insert(a, MakePresents(2, 1.f));
+  cache.Insert(b, MakePresents(2, 2.f));
+
+  std::vector<OrtValue> presents;
+  EXPECT_EQ(cache.Lookup(a, 2, presents), 2);
+
+  cache.Insert(c, MakePresents(2, 3.f));
+  EXPECT_EQ(cache.Lookup(b, 2, presents), 0);
+  EXPECT_EQ(cache.Lookup(a, 2, presents), 2);
+  EXPECT_EQ(FirstValue(presents), 1.f);
+  EXPECT_EQ(cache.Lookup(c, 2, presents), 2);
+  EXPECT_EQ(FirstValue(presents), 3.f);
+  EXPECT_EQ(cache.GetStats().evictions, 1u);
+  EXPECT_EQ(cache.GetStats().bytes, 32u);
+
+  // An entry larger than the whole cache is not stored.
+  const std::vector<int32_t> long_prompt = {4, 4, 4, 4, 4, 4};
+  cache.Insert(long_prompt, MakePresents(6, 4.f));
+  EXPECT_EQ(cache.Lookup(long_prompt, 6, presents), 0);
+  EXPECT_EQ(cache.GetStats().evictions, 1u);
+  EXPECT_EQ(cache.GetStats().bytes, 32u);
+}
+
+}  // namespace test
+}  // namespace transformers
+}  // namespace contrib
+}  // namespace onnxruntime
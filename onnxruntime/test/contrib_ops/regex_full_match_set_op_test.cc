@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "gtest/gtest.h"
+#include "test/providers/provider_test_utils.h"
+
+namespace onnxruntime {
+namespace test {
+
+TEST(RegexFullMatchSetOpTest, MultiplePatterns) {
+  OpTester test("RegexFullMatchSet", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("patterns", std::vector<std::string>{R"(www\.[\w.-]+\.com)", R"(.*@(yahoo|gmail)\.com)",
+                                                         R"(www\..*)"});
+  test.AddInput<std::string>("X", {2, 2}, {"www.google.com", "account@gmail.com", "www.bbc.co.uk", "not email"});
+  test.AddOutput<bool>("Y0", {2, 2}, {true, false, false, false});
+  test.AddOutput<bool>("Y1", {2, 2}, {false, true, false, false});
+  test.AddOutput<bool>("Y2", {2, 2}, {true, false, true, false});
+  test.Run();
+}
+
+TEST(RegexFullMatchSetOpTest, MultibyteMatch) {
+  OpTester test("RegexFullMatchSet", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("patterns", std::vector<std::string>{R"(.*Grüßen$)", R"(^Понед.*)"});
+  test.AddInput<std::string>("X", {3}, {"Mit freundlichen Grüßen", "Понедельник", "недельник"});
+  test.AddOutput<bool>("Y0", {3}, {true, false, false});
+  test.AddOutput<bool>("Y1", {3}, {false, true, false});
+  test.Run();
+}
+
+TEST(RegexFullMatchSetOpTest, InvalidPattern) {
+  OpTester test("RegexFullMatchSet", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("patterns", std::vector<std::string>{"abc", "[a-z"});
+  test.AddInput<std::string>("X", {1}, {"abc"});
+  test.AddOutput<bool>("Y0", {1}, {true});
+  test.AddOutput<bool>("Y1", {1}, {false});
+  test.Run(OpTester::ExpectResult::kExpectFailure, "Invalid regex pattern: [a-z");
+}
+
+TEST(RegexFullMatchSetOpTest, PatternCountMismatch) {
+  OpTester test("RegexFullMatchSet", 1, onnxruntime::kMSDomain);
+  test.AddAttribute("patterns", std::vector<std::string>{"abc", "def"});
+  test.AddInput<std::string>("X", {1}, {"abc"});
+  test.AddOutput<bool>("Y0", {1}, {true});
+  test.Run(OpTester::ExpectResult::kExpectFailure, "must match the number of outputs");
+}
+
+}  // namespace test
+}  // namespace onnxruntime
@@ -0,0 +1,83 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "contrib_ops/cpu/transformers/sampling_cpu_helper.h"
+
+namespace onnxruntime {
+namespace contrib {
+namespace test {
+
+namespace {
+
+struct TestParameters : public transformers::IGenerationParameters {
+  TestParameters() {
+    filter_value = -std::numeric_limits<float>::infinity();
+    top_p = 1.0f;
+  }
+};
+
+std::vector<int32_t> Select(const std::vector<float>& probs, const TestParameters& parameters) {
+  std::vector<int32_t> candidates(probs.size());
+  const size_t kept = SamplingCpuHelper::SelectTokens<float>(probs, &parameters, candidates);
+  candidates.resize(kept);
+  std::sort(candidates.begin(), candidates.end());
+  return candidates;
+}
+
+}  // namespace
+
+TEST(SamplingCpuHelperTest, SelectTokensTopKAndMinP) {
+  const std::vector<float> probs = {0.05f, 0.4f, 0.1f, 0.3f, 0.15f};
+
+  TestParameters parameters;
+  parameters.top_k = 2;
+  EXPECT_EQ(Select(probs, parameters), (std::vector<int32_t>{1, 3}));
+
+  parameters.top_k = 0;
+  parameters.min_p = 0.3f;  // keeps tokens with probability >= 0.12
+  EXPECT_EQ(Select(probs, parameters), (std::vector<int32_t>{1, 3, 4}));
+}
+
+TEST(SamplingCpuHelperTest, SelectTokensTopP) {
+  const std::vector<float> probs = {0.05f, 0.4f, 0.1f, 0.3f, 0.15f};
+
+  TestParameters parameters;
+  parameters.top_p = 0.6f;
+  EXPECT_EQ(Select(probs, parameters), (std::vector<int32_t>{1, 3}));
+
+  // Custom sampling also keeps the token that crosses top_p.
+  parameters.custom_sampling = true;
+  parameters.top_p = 0.5f;
+  EXPECT_EQ(Select(probs, parameters), (std::vector<int32_t>{1, 3}));
+
+  // top_p is relative to the mass that top-k keeps.
+  parameters.custom_sampling = false;
+  parameters.top_k = 3;
+  parameters.top_p = 0.45f;
+  EXPECT_EQ(Select(probs, parameters), (std::vector<int32_t>{1}));
+
+  parameters.top_k = 0;
+  parameters.top_p = 0.0f;
+  parameters.min_tokens_to_keep = 3;
+  EXPECT_EQ(Select(probs, parameters), (std::vector<int32_t>{1, 3, 4}));
+}
+
+TEST(SamplingCpuHelperTest, FilterAndSample) {
+  std::vector<float> scores = {1.f, 2.f, 3.f, 4.f};
+  std::vector<int32_t> kept = {3, 1};
+  const float filter_value = -std::numeric_limits<float>::infinity();
+
+  // Token 1 has weight e^-2 of token 3, so draws below 1 / (1 + e^2) pick it.
+  EXPECT_EQ(SamplingCpuHelper::FilterAndSample<float>(scores, kept, filter_value, 0.1), 1);
+  EXPECT_EQ(scores, (std::vector<float>{filter_value, 2.f, filter_value, 4.f}));
+  EXPECT_EQ(SamplingCpuHelper::FilterAndSample<float>(scores, kept, filter_value, 0.5), 3);
+}
+
+}  // namespace test
+}  // namespace contrib
+}  // namespace onnxruntime
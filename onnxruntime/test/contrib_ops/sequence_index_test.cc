@@ -0,0 +1,184 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "contrib_ops/cpu/transformers/sequence_index.h"
+#include "contrib_ops/cpu/transformers/sequences.h"
+
+namespace onnxruntime {
+namespace contrib {
+namespace transformers {
+namespace test {
+
+namespace {
+
+std::set<int32_t> GetTokens(const SequenceIndex& index, int beam_index) {
+  std::set<int32_t> tokens;
+  index.ForEachToken(beam_index, [&tokens](int32_t token) { EXPECT_TRUE(tokens.insert(token).second); });
+  return tokens;
+}
+
+std::set<int32_t> GetBlockedTokens(const SequenceIndex& index, int beam_index) {
+  std::set<int32_t> tokens;
+  index.ForEachBlockedToken(beam_index, [&tokens](int32_t token) { tokens.insert(token); });
+  return tokens;
+}
+
+std::set<int32_t> ScanTokens(gsl::span<const int32_t> sequence) {
+  std::set<int32_t> tokens;
+  for (int32_t token : sequence) {
+    if (token >= 0) {
+      tokens.insert(token);
+    }
+  }
+  return tokens;
+}
+
+std::set<int32_t> ScanBlockedTokens(gsl::span<const int32_t> sequence, int ngram_size) {
+  std::set<int32_t> tokens;
+  const size_t prefix_length = static_cast<size_t>(ngram_size) - 1;
+  for (size_t j = 0; j + prefix_length < sequence.size(); ++j) {
+    if (std::equal(sequence.begin() + j, sequence.begin() + j + prefix_length, sequence.end() - prefix_length)) {
+      tokens.insert(sequence[j + prefix_length]);
+    }
+  }
+  return tokens;
+}
+
+}  // namespace
+
+TEST(SequenceIndexTest, KeepsDistinctTokens) {
+  const std::vector<int32_t> sequence = {3, -1, 3, 70};
+  SequenceIndex index(true, 0);
+  index.Start(1, [&sequence](int) { return gsl::make_span(sequence); });
+  EXPECT_EQ(GetTokens(index, 0), (std::set<int32_t>{3, 70}));
+
+  const std::vector<int32_t> next_tokens = {1};
+  index.AppendTokens(next_tokens);
+  index.AppendTokens(std::vector<int32_t>{70});
+  EXPECT_EQ(GetTokens(index, 0), (std::set<int32_t>{1, 3, 70}));
+}
+
+TEST(SequenceIndexTest, FindsRepeatingNGrams) {
+  const std::vector<int32_t> sequence = {1, 2, 3, 1, 2, 4, 1};
+  SequenceIndex index(false, 3);
+  index.Start(1, [&sequence](int) { return gsl::make_span(sequence); });
+  EXPECT_TRUE(GetBlockedTokens(index, 0).empty());
+
+  // After "1 2" the 3-grams "1 2 3" and "1 2 4" would repeat.
+  index.AppendTokens(std::vector<int32_t>{2});
+  EXPECT_EQ(GetBlockedTokens(index, 0), (std::set<int32_t>{3, 4}));
+}
+
+TEST(SequenceIndexTest, SharesHistoryOfSelectedBeams) {
+  const std::vector<int32_t> sequence = {5, 6};
+  SequenceIndex index(true, 2);
+  index.Start(2, [&sequence](int) { return gsl::make_span(sequence); });
+
+  // Both beams continue beam 0, and only the tokens of their own sequence are reported.
+  index.SelectBeams(std::vector<int32_t>{0, 0}, std::vector<int32_t>{5, 7});
+  EXPECT_EQ(GetTokens(index, 0), (std::set<int32_t>{5, 6}));
+  EXPECT_EQ(GetTokens(index, 1), (std::set<int32_t>{5, 6, 7}));
+  EXPECT_EQ(GetBlockedTokens(index, 0), (std::set<int32_t>{6}));
+  EXPECT_TRUE(GetBlockedTokens(index, 1).empty());
+}
+
+// The nodes of the beams that are not selected are dropped, so the index stays within twice the nodes of the
+// selected sequences instead of growing with every beam of every step.
+TEST(SequenceIndexTest, DropsUnselectedBeams) {
+  constexpr int kNumBeams = 4;
+  constexpr int kNumSteps = 1000;
+  constexpr int kNGramSize = 3;
+  const std::vector<int32_t> prompt = {1, 2};
+  SequenceIndex index(true, kNGramSize);
+  index.Start(kNumBeams, [&prompt](int) { return gsl::make_span(prompt); });
+
+  std::vector<std::vector<int32_t>> sequences(kNumBeams, prompt);
+  for (int step = 0; step < kNumSteps; step++) {
+    // Every beam continues beam 0, so the sequences of the other beams are no longer selected.
+    const std::vector<int32_t> beam_indices(kNumBeams, 0);
+    const std::vector<int32_t> next_tokens = {step % 7, 1, 2, 3};
+    index.SelectBeams(beam_indices, next_tokens);
+
+    const std::vector<int32_t> selected = sequences[0];
+    for (int i = 0; i < kNumBeams; i++) {
+      sequences[i] = selected;
+      sequences[i].push_back(next_tokens[i]);
+    }
+
+    // The root, the shared sequence of beam 0 and the last token of the other beams.
+    const size_t num_selected_nodes = 1 + prompt.size() + static_cast<size_t>(step) + kNumBeams;
+    ASSERT_LE(index.NumNodes(), std::max<size_t>(256, 2 * num_selected_nodes)) << "step " << step;
+
+    if (step % 100 == 99) {
+      for (int i = 0; i < kNumBeams; i++) {
+        EXPECT_EQ(GetTokens(index, i), ScanTokens(sequences[i])) << "step " << step << " beam " << i;
+        EXPECT_EQ(GetBlockedTokens(index, i), ScanBlockedTokens(sequences[i], kNGramSize))
+            << "step " << step << " beam " << i;
+      }
+    }
+  }
+
+  EXPECT_LT(index.NumNodes(), static_cast<size_t>(kNumBeams * kNumSteps / 2));
+}
+
+// The index of Sequences matches a scan of the sequences when beams are selected several times.
+TEST(SequenceIndexTest, FollowsSequencesWithDuplicatedBeams) {
+  constexpr int kBatchBeamSize = 3;
+  constexpr int kSequenceLength = 2;
+  constexpr int kMaxLength = 16;
+  constexpr int kNGramSize = 2;
+
+  std::vector<int32_t> buffer(2 * kBatchBeamSize * kMaxLength, 0);
+  for (int i = 0; i < kBatchBeamSize; i++) {
+    buffer[i * kMaxLength] = 1;
+    buffer[i * kMaxLength + 1] = 2;
+  }
+
+  Sequences sequences;
+  sequences.Init(buffer, kBatchBeamSize, kSequenceLength, kMaxLength);
+
+  IGenerationParameters parameters{};
+  parameters.repetition_penalty = 1.1f;
+  parameters.no_repeat_ngram_size = kNGramSize;
+  sequences.InitIndex(parameters);
+
+  auto check = [&sequences]() {
+    const SequenceIndex* index = sequences.GetIndex();
+    ASSERT_NE(index, nullptr);
+    for (int i = 0; i < kBatchBeamSize; i++) {
+      gsl::span<const int32_t> sequence = sequences.GetSequence(i);
+      EXPECT_EQ(GetTokens(*index, i), ScanTokens(sequence)) << "beam " << i;
+      EXPECT_EQ(GetBlockedTokens(*index, i), ScanBlockedTokens(sequence, kNGramSize)) << "beam " << i;
+    }
+  };
+
+  // The first append happens before the index is started, so it is picked up from the sequences.
+  const std::vector<std::vector<int32_t>> steps_beam_indices = {
+      {0, 0, 1}, {0, 0, 0}, {2, 1, 1}, {1, 1, 2}, {0, 2, 2}, {1, 0, 0}};
+  const std::vector<std::vector<int32_t>> steps_next_tokens = {
+      {3, 1, 2}, {1, 2, 3}, {2, 1, 3}, {3, 3, 1}, {2, 1, 2}, {2, 2, 3}};
+  for (size_t step = 0; step < steps_beam_indices.size(); step++) {
+    std::vector<int32_t> beam_indices = steps_beam_indices[step];
+    std::vector<int32_t> next_tokens = steps_next_tokens[step];
+    gsl::span<int32_t> beam_indices_span(beam_indices);
+    gsl::span<int32_t> next_tokens_span(next_tokens);
+    sequences.AppendNextTokenToSequences(beam_indices_span, next_tokens_span);
+    check();
+  }
+
+  // Greedy search appends to the first buffer, which is the current one after an even number of beam selections.
+  std::vector<int32_t> next_tokens = {4, 1, 2};
+  gsl::span<int32_t> next_tokens_span(next_tokens);
+  sequences.AppendNextTokenToSequences(next_tokens_span);
+  check();
+}
+
+}  // namespace test
+}  // namespace transformers
+}  // namespace contrib
+}  // namespace onnxruntime
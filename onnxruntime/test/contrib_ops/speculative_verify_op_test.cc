@@ -0,0 +1,94 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "gtest/gtest.h"
+#include "test/providers/provider_test_utils.h"
+
+namespace onnxruntime {
+namespace test {
+
+namespace {
+
+// Logits of one position where only `token` has non-zero probability after softmax.
+std::vector<float> OneHotLogits(int64_t token, int64_t vocab_size) {
+  std::vector<float> logits(static_cast<size_t>(vocab_size), -1000.f);
+  logits[static_cast<size_t>(token)] = 0.f;
+  return logits;
+}
+
+void AppendPositions(std::vector<float>& logits, std::initializer_list<int64_t> tokens, int64_t vocab_size) {
+  for (int64_t token : tokens) {
+    auto position = OneHotLogits(token, vocab_size);
+    logits.insert(logits.end(), position.begin(), position.end());
+  }
+}
+
+}  // namespace
+
+TEST(SpeculativeVerifyOpTest, GreedyAcceptsMatchingPrefix) {
+  OpTester test("SpeculativeVerify", 1, onnxruntime::kMSDomain);
+  test.AddAttribute<int64_t>("pad_token_id", -1);
+
+  // Row 0 accepts every draft token and gets a bonus token. Row 1 diverges at the second position.
+  test.AddInput<int32_t>("draft_tokens", {2, 3}, {1, 2, 3, 4, 0, 2});
+  test.AddInput<float>("logits", {2, 4, 5},
+                       {0.f, 9.f, 0.f, 0.f, 0.f,
+                        0.f, 0.f, 9.f, 0.f, 0.f,
+                        0.f, 0.f, 0.f, 9.f, 0.f,
+                        9.f, 0.f, 0.f, 0.f, 0.f,
+                        // row 1
+                        0.f, 0.f, 0.f, 0.f, 9.f,
+                        0.f, 0.f, 0.f, 9.f, 0.f,
+                        0.f, 0.f, 9.f, 0.f, 0.f,
+                        0.f, 9.f, 0.f, 0.f, 0.f});
+  test.AddOutput<int32_t>("tokens", {2, 4}, {1, 2, 3, 0, 4, 3, -1, -1});
+  test.AddOutput<int32_t>("accepted_lengths", {2}, {3, 1});
+  test.Run();
+}
+
+TEST(SpeculativeVerifyOpTest, GreedyRejectsFirstToken) {
+  OpTester test("SpeculativeVerify", 1, onnxruntime::kMSDomain);
+  test.AddInput<int32_t>("draft_tokens", {1, 2}, {2, 2});
+  test.AddInput<float>("logits", {1, 3, 3}, {3.f, 1.f, 2.f, 0.f, 0.f, 1.f, 0.f, 1.f, 0.f});
+  test.AddOutput<int32_t>("tokens", {1, 3}, {0, 0, 0});
+  test.AddOutput<int32_t>("accepted_lengths", {1}, {0});
+  test.Run();
+}
+
+TEST(SpeculativeVerifyOpTest, SamplingAcceptsAndResamples) {
+  constexpr int64_t vocab_size = 4;
+  OpTester test("SpeculativeVerify", 1, onnxruntime::kMSDomain);
+  test.AddAttribute<int64_t>("do_sample", 1);
+  test.AddAttribute<int64_t>("pad_token_id", -1);
+  test.AddAttribute("seed", 1.0f);
+
+  // Row 0: p(x) >= q(x) at both positions, so both draft tokens are kept and the bonus token is drawn from p.
+  // Row 1: p(x) == 0 at the first position, so it is rejected and resampled from max(0, p - q), which is token 3.
+  std::vector<float> logits;
+  AppendPositions(logits, {2, 1, 0}, vocab_size);
+  AppendPositions(logits, {3, 1, 1}, vocab_size);
+  std::vector<float> draft_probs = {0.1f, 0.2f, 0.3f, 0.4f,
+                                    0.25f, 0.25f, 0.25f, 0.25f,
+                                    0.f, 1.f, 0.f, 0.f,
+                                    0.25f, 0.25f, 0.25f, 0.25f};
+
+  test.AddInput<int32_t>("draft_tokens", {2, 2}, {2, 1, 1, 1});
+  test.AddInput<float>("logits", {2, 3, vocab_size}, logits);
+  test.AddInput<float>("draft_probs", {2, 2, vocab_size}, draft_probs);
+  test.AddOutput<int32_t>("tokens", {2, 3}, {2, 1, 0, 3, -1, -1});
+  test.AddOutput<int32_t>("accepted_lengths", {2}, {2, 0});
+  test.Run();
+}
+
+TEST(SpeculativeVerifyOpTest, SamplingRequiresDraftProbs) {
+  OpTester test("SpeculativeVerify", 1, onnxruntime::kMSDomain);
+  test.AddAttribute<int64_t>("do_sample", 1);
+  test.AddInput<int32_t>("draft_tokens", {1, 1}, {0});
+  test.AddInput<float>("logits", {1, 2, 2}, {1.f, 0.f, 1.f, 0.f});
+  test.AddOutput<int32_t>("tokens", {1, 2}, {0, 0});
+  test.AddOutput<int32_t>("accepted_lengths", {1}, {1});
+  test.Run(OpTester::ExpectResult::kExpectFailure, "draft_probs is required when do_sample is 1");
+}
+
+}  // namespace test
+}  // namespace onnxruntime
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <cfloat>
+#include <filesystem>
 #include <functional>
 #include <future>
 #include <iterator>
@@ -422,6 +423,93 @@ TEST(InferenceSessionTests, OnlyExecutePathToFetches) {
   RunModel(session_object, run_options);
 }
 
+// y1 = Neg(Abs(x)) and y2 = Neg(Sqrt(Abs(x))), with x of shape [2, 2]
+static std::string CreateTwoHeadModel() {
+  onnxruntime::Model model("two_heads", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+                           {{kOnnxDomain, 12}}, {}, DefaultLoggingManager().DefaultLogger());
+  auto& graph = model.MainGraph();
+
+  ONNX_NAMESPACE::TypeProto float_tensor;
+  float_tensor.mutable_tensor_type()->set_elem_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+  float_tensor.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_value(2);
+  float_tensor.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_value(2);
+
+  auto& x = graph.GetOrCreateNodeArg("x", &float_tensor);
+  auto& abs_out = graph.GetOrCreateNodeArg("abs_out", &float_tensor);
+  auto& sqrt_out = graph.GetOrCreateNodeArg("sqrt_out", &float_tensor);
+  auto& y1 = graph.GetOrCreateNodeArg("y1", &float_tensor);
+  auto& y2 = graph.GetOrCreateNodeArg("y2", &float_tensor);
+  graph.AddNode("abs", "Abs", "trunk", {&x}, {&abs_out});
+  graph.AddNode("neg_1", "Neg", "head 1", {&abs_out}, {&y1});
+  graph.AddNode("sqrt", "Sqrt", "head 2", {&abs_out}, {&sqrt_out});
+  graph.AddNode("neg_2", "Neg", "head 2", {&sqrt_out}, {&y2});
+  EXPECT_STATUS_OK(graph.Resolve());
+
+  std::string model_str;
+  model.ToProto().SerializeToString(&model_str);
+  return model_str;
+}
+
+TEST(InferenceSessionTests, PruneExecutionToFetches) {
+  SessionOptions so;
+  so.session_logid = "InferenceSessionTests.PruneExecutionToFetches";
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsPruneExecutionToFetches, "1"));
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsPrunedExecutionPlanCacheSize, "1"));
+
+  InferenceSessionWrapper session_object{so, GetEnvironment()};
+  std::stringstream model_stream(CreateTwoHeadModel());
+  ASSERT_STATUS_OK(session_object.Load(model_stream));
+  ASSERT_STATUS_OK(session_object.Initialize());
+
+  OrtValue x;
+  CreateMLValue<float>(TestCPUExecutionProvider()->CreatePreferredAllocators()[0], {2, 2}, {-1.f, -4.f, -9.f, 16.f},
+                       &x);
+  NameMLValMap feeds{{"x", x}};
+
+  // the results are the same as those of the full plan, including with the memory patterns of previous runs
+  for (int i = 0; i < 2; ++i) {
+    std::vector<OrtValue> fetches;
+    ASSERT_STATUS_OK(session_object.Run(RunOptions{}, feeds, std::vector<std::string>{"y1"}, &fetches));
+    VerifyOutputs(fetches, {2, 2}, {-1.f, -4.f, -9.f, -16.f});
+
+    fetches.clear();
+    ASSERT_STATUS_OK(session_object.Run(RunOptions{}, feeds, std::vector<std::string>{"y2"}, &fetches));
+    VerifyOutputs(fetches, {2, 2}, {-1.f, -2.f, -3.f, -4.f});
+
+    fetches.clear();
+    ASSERT_STATUS_OK(session_object.Run(RunOptions{}, feeds, std::vector<std::string>{"y2", "y1"}, &fetches));
+    ASSERT_EQ(fetches.size(), 2u);
+    VerifyOutputs(std::vector<OrtValue>{fetches[0]}, {2, 2}, {-1.f, -2.f, -3.f, -4.f});
+    VerifyOutputs(std::vector<OrtValue>{fetches[1]}, {2, 2}, {-1.f, -4.f, -9.f, -16.f});
+  }
+
+  const auto& session_state = session_object.GetSessionState();
+  std::vector<int> y1_idxs(1), y2_idxs(1);
+  ASSERT_STATUS_OK(session_state.GetOrtValueNameIdxMap().GetIdx("y1", y1_idxs[0]));
+  ASSERT_STATUS_OK(session_state.GetOrtValueNameIdxMap().GetIdx("y2", y2_idxs[0]));
+
+  std::shared_ptr<const PrunedExecutionPlan> y1_plan;
+  ASSERT_STATUS_OK(session_state.GetPrunedExecutionPlan(y1_idxs, y1_plan));
+  ASSERT_NE(y1_plan, nullptr);
+  EXPECT_EQ(y1_plan->nodes_to_execute.size(), 2u);
+
+  std::shared_ptr<const PrunedExecutionPlan> plan;
+  ASSERT_STATUS_OK(session_state.GetPrunedExecutionPlan(y1_idxs, plan));
+  EXPECT_EQ(plan, y1_plan);
+
+  // the cache holds a single plan, so the plan for y2 evicts the one for y1
+  ASSERT_STATUS_OK(session_state.GetPrunedExecutionPlan(y2_idxs, plan));
+  ASSERT_NE(plan, nullptr);
+  EXPECT_EQ(plan->nodes_to_execute.size(), 3u);
+  ASSERT_STATUS_OK(session_state.GetPrunedExecutionPlan(y1_idxs, plan));
+  EXPECT_NE(plan, y1_plan);
+
+  // all the nodes are needed for both outputs
+  std::vector<int> all_idxs{y2_idxs[0], y1_idxs[0]};
+  ASSERT_STATUS_OK(session_state.GetPrunedExecutionPlan(all_idxs, plan));
+  EXPECT_EQ(plan, nullptr);
+}
+
 TEST(InferenceSessionTests, DisableCPUArena) {
   SessionOptions so;
 
@@ -499,6 +587,367 @@ TEST(InferenceSessionTests, TestModelSerialization) {
   ASSERT_TRUE(session_object_emptyValidation.Initialize().IsOK());
 }
 
+TEST(InferenceSessionTests, OptimizedModelCache) {
+  const std::string test_model = "testdata/transform/abs-id-max.onnx";
+  const std::filesystem::path cache_dir = "optimized_model_cache_test";
+  std::filesystem::remove_all(cache_dir);
+
+  auto get_cache_entries = [&cache_dir]() {
+    std::vector<std::filesystem::path> entries;
+    for (const auto& entry : std::filesystem::directory_iterator(cache_dir)) {
+      entries.push_back(entry.path());
+    }
+    return entries;
+  };
+
+  auto create_session = [&](TransformerLevel level, const std::string& max_size_in_bytes,
+                            bool with_custom_transformer = false) {
+    SessionOptions so;
+    so.session_logid = "InferenceSessionTests.OptimizedModelCache";
+    so.graph_optimization_level = level;
+    EXPECT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsOptimizedModelCacheDir,
+                                                      cache_dir.string().c_str()));
+    EXPECT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsOptimizedModelCacheMaxSizeInBytes,
+                                                      max_size_in_bytes.c_str()));
+    auto session = std::make_unique<InferenceSessionWrapper>(so, GetEnvironment());
+    EXPECT_STATUS_OK(session->Load(test_model));
+    if (with_custom_transformer) {
+      EXPECT_STATUS_OK(session->RegisterGraphTransformer(std::make_unique<DummyGraphTransformer>("DummyTransformer"),
+                                                         TransformerLevel::Level1));
+    }
+    EXPECT_STATUS_OK(session->Initialize());
+    return session;
+  };
+
+  // A has the shape [2, 3, 4]
+  auto run = [](InferenceSession& session) {
+    std::vector<float> values(24);
+    for (size_t i = 0; i < values.size(); ++i) {
+      values[i] = static_cast<float>(i) - 12.f;
+    }
+    const std::vector<int64_t> dims{2, 3, 4};
+    OrtValue a;
+    CreateMLValue<float>(TestCPUExecutionProvider()->CreatePreferredAllocators()[0], dims, values, &a);
+    std::vector<OrtValue> fetches;
+    EXPECT_STATUS_OK(session.Run(RunOptions{}, NameMLValMap{{"A", a}}, std::vector<std::string>{"D"}, &fetches));
+    const auto output = fetches.at(0).Get<Tensor>().DataAsSpan<float>();
+    return std::vector<float>(output.begin(), output.end());
+  };
+
+  std::vector<float> expected_output;
+  {
+    SessionOptions so;
+    so.session_logid = "InferenceSessionTests.OptimizedModelCache";
+    so.graph_optimization_level = TransformerLevel::Level1;
+    InferenceSession session{so, GetEnvironment()};
+    ASSERT_STATUS_OK(session.Load(test_model));
+    ASSERT_STATUS_OK(session.Initialize());
+    expected_output = run(session);
+  }
+
+  // the first session optimizes the model and stores it
+  {
+    auto session = create_session(TransformerLevel::Level1, "0");
+    EXPECT_EQ(CountOpsInGraph(session->GetGraph())["Identity"], 0);
+    EXPECT_EQ(run(*session), expected_output);
+  }
+
+  auto entries = get_cache_entries();
+  ASSERT_EQ(entries.size(), 1u);
+  const std::filesystem::path level1_entry = entries[0];
+  EXPECT_EQ(level1_entry.extension(), ".ort");
+
+  // the second session loads it from the cache, which marks the entry as recently used
+  const auto long_ago = std::filesystem::last_write_time(level1_entry) - std::chrono::hours(24);
+  std::filesystem::last_write_time(level1_entry, long_ago);
+  {
+    auto session = create_session(TransformerLevel::Level1, "0");
+    EXPECT_EQ(CountOpsInGraph(session->GetGraph())["Identity"], 0);
+    EXPECT_EQ(run(*session), expected_output);
+  }
+
+  EXPECT_EQ(get_cache_entries().size(), 1u);
+  EXPECT_GT(std::filesystem::last_write_time(level1_entry), long_ago);
+
+  // a session with a custom graph transformer neither loads nor stores an entry
+  {
+    const auto last_used = std::filesystem::last_write_time(level1_entry);
+    auto session = create_session(TransformerLevel::Level1, "0", /*with_custom_transformer*/ true);
+    EXPECT_EQ(run(*session), expected_output);
+    EXPECT_EQ(get_cache_entries().size(), 1u);
+    EXPECT_EQ(std::filesystem::last_write_time(level1_entry), last_used);
+  }
+
+  // a different optimization level is a different entry, and the size limit evicts the older one
+  { auto session = create_session(TransformerLevel::Level2, "1"); }
+
+  entries = get_cache_entries();
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_NE(entries[0], level1_entry);
+
+  std::filesystem::remove_all(cache_dir);
+}
+
+// The decisions of the CPU fusion cost model saved in the model metadata are replayed when the session is created.
+TEST(InferenceSessionTests, CpuFusionDecisionsFromModelMetadata) {
+  // y = MatMul(x, w) + b, which MatMulAddFusion fuses into a Gemm
+  ONNX_NAMESPACE::ModelProto model_proto;
+  model_proto.set_ir_version(ONNX_NAMESPACE::Version::IR_VERSION);
+  auto* opset = model_proto.add_opset_import();
+  opset->set_domain("");
+  opset->set_version(13);
+  auto& graph_proto = *model_proto.mutable_graph();
+  graph_proto.set_name("matmul_add");
+  auto add_value_info = [](ONNX_NAMESPACE::ValueInfoProto& value_info, const std::string& name,
+                           std::initializer_list<int64_t> dims) {
+    value_info.set_name(name);
+    auto* tensor_type = value_info.mutable_type()->mutable_tensor_type();
+    tensor_type->set_elem_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+    for (int64_t dim : dims) {
+      tensor_type->mutable_shape()->add_dim()->set_dim_value(dim);
+    }
+  };
+  add_value_info(*graph_proto.add_input(), "x", {16, 32});
+  add_value_info(*graph_proto.add_output(), "y", {16, 64});
+  auto add_initializer = [&graph_proto](const std::string& name, std::initializer_list<int64_t> dims) {
+    auto& initializer = *graph_proto.add_initializer();
+    initializer.set_name(name);
+    initializer.set_data_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+    int64_t size = 1;
+    for (int64_t dim : dims) {
+      initializer.add_dims(dim);
+      size *= dim;
+    }
+    for (int64_t i = 0; i < size; ++i) {
+      initializer.add_float_data(static_cast<float>(i % 7) - 3.f);
+    }
+  };
+  add_initializer("w", {32, 64});
+  add_initializer("b", {64});
+  auto& matmul = *graph_proto.add_node();
+  matmul.set_op_type("MatMul");
+  matmul.add_input("x");
+  matmul.add_input("w");
+  matmul.add_output("matmul_out");
+  auto& add = *graph_proto.add_node();
+  add.set_op_type("Add");
+  add.add_input("matmul_out");
+  add.add_input("b");
+  add.add_output("y");
+
+  auto count_gemm_nodes = [&model_proto](const SessionOptions& so, bool with_other_ep) {
+    const std::string model_data = model_proto.SerializeAsString();
+    InferenceSessionWrapper session{so, GetEnvironment()};
+    EXPECT_STATUS_OK(session.Load(model_data.data(), static_cast<int>(model_data.size())));
+    if (with_other_ep) {
+      EXPECT_STATUS_OK(session.RegisterExecutionProvider(std::make_unique<DummyExecutionProvider>()));
+    }
+    EXPECT_STATUS_OK(session.Initialize());
+    return std::make_pair(CountOpsInGraph(session.GetGraph())["Gemm"], session.GetTuningResults());
+  };
+
+  // an offline tuning run records the decision for the pattern
+  SessionOptions tuning_so;
+  tuning_so.session_logid = "InferenceSessionTests.CpuFusionDecisionsFromModelMetadata";
+  tuning_so.graph_optimization_level = TransformerLevel::Level1;
+  ASSERT_STATUS_OK(tuning_so.config_options.AddConfigEntry(kOrtSessionOptionsCpuTunableOpTuningEnable, "1"));
+  ASSERT_STATUS_OK(tuning_so.config_options.AddConfigEntry(kOrtSessionOptionsCpuTunableOpMaxTuningDurationMs, "1"));
+  std::vector<TuningResults> tuning_results = count_gemm_nodes(tuning_so, false).second;
+  auto cpu_results = std::find_if(tuning_results.begin(), tuning_results.end(),
+                                  [](const TuningResults& results) { return results.ep == kCpuExecutionProvider; });
+  ASSERT_NE(cpu_results, tuning_results.end());
+  KernelMap& decisions = cpu_results->results["CpuFusion_MatMulAdd"];
+  ASSERT_EQ(decisions.size(), 1u);
+
+  SessionOptions so;
+  so.session_logid = "InferenceSessionTests.CpuFusionDecisionsFromModelMetadata";
+  so.graph_optimization_level = TransformerLevel::Level1;
+  for (int decision : {0, 1}) {
+    decisions.begin()->second = decision;
+    json tuning_results_json = json::array();
+    tuning_results_json.push_back({{"ep", cpu_results->ep},
+                                   {"validators", cpu_results->validators},
+                                   {"results", cpu_results->results}});
+    model_proto.clear_metadata_props();
+    auto* metadata = model_proto.add_metadata_props();
+    metadata->set_key(inference_session_utils::kTuningResultsKeys);
+    metadata->set_value(tuning_results_json.dump());
+
+    EXPECT_EQ(count_gemm_nodes(so, false).first, decision) << "decision " << decision;
+
+    // the decisions are ignored if the nodes may be assigned to other EPs, and the fusion is applied as without them
+    EXPECT_EQ(count_gemm_nodes(so, true).first, 1) << "decision " << decision;
+  }
+}
+
+TEST(InferenceSessionTests, ShapeSpecializations) {
+  // x has the shape [Dim1, Dim2, 5]
+  const PathString model_uri = ORT_TSTR("testdata/abs_free_dimensions.onnx");
+  SessionOptions so;
+  so.session_logid = "InferenceSessionTests.ShapeSpecializations";
+  InferenceSessionWrapper session_object{so, GetEnvironment()};
+  ASSERT_STATUS_OK(session_object.Load(model_uri));
+  ASSERT_STATUS_OK(session_object.Initialize());
+
+  const auto& model_inputs = session_object.GetGraph().GetInputs();
+  ASSERT_TRUE(ShapeSpecializations::HasSymbolicDims(model_inputs));
+
+  int num_created = 0;
+  auto create_session = [&](const std::vector<FreeDimensionOverride>& free_dimension_overrides,
+                            std::unique_ptr<InferenceSession>& session) {
+    ++num_created;
+    SessionOptions specialized_so = so;
+    specialized_so.free_dimension_overrides = free_dimension_overrides;
+    session = std::make_unique<InferenceSession>(specialized_so, GetEnvironment());
+    ORT_RETURN_IF_ERROR(session->Load(model_uri));
+    return session->Initialize();
+  };
+
+  ShapeSpecializations specializations(model_inputs, /*min_run_count*/ 2, /*max_sessions*/ 1, create_session,
+                                       DefaultLoggingManager().DefaultLogger());
+
+  auto allocator = TestCPUExecutionProvider()->CreatePreferredAllocators()[0];
+  const std::vector<std::string> feed_names{"x"};
+  auto make_feeds = [&](int64_t dim1) {
+    const std::vector<int64_t> dims{dim1, 2, 5};
+    std::vector<float> values(static_cast<size_t>(dim1 * 2 * 5), -1.f);
+    std::vector<OrtValue> feeds(1);
+    CreateMLValue<float>(allocator, dims, values, &feeds[0]);
+    return feeds;
+  };
+
+  // the second Run with the shape creates the specialized session and is routed to it, as are the Runs after it
+  const auto feeds = make_feeds(1);
+  EXPECT_EQ(specializations.GetSession(feed_names, feeds), nullptr);
+  EXPECT_EQ(specializations.FindSession(feed_names, feeds), nullptr);
+  InferenceSession* specialized_session = specializations.GetSession(feed_names, feeds);
+  ASSERT_NE(specialized_session, nullptr);
+  EXPECT_EQ(specializations.FindSession(feed_names, feeds), specialized_session);
+  EXPECT_EQ(specializations.GetSession(feed_names, feeds), specialized_session);
+  EXPECT_EQ(num_created, 1);
+
+  auto inputs = specialized_session->GetModelInputs();
+  ASSERT_STATUS_OK(inputs.first);
+  const auto* shape = inputs.second->at(0)->Shape();
+  ASSERT_NE(shape, nullptr);
+  EXPECT_EQ(shape->dim(0).dim_value(), 1);
+  EXPECT_EQ(shape->dim(1).dim_value(), 2);
+
+  std::vector<OrtValue> fetches;
+  ASSERT_STATUS_OK(specialized_session->Run(RunOptions{}, feed_names, feeds, std::vector<std::string>{"y"},
+                                            &fetches, nullptr));
+  VerifyOutputs(fetches, {1, 2, 5}, std::vector<float>(10, 1.f));
+
+  // the limit of specialized sessions was reached, so other shapes stay with the generic session
+  const auto other_feeds = make_feeds(3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(specializations.GetSession(feed_names, other_feeds), nullptr);
+  }
+  EXPECT_EQ(num_created, 1);
+}
+
+// The specialized sessions created by the session config share the initializers, pre-packed weights and thread pools
+// of the session, which may be loaded from memory.
+TEST(InferenceSessionTests, ShapeSpecializationsFromConfig) {
+  // y = MatMul(x, w) with x of shape [batch, 4] and w of shape [4, 8]
+  constexpr int64_t kK = 4;
+  constexpr int64_t kN = 8;
+  ONNX_NAMESPACE::ModelProto model_proto;
+  model_proto.set_ir_version(ONNX_NAMESPACE::Version::IR_VERSION);
+  auto* opset = model_proto.add_opset_import();
+  opset->set_domain("");
+  opset->set_version(13);
+  auto& graph_proto = *model_proto.mutable_graph();
+  graph_proto.set_name("matmul");
+  auto add_value_info = [](ONNX_NAMESPACE::ValueInfoProto& value_info, const std::string& name, int64_t dim) {
+    value_info.set_name(name);
+    auto* tensor_type = value_info.mutable_type()->mutable_tensor_type();
+    tensor_type->set_elem_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+    tensor_type->mutable_shape()->add_dim()->set_dim_param("batch");
+    tensor_type->mutable_shape()->add_dim()->set_dim_value(dim);
+  };
+  add_value_info(*graph_proto.add_input(), "x", kK);
+  add_value_info(*graph_proto.add_output(), "y", kN);
+  auto& w = *graph_proto.add_initializer();
+  w.set_name("w");
+  w.set_data_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+  w.add_dims(kK);
+  w.add_dims(kN);
+  for (int64_t i = 0; i < kK * kN; ++i) {
+    w.add_float_data(static_cast<float>(i % 7) - 3.f);
+  }
+  auto& matmul = *graph_proto.add_node();
+  matmul.set_op_type("MatMul");
+  matmul.add_input("x");
+  matmul.add_input("w");
+  matmul.add_output("y");
+  std::string model_data;
+  ASSERT_TRUE(model_proto.SerializeToString(&model_data));
+
+  SessionOptions so;
+  so.session_logid = "InferenceSessionTests.ShapeSpecializationsFromConfig";
+  so.intra_op_param.thread_pool_size = 2;
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsShapeSpecializationMinRunCount, "2"));
+  InferenceSession session_object{so, GetEnvironment()};
+  ASSERT_STATUS_OK(session_object.Load(model_data.data(), static_cast<int>(model_data.size())));
+  ASSERT_STATUS_OK(session_object.Initialize());
+
+  // x is all ones, so each output is the sum of a column of w
+  constexpr int64_t kBatch = 3;
+  std::vector<float> expected(static_cast<size_t>(kBatch * kN), 0.f);
+  for (int64_t b = 0; b < kBatch; ++b) {
+    for (int64_t i = 0; i < kK * kN; ++i) {
+      expected[static_cast<size_t>(b * kN + i % kN)] += static_cast<float>(i % 7) - 3.f;
+    }
+  }
+
+  const std::vector<std::string> feed_names{"x"};
+  std::vector<OrtValue> feeds(1);
+  std::vector<float> values(static_cast<size_t>(kBatch * kK), 1.f);
+  CreateMLValue<float>(TestCPUExecutionProvider()->CreatePreferredAllocators()[0], {kBatch, kK}, values, &feeds[0]);
+  auto run = [&]() {
+    std::vector<OrtValue> fetches;
+    ASSERT_STATUS_OK(session_object.Run(RunOptions{}, feed_names, feeds, std::vector<std::string>{"y"}, &fetches));
+    VerifyOutputs(fetches, {kBatch, kN}, expected);
+  };
+
+  run();
+  EXPECT_EQ(session_object.GetSpecializedSession(feed_names, feeds), nullptr);
+
+  // the second Run creates the specialized session and runs on it
+  run();
+  const InferenceSession* specialized_session = session_object.GetSpecializedSession(feed_names, feeds);
+  ASSERT_NE(specialized_session, nullptr);
+  run();
+  EXPECT_EQ(session_object.GetSpecializedSession(feed_names, feeds), specialized_session);
+
+  auto inputs = specialized_session->GetModelInputs();
+  ASSERT_STATUS_OK(inputs.first);
+  const auto* shape = inputs.second->at(0)->Shape();
+  ASSERT_NE(shape, nullptr);
+  EXPECT_EQ(shape->dim(0).dim_value(), kBatch);
+
+  const SessionState& session_state = session_object.GetSessionState();
+  const SessionState& specialized_session_state = specialized_session->GetSessionState();
+  ASSERT_NE(session_state.GetThreadPool(), nullptr);
+  EXPECT_EQ(specialized_session_state.GetThreadPool(), session_state.GetThreadPool());
+
+  // the MatMul of the specialized session uses the weight the MatMul of the session pre-packed
+  EXPECT_EQ(session_state.GetUsedSharedPrePackedWeightCounter(), 0u);
+  EXPECT_EQ(specialized_session_state.GetUsedSharedPrePackedWeightCounter(), 1u);
+
+  // other shapes keep running on the session
+  std::vector<OrtValue> other_feeds(1);
+  std::vector<float> other_values(static_cast<size_t>(kK), 1.f);
+  CreateMLValue<float>(TestCPUExecutionProvider()->CreatePreferredAllocators()[0], {1, kK}, other_values,
+                       &other_feeds[0]);
+  std::vector<OrtValue> fetches;
+  ASSERT_STATUS_OK(session_object.Run(RunOptions{}, feed_names, other_feeds, std::vector<std::string>{"y"},
+                                      &fetches));
+  VerifyOutputs(fetches, {1, kN}, std::vector<float>(expected.begin(), expected.begin() + kN));
+  EXPECT_EQ(session_object.GetSpecializedSession(feed_names, other_feeds), nullptr);
+}
+
 TEST(InferenceSessionTests, RequestLoadCancellation) {
   {
     // Explicit cancel during load, small model is fine
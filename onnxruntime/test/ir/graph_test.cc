@@ -1507,6 +1507,46 @@ TEST_F(GraphTest, ShapeInferenceErrorHandling) {
                                       "Node (node_1) Op (ShapeInferenceThrowsOp) [ShapeInferenceError] try harder");
 }
 
+TEST_F(GraphTest, ResolveInfersConsumersOfChangedNodes) {
+  Model model("graph", false, *logger_);
+  auto& graph = model.MainGraph();
+
+  TypeProto float_n_by_3;
+  float_n_by_3.mutable_tensor_type()->set_elem_type(TensorProto_DataType_FLOAT);
+  float_n_by_3.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_param("N");
+  float_n_by_3.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_value(3);
+
+  TypeProto float_4_by_3 = float_n_by_3;
+  float_4_by_3.mutable_tensor_type()->mutable_shape()->mutable_dim(0)->set_dim_value(4);
+
+  auto& x = graph.GetOrCreateNodeArg("x", &float_n_by_3);
+  auto& w = graph.GetOrCreateNodeArg("w", &float_4_by_3);
+  auto& y = graph.GetOrCreateNodeArg("y", nullptr);
+  auto& z = graph.GetOrCreateNodeArg("z", nullptr);
+  auto& relu = graph.AddNode("relu", "Relu", "relu", {&x}, {&y});
+  graph.AddNode("abs", "Abs", "abs", {&y}, {&z});
+
+  Graph::ResolveOptions options;
+  options.verify_skipped_inferencing = true;
+  ASSERT_STATUS_OK(graph.Resolve(options));
+  ASSERT_NE(z.Shape(), nullptr);
+  EXPECT_EQ(z.Shape()->dim(0).dim_param(), "N");
+
+  // nothing changed, so inferencing is skipped for both nodes
+  graph.SetGraphResolveNeeded();
+  ASSERT_STATUS_OK(graph.Resolve(options));
+
+  // change the input of the first node and clear the shape of its output, as a graph transformer would.
+  // the consumer of the output has to be inferred again even though the node itself did not change.
+  relu.MutableInputDefs()[0] = &w;
+  y.ClearShape();
+  graph.SetGraphResolveNeeded();
+  ASSERT_STATUS_OK(graph.Resolve(options));
+  ASSERT_NE(z.Shape(), nullptr);
+  EXPECT_EQ(z.Shape()->dim(0).dim_value(), 4);
+  EXPECT_EQ(z.Shape()->dim(1).dim_value(), 3);
+}
+
 TEST_F(GraphTest, AddTensorAttribute) {
   OPERATOR_SCHEMA(__Constant)
       .SetDoc("Constant Op.")
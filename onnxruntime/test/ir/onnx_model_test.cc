@@ -6,7 +6,9 @@
 #include "core/platform/env.h"
 #include "core/graph/graph_viewer.h"
 #include "core/graph/model.h"
+#include "core/graph/model_proto_parser.h"
 #include "core/graph/op.h"
+#include "core/platform/threadpool.h"
 #include "core/session/onnxruntime_c_api.h"
 #include "test/providers/provider_test_utils.h"  //For ASSERT_STATUS_OK
 #include "test/test_environment.h"
@@ -80,6 +82,116 @@ TEST_F(ONNXModelsTest, future_opset) {
   ASSERT_FALSE(st.IsOK());
 }
 
+// Serialized model whose main graph has its nodes and initializers interleaved with each other and with the other
+// fields of the graph, so splitting them off has to preserve the order within each field. SerializeAsString writes
+// the fields in the order of their numbers, so the graph is concatenated from separately serialized fragments.
+static std::string CreateSerializedModelWithManyInitializers(int num_initializers) {
+  auto add_value_info = [](ValueInfoProto& value_info, const std::string& name) {
+    value_info.set_name(name);
+    auto* tensor_type = value_info.mutable_type()->mutable_tensor_type();
+    tensor_type->set_elem_type(TensorProto_DataType_FLOAT);
+    tensor_type->mutable_shape()->add_dim()->set_dim_value(4);
+  };
+
+  std::string graph_bytes;
+  auto append_fragment = [&graph_bytes](const GraphProto& fragment) { graph_bytes += fragment.SerializeAsString(); };
+
+  GraphProto fragment;
+  fragment.set_name("graph");
+  add_value_info(*fragment.add_input(), "x0");
+  append_fragment(fragment);
+
+  for (int i = 0; i < num_initializers; ++i) {
+    const std::string index = std::to_string(i);
+    fragment.Clear();
+    auto* node = fragment.add_node();
+    node->set_name("add" + index);
+    node->set_op_type("Add");
+    node->add_input("x" + index);
+    node->add_input("w" + index);
+    node->add_output("x" + std::to_string(i + 1));
+    append_fragment(fragment);
+
+    fragment.Clear();
+    auto* initializer = fragment.add_initializer();
+    initializer->set_name("w" + index);
+    initializer->set_data_type(TensorProto_DataType_FLOAT);
+    initializer->add_dims(4);
+    const float values[] = {static_cast<float>(i), 1.f, 2.f, 3.f};
+    initializer->set_raw_data(values, sizeof(values));
+    append_fragment(fragment);
+
+    if (i % 10 == 0) {
+      fragment.Clear();
+      add_value_info(*fragment.add_value_info(), "x" + std::to_string(i + 1));
+      append_fragment(fragment);
+    }
+  }
+
+  fragment.Clear();
+  add_value_info(*fragment.add_output(), "x" + std::to_string(num_initializers));
+  append_fragment(fragment);
+
+  // the graph field (7) is placed between the other fields of the model
+  ModelProto model_proto;
+  model_proto.set_ir_version(ONNX_NAMESPACE::Version::IR_VERSION);
+  model_proto.set_producer_name("onnx_model_test");
+  auto* opset = model_proto.add_opset_import();
+  opset->set_domain("");
+  opset->set_version(13);
+  std::string serialized = model_proto.SerializeAsString();
+
+  serialized += static_cast<char>((7 << 3) | 2);
+  for (uint64_t length = graph_bytes.size(); ; length >>= 7) {
+    if (length < 0x80) {
+      serialized += static_cast<char>(length);
+      break;
+    }
+    serialized += static_cast<char>((length & 0x7f) | 0x80);
+  }
+  serialized += graph_bytes;
+
+  model_proto.Clear();
+  auto* metadata = model_proto.add_metadata_props();
+  metadata->set_key("key");
+  metadata->set_value("value");
+  serialized += model_proto.SerializeAsString();
+  return serialized;
+}
+
+TEST_F(ONNXModelsTest, ParseModelProtoInParallel) {
+  const std::string serialized = CreateSerializedModelWithManyInitializers(100);
+  ModelProto expected;
+  ASSERT_TRUE(expected.ParseFromString(serialized));
+  ASSERT_EQ(expected.graph().node_size(), 100);
+  ASSERT_EQ(expected.graph().initializer_size(), 100);
+
+  concurrency::ThreadPool thread_pool(&Env::Default(), ThreadOptions(), ORT_TSTR("parse"), 4, true);
+
+  ModelProto parsed;
+  ASSERT_TRUE(ParseModelProto(serialized.data(), serialized.size(), parsed, &thread_pool,
+                              /*min_bytes_for_parallel_parse*/ 0));
+  EXPECT_EQ(parsed.SerializeAsString(), expected.SerializeAsString());
+
+  // without a pool the model is parsed on the calling thread
+  ModelProto parsed_sequentially;
+  ASSERT_TRUE(ParseModelProto(serialized.data(), serialized.size(), parsed_sequentially, nullptr,
+                              /*min_bytes_for_parallel_parse*/ 0));
+  EXPECT_EQ(parsed_sequentially.SerializeAsString(), expected.SerializeAsString());
+
+  std::shared_ptr<Model> model;
+  ASSERT_STATUS_OK(Model::Load(std::move(parsed), model, nullptr, *logger_));
+  EXPECT_EQ(model->MainGraph().NumberOfNodes(), 100);
+  EXPECT_EQ(model->MainGraph().GetAllInitializedTensors().size(), 100u);
+
+  // truncated models are rejected like by ParseFromArray
+  const std::string truncated = serialized.substr(0, serialized.size() - 5);
+  ModelProto invalid;
+  EXPECT_FALSE(invalid.ParseFromString(truncated));
+  EXPECT_FALSE(ParseModelProto(truncated.data(), truncated.size(), invalid, &thread_pool,
+                               /*min_bytes_for_parallel_parse*/ 0));
+}
+
 class ONNXModelsTest1 : public ::testing::TestWithParam<const ORTCHAR_T*> {
   // You can implement all the usual fixture class members here.
   // To access the test parameter, call GetParam() from class
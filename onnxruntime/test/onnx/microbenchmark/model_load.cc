@@ -0,0 +1,119 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <benchmark/benchmark.h>
+#include <core/graph/model.h>
+#include <core/graph/model_proto_parser.h>
+#include <core/graph/onnx_protobuf.h>
+#include <core/session/ort_env.h>
+#include <core/util/thread_utils.h>
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+extern OrtEnv* env;
+
+using namespace onnxruntime;
+
+// Serialized model with a chain of Add nodes, each with an initializer of initializer_size floats.
+static std::string CreateSerializedModel(int64_t num_initializers, int64_t initializer_size) {
+  ONNX_NAMESPACE::ModelProto model_proto;
+  model_proto.set_ir_version(ONNX_NAMESPACE::Version::IR_VERSION);
+  auto* opset = model_proto.add_opset_import();
+  opset->set_domain("");
+  opset->set_version(13);
+
+  auto* graph = model_proto.mutable_graph();
+  graph->set_name("graph");
+  auto add_value_info = [initializer_size](ONNX_NAMESPACE::ValueInfoProto& value_info, const std::string& name) {
+    value_info.set_name(name);
+    auto* tensor_type = value_info.mutable_type()->mutable_tensor_type();
+    tensor_type->set_elem_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+    tensor_type->mutable_shape()->add_dim()->set_dim_value(initializer_size);
+  };
+  add_value_info(*graph->add_input(), "x0");
+
+  const std::vector<float> values(static_cast<size_t>(initializer_size), 1.f);
+  for (int64_t i = 0; i < num_initializers; ++i) {
+    const std::string index = std::to_string(i);
+    auto* initializer = graph->add_initializer();
+    initializer->set_name("w" + index);
+    initializer->set_data_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+    initializer->add_dims(initializer_size);
+    initializer->set_raw_data(values.data(), values.size() * sizeof(float));
+
+    auto* node = graph->add_node();
+    node->set_op_type("Add");
+    node->add_input("x" + index);
+    node->add_input("w" + index);
+    node->add_output("x" + std::to_string(i + 1));
+  }
+
+  add_value_info(*graph->add_output(), "x" + std::to_string(num_initializers));
+  return model_proto.SerializeAsString();
+}
+
+static void BM_ParseModelProto(benchmark::State& state) {
+  const std::string model = CreateSerializedModel(state.range(0), state.range(1));
+  const bool parallel = state.range(2) != 0;
+  OrtThreadPoolParams tpo;
+  std::unique_ptr<concurrency::ThreadPool> tp(
+      concurrency::CreateThreadPool(&onnxruntime::Env::Default(), tpo, concurrency::ThreadPoolType::INTRA_OP));
+  for (auto _ : state) {
+    ONNX_NAMESPACE::ModelProto model_proto;
+    const bool parsed = ParseModelProto(model.data(), model.size(), model_proto, tp.get(),
+                                        parallel ? 0 : std::numeric_limits<size_t>::max());
+    if (!parsed) {
+      state.SkipWithError("Protobuf parsing failed.");
+      break;
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(model.size()));
+}
+
+BENCHMARK(BM_ParseModelProto)
+    ->ArgNames({"initializers", "size", "parallel"})
+    ->Args({10000, 16, 0})
+    ->Args({10000, 16, 1})
+    ->Args({10000, 4096, 0})
+    ->Args({10000, 4096, 1})
+    ->Args({1000, 65536, 0})
+    ->Args({1000, 65536, 1})
+    ->UseRealTime()
+    ->Unit(benchmark::TimeUnit::kMillisecond);
+
+// Load latency of a model file parsed on an intra-op pool, including the construction and resolution of the graph.
+static void BM_LoadLargeModel(benchmark::State& state) {
+  const std::string model = CreateSerializedModel(state.range(0), state.range(1));
+  const std::string model_path = "model_load_benchmark.onnx";
+  std::ofstream(model_path, std::ios::binary | std::ios::trunc).write(model.data(), model.size());
+
+  OrtThreadPoolParams tpo;
+  std::unique_ptr<concurrency::ThreadPool> tp(
+      concurrency::CreateThreadPool(&onnxruntime::Env::Default(), tpo, concurrency::ThreadPoolType::INTRA_OP));
+  ModelOptions model_options;
+  model_options.thread_pool = tp.get();
+
+  auto logger = env->GetLoggingManager()->CreateLogger("test");
+  for (auto _ : state) {
+    std::shared_ptr<onnxruntime::Model> loaded_model;
+    auto st = onnxruntime::Model::Load(ToPathString(model_path), loaded_model, nullptr, *logger, model_options);
+    if (!st.IsOK()) {
+      state.SkipWithError(st.ErrorMessage().c_str());
+      break;
+    }
+  }
+
+  std::remove(model_path.c_str());
+}
+
+BENCHMARK(BM_LoadLargeModel)
+    ->ArgNames({"initializers", "size"})
+    ->Args({10000, 16})
+    ->Args({10000, 4096})
+    ->UseRealTime()
+    ->Unit(benchmark::TimeUnit::kMillisecond);
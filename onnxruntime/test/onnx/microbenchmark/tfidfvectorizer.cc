@@ -0,0 +1,180 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <benchmark/benchmark.h>
+#include <core/graph/onnx_protobuf.h>
+#include <core/session/onnxruntime_c_api.h>
+#include <core/session/onnxruntime_cxx_api.h>
+#include <core/session/ort_env.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+extern OrtEnv* env;
+extern const OrtApi* g_ort;
+
+#define ORT_BREAK_ON_ERROR(expr)                                \
+  do {                                                          \
+    OrtStatus* onnx_status = (expr);                            \
+    if (onnx_status != NULL) {                                  \
+      state.SkipWithError(g_ort->GetErrorMessage(onnx_status)); \
+      g_ort->ReleaseStatus(onnx_status);                        \
+    }                                                           \
+  } while (0);
+
+namespace {
+
+// Pool of vocab_size unigrams followed by vocab_size bigrams over items [0, vocab_size)
+std::string CreateTfIdfModel(int64_t vocab_size, bool string_input) {
+  ONNX_NAMESPACE::ModelProto model;
+  model.set_ir_version(ONNX_NAMESPACE::IR_VERSION);
+  auto* opset = model.add_opset_import();
+  opset->set_domain("");
+  opset->set_version(9);
+
+  auto* graph = model.mutable_graph();
+  graph->set_name("tfidf");
+
+  auto* node = graph->add_node();
+  node->set_op_type("TfIdfVectorizer");
+  node->add_input("X");
+  node->add_output("Y");
+
+  auto add_attr = [node](const char* name, ONNX_NAMESPACE::AttributeProto_AttributeType type) {
+    auto* attr = node->add_attribute();
+    attr->set_name(name);
+    attr->set_type(type);
+    return attr;
+  };
+  add_attr("mode", ONNX_NAMESPACE::AttributeProto_AttributeType_STRING)->set_s("TFIDF");
+  add_attr("min_gram_length", ONNX_NAMESPACE::AttributeProto_AttributeType_INT)->set_i(1);
+  add_attr("max_gram_length", ONNX_NAMESPACE::AttributeProto_AttributeType_INT)->set_i(2);
+  add_attr("max_skip_count", ONNX_NAMESPACE::AttributeProto_AttributeType_INT)->set_i(1);
+
+  auto* ngram_counts = add_attr("ngram_counts", ONNX_NAMESPACE::AttributeProto_AttributeType_INTS);
+  ngram_counts->add_ints(0);
+  ngram_counts->add_ints(vocab_size);
+
+  auto* ngram_indexes = add_attr("ngram_indexes", ONNX_NAMESPACE::AttributeProto_AttributeType_INTS);
+  auto* weights = add_attr("weights", ONNX_NAMESPACE::AttributeProto_AttributeType_FLOATS);
+  for (int64_t i = 0; i < 2 * vocab_size; ++i) {
+    ngram_indexes->add_ints(i);
+    weights->add_floats(1.0f / static_cast<float>(i + 1));
+  }
+
+  auto* pool = string_input ? add_attr("pool_strings", ONNX_NAMESPACE::AttributeProto_AttributeType_STRINGS)
+                            : add_attr("pool_int64s", ONNX_NAMESPACE::AttributeProto_AttributeType_INTS);
+  auto add_item = [pool, string_input](int64_t item) {
+    if (string_input) {
+      pool->add_strings("token_" + std::to_string(item));
+    } else {
+      pool->add_ints(item);
+    }
+  };
+  for (int64_t i = 0; i < vocab_size; ++i) {
+    add_item(i);
+  }
+  for (int64_t i = 0; i < vocab_size; ++i) {
+    add_item(i);
+    add_item((i * 7 + 1) % vocab_size);
+  }
+
+  auto* input = graph->add_input();
+  input->set_name("X");
+  auto* input_type = input->mutable_type()->mutable_tensor_type();
+  input_type->set_elem_type(string_input ? ONNX_NAMESPACE::TensorProto_DataType_STRING
+                                         : ONNX_NAMESPACE::TensorProto_DataType_INT64);
+  input_type->mutable_shape()->add_dim()->set_dim_param("B");
+  input_type->mutable_shape()->add_dim()->set_dim_param("C");
+
+  auto* output = graph->add_output();
+  output->set_name("Y");
+  auto* output_type = output->mutable_type()->mutable_tensor_type();
+  output_type->set_elem_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+  output_type->mutable_shape()->add_dim()->set_dim_param("B");
+  output_type->mutable_shape()->add_dim()->set_dim_param("N");
+
+  return model.SerializeAsString();
+}
+
+}  // namespace
+
+// Arguments: vocabulary size, batch size, row length
+template <bool StringInput>
+static void BM_TfIdfVectorizer(benchmark::State& state) {
+  const int64_t vocab_size = state.range(0);
+  const int64_t batch_size = state.range(1);
+  const int64_t row_size = state.range(2);
+
+  const std::string model_data = CreateTfIdfModel(vocab_size, StringInput);
+
+  OrtSessionOptions* session_options;
+  ORT_BREAK_ON_ERROR(g_ort->CreateSessionOptions(&session_options));
+  OrtSession* session;
+  ORT_BREAK_ON_ERROR(g_ort->CreateSessionFromArray(env, model_data.data(), model_data.size(),
+                                                   session_options, &session));
+
+  // Half of the items are outside of the vocabulary
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int64_t> dist(0, 2 * vocab_size - 1);
+  std::vector<int64_t> items(static_cast<size_t>(batch_size * row_size));
+  for (auto& item : items) {
+    item = dist(gen);
+  }
+
+  const int64_t shape[] = {batch_size, row_size};
+  OrtValue* input_tensor = nullptr;
+  OrtAllocator* allocator;
+  ORT_BREAK_ON_ERROR(g_ort->GetAllocatorWithDefaultOptions(&allocator));
+  std::vector<std::string> strings;
+  if constexpr (StringInput) {
+    strings.reserve(items.size());
+    std::vector<const char*> cstrings;
+    cstrings.reserve(items.size());
+    for (int64_t item : items) {
+      strings.push_back("token_" + std::to_string(item));
+      cstrings.push_back(strings.back().c_str());
+    }
+    ORT_BREAK_ON_ERROR(g_ort->CreateTensorAsOrtValue(allocator, shape, 2, ONNX_TENSOR_ELEMENT_DATA_TYPE_STRING,
+                                                     &input_tensor));
+    ORT_BREAK_ON_ERROR(g_ort->FillStringTensor(input_tensor, cstrings.data(), cstrings.size()));
+  } else {
+    OrtMemoryInfo* memory_info;
+    ORT_BREAK_ON_ERROR(g_ort->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &memory_info));
+    ORT_BREAK_ON_ERROR(g_ort->CreateTensorWithDataAsOrtValue(memory_info, items.data(), items.size() * sizeof(int64_t),
+                                                             shape, 2, ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64,
+                                                             &input_tensor));
+    g_ort->ReleaseMemoryInfo(memory_info);
+  }
+
+  const char* input_names[] = {"X"};
+  const char* output_names[] = {"Y"};
+  for (auto _ : state) {
+    OrtValue* output_tensor = nullptr;
+    ORT_BREAK_ON_ERROR(g_ort->Run(session, nullptr, input_names, &input_tensor, 1, output_names, 1, &output_tensor));
+    state.PauseTiming();
+    g_ort->ReleaseValue(output_tensor);
+    state.ResumeTiming();
+  }
+
+  g_ort->ReleaseValue(input_tensor);
+  g_ort->ReleaseSession(session);
+  g_ort->ReleaseSessionOptions(session_options);
+}
+
+BENCHMARK_TEMPLATE(BM_TfIdfVectorizer, false)
+    ->UseRealTime()
+    ->Unit(benchmark::TimeUnit::kMicrosecond)
+    ->Args({1000, 1, 256})
+    ->Args({1000, 64, 256})
+    ->Args({100000, 64, 256})
+    ->Args({1000000, 64, 256});
+
+BENCHMARK_TEMPLATE(BM_TfIdfVectorizer, true)
+    ->UseRealTime()
+    ->Unit(benchmark::TimeUnit::kMicrosecond)
+    ->Args({1000, 1, 256})
+    ->Args({1000, 64, 256})
+    ->Args({100000, 64, 256})
+    ->Args({1000000, 64, 256});
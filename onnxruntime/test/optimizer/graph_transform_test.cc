@@ -5,6 +5,7 @@
 #pragma warning(disable : 4244)
 #endif
 
+#include <fstream>
 #include <random>
 
 #include "gtest/gtest.h"
@@ -15,6 +16,7 @@
 #include "core/common/span_utils.h"
 #include "core/framework/data_types.h"
 #include "core/framework/ort_value.h"
+#include "core/framework/tuning_context.h"
 #include "core/graph/graph_utils.h"
 #include "core/graph/graph_viewer.h"
 #include "core/graph/model.h"
@@ -52,6 +54,7 @@
 #include "core/optimizer/graph_transformer_utils.h"
 #include "core/optimizer/graph_transformer.h"
 #include "core/optimizer/identity_elimination.h"
+#include "core/optimizer/impute_scale_normalize_fusion.h"
 #include "core/optimizer/initializer.h"
 #include "core/optimizer/isinf_reducesum_fusion.h"
 #include "core/optimizer/label_encoder_fusion.h"
@@ -68,6 +71,7 @@
 #include "core/optimizer/propagate_cast_ops.h"
 #include "core/optimizer/qdq_transformer/qdq_util.h"
 #include "core/optimizer/quick_gelu_fusion.h"
+#include "core/optimizer/regex_full_match_set_fusion.h"
 #include "core/optimizer/relu_clip_fusion.h"
 #include "core/optimizer/reshape_fusion.h"
 #include "core/optimizer/rule_based_graph_transformer.h"
@@ -75,6 +79,7 @@
 #include "core/optimizer/unsqueeze_elimination.h"
 #include "core/optimizer/utils.h"
 #include "core/platform/env.h"
+#include "core/platform/threadpool.h"
 #include "core/session/inference_session.h"
 #include "core/session/onnxruntime_session_options_config_keys.h"
 #include "core/util/math.h"
@@ -734,6 +739,218 @@ TEST_F(GraphTransformationTests, ConstantFoldingSubgraph) {
       << "Constant folding should have been able to remove the Add node in both subgraphs";
 }
 
+// The independent Transpose and Abs nodes are folded in parallel and stored in the constant folding cache. With a
+// memory budget the large outputs stay in the data files of the cache, and a second pass loads all outputs from it.
+TEST_F(GraphTransformationTests, ConstantFoldingCache) {
+  TemporaryDirectory cache_dir{ORT_TSTR("constant_folding_cache_test_dir")};
+
+  constexpr int64_t rows = 64;
+  constexpr int64_t cols = 32;
+  auto build_graph = [&](Graph& graph) {
+    TypeProto float_tensor_type;
+    float_tensor_type.mutable_tensor_type()->set_elem_type(TensorProto_DataType_FLOAT);
+
+    TensorProto weight;
+    weight.set_name("weight");
+    weight.set_data_type(TensorProto_DataType_FLOAT);
+    weight.add_dims(rows);
+    weight.add_dims(cols);
+    for (int64_t i = 0; i < rows * cols; ++i) {
+      weight.add_float_data(static_cast<float>(i) - 1000.f);
+    }
+    graph.AddInitializedTensor(weight);
+
+    TensorProto bias;
+    bias.set_name("bias");
+    bias.set_data_type(TensorProto_DataType_FLOAT);
+    bias.add_dims(rows);
+    for (int64_t i = 0; i < rows; ++i) {
+      bias.add_float_data(-static_cast<float>(i));
+    }
+    graph.AddInitializedTensor(bias);
+
+    auto& weight_arg = graph.GetOrCreateNodeArg("weight", &float_tensor_type);
+    auto& bias_arg = graph.GetOrCreateNodeArg("bias", &float_tensor_type);
+    auto& input_arg = graph.GetOrCreateNodeArg("input", &float_tensor_type);
+    auto& transpose_out = graph.GetOrCreateNodeArg("transpose_out", &float_tensor_type);
+    auto& neg_out = graph.GetOrCreateNodeArg("neg_out", &float_tensor_type);
+    auto& abs_out = graph.GetOrCreateNodeArg("abs_out", &float_tensor_type);
+    auto& add_out = graph.GetOrCreateNodeArg("add_out", &float_tensor_type);
+    auto& output_arg = graph.GetOrCreateNodeArg("output", &float_tensor_type);
+
+    graph.AddNode("transpose", "Transpose", "", {&weight_arg}, {&transpose_out});
+    graph.AddNode("abs", "Abs", "", {&bias_arg}, {&abs_out});
+    graph.AddNode("neg", "Neg", "", {&transpose_out}, {&neg_out});
+    graph.AddNode("add", "Add", "", {&input_arg, &neg_out}, {&add_out});
+    graph.AddNode("add_bias", "Add", "", {&add_out, &abs_out}, {&output_arg});
+    ASSERT_STATUS_OK(graph.Resolve());
+  };
+
+  auto fold = [&](Graph& graph, const std::string& memory_budget_in_bytes) {
+    ConfigOptions config_options;
+    ASSERT_STATUS_OK(config_options.AddConfigEntry(kOrtSessionOptionsConstantFoldingCacheDir,
+                                                   ToUTF8String(cache_dir.Path()).c_str()));
+    ASSERT_STATUS_OK(config_options.AddConfigEntry(kOrtSessionOptionsConstantFoldingMemoryBudgetInBytes,
+                                                   memory_budget_in_bytes.c_str()));
+    ASSERT_STATUS_OK(config_options.AddConfigEntry(kOrtSessionOptionsConstantFoldingNumThreads, "2"));
+
+    concurrency::ThreadPool thread_pool(&Env::Default(), ThreadOptions(), ORT_TSTR("constant_folding"), 2, true);
+    std::unique_ptr<CPUExecutionProvider> e = std::make_unique<CPUExecutionProvider>(CPUExecutionProviderInfo());
+    onnxruntime::GraphTransformerManager graph_transformation_mgr{5};
+    ASSERT_STATUS_OK(graph_transformation_mgr.Register(
+        std::make_unique<ConstantFolding>(*e.get(), false /*skip_dequantize_linear*/, config_options,
+                                          InlinedHashSet<std::string_view>{}, InlinedHashSet<std::string>{},
+                                          &thread_pool),
+        TransformerLevel::Level1));
+    ASSERT_STATUS_OK(graph_transformation_mgr.ApplyTransformers(graph, TransformerLevel::Level1, *logger_));
+
+    std::map<std::string, int> op_to_count = CountOpsInGraph(graph);
+    EXPECT_EQ(op_to_count["Transpose"], 0);
+    EXPECT_EQ(op_to_count["Neg"], 0);
+    EXPECT_EQ(op_to_count["Abs"], 0);
+    EXPECT_EQ(op_to_count["Add"], 2);
+  };
+
+  auto check_neg_out = [&](const Graph& graph, bool expect_external_data) {
+    const TensorProto* neg_out = nullptr;
+    ASSERT_TRUE(graph.GetInitializedTensor("neg_out", neg_out));
+    EXPECT_EQ(utils::HasExternalData(*neg_out), expect_external_data);
+
+    Initializer values{*neg_out, graph.ModelPath()};
+    const auto data = values.DataAsSpan<float>();
+    ASSERT_EQ(data.size(), static_cast<size_t>(rows * cols));
+    for (int64_t i = 0; i < cols; ++i) {
+      for (int64_t j = 0; j < rows; ++j) {
+        ASSERT_EQ(data[i * rows + j], 1000.f - static_cast<float>(j * cols + i));
+      }
+    }
+  };
+
+  {
+    Model model("ConstantFoldingCache", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+                {{kOnnxDomain, 17}}, {}, *logger_);
+    build_graph(model.MainGraph());
+    fold(model.MainGraph(), "4096");
+
+    // the 8 KB outputs exceed the budget and stay in the cache, the small output of Abs is kept in memory
+    check_neg_out(model.MainGraph(), true);
+    const TensorProto* abs_out = nullptr;
+    ASSERT_TRUE(model.MainGraph().GetInitializedTensor("abs_out", abs_out));
+    EXPECT_FALSE(utils::HasExternalData(*abs_out));
+  }
+
+  size_t num_entries = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(cache_dir.Path())) {
+    num_entries += entry.path().extension() == ".pb" ? 1 : 0;
+  }
+  EXPECT_EQ(num_entries, 3u);
+
+  {
+    // the output of Transpose is no longer counted once Neg is folded, so the output of Neg fits in the budget
+    Model model("ConstantFoldingCache", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+                {{kOnnxDomain, 17}}, {}, *logger_);
+    build_graph(model.MainGraph());
+    fold(model.MainGraph(), "12288");
+    check_neg_out(model.MainGraph(), false);
+  }
+
+  // Overwrite the data files of the entries, so that only outputs loaded from the cache have the sentinel value.
+  constexpr float sentinel = 12345.f;
+  for (const auto& entry : std::filesystem::directory_iterator(cache_dir.Path())) {
+    if (entry.path().extension() == ".bin") {
+      const std::vector<float> data(entry.file_size() / sizeof(float), sentinel);
+      std::ofstream stream(entry.path(), std::ios::binary | std::ios::trunc);
+      stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(entry.file_size()));
+      ASSERT_TRUE(stream.good());
+    }
+  }
+
+  {
+    // all outputs are loaded from the cache, and kept in memory without a budget
+    Model model("ConstantFoldingCache", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+                {{kOnnxDomain, 17}}, {}, *logger_);
+    build_graph(model.MainGraph());
+    fold(model.MainGraph(), "0");
+
+    for (const char* name : {"neg_out", "abs_out"}) {
+      const TensorProto* output = nullptr;
+      ASSERT_TRUE(model.MainGraph().GetInitializedTensor(name, output));
+      EXPECT_FALSE(utils::HasExternalData(*output));
+      Initializer values{*output, model.MainGraph().ModelPath()};
+      for (float value : values.DataAsSpan<float>()) {
+        ASSERT_EQ(value, sentinel) << name;
+      }
+    }
+  }
+}
+
+// A node that is not folded, such as any node but DequantizeLinear for ConstantFoldingDQ, does not commit the pending
+// folds it consumes. Folding a Shape node after it removes the input chain of the Shape node, which includes the
+// pending nodes, so they must be committed first.
+TEST_F(GraphTransformationTests, ConstantFoldingShapeAfterPendingFold) {
+  class ConstantFoldingExceptAdd : public ConstantFolding {
+   public:
+    ConstantFoldingExceptAdd(const IExecutionProvider& execution_provider, const ConfigOptions& config_options,
+                             concurrency::ThreadPool* thread_pool)
+        : ConstantFolding("ConstantFoldingExceptAdd", execution_provider, false /*skip_dequantize_linear*/,
+                          config_options, {}, {}, thread_pool) {}
+
+   protected:
+    bool AllowConstantFolding(const Node& node) const override { return node.OpType() != "Add"; }
+  };
+
+  Model model("ConstantFoldingShapeAfterPendingFold", false, *logger_);
+  Graph& graph = model.MainGraph();
+
+  TypeProto float_tensor_type;
+  float_tensor_type.mutable_tensor_type()->set_elem_type(TensorProto_DataType_FLOAT);
+  float_tensor_type.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_value(2);
+  float_tensor_type.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_value(3);
+  TypeProto int64_tensor_type;
+  int64_tensor_type.mutable_tensor_type()->set_elem_type(TensorProto_DataType_INT64);
+
+  TensorProto weight;
+  weight.set_name("weight");
+  weight.set_data_type(TensorProto_DataType_FLOAT);
+  weight.add_dims(2);
+  weight.add_dims(3);
+  for (int i = 0; i < 6; ++i) {
+    weight.add_float_data(static_cast<float>(i));
+  }
+  graph.AddInitializedTensor(weight);
+
+  // weight -> Neg -> Add(input) -> Shape
+  auto& weight_arg = graph.GetOrCreateNodeArg("weight", &float_tensor_type);
+  auto& input_arg = graph.GetOrCreateNodeArg("input", &float_tensor_type);
+  auto& neg_out = graph.GetOrCreateNodeArg("neg_out", &float_tensor_type);
+  auto& add_out = graph.GetOrCreateNodeArg("add_out", &float_tensor_type);
+  auto& shape_out = graph.GetOrCreateNodeArg("shape_out", &int64_tensor_type);
+  graph.AddNode("neg", "Neg", "", {&weight_arg}, {&neg_out});
+  graph.AddNode("add", "Add", "", {&input_arg, &neg_out}, {&add_out});
+  graph.AddNode("shape", "Shape", "", {&add_out}, {&shape_out});
+  ASSERT_STATUS_OK(graph.Resolve());
+
+  const ConfigOptions empty_config_options;
+  concurrency::ThreadPool thread_pool(&Env::Default(), ThreadOptions(), ORT_TSTR("constant_folding"), 2, true);
+  std::unique_ptr<CPUExecutionProvider> e = std::make_unique<CPUExecutionProvider>(CPUExecutionProviderInfo());
+  onnxruntime::GraphTransformerManager graph_transformation_mgr{5};
+  ASSERT_STATUS_OK(graph_transformation_mgr.Register(
+      std::make_unique<ConstantFoldingExceptAdd>(*e.get(), empty_config_options, &thread_pool),
+      TransformerLevel::Level1));
+  ASSERT_STATUS_OK(graph_transformation_mgr.ApplyTransformers(graph, TransformerLevel::Level1, *logger_));
+
+  std::map<std::string, int> op_to_count = CountOpsInGraph(graph);
+  EXPECT_EQ(op_to_count["Neg"], 0);
+  EXPECT_EQ(op_to_count["Add"], 0);
+  EXPECT_EQ(op_to_count["Shape"], 0);
+
+  const TensorProto* shape = nullptr;
+  ASSERT_TRUE(graph.GetInitializedTensor("shape_out", shape));
+  Initializer shape_values{*shape, graph.ModelPath()};
+  const auto shape_data = shape_values.DataAsSpan<int64_t>();
+  EXPECT_EQ(std::vector<int64_t>(shape_data.begin(), shape_data.end()), (std::vector<int64_t>{2, 3}));
+}
+
 TEST_F(GraphTransformationTests, ConstantFoldingWithShapeToInitializer) {
   constexpr const ORTCHAR_T* model_uri = MODEL_FOLDER "fusion/constant_folding_with_shape_to_initializer.onnx";
   std::shared_ptr<Model> model;
@@ -2696,7 +2913,133 @@ TEST_F(GraphTransformationTests, MatMulAddFusion_NeedReshape_3D) {
                                         1, pre_graph_checker, post_graph_checker));
 }
 
+// The tuning results of the CPU EP decide whether MatMul and Add are fused for the shapes of the pattern.
+TEST_F(GraphTransformationTests, MatMulAddFusion_CostModel) {
+  auto build_test_case = [&](ModelTestBuilder& builder) {
+    auto* input_arg = builder.MakeInput<float>({{16, 32}});
+    auto* weight_arg = builder.MakeInitializer<float>({32, 64}, -1.f, 1.f);
+    auto* bias_arg = builder.MakeInitializer<float>({64}, -1.f, 1.f);
+    auto* matmul_out = builder.MakeIntermediate();
+    auto* output_arg = builder.MakeOutput();
+    builder.AddNode("MatMul", {input_arg, weight_arg}, {matmul_out});
+    builder.AddNode("Add", {matmul_out, bias_arg}, {output_arg});
+  };
+
+  auto graph_checker = [](bool fused) {
+    return [fused](Graph& graph) {
+      std::map<std::string, int> op_to_count = CountOpsInGraph(graph);
+      TEST_RETURN_IF_NOT(op_to_count["MatMul"] == (fused ? 0 : 1));
+      TEST_RETURN_IF_NOT(op_to_count["Add"] == (fused ? 0 : 1));
+      TEST_RETURN_IF_NOT(op_to_count["Gemm"] == (fused ? 1 : 0));
+      return Status::OK();
+    };
+  };
+
+  auto transform = [&](const IExecutionProvider& cpu_ep, const std::function<Status(Graph&)>& post_graph_checker) {
+    auto transformer = std::make_unique<MatMulAddFusion>(InlinedHashSet<std::string_view>{}, &cpu_ep);
+    return TestGraphTransformer(build_test_case, 18, *logger_, std::move(transformer), TransformerLevel::Level1, 1,
+                                nullptr, post_graph_checker);
+  };
+
+  CPUExecutionProvider cpu_ep{CPUExecutionProviderInfo()};
+  ITuningContext& tuning_ctx = *cpu_ep.GetTuningContext();
+  TuningResultsManager& manager = tuning_ctx.GetTuningResultsManager();
+  constexpr const char* op_signature = "CpuFusion_MatMulAdd";
+
+  // tuning profiles the fused and unfused subgraphs, and records the decision
+  tuning_ctx.EnableTunableOpAndTuning();
+  tuning_ctx.SetMaxTuningDurationMs(1);
+  ASSERT_STATUS_OK(transform(cpu_ep, nullptr));
+  const KernelMap decisions = manager.Lookup(op_signature);
+  ASSERT_EQ(decisions.size(), 1u);
+  const std::string params_signature = decisions.begin()->first;
+  ASSERT_EQ(params_signature, "MatMul(1:16x32,1:32x64c)Add(*,1:64c)");
+
+  // without tuning, the recorded decisions are followed
+  tuning_ctx.DisableTuning();
+  for (int decision : {0, 1}) {
+    manager.Delete(op_signature, params_signature);
+    manager.Add(op_signature, params_signature, decision);
+    ASSERT_STATUS_OK(transform(cpu_ep, graph_checker(decision == 1)));
+  }
+
+  // without TunableOp, the fusion is always applied
+  tuning_ctx.DisableTunableOp();
+  manager.Delete(op_signature, params_signature);
+  manager.Add(op_signature, params_signature, 0);
+  ASSERT_STATUS_OK(transform(cpu_ep, graph_checker(true)));
+}
+
 #ifndef DISABLE_CONTRIB_OPS
+// The tuning results of the CPU EP decide whether Gemm and an activation are fused for the shapes of the pattern.
+TEST_F(GraphTransformationTests, GemmActivationFusion_CostModel) {
+  auto build_test_case = [&](ModelTestBuilder& builder) {
+    auto* input_arg = builder.MakeInput<float>({{16, 32}});
+    auto* weight_arg = builder.MakeInitializer<float>({32, 64}, -1.f, 1.f);
+    auto* bias_arg = builder.MakeInitializer<float>({64}, -1.f, 1.f);
+    auto* gemm_out = builder.MakeIntermediate();
+    auto* output_arg = builder.MakeOutput();
+    builder.AddNode("Gemm", {input_arg, weight_arg, bias_arg}, {gemm_out});
+    builder.AddNode("Relu", {gemm_out}, {output_arg});
+  };
+
+  auto graph_checker = [](bool fused) {
+    return [fused](Graph& graph) {
+      std::map<std::string, int> op_to_count = CountOpsInGraph(graph);
+      TEST_RETURN_IF_NOT(op_to_count["Gemm"] == (fused ? 0 : 1));
+      TEST_RETURN_IF_NOT(op_to_count["Relu"] == (fused ? 0 : 1));
+      TEST_RETURN_IF_NOT(op_to_count["com.microsoft.FusedGemm"] == (fused ? 1 : 0));
+      return Status::OK();
+    };
+  };
+
+  auto transform = [&](const IExecutionProvider& cpu_ep, const std::function<Status(Graph&)>& post_graph_checker) {
+    auto transformer = std::make_unique<GemmActivationFusion>(InlinedHashSet<std::string_view>{}, &cpu_ep);
+    return TestGraphTransformer(build_test_case, 18, *logger_, std::move(transformer), TransformerLevel::Level2, 1,
+                                nullptr, post_graph_checker);
+  };
+
+  CPUExecutionProvider cpu_ep{CPUExecutionProviderInfo()};
+  ITuningContext& tuning_ctx = *cpu_ep.GetTuningContext();
+  TuningResultsManager& manager = tuning_ctx.GetTuningResultsManager();
+  constexpr const char* op_signature = "CpuFusion_GemmActivation";
+
+  // tuning profiles the fused and unfused subgraphs, and records the decision
+  tuning_ctx.EnableTunableOpAndTuning();
+  tuning_ctx.SetMaxTuningDurationMs(1);
+  ASSERT_STATUS_OK(transform(cpu_ep, nullptr));
+  const KernelMap decisions = manager.Lookup(op_signature);
+  ASSERT_EQ(decisions.size(), 1u);
+  const std::string params_signature = decisions.begin()->first;
+  ASSERT_EQ(params_signature, "Gemm(1:16x32,1:32x64c,1:64c)Relu(*)");
+
+  // without tuning, the recorded decisions are followed
+  tuning_ctx.DisableTuning();
+  for (int decision : {0, 1}) {
+    manager.Delete(op_signature, params_signature);
+    manager.Add(op_signature, params_signature, decision);
+    ASSERT_STATUS_OK(transform(cpu_ep, graph_checker(decision == 1)));
+  }
+
+  // the decisions only apply to nodes of the CPU EP
+  manager.Delete(op_signature, params_signature);
+  manager.Add(op_signature, params_signature, 0);
+  auto assign_to_other_ep = [](Graph& graph) {
+    for (auto& node : graph.Nodes()) {
+      node.SetExecutionProviderType(kCudaExecutionProvider);
+    }
+    return Status::OK();
+  };
+  ASSERT_STATUS_OK(TestGraphTransformer(
+      build_test_case, 18, *logger_,
+      std::make_unique<GemmActivationFusion>(InlinedHashSet<std::string_view>{}, &cpu_ep), TransformerLevel::Level2, 1,
+      assign_to_other_ep, graph_checker(true)));
+
+  // without TunableOp, the fusion is always applied
+  tuning_ctx.DisableTunableOp();
+  ASSERT_STATUS_OK(transform(cpu_ep, graph_checker(true)));
+}
+
 TEST_F(GraphTransformationTests, Gemm_Relu_three_input) {
   constexpr const ORTCHAR_T* model_uri = MODEL_FOLDER "matmul_add_fusion/3Input/gemm_relu.onnx";
 
@@ -5673,6 +6016,232 @@ TEST_F(GraphTransformationTests, QuickGelu) {
   }
 }
 
+// The ModelTestBuilder based helpers only import the ONNX and MS domains, so the ai.onnx.ml model is built directly.
+TEST_F(GraphTransformationTests, ImputeScaleNormalizeFusion) {
+  auto apply_fusion = [&](const std::function<void(ModelTestBuilder& builder)>& build_test_case,
+                          std::map<std::string, int>& op_to_count) {
+    std::unordered_map<std::string, int> domain_to_version;
+    domain_to_version[kOnnxDomain] = 14;
+    domain_to_version[kMLDomain] = 1;
+    domain_to_version[kMSDomain] = 1;
+    Model model("ImputeScaleNormalizeFusion", false, ModelMetaData(), PathString(),
+                IOnnxRuntimeOpSchemaRegistryList(), domain_to_version, {}, *logger_);
+    Graph& graph = model.MainGraph();
+    ModelTestBuilder builder(graph);
+    build_test_case(builder);
+    builder.SetGraphOutputs();
+    ASSERT_STATUS_OK(graph.Resolve());
+
+    onnxruntime::GraphTransformerManager graph_transformation_mgr{5};
+    ASSERT_STATUS_OK(graph_transformation_mgr.Register(std::make_unique<ImputeScaleNormalizeFusion>(),
+                                                       TransformerLevel::Level2));
+    ASSERT_STATUS_OK(graph_transformation_mgr.ApplyTransformers(graph, TransformerLevel::Level2, *logger_));
+    ASSERT_STATUS_OK(graph.Resolve());
+    op_to_count = CountOpsInGraph(graph);
+
+    for (auto& node : graph.Nodes()) {
+      if (node.OpType() == "ImputeScaleNormalize") {
+        const auto& attrs = node.GetAttributes();
+        ASSERT_TRUE(attrs.find("offset") != attrs.end());
+        ASSERT_TRUE(attrs.find("scale") != attrs.end());
+        ASSERT_EQ(attrs.at("norm").s(), "L2");
+      }
+    }
+  };
+
+  auto add_imputer = [](ModelTestBuilder& builder, NodeArg* input, NodeArg* output) {
+    Node& imputer = builder.AddNode("Imputer", {input}, {output}, kMLDomain);
+    imputer.AddAttribute("imputed_value_floats", std::vector<float>{1.f, 2.f, 3.f});
+    imputer.AddAttribute("replaced_value_float", std::numeric_limits<float>::quiet_NaN());
+  };
+
+  auto add_scaler_and_normalizer = [](ModelTestBuilder& builder, NodeArg* input, NodeArg* output) {
+    auto* scaler_out = builder.MakeIntermediate();
+    Node& scaler = builder.AddNode("Scaler", {input}, {scaler_out}, kMLDomain);
+    scaler.AddAttribute("offset", std::vector<float>{0.5f, 1.5f, 2.5f});
+    scaler.AddAttribute("scale", std::vector<float>{2.f, 3.f, 4.f});
+    Node& normalizer = builder.AddNode("Normalizer", {scaler_out}, {output}, kMLDomain);
+    normalizer.AddAttribute("norm", "L2");
+  };
+
+  // Imputer -> Scaler -> Normalizer is fused into a single node.
+  {
+    std::map<std::string, int> op_to_count;
+    apply_fusion(
+        [&](ModelTestBuilder& builder) {
+          auto* input_arg = builder.MakeInput<float>({{4, 3}});
+          auto* imputer_out = builder.MakeIntermediate();
+          add_imputer(builder, input_arg, imputer_out);
+          add_scaler_and_normalizer(builder, imputer_out, builder.MakeOutput());
+        },
+        op_to_count);
+    ASSERT_EQ(op_to_count["ai.onnx.ml.Imputer"], 0);
+    ASSERT_EQ(op_to_count["ai.onnx.ml.Scaler"], 0);
+    ASSERT_EQ(op_to_count["ai.onnx.ml.Normalizer"], 0);
+    ASSERT_EQ(op_to_count["com.microsoft.ImputeScaleNormalize"], 1);
+  }
+
+  // The Imputer output is also a graph output, so only Scaler -> Normalizer is fused.
+  {
+    std::map<std::string, int> op_to_count;
+    apply_fusion(
+        [&](ModelTestBuilder& builder) {
+          auto* input_arg = builder.MakeInput<float>({{4, 3}});
+          auto* imputer_out = builder.MakeOutput();
+          add_imputer(builder, input_arg, imputer_out);
+          add_scaler_and_normalizer(builder, imputer_out, builder.MakeOutput());
+        },
+        op_to_count);
+    ASSERT_EQ(op_to_count["ai.onnx.ml.Imputer"], 1);
+    ASSERT_EQ(op_to_count["ai.onnx.ml.Scaler"], 0);
+    ASSERT_EQ(op_to_count["ai.onnx.ml.Normalizer"], 0);
+    ASSERT_EQ(op_to_count["com.microsoft.ImputeScaleNormalize"], 1);
+  }
+
+  // Rank 3 input is not supported by Normalizer, so nothing is fused.
+  {
+    std::map<std::string, int> op_to_count;
+    apply_fusion(
+        [&](ModelTestBuilder& builder) {
+          auto* input_arg = builder.MakeInput<float>({{2, 4, 3}});
+          auto* imputer_out = builder.MakeIntermediate();
+          add_imputer(builder, input_arg, imputer_out);
+          auto* scaler_out = builder.MakeOutput();
+          Node& scaler = builder.AddNode("Scaler", {imputer_out}, {scaler_out}, kMLDomain);
+          scaler.AddAttribute("offset", std::vector<float>{0.5f});
+          scaler.AddAttribute("scale", std::vector<float>{2.f});
+        },
+        op_to_count);
+    ASSERT_EQ(op_to_count["ai.onnx.ml.Imputer"], 1);
+    ASSERT_EQ(op_to_count["ai.onnx.ml.Scaler"], 1);
+    ASSERT_EQ(op_to_count["com.microsoft.ImputeScaleNormalize"], 0);
+  }
+}
+
+TEST_F(GraphTransformationTests, RegexFullMatchSetFusion) {
+  auto build_test_case = [](ModelTestBuilder& builder) {
+    auto* input_arg = builder.MakeInput<std::string>(
+        {2, 3}, {"www.google.com", "account@gmail.com", "www.bbc.co.uk", "not email", "ERROR disk full", ""});
+    auto* other_input_arg = builder.MakeInput<std::string>({2}, {"ERROR timeout", "INFO ok"});
+
+    const std::vector<std::string> patterns{R"(www\.[\w.-]+\.com)", R"([\w.\-]{0,25}@(yahoo|gmail)\.com)",
+                                            R"(ERROR .*)"};
+    for (const auto& pattern : patterns) {
+      Node& node = builder.AddNode("RegexFullMatch", {input_arg}, {builder.MakeOutput()});
+      node.AddAttribute("pattern", pattern);
+    }
+
+    // A RegexFullMatch node on a different input is left alone.
+    Node& other_node = builder.AddNode("RegexFullMatch", {other_input_arg}, {builder.MakeOutput()});
+    other_node.AddAttribute("pattern", std::string(R"(ERROR .*)"));
+  };
+
+  auto check_transformed_graph = [](InferenceSessionWrapper& session) {
+    auto op_to_count = CountOpsInGraph(session.GetGraph());
+    EXPECT_EQ(op_to_count["RegexFullMatch"], 1);
+    EXPECT_EQ(op_to_count["com.microsoft.RegexFullMatchSet"], 1);
+  };
+
+  TransformerTester(build_test_case, check_transformed_graph, TransformerLevel::Level1, TransformerLevel::Level2, 20);
+}
+
+// The fusion connects the producer and the consumers of the fused nodes to the new node without a Resolve.
+TEST_F(GraphTransformationTests, RegexFullMatchSetFusionMovesEdges) {
+  Model model("RegexFullMatchSetFusionMovesEdges", false, ModelMetaData(), PathString(),
+              IOnnxRuntimeOpSchemaRegistryList(), {{kOnnxDomain, 20}, {kMSDomain, 1}}, {}, *logger_);
+  Graph& graph = model.MainGraph();
+
+  TypeProto string_tensor_type;
+  string_tensor_type.mutable_tensor_type()->set_elem_type(TensorProto_DataType_STRING);
+  TypeProto bool_tensor_type;
+  bool_tensor_type.mutable_tensor_type()->set_elem_type(TensorProto_DataType_BOOL);
+
+  auto& input_arg = graph.GetOrCreateNodeArg("input", &string_tensor_type);
+  auto& identity_out = graph.GetOrCreateNodeArg("identity_out", &string_tensor_type);
+  graph.AddNode("identity", "Identity", "", {&input_arg}, {&identity_out});
+
+  const std::vector<std::string> patterns{R"(www\.[\w.-]+\.com)", R"(ERROR .*)"};
+  for (size_t i = 0; i < patterns.size(); ++i) {
+    const std::string index = std::to_string(i);
+    auto& match_out = graph.GetOrCreateNodeArg("match_out" + index, &bool_tensor_type);
+    auto& output_arg = graph.GetOrCreateNodeArg("output" + index, &bool_tensor_type);
+    Node& match = graph.AddNode("match" + index, "RegexFullMatch", "", {&identity_out}, {&match_out});
+    match.AddAttribute("pattern", patterns[i]);
+    graph.AddNode("not" + index, "Not", "", {&match_out}, {&output_arg});
+  }
+  ASSERT_STATUS_OK(graph.Resolve());
+
+  // ApplyImpl is called directly, as Apply resolves the graph afterwards, which rebuilds the edges.
+  RegexFullMatchSetFusion fusion;
+  bool modified = false;
+  ASSERT_STATUS_OK(fusion.ApplyImpl(graph, modified, 0, *logger_));
+  ASSERT_TRUE(modified);
+
+  const Node* set_node = nullptr;
+  for (const auto& node : graph.Nodes()) {
+    EXPECT_NE(node.OpType(), "RegexFullMatch");
+    if (node.OpType() == "RegexFullMatchSet") {
+      set_node = &node;
+    }
+  }
+  ASSERT_NE(set_node, nullptr);
+
+  ASSERT_EQ(set_node->GetInputEdgesCount(), 1u);
+  EXPECT_EQ(set_node->InputNodesBegin()->Name(), "identity");
+  EXPECT_EQ(graph.GetProducerNode("match_out1"), set_node);
+
+  ASSERT_EQ(set_node->GetOutputEdgesCount(), 2u);
+  for (auto it = set_node->OutputEdgesBegin(); it != set_node->OutputEdgesEnd(); ++it) {
+    EXPECT_EQ(it->GetNode().Name(), "not" + std::to_string(it->GetSrcArgIndex()));
+    EXPECT_EQ(it->GetDstArgIndex(), 0);
+  }
+
+  ASSERT_STATUS_OK(graph.Resolve());
+}
+
+TEST_F(GraphTransformationTests, ElementwiseChainFusion) {
+  auto build_test_case = [](ModelTestBuilder& builder) {
+    auto* input_arg = builder.MakeInput<float>({2, 3, 4}, -2.f, 2.f);
+    auto* bias_arg = builder.MakeInitializer<float>({4}, {0.5f, -0.5f, 1.f, -1.f});
+    auto* scale_arg = builder.MakeInitializer<float>({}, {3.f});
+    auto* column_arg = builder.MakeInitializer<float>({2, 3, 1}, {1.f, 2.f, 3.f, 4.f, 5.f, 6.f});
+
+    // Y = (A * Tanh(A)) / scale - X with A = X + bias is fused.
+    auto* add_out = builder.MakeIntermediate();
+    auto* tanh_out = builder.MakeIntermediate();
+    auto* mul_out = builder.MakeIntermediate();
+    auto* div_out = builder.MakeIntermediate();
+    builder.AddNode("Add", {input_arg, bias_arg}, {add_out});
+    builder.AddNode("Tanh", {add_out}, {tanh_out});
+    builder.AddNode("Mul", {add_out, tanh_out}, {mul_out});
+    builder.AddNode("Div", {mul_out, scale_arg}, {div_out});
+    builder.AddNode("Sub", {div_out, input_arg}, {builder.MakeOutput()});
+
+    // A is also used outside of the chain, so the Add stays and the Relu has nothing to fuse with.
+    builder.AddNode("Relu", {add_out}, {builder.MakeOutput()});
+
+    // The Mul broadcasts along the last dimension, which the fused kernel doesn't support.
+    auto* column_mul_out = builder.MakeIntermediate();
+    builder.AddNode("Mul", {input_arg, column_arg}, {column_mul_out});
+    builder.AddNode("Neg", {column_mul_out}, {builder.MakeOutput()});
+  };
+
+  auto check_transformed_graph = [](InferenceSessionWrapper& session) {
+    auto op_to_count = CountOpsInGraph(session.GetGraph());
+    EXPECT_EQ(op_to_count["com.microsoft.FusedElementwise"], 1);
+    EXPECT_EQ(op_to_count["Add"], 1);
+    EXPECT_EQ(op_to_count["Relu"], 1);
+    EXPECT_EQ(op_to_count["Mul"], 1);
+    EXPECT_EQ(op_to_count["Neg"], 1);
+    EXPECT_EQ(op_to_count["Tanh"], 0);
+    EXPECT_EQ(op_to_count["Div"], 0);
+    EXPECT_EQ(op_to_count["Sub"], 0);
+  };
+
+  TransformerTester(build_test_case, check_transformed_graph, TransformerLevel::Level2, TransformerLevel::Level3, 14,
+                    1e-6, 1e-6);
+}
+
 struct BiasSoftmaxFusionTester {
   std::shared_ptr<Model> p_model_;
   Status model_load_;
@@ -107,6 +107,45 @@ TEST(OptimizerInitializerTest, LoadExternalData) {
     EXPECT_THROW(Initializer i(tensor_proto, tensor_data_dir_path), OnnxRuntimeException);
   }
 }
+
+TEST(OptimizerInitializerTest, ModifyExternalData) {
+  const std::vector<float> tensor_data{1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
+  const std::filesystem::path tensor_data_dir_path = ORT_TSTR(".");
+  const std::filesystem::path tensor_data_file_path = ORT_TSTR("OptimizerInitializerTest_ModifyExternalData.bin");
+  ScopedFileDeleter file_deleter{};
+
+  ASSERT_STATUS_OK(WriteExternalDataFile(
+      gsl::make_span(tensor_data), tensor_data_dir_path / tensor_data_file_path, file_deleter));
+
+  ONNX_NAMESPACE::TensorProto tensor_proto{};
+  tensor_proto.set_name("test");
+  tensor_proto.add_dims(2);
+  tensor_proto.add_dims(3);
+  tensor_proto.set_data_type(ONNX_NAMESPACE::TensorProto_DataType_FLOAT);
+  tensor_proto.set_data_location(ONNX_NAMESPACE::TensorProto_DataLocation_EXTERNAL);
+  SetTensorProtoExternalData("location", ToUTF8String(tensor_data_file_path.native()), tensor_proto);
+  SetTensorProtoExternalData("offset", "0", tensor_proto);
+  SetTensorProtoExternalData("length", std::to_string(tensor_data.size() * sizeof(float)), tensor_proto);
+
+  // the external data is mapped copy-on-write, so modifying one initializer does not change the file or the data of
+  // other initializers loaded from it
+  Initializer modified(tensor_proto, tensor_data_dir_path);
+  modified.add(1.f);
+  modified.data<float>()[0] = 42.f;
+
+  const std::vector<float> expected_modified{42.f, 3.f, 4.f, 5.f, 6.f, 7.f};
+  EXPECT_EQ(modified.DataAsSpan<float>(), gsl::make_span(expected_modified));
+
+  Initializer unmodified(tensor_proto, tensor_data_dir_path);
+  EXPECT_EQ(unmodified.DataAsSpan<float>(), gsl::make_span(tensor_data));
+
+  // the modified data is saved
+  ONNX_NAMESPACE::TensorProto modified_proto;
+  modified.ToProto(modified_proto);
+  EXPECT_FALSE(utils::HasExternalData(modified_proto));
+  Initializer reloaded(modified_proto, tensor_data_dir_path);
+  EXPECT_EQ(reloaded.DataAsSpan<float>(), gsl::make_span(expected_modified));
+}
 #endif
 
 template <typename T>
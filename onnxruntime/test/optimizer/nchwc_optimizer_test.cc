@@ -1370,30 +1370,224 @@ TEST(NchwcOptimizerTests, Activation) {
 
   // Verify that the optimizer doesn't add reorders for these activations that
   // cannot be fused with a convolution.
-  std::vector<std::string> activation_op_types{"Relu", "Sigmoid", "Tanh"};
+  std::vector<std::string> activation_op_types{"Relu", "Sigmoid", "Tanh", "LeakyRelu", "HardSigmoid", "Elu", "Selu",
+                                               "Softplus", "Softsign"};
   for (auto& activation_op_type : activation_op_types) {
     test_case(activation_op_type);
   }
 }
 
-TEST(NchwcOptimizerTests, MaxPoolTypeCheck) {
+TEST(NchwcOptimizerTests, ConvAddActivationFusion) {
+  auto test_case = [&](const std::string& activation_op_type) {
+    auto build_test_case = [&](NchwcTestHelper& helper) {
+      auto* input_arg = helper.MakeInput<float>({1, 32, 19, 17});
+      auto* conv1_output_arg = helper.MakeIntermediate();
+      auto* conv2_output_arg = helper.MakeIntermediate();
+      auto* add_output_arg = helper.MakeIntermediate();
+      auto* output_arg = helper.MakeOutput();
+
+      helper.AddConvNode(input_arg, conv1_output_arg, {32, 32, 3, 3});
+      helper.AddConvNode(input_arg, conv2_output_arg, {32, 32, 3, 3});
+      helper.AddNode("Add", {conv1_output_arg, conv2_output_arg}, {add_output_arg});
+      auto& activation_node = helper.AddNode(activation_op_type, {add_output_arg}, {output_arg});
+      activation_node.AddAttribute("alpha", 0.125f);
+      if (activation_op_type == "HardSigmoid") {
+        activation_node.AddAttribute("beta", 0.25f);
+      }
+
+      helper.per_sample_tolerance_ = .001f;
+    };
+
+    auto check_nchwc_graph = [&](InferenceSessionWrapper& session) {
+      auto op_to_count = CountOpsInGraph(session.GetGraph());
+      EXPECT_EQ(op_to_count["com.microsoft.nchwc.Conv"], 2);
+      EXPECT_EQ(op_to_count["com.microsoft.nchwc.ReorderInput"], 1);
+      EXPECT_EQ(op_to_count["com.microsoft.nchwc.ReorderOutput"], 1);
+      EXPECT_EQ(op_to_count["Add"], 0);
+      EXPECT_EQ(op_to_count[activation_op_type], 0);
+    };
+
+    NchwcOptimizerTester(build_test_case, check_nchwc_graph);
+  };
+
+  // Verify that activations with parameters are fused into the NCHWc Conv node
+  // after the Conv/Add fusion.
+  test_case("LeakyRelu");
+  test_case("HardSigmoid");
+}
+
+TEST(NchwcOptimizerTests, Pad) {
+  auto test_case = [&](int opset_version, const std::string& mode, const std::vector<int64_t>& pads) {
+    auto build_test_case = [&](NchwcTestHelper& helper) {
+      auto* input_arg = helper.MakeInput<float>({2, 16, 9, 11});
+      auto* conv_output_arg = helper.MakeIntermediate();
+      auto* output_arg = helper.MakeOutput();
+
+      // Use an output channel count that is not block aligned.
+      helper.AddConvNode(input_arg, conv_output_arg, {20, 16, 3, 3});
+
+      // Use a non-zero constant value so that the Pad is not fused into another node.
+      constexpr float value = 1.5f;
+      std::vector<NodeArg*> input_args{conv_output_arg};
+      if (opset_version >= 11) {
+        input_args.push_back(helper.Make1DInitializer<int64_t>(pads));
+        if (mode == "constant") {
+          input_args.push_back(helper.MakeInitializer<float>({}, {value}));
+        }
+      }
+      auto& pad_node = helper.AddNode("Pad", input_args, {output_arg});
+      pad_node.AddAttribute("mode", mode);
+      if (opset_version < 11) {
+        pad_node.AddAttribute("pads", pads);
+        if (mode == "constant") {
+          pad_node.AddAttribute("value", value);
+        }
+      }
+    };
+
+    auto check_nchwc_graph = [&](InferenceSessionWrapper& session) {
+      auto op_to_count = CountOpsInGraph(session.GetGraph());
+      EXPECT_EQ(op_to_count["com.microsoft.nchwc.Conv"], 1);
+      EXPECT_EQ(op_to_count["com.microsoft.nchwc.Pad"], 1);
+      EXPECT_EQ(op_to_count["com.microsoft.nchwc.ReorderInput"], 1);
+      EXPECT_EQ(op_to_count["com.microsoft.nchwc.ReorderOutput"], 1);
+      EXPECT_EQ(op_to_count["Pad"], 0);
+    };
+
+    NchwcOptimizerTester(build_test_case, check_nchwc_graph, opset_version);
+  };
+
+  // Verify that Pad nodes that only pad the spatial dimensions are converted to
+  // the NCHWc format for the supported modes and versions of the operator.
+  static const int opset_versions[] = {10, 11, 13, 18};
+  for (auto opset_version : opset_versions) {
+    for (const std::string mode : {"constant", "reflect", "edge"}) {
+      test_case(opset_version, mode, {0, 0, 1, 2, 0, 0, 3, 0});
+      test_case(opset_version, mode, {0, 0, 0, 0, 0, 0, 2, 2});
+    }
+  }
+}
+
+TEST(NchwcOptimizerTests, PadChannels) {
   auto build_test_case = [&](NchwcTestHelper& helper) {
-    auto add_pool_node = [&](NchwcTestHelper& helper, NodeArg* input_arg) {
+    auto* input_arg = helper.MakeInput<float>({1, 16, 9, 11});
+    auto* conv_output_arg = helper.MakeIntermediate();
+    auto* output_arg = helper.MakeOutput();
+
+    helper.AddConvNode(input_arg, conv_output_arg, {32, 16, 3, 3});
+    auto& pad_node = helper.AddNode("Pad", {conv_output_arg, helper.Make1DInitializer<int64_t>({0, 1, 1, 1, 0, 1, 1, 1})},
+                                    {output_arg});
+    pad_node.AddAttribute("mode", "edge");
+  };
+
+  auto check_nchwc_graph = [&](InferenceSessionWrapper& session) {
+    auto op_to_count = CountOpsInGraph(session.GetGraph());
+    EXPECT_EQ(op_to_count["com.microsoft.nchwc.Conv"], 1);
+    EXPECT_EQ(op_to_count["com.microsoft.nchwc.Pad"], 0);
+    EXPECT_EQ(op_to_count["Pad"], 1);
+  };
+
+  // Verify that a Pad node that pads the channel dimension is not converted.
+  NchwcOptimizerTester(build_test_case, check_nchwc_graph);
+}
+
+TEST(NchwcOptimizerTests, ResizeNearestHalfPixel) {
+  auto test_case = [&](const std::string& transformation_mode, const std::string& nearest_mode, bool expect_nchwc) {
+    auto build_test_case = [&](NchwcTestHelper& helper) {
+      auto* input_arg = helper.MakeInput<float>({1, 16, 13, 10});
+      auto* conv_output_arg = helper.MakeIntermediate();
       auto* output_arg = helper.MakeOutput();
+
+      helper.AddConvNode(input_arg, conv_output_arg, {32, 16, 1, 1});
+
+      std::vector<NodeArg*> input_args{conv_output_arg,
+                                       helper.Make1DInitializer<float>({}),
+                                       helper.Make1DInitializer<float>({1.f, 1.f, 2.f, 3.f})};
+      Node& resize_node = helper.AddNode("Resize", input_args, {output_arg});
+      if (!transformation_mode.empty()) {
+        resize_node.AddAttribute("coordinate_transformation_mode", transformation_mode);
+      }
+      if (!nearest_mode.empty()) {
+        resize_node.AddAttribute("nearest_mode", nearest_mode);
+      }
+    };
+
+    auto check_nchwc_graph = [&](InferenceSessionWrapper& session) {
+      auto op_to_count = CountOpsInGraph(session.GetGraph());
+      EXPECT_EQ(op_to_count["com.microsoft.nchwc.Upsample"], expect_nchwc ? 1 : 0);
+      EXPECT_EQ(op_to_count["Resize"], expect_nchwc ? 0 : 1);
+    };
+
+    NchwcOptimizerTester(build_test_case, check_nchwc_graph, 13);
+  };
+
+  // With integer scales, rounding the half pixel coordinates to the nearest
+  // input index gives the same result as the asymmetric floor mode.
+  test_case("", "", true);
+  test_case("half_pixel", "round_prefer_floor", true);
+  test_case("half_pixel", "round_prefer_ceil", true);
+  test_case("pytorch_half_pixel", "round_prefer_floor", true);
+  test_case("half_pixel", "floor", false);
+  test_case("asymmetric", "round_prefer_floor", false);
+  test_case("align_corners", "round_prefer_floor", false);
+}
+
+TEST(NchwcOptimizerTests, PoolReorderCost) {
+  auto test_case = [&](const std::string& consumer_op_type) {
+    auto build_test_case = [&](NchwcTestHelper& helper) {
+      auto* input_arg = helper.MakeInput<float>({1, 32, 13, 13});
+      auto* pool_output_arg = helper.MakeIntermediate();
+      auto* output_arg = helper.MakeOutput();
+
+      auto& pool_node = helper.AddNode("MaxPool", {input_arg}, {pool_output_arg});
+      pool_node.AddAttribute("kernel_shape", std::vector<int64_t>{3, 3});
+      if (consumer_op_type == "Conv") {
+        helper.AddConvNode(pool_output_arg, output_arg, {16, 32, 1, 1});
+      } else {
+        helper.AddNode(consumer_op_type, {pool_output_arg}, {output_arg});
+      }
+    };
+
+    auto check_nchwc_graph = [&](InferenceSessionWrapper& session) {
+      auto op_to_count = CountOpsInGraph(session.GetGraph());
+      const int expected_nchwc_pools = consumer_op_type == "Conv" ? 1 : 0;
+      EXPECT_EQ(op_to_count["com.microsoft.nchwc.MaxPool"], expected_nchwc_pools);
+      EXPECT_EQ(op_to_count["MaxPool"], 1 - expected_nchwc_pools);
+      EXPECT_EQ(op_to_count["com.microsoft.nchwc.ReorderInput"], expected_nchwc_pools);
+      EXPECT_EQ(op_to_count["com.microsoft.nchwc.ReorderOutput"], expected_nchwc_pools);
+    };
+
+    NchwcOptimizerTester(build_test_case, check_nchwc_graph);
+  };
+
+  // Verify that a pooling node with an NCHW input is only converted if its
+  // output can remain in NCHWc format.
+  test_case("Conv");
+  test_case("Flatten");
+}
+
+TEST(NchwcOptimizerTests, MaxPoolTypeCheck) {
+  auto build_test_case = [&](NchwcTestHelper& helper) {
+    auto add_pool_node = [&](NchwcTestHelper& helper, NodeArg* input_arg, NodeArg* output_arg) {
       auto& pool_node = helper.AddNode("MaxPool", {input_arg}, {output_arg});
       pool_node.AddAttribute("pads", std::vector<int64_t>{0, 0, 0, 0});
       pool_node.AddAttribute("kernel_shape", std::vector<int64_t>{3, 3});
     };
 
+    // The float pooling node feeds a convolution, so its output can remain in
+    // NCHWc format.
     const std::vector<int64_t> input_shape{1, 32, 13, 13};
-    add_pool_node(helper, helper.MakeInput<float>(input_shape));
-    add_pool_node(helper, helper.MakeInput<uint8_t>(input_shape));
+    auto* pool_output_arg = helper.MakeIntermediate();
+    add_pool_node(helper, helper.MakeInput<float>(input_shape), pool_output_arg);
+    helper.AddConvNode(pool_output_arg, helper.MakeOutput(), {16, 32, 1, 1});
+    add_pool_node(helper, helper.MakeInput<uint8_t>(input_shape), helper.MakeOutput());
   };
 
   auto check_nchwc_graph = [&](InferenceSessionWrapper& session) {
     auto op_to_count = CountOpsInGraph(session.GetGraph());
     EXPECT_EQ(op_to_count["MaxPool"], 1);
     EXPECT_EQ(op_to_count["com.microsoft.nchwc.MaxPool"], 1);
+    EXPECT_EQ(op_to_count["com.microsoft.nchwc.Conv"], 1);
     EXPECT_EQ(op_to_count["com.microsoft.nchwc.ReorderInput"], 1);
     EXPECT_EQ(op_to_count["com.microsoft.nchwc.ReorderOutput"], 1);
   };
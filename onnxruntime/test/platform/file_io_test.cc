@@ -3,6 +3,7 @@
 
 #include "core/platform/env.h"
 
+#include <algorithm>
 #include <fstream>
 #include <random>
 #include <utility>
@@ -19,6 +20,7 @@
 #include "gtest/gtest.h"
 
 #include "core/common/span_utils.h"
+#include "test/util/include/asserts.h"
 #include "test/util/include/file_util.h"
 
 namespace onnxruntime {
@@ -171,11 +173,6 @@ TEST(FileIoTest, MapFileIntoMemory) {
     const auto offset = offset_and_length.first;
     const auto length = offset_and_length.second;
 
-    // The offset must be a multiple of the allocation granularity
-    if (offset % allocation_granularity != 0) {
-      continue;
-    }
-
     Env::MappedMemoryPtr mapped_memory{};
     auto status = Env::Default().MapFileIntoMemory(
         tmp.path.c_str(), offset, length, mapped_memory);
@@ -193,7 +190,7 @@ TEST(FileIoTest, MapFileIntoMemory) {
   {
     Env::MappedMemoryPtr mapped_memory{};
 
-    // invalid - offset is not a multiple of the allocation granularity
+    // invalid - offset is past the end of the file
     ASSERT_FALSE(Env::Default().MapFileIntoMemory(
                                    tmp.path.c_str(), allocation_granularity * 3 / 2, page_size / 10, mapped_memory)
                      .IsOK());
@@ -208,5 +205,22 @@ TEST(FileIoTest, MapFileIntoMemory) {
 }
 #endif
 
+TEST(FileIoTest, MapFileIntoMemoryIsCopyOnWrite) {
+  TempFilePath tmp(ORT_TSTR("map_file_test_"));
+  const auto expected_data = GenerateData(1024);
+  WriteDataToFile(gsl::make_span(expected_data), tmp.path);
+
+  {
+    Env::MappedMemoryPtr mapped_memory{};
+    ASSERT_STATUS_OK(Env::Default().MapFileIntoMemory(tmp.path.c_str(), 0, expected_data.size(), mapped_memory));
+    std::fill_n(mapped_memory.get(), expected_data.size(), '\0');
+  }
+
+  // writes to the mapped memory must not change the file
+  std::vector<char> buffer(expected_data.size());
+  ASSERT_STATUS_OK(Env::Default().ReadFileIntoBuffer(tmp.path.c_str(), 0, buffer.size(), gsl::make_span(buffer)));
+  ASSERT_TRUE(SpanEq(gsl::make_span(buffer), gsl::make_span(expected_data)));
+}
+
 }  // namespace test
 }  // namespace onnxruntime
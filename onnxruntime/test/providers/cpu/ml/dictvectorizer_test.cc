@@ -42,5 +42,39 @@ TEST(MLOpTest, DictVectorizerInt64Input) {
   test.Run();
 }
 
+TEST(MLOpTest, DictVectorizerDuplicatedVocabulary) {
+  OpTester test("DictVectorizer", 1, onnxruntime::kMLDomain);
+
+  test.AddAttribute("int64_vocabulary", std::vector<int64_t>{4, 2, 4, 7, 1});
+
+  std::map<int64_t, float> map;
+  map[1] = 1.5f;
+  map[4] = 2.5f;
+  map[9] = 3.5f;
+
+  test.AddInput<int64_t, float>("X", map);
+
+  std::vector<int64_t> dims{1, 5};
+  test.AddOutput<float>("Y", dims, {2.5f, 0.f, 2.5f, 0.f, 1.5f});
+  test.Run();
+}
+
+TEST(MLOpTest, DictVectorizerInputLargerThanVocabulary) {
+  OpTester test("DictVectorizer", 1, onnxruntime::kMLDomain);
+
+  test.AddAttribute("string_vocabulary", std::vector<std::string>{"c", "a"});
+
+  std::map<std::string, double> map;
+  map["a"] = 1.0;
+  map["b"] = 2.0;
+  map["d"] = 3.0;
+
+  test.AddInput<std::string, double>("X", map);
+
+  std::vector<int64_t> dims{1, 2};
+  test.AddOutput<double>("Y", dims, {0.0, 1.0});
+  test.Run();
+}
+
 }  // namespace test
 }  // namespace onnxruntime
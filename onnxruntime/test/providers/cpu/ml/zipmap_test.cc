@@ -55,6 +55,14 @@ TEST(MLOpTest, ZipMapOpInt64Float1D) {
   TestHelper<int64_t>({10, 20, 30, 40, 50, 60}, "int64_t", {6});
 }
 
+TEST(MLOpTest, ZipMapOpStringFloatUnsortedLabels) {
+  TestHelper<string>({"class3", "class1", "class2"}, "string", {2, 3});
+}
+
+TEST(MLOpTest, ZipMapOpInt64FloatUnsortedLabels) {
+  TestHelper<int64_t>({60, -10, 40, 20, 50, 0}, "int64_t", {1, 6});
+}
+
 // Negative test cases
 TEST(MLOpTest, ZipMapOpStringFloatStrideMoreThanNumLabels) {
   TestHelper<string>({"class1", "class2", "class3"}, "string", {1, 6}, OpTester::ExpectResult::kExpectFailure);
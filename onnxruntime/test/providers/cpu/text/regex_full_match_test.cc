@@ -115,5 +115,41 @@ TEST(RegexFullMatch, NonUtf8Pattern) {
                        });
   test.Run(BaseTester::ExpectResult::kExpectFailure, "Invalid regex pattern");
 }
+
+TEST(RegexFullMatch, CaseInsensitiveLiteralPrefix) {
+  RunTest({4}, {"ERROR code 7", "error Code 42", "Errors code 1", "warn code 3"}, R"((?i)error code \d+)",
+          {true, true, false, false});
+}
+
+TEST(RegexFullMatch, LargeInput) {
+  constexpr int64_t kNumStrings = 4096;
+  std::vector<std::string> input;
+  input.reserve(kNumStrings);
+  // std::vector<bool> has no data(), so the expected values are kept in a plain array.
+  auto output = std::make_unique<bool[]>(kNumStrings);
+  for (int64_t i = 0; i < kNumStrings; ++i) {
+    switch (i % 4) {
+      case 0:
+        input.push_back("ERROR code " + std::to_string(i));
+        output[i] = true;
+        break;
+      case 1:
+        input.push_back("ERROR code " + std::to_string(i) + "!");
+        break;
+      case 2:
+        input.push_back("INFO code " + std::to_string(i));
+        break;
+      default:
+        input.push_back("");
+        break;
+    }
+  }
+
+  OpTester test("RegexFullMatch", 20, kOnnxDomain);
+  test.AddAttribute("pattern", R"(ERROR code \d+)");
+  test.AddInput<std::string>("Input", {kNumStrings}, input);
+  test.AddOutput<bool>("Output", {kNumStrings}, output.get(), static_cast<size_t>(kNumStrings));
+  test.Run();
+}
 }  // namespace test
 }  // namespace onnxruntime
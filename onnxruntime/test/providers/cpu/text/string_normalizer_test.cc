@@ -211,6 +211,47 @@ TEST(ContribOpTest, StringNormalizerSensitiveFilterOutUpperEmptyCase) {
   test.Run(OpTester::ExpectResult::kExpectSuccess);
 }
 
+TEST(ContribOpTest, StringNormalizerInsensitiveFilterOutMixedAsciiLower) {
+  // - case-INSENSITIVE approach en_US locale
+  // - stopwords given in mixed case, ASCII and non-ASCII
+  // - LOWER applied to the remaining strings
+  OpTester test("StringNormalizer", opset_ver, domain);
+  InitTestAttr(test, "LOWER", false, {"Monday", "École"}, test_locale);
+  std::vector<int64_t> dims{6};
+  std::vector<std::string> input = {"MONDAY",
+                                    "monday",
+                                    "école",
+                                    "ÉCOLE",
+                                    "Tuesday",
+                                    "BESANÇON"};
+  test.AddInput<std::string>("T", dims, input);
+
+  std::vector<std::string> output = {"tuesday", "besançon"};
+  test.AddOutput<std::string>("Y", {2}, output);
+  test.Run(OpTester::ExpectResult::kExpectSuccess);
+}
+
+TEST(ContribOpTest, StringNormalizerInsensitiveFilterOutUpperLargeInput) {
+  // Enough strings to be split across threads
+  OpTester test("StringNormalizer", opset_ver, domain);
+  InitTestAttr(test, "UPPER", false, {"monday"}, test_locale);
+  constexpr int64_t count = 4096;
+  std::vector<std::string> input;
+  std::vector<std::string> output;
+  input.reserve(count);
+  for (int64_t i = 0; i < count; ++i) {
+    if (i % 3 == 0) {
+      input.push_back((i % 2 == 0) ? "Monday" : "MONDAY");
+    } else {
+      input.push_back("day_" + std::to_string(i) + "_é");
+      output.push_back("DAY_" + std::to_string(i) + "_É");
+    }
+  }
+  test.AddInput<std::string>("T", {count}, input);
+  test.AddOutput<std::string>("Y", {static_cast<int64_t>(output.size())}, output);
+  test.Run(OpTester::ExpectResult::kExpectSuccess);
+}
+
 // Fails on iOS because necessary locales are not installed
 // MacOS runs fine.
 #ifndef ORT_IOS